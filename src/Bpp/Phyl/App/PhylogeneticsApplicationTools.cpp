@@ -1605,7 +1605,8 @@ SubstitutionCount* PhylogeneticsApplicationTools::getSubstitutionCount(
   {
     string weightOption = ApplicationTools::getStringParameter("weight", nijtParams, "None", "", true, warn + 1);
     AlphabetIndex2* weights = SequenceApplicationTools::getAlphabetIndex2(alphabet, weightOption, "Substitution weight scheme:");
-    substitutionCount = new UniformizationSubstitutionCount(model, new TotalSubstitutionRegister(model), weights);
+    double tolerance = ApplicationTools::getDoubleParameter("tolerance", nijtParams, 1e-12, "", true, warn + 1);
+    substitutionCount = new UniformizationSubstitutionCount(model, new TotalSubstitutionRegister(model), weights, tolerance);
   }
   else if (nijtOption == "Decomposition")
   {
@@ -0,0 +1,354 @@
+//
+// File: BipartitionCounter.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include "BipartitionCounter.h"
+#include "TreeTools.h"
+#include "Io/IoTree.h"
+
+#include <Bpp/Exceptions.h>
+#include <Bpp/Numeric/Number.h>
+#include <Bpp/Numeric/VectorTools.h>
+#include <Bpp/App/ApplicationTools.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+/******************************************************************************/
+
+BipartitionCounter::BipartitionCounter(bool checkNames) :
+  bipartitions_(0),
+  lastOccurrences_(),
+  nbTrees_(0),
+  checkNames_(checkNames)
+{}
+
+BipartitionCounter::BipartitionCounter(const vector<string>& elements, bool checkNames) :
+  bipartitions_(new BipartitionSet(elements)),
+  lastOccurrences_(),
+  nbTrees_(0),
+  checkNames_(checkNames)
+{}
+
+/******************************************************************************/
+
+void BipartitionCounter::init_(const Tree& tree)
+{
+  vector<string> elements = tree.getLeavesNames();
+  std::sort(elements.begin(), elements.end());
+  bipartitions_ = new BipartitionSet(elements);
+}
+
+/******************************************************************************/
+
+void BipartitionCounter::checkLeaves_(const Tree& tree) const
+{
+  if (tree.getNumberOfLeaves() != bipartitions_->getNumberOfElements()
+      || (checkNames_ && !VectorTools::haveSameElements(tree.getLeavesNames(), bipartitions_->getElementNames())))
+    throw Exception("BipartitionCounter::addTree. Distinct leaf sets between trees");
+}
+
+/******************************************************************************/
+
+void BipartitionCounter::addTree(const Tree& tree)
+{
+  if (!bipartitions_)
+    init_(tree);
+  checkLeaves_(tree);
+  vector<uint64_t> bits;
+  vector<int> nodeIds;
+  addTree_(tree, nbTrees_, bits, nodeIds);
+}
+
+/******************************************************************************/
+
+void BipartitionCounter::addTree_(const Tree& tree, size_t position, vector<uint64_t>& bits, vector<int>& nodeIds)
+{
+  bipartitions_->getTreeBipartitions(tree, bits, nodeIds);
+  size_t nbWords = bipartitions_->getNumberOfWords();
+  for (size_t i = 0; i < nodeIds.size(); i++)
+  {
+    size_t pos = bipartitions_->add(&bits[i * nbWords]);
+    if (pos >= lastOccurrences_.size())
+      lastOccurrences_.resize(pos + 1);
+    lastOccurrences_[pos] = pair<size_t, size_t>(position, i);
+  }
+  nbTrees_++;
+}
+
+/******************************************************************************/
+
+void BipartitionCounter::addTrees(const vector<Tree*>& trees)
+{
+  if (trees.size() == 0)
+    return;
+  if (!bipartitions_)
+    init_(*trees[0]);
+
+  size_t first = nbTrees_;
+  vector<string> errors(trees.size());
+  long nbTrees = static_cast<long>(trees.size());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    // Each thread counts its trees separately:
+    BipartitionCounter local(bipartitions_->getElementNames(), checkNames_);
+    vector<uint64_t> bits;
+    vector<int> nodeIds;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (long li = 0; li < nbTrees; ++li)
+    {
+      size_t i = static_cast<size_t>(li);
+      try
+      {
+        checkLeaves_(*trees[i]);
+        local.addTree_(*trees[i], first + i, bits, nodeIds);
+      }
+      catch (exception& e)
+      {
+        errors[i] = e.what();
+      }
+    }
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+    merge_(local);
+  }
+  for (size_t i = 0; i < errors.size(); i++)
+  {
+    if (!errors[i].empty())
+      throw Exception(errors[i]);
+  }
+}
+
+/******************************************************************************/
+
+void BipartitionCounter::addTrees(ITreeStream& trees, size_t batchSize)
+{
+  if (batchSize == 0)
+    throw Exception("BipartitionCounter::addTrees. The batch size must be positive.");
+  vector<Tree*> batch;
+  bool end = false;
+  while (!end)
+  {
+    try
+    {
+      end = (trees.nextTrees(batch, batchSize) < batchSize);
+      addTrees(batch);
+    }
+    catch (...)
+    {
+      for (size_t i = 0; i < batch.size(); i++)
+      {
+        delete batch[i];
+      }
+      throw;
+    }
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+      delete batch[i];
+    }
+    batch.clear();
+  }
+}
+
+/******************************************************************************/
+
+void BipartitionCounter::merge_(const BipartitionCounter& counter)
+{
+  const BipartitionSet& bipS = *counter.bipartitions_;
+  for (size_t i = 0; i < bipS.getNumberOfBipartitions(); i++)
+  {
+    size_t pos = bipartitions_->add(bipS.getBipartition(i), bipS.getCount(i));
+    if (pos >= lastOccurrences_.size())
+      lastOccurrences_.resize(pos + 1);
+    lastOccurrences_[pos] = std::max(lastOccurrences_[pos], counter.lastOccurrences_[i]);
+  }
+  nbTrees_ += counter.nbTrees_;
+}
+
+/******************************************************************************/
+
+const BipartitionSet& BipartitionCounter::getBipartitionSet() const
+{
+  if (nbTrees_ == 0)
+    throw Exception("BipartitionCounter::getBipartitionSet. No tree passed");
+  return *bipartitions_;
+}
+
+/******************************************************************************/
+
+vector<size_t> BipartitionCounter::getOrder() const
+{
+  vector< pair< pair<size_t, size_t>, size_t > > order(lastOccurrences_.size());
+  for (size_t i = 0; i < order.size(); i++)
+  {
+    order[i] = make_pair(lastOccurrences_[i], i);
+  }
+  std::sort(order.begin(), order.end());
+  vector<size_t> indices(order.size());
+  for (size_t i = 0; i < order.size(); i++)
+  {
+    indices[i] = order[i].second;
+  }
+  return indices;
+}
+
+/******************************************************************************/
+
+BipartitionList* BipartitionCounter::getBipartitions(vector<size_t>& bipScore) const
+{
+  const BipartitionSet& bipS = getBipartitionSet();
+  vector<size_t> indices = getOrder();
+  bipScore.resize(indices.size());
+  for (size_t i = 0; i < indices.size(); i++)
+  {
+    bipScore[i] = bipS.getCount(indices[i]);
+  }
+  BipartitionList* bipL = bipS.toBipartitionList(indices);
+
+  /* add terminal branches */
+  bipL->addTrivialBipartitions(false);
+  for (size_t i = 0; i < bipL->getNumberOfElements(); i++)
+  {
+    bipScore.push_back(nbTrees_);
+  }
+  return bipL;
+}
+
+/******************************************************************************/
+
+TreeTemplate<Node>* BipartitionCounter::getConsensus(double threshold) const
+{
+  const BipartitionSet& bipS = getBipartitionSet();
+
+  // Bipartitions are considered in decreasing score order, and from the last
+  // to the first occurrence for equal scores:
+  vector<size_t> indices = getOrder();
+  vector< pair<size_t, size_t> > candidates; // (score, rank in the order of occurrence)
+  double score;
+  for (size_t i = 0; i < indices.size(); i++)
+  {
+    score = static_cast<double>(bipS.getCount(indices[i])) / static_cast<double>(nbTrees_);
+    if (score <= threshold && score != 1.)
+      continue;
+    candidates.push_back(make_pair(bipS.getCount(indices[i]), i));
+  }
+  std::sort(candidates.begin(), candidates.end());
+
+  // Bipartitions found in more than half of the trees are all compatible,
+  // the other ones are compared with the bipartitions kept so far:
+  vector<size_t> kept;
+  for (size_t i = candidates.size(); i > 0; i--)
+  {
+    size_t index = indices[candidates[i - 1].second];
+    score = static_cast<double>(candidates[i - 1].first) / static_cast<double>(nbTrees_);
+    bool compatible = true;
+    if (score <= 0.5)
+    {
+      for (size_t j = 0; compatible && j < kept.size(); j++)
+      {
+        compatible = bipS.areCompatible(index, indices[kept[j]]);
+      }
+    }
+    if (compatible)
+      kept.push_back(candidates[i - 1].second);
+  }
+
+  /* restore the original order, and add terminal branches */
+  std::sort(kept.begin(), kept.end());
+  for (size_t i = 0; i < kept.size(); i++)
+  {
+    kept[i] = indices[kept[i]];
+  }
+  BipartitionList* bipL = bipS.toBipartitionList(kept);
+  bipL->addTrivialBipartitions(false);
+  TreeTemplate<Node>* tr;
+  try
+  {
+    tr = bipL->toTree();
+  }
+  catch (...)
+  {
+    delete bipL;
+    throw;
+  }
+  delete bipL;
+  return tr;
+}
+
+/******************************************************************************/
+
+void BipartitionCounter::setBootstrapValues(Tree& tree, bool verbose, int format) const
+{
+  const BipartitionSet& bipS = getBipartitionSet();
+  vector<uint64_t> bits;
+  vector<int> index;
+  bipS.getTreeBipartitions(tree, bits, index, true);
+  size_t nbWords = bipS.getNumberOfWords();
+
+  for (size_t i = 0; i < index.size(); i++)
+  {
+    if (verbose)
+      ApplicationTools::displayGauge(i, index.size() - 1, '=');
+    if (tree.isLeaf(index[i]))
+      continue;
+    const uint64_t* bip = &bits[i * nbWords];
+    size_t count;
+    if (bipS.getPartitionSize(bip) == 1)
+      count = nbTrees_; // Trivial bipartitions are found in all trees.
+    else
+    {
+      size_t j = bipS.find(bip);
+      count = (j == BipartitionSet::NOT_FOUND ? 0 : bipS.getCount(j));
+    }
+    Number<double> bootstrapValue(format >= 0 ? round(static_cast<double>(count) * pow(10., 2 + format) / static_cast<double>(nbTrees_)) / pow(10., format) : static_cast<double>(count));
+    tree.setBranchProperty(index[i], TreeTools::BOOTSTRAP, bootstrapValue);
+  }
+}
+
+/******************************************************************************/
+
@@ -0,0 +1,191 @@
+//
+// File: BipartitionCounter.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _BIPARTITIONCOUNTER_H_
+#define _BIPARTITIONCOUNTER_H_
+
+#include "BipartitionSet.h"
+#include "BipartitionList.h"
+#include "TreeTemplate.h"
+
+// From the STL:
+#include <string>
+#include <vector>
+
+namespace bpp
+{
+
+class ITreeStream;
+
+/**
+ * @brief Count the occurrences of the distinct bipartitions of a collection of trees.
+ *
+ * Trees are added one at a time, or by batches, and only one copy of each
+ * distinct non-trivial bipartition is kept in memory, with its number of
+ * occurrences, in a BipartitionSet. The memory used therefore depends on the
+ * number of distinct bipartitions only, and not on the number of trees.
+ *
+ * When trees are added by batches and OpenMP is enabled, each thread counts
+ * the bipartitions of its own trees in a private accumulator, and the
+ * accumulators are merged at the end of the batch. Results do not depend on
+ * the number of threads: the order of the bipartitions is defined by their
+ * last occurrence in the sequence of trees.
+ *
+ * Once all trees are counted, several consensus trees can be built, and
+ * bootstrap values can be set on any tree with the same leaves, without
+ * reading the trees again.
+ *
+ * @see TreeTools::thresholdConsensus, TreeTools::computeBootstrapValues
+ */
+class BipartitionCounter
+{
+  private:
+    BipartitionSet* bipartitions_;
+    // Position (tree, bipartition in the tree) of the last occurrence of each distinct bipartition:
+    std::vector< std::pair<size_t, size_t> > lastOccurrences_;
+    size_t nbTrees_;
+    bool checkNames_;
+
+  public:
+    /**
+     * @param checkNames Tell if the leaf names of each tree should be compared to those of the first tree.
+     */
+    BipartitionCounter(bool checkNames = true);
+
+    virtual ~BipartitionCounter() { delete bipartitions_; }
+
+  private:
+    BipartitionCounter(const std::vector<std::string>& elements, bool checkNames);
+    BipartitionCounter(const BipartitionCounter& counter);
+    BipartitionCounter& operator=(const BipartitionCounter& counter);
+
+  public:
+    size_t getNumberOfTrees() const { return nbTrees_; }
+
+    /**
+     * @brief Count the bipartitions of one tree.
+     *
+     * @param tree The tree, whose leaves must be the same as those of the previous trees.
+     * @throw Exception If the tree does not have the same leaves as the previous ones.
+     */
+    void addTree(const Tree& tree);
+
+    /**
+     * @brief Count the bipartitions of several trees, in parallel if OpenMP is enabled.
+     *
+     * @param trees The trees, whose leaves must be the same as those of the previous trees.
+     * @throw Exception If a tree does not have the same leaves as the previous ones.
+     */
+    void addTrees(const std::vector<Tree*>& trees);
+
+    /**
+     * @brief Count the bipartitions of all remaining trees of a stream.
+     *
+     * Trees are read by batches, which are processed as with addTrees, and
+     * deleted before the next batch is read.
+     *
+     * @param trees The stream of trees.
+     * @param batchSize The maximum number of trees in memory.
+     * @throw Exception If a tree does not have the same leaves as the previous ones, or cannot be read.
+     */
+    void addTrees(ITreeStream& trees, size_t batchSize = 256);
+
+    /**
+     * @return The distinct non-trivial bipartitions found so far, with their number of occurrences.
+     * @throw Exception If no tree was counted.
+     */
+    const BipartitionSet& getBipartitionSet() const;
+
+    /**
+     * @return The indices of the distinct bipartitions in the set, sorted according to their last occurrence.
+     */
+    std::vector<size_t> getOrder() const;
+
+    /**
+     * @brief Get all distinct bipartitions, with their number of occurrences.
+     *
+     * Distinct bipartitions are sorted according to their last occurrence,
+     * and followed by the trivial bipartitions.
+     *
+     * @param bipScore [out] The number of occurrences of each bipartition.
+     * @return A new BipartitionList.
+     * @see TreeTools::bipartitionOccurrences
+     */
+    BipartitionList* getBipartitions(std::vector<size_t>& bipScore) const;
+
+    /**
+     * @brief General greedy consensus tree of the counted trees.
+     *
+     * Bipartitions are considered in decreasing number of occurrences, the
+     * last occurring first for equal numbers, and a bipartition is kept if it
+     * is compatible with all the bipartitions kept before it.
+     *
+     * @param threshold Minimum support for a bipartition to be included in the consensus tree.
+     * @return A new tree.
+     * @see TreeTools::thresholdConsensus
+     */
+    TreeTemplate<Node>* getConsensus(double threshold) const;
+
+    /**
+     * @brief Set the bootstrap values of a tree, from the counted trees.
+     *
+     * @param tree The tree to annotate, with the same leaves as the counted trees.
+     * @param verbose Tell if a progress bar should be displayed.
+     * @param format The number of decimals of the percentages (a negative value gives the number of occurrences instead).
+     * @see TreeTools::computeBootstrapValues
+     */
+    void setBootstrapValues(Tree& tree, bool verbose = true, int format = 0) const;
+
+  private:
+    /**
+     * @brief Count the bipartitions of a tree, with its position in the sequence of trees.
+     */
+    void addTree_(const Tree& tree, size_t position, std::vector<uint64_t>& bits, std::vector<int>& nodeIds);
+
+    void checkLeaves_(const Tree& tree) const;
+
+    void init_(const Tree& tree);
+
+    void merge_(const BipartitionCounter& counter);
+};
+
+} //end of namespace bpp.
+
+#endif //_BIPARTITIONCOUNTER_H_
+
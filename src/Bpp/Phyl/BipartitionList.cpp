@@ -39,6 +39,7 @@
 
 #include "BipartitionList.h"
 #include "BipartitionTools.h"
+#include "BipartitionSet.h"
 
 #include "TreeTemplate.h"
 
@@ -438,11 +439,13 @@ bool BipartitionList::areCompatible(size_t k1, size_t k2) const
 
 bool BipartitionList::areAllCompatible() const
 {
-  for (size_t i = 0; i < bitBipartitionList_.size(); i++)
+  // Identical bipartitions are compatible, so that only distinct ones are compared:
+  BipartitionSet bipS(*this);
+  for (size_t i = 0; i < bipS.getNumberOfBipartitions(); i++)
   {
-    for (size_t j = i + 1; j < bitBipartitionList_.size(); j++)
+    for (size_t j = i + 1; j < bipS.getNumberOfBipartitions(); j++)
     {
-      if (!BipartitionList::areCompatible(i, j))
+      if (!bipS.areCompatible(i, j))
         return false;
     }
   }
@@ -615,6 +618,11 @@ void BipartitionList::flip(size_t k)
     flipbip[i] = 0;
   }
   BipartitionTools::bitNot(flipbip, bitBipartitionList_[k], nbint);
+  // Unused bits of the last word are kept unset, so that bipartitions can be compared word by word:
+  for (size_t i = elements_.size(); i < nbint * lword; i++)
+  {
+    BipartitionTools::bit0(flipbip, static_cast<int>(i));
+  }
   delete[] bitBipartitionList_[k];
   bitBipartitionList_[k] = flipbip;
 }
@@ -661,14 +669,9 @@ TreeTemplate<Node>* BipartitionList::toTree() const
   if (!BipartitionList::areAllCompatible())
     throw Exception("Trying to build a tree from incompatible bipartitions");
 
-  sortedBipL = dynamic_cast<BipartitionList*>(clone());
-  for (size_t i = 0; i < sortedBipL->getNumberOfBipartitions(); i++)
-  {
-    if (sortedBipL->getPartitionSize(i) > sortedBipL->getNumberOfElements() / 2)
-      sortedBipL->flip(i);
-  }
+  // Distinct bipartitions, with their smallest partition coded with ones:
+  sortedBipL = BipartitionSet(*this).toBipartitionList();
   sortedBipL->sortByPartitionSize();
-  sortedBipL->removeRedundantBipartitions();
   sortedBitBipL = sortedBipL->getBitBipartitionList();
 
   for (size_t i = 0; i < sortedBipL->getNumberOfBipartitions(); i++)
@@ -734,6 +737,7 @@ TreeTemplate<Node>* BipartitionList::toTree() const
   /* construct tree and return */
   TreeTemplate<Node>* tr = new TreeTemplate<Node>(rootNd);
   tr->resetNodesId();
+  delete[] bip;
   delete sortedBipL;
   return tr;
 }
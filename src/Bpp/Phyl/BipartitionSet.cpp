@@ -0,0 +1,418 @@
+//
+// File: BipartitionSet.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include "BipartitionSet.h"
+#include "BipartitionList.h"
+#include "BipartitionTools.h"
+#include "TreeTemplate.h"
+#include "TreeTraversal.h"
+
+#include <Bpp/Exceptions.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <algorithm>
+#include <climits> // defines CHAR_BIT
+
+using namespace std;
+
+/******************************************************************************/
+
+const size_t BipartitionSet::NOT_FOUND = static_cast<size_t>(-1);
+
+/******************************************************************************/
+
+BipartitionSet::BipartitionSet(const std::vector<std::string>& elements) :
+  elements_(elements),
+  elementIndex_(),
+  nbWords_(0),
+  lastWordMask_(0),
+  words_(),
+  hashes_(),
+  counts_(),
+  firstWithHash_(),
+  nextWithHash_(),
+  totalCount_(0)
+{
+  init_();
+}
+
+/******************************************************************************/
+
+BipartitionSet::BipartitionSet(const Tree& tree, bool trivial) :
+  elements_(tree.getLeavesNames()),
+  elementIndex_(),
+  nbWords_(0),
+  lastWordMask_(0),
+  words_(),
+  hashes_(),
+  counts_(),
+  firstWithHash_(),
+  nextWithHash_(),
+  totalCount_(0)
+{
+  std::sort(elements_.begin(), elements_.end());
+  init_();
+  addTree(tree, trivial);
+}
+
+/******************************************************************************/
+
+BipartitionSet::BipartitionSet(const BipartitionList& bipL) :
+  elements_(bipL.getElementNames()),
+  elementIndex_(),
+  nbWords_(0),
+  lastWordMask_(0),
+  words_(),
+  hashes_(),
+  counts_(),
+  firstWithHash_(),
+  nextWithHash_(),
+  totalCount_(0)
+{
+  init_();
+  vector<size_t> positions(elements_.size());
+  for (size_t i = 0; i < positions.size(); i++)
+  {
+    positions[i] = i;
+  }
+  const vector<int*>& bitBipL = bipL.getBitBipartitionList();
+  vector<uint64_t> bits(nbWords_);
+  for (size_t i = 0; i < bitBipL.size(); i++)
+  {
+    importBipartition(bitBipL[i], positions, &bits[0]);
+    add(&bits[0]);
+  }
+}
+
+/******************************************************************************/
+
+void BipartitionSet::init_()
+{
+  nbWords_ = (elements_.size() + 63) / 64;
+  size_t nbLastBits = elements_.size() % 64;
+  lastWordMask_ = nbLastBits == 0 ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << nbLastBits) - 1;
+  elementIndex_.reserve(elements_.size());
+  for (size_t i = 0; i < elements_.size(); i++)
+  {
+    if (!elementIndex_.insert(make_pair(elements_[i], i)).second)
+      throw Exception("BipartitionSet. Duplicated element name: " + elements_[i]);
+  }
+}
+
+/******************************************************************************/
+
+uint64_t BipartitionSet::hash(const uint64_t* bits, size_t nbWords)
+{
+  // Words are combined with a cheap multiplicative step, and the result is mixed with the 'splitmix64' finalizer:
+  uint64_t h = static_cast<uint64_t>(nbWords);
+  for (size_t i = 0; i < nbWords; i++)
+  {
+    h = (h ^ bits[i]) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 32;
+  }
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+/******************************************************************************/
+
+bool BipartitionSet::areCompatible(const uint64_t* bits1, const uint64_t* bits2, size_t nbWords)
+{
+  bool disjoint = true, in1 = true, in2 = true;
+  for (size_t i = 0; i < nbWords && (disjoint || in1 || in2); i++)
+  {
+    if (bits1[i] & bits2[i]) disjoint = false;
+    if (bits1[i] & ~bits2[i]) in2 = false;
+    if (bits2[i] & ~bits1[i]) in1 = false;
+  }
+  return disjoint || in1 || in2;
+}
+
+/******************************************************************************/
+
+size_t BipartitionSet::getPartitionSize(const uint64_t* bits) const
+{
+  size_t size = 0;
+  for (size_t i = 0; i < nbWords_; i++)
+  {
+    size += popcount(bits[i]);
+  }
+  return std::min(size, elements_.size() - size);
+}
+
+/******************************************************************************/
+
+void BipartitionSet::canonicalize(uint64_t* bits) const
+{
+  if (nbWords_ == 0)
+    return;
+  if (bits[0] & 1)
+  {
+    for (size_t i = 0; i < nbWords_; i++)
+    {
+      bits[i] = ~bits[i];
+    }
+  }
+  bits[nbWords_ - 1] &= lastWordMask_;
+}
+
+/******************************************************************************/
+
+size_t BipartitionSet::find(const uint64_t* bits, uint64_t hash) const
+{
+  unordered_map<uint64_t, size_t>::const_iterator it = firstWithHash_.find(hash);
+  if (it == firstWithHash_.end())
+    return NOT_FOUND;
+  for (size_t i = it->second; i != NOT_FOUND; i = nextWithHash_[i])
+  {
+    if (std::equal(bits, bits + nbWords_, words_.begin() + static_cast<ptrdiff_t>(i * nbWords_)))
+      return i;
+  }
+  return NOT_FOUND;
+}
+
+/******************************************************************************/
+
+size_t BipartitionSet::add(const uint64_t* bits, size_t count)
+{
+  uint64_t h = hash(bits, nbWords_);
+  size_t i = find(bits, h);
+  if (i == NOT_FOUND)
+  {
+    i = counts_.size();
+    words_.insert(words_.end(), bits, bits + nbWords_);
+    hashes_.push_back(h);
+    counts_.push_back(0);
+    // New bipartitions are put first in the chain of their hash value:
+    unordered_map<uint64_t, size_t>::iterator it = firstWithHash_.find(h);
+    if (it == firstWithHash_.end())
+    {
+      nextWithHash_.push_back(NOT_FOUND);
+      firstWithHash_[h] = i;
+    }
+    else
+    {
+      nextWithHash_.push_back(it->second);
+      it->second = i;
+    }
+  }
+  counts_[i] += count;
+  totalCount_ += count;
+  return i;
+}
+
+/******************************************************************************/
+
+void BipartitionSet::addTree(const Tree& tree, bool trivial)
+{
+  vector<uint64_t> bits;
+  vector<int> nodeIds;
+  getTreeBipartitions(tree, bits, nodeIds, trivial);
+  for (size_t i = 0; i < nodeIds.size(); i++)
+  {
+    add(&bits[i * nbWords_]);
+  }
+}
+
+/******************************************************************************/
+
+void BipartitionSet::getTreeBipartitions(const Tree& tree, vector<uint64_t>& bits, vector<int>& nodeIds, bool trivial) const
+{
+  bits.clear();
+  nodeIds.clear();
+  const TreeTemplate<Node>* ttree = dynamic_cast<const TreeTemplate<Node>*>(&tree);
+  TreeTemplate<Node>* tmp = 0;
+  if (!ttree)
+  {
+    tmp = new TreeTemplate<Node>(tree);
+    ttree = tmp;
+  }
+
+  const Node* root = ttree->getRootNode();
+  TreeTraversal<const Node> traversal(root, BasicTreeTraversal::POSTORDER);
+
+  // The leaves under each node visited so far, and not yet merged with their father:
+  vector<uint64_t> stack;
+  stack.reserve(nbWords_ * traversal.size());
+  for (size_t k = 0; k < traversal.size(); k++)
+  {
+    const Node* node = traversal[k];
+    size_t nbSons = node->getNumberOfSons();
+    if (nbSons == 0)
+    {
+      unordered_map<string, size_t>::const_iterator it = elementIndex_.find(node->getName());
+      if (it == elementIndex_.end())
+      {
+        if (tmp) delete tmp;
+        throw Exception("BipartitionSet::getTreeBipartitions. Leaf name is not in the set: " + node->getName());
+      }
+      stack.resize(stack.size() + nbWords_, 0);
+      stack[stack.size() - nbWords_ + it->second / 64] |= static_cast<uint64_t>(1) << (it->second % 64);
+    }
+    else
+    {
+      // Sons are the last entries of the stack:
+      size_t first = stack.size() - nbSons * nbWords_;
+      for (size_t s = 1; s < nbSons; s++)
+      {
+        for (size_t i = 0; i < nbWords_; i++)
+        {
+          stack[first + i] |= stack[first + s * nbWords_ + i];
+        }
+      }
+      stack.resize(first + nbWords_);
+    }
+
+    if (node == root)
+      continue;
+    if (node->getFather() == root && root->getNumberOfSons() == 2 && node == root->getSon(1))
+      continue;
+    const uint64_t* under = &stack[stack.size() - nbWords_];
+    if (!trivial && getPartitionSize(under) < 2)
+      continue;
+    bits.insert(bits.end(), under, under + nbWords_);
+    canonicalize(&bits[bits.size() - nbWords_]);
+    nodeIds.push_back(node->getId());
+  }
+
+  if (tmp) delete tmp;
+}
+
+/******************************************************************************/
+
+vector<size_t> BipartitionSet::getElementPositions(const vector<string>& names) const
+{
+  vector<size_t> positions(names.size());
+  for (size_t i = 0; i < names.size(); i++)
+  {
+    unordered_map<string, size_t>::const_iterator it = elementIndex_.find(names[i]);
+    if (it == elementIndex_.end())
+      throw Exception("BipartitionSet::getElementPositions. Element is not in the set: " + names[i]);
+    positions[i] = it->second;
+  }
+  return positions;
+}
+
+/******************************************************************************/
+
+void BipartitionSet::importBipartition(const int* bitBip, const vector<size_t>& positions, uint64_t* bits) const
+{
+  std::fill(bits, bits + nbWords_, 0);
+  size_t lword = static_cast<size_t>(BipartitionTools::LWORD);
+  for (size_t k = 0; k < positions.size(); k++)
+  {
+    if ((static_cast<unsigned int>(bitBip[k / lword]) >> (k % lword)) & 1)
+      bits[positions[k] / 64] |= static_cast<uint64_t>(1) << (positions[k] % 64);
+  }
+  canonicalize(bits);
+}
+
+/******************************************************************************/
+
+BipartitionList* BipartitionSet::toBipartitionList_(const vector<const uint64_t*>& bits) const
+{
+  size_t lword  = static_cast<size_t>(BipartitionTools::LWORD);
+  size_t nbword = (elements_.size() + lword - 1) / lword;
+  size_t nbint  = nbword * lword / (CHAR_BIT * sizeof(int));
+
+  vector<int> ints(bits.size() * nbint, 0);
+  vector<int*> bitBipL(bits.size());
+  for (size_t i = 0; i < bits.size(); i++)
+  {
+    // As in BipartitionList, the smallest partition is coded with ones:
+    size_t size = 0;
+    for (size_t w = 0; w < nbWords_; w++)
+    {
+      size += popcount(bits[i][w]);
+    }
+    bool ones = (size <= elements_.size() / 2);
+    bitBipL[i] = &ints[i * nbint];
+    for (size_t k = 0; k < elements_.size(); k++)
+    {
+      if ((((bits[i][k / 64] >> (k % 64)) & 1) != 0) == ones)
+        BipartitionTools::bit1(bitBipL[i], static_cast<int>(k));
+    }
+  }
+  // The list makes its own copy of the bipartitions:
+  return new BipartitionList(elements_, bitBipL);
+}
+
+/******************************************************************************/
+
+BipartitionList* BipartitionSet::toBipartitionList() const
+{
+  vector<const uint64_t*> bits(counts_.size());
+  for (size_t i = 0; i < bits.size(); i++)
+  {
+    bits[i] = getBipartition(i);
+  }
+  return toBipartitionList_(bits);
+}
+
+/******************************************************************************/
+
+BipartitionList* BipartitionSet::toBipartitionList(const vector<size_t>& indices) const
+{
+  vector<const uint64_t*> bits(indices.size());
+  for (size_t i = 0; i < bits.size(); i++)
+  {
+    if (indices[i] >= counts_.size())
+      throw IndexOutOfBoundsException("BipartitionSet::toBipartitionList.", indices[i], 0, counts_.size() - 1);
+    bits[i] = getBipartition(indices[i]);
+  }
+  return toBipartitionList_(bits);
+}
+
+/******************************************************************************/
+
+BipartitionList* BipartitionSet::toBipartitionList(const uint64_t* bits, size_t nbBipartitions) const
+{
+  vector<const uint64_t*> bitBipL(nbBipartitions);
+  for (size_t i = 0; i < nbBipartitions; i++)
+  {
+    bitBipL[i] = bits + i * nbWords_;
+  }
+  return toBipartitionList_(bitBipL);
+}
+
+/******************************************************************************/
+
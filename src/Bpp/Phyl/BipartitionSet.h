@@ -0,0 +1,311 @@
+//
+// File: BipartitionSet.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _BIPARTITIONSET_H_
+#define _BIPARTITIONSET_H_
+
+#include "Tree.h"
+
+#include <Bpp/Clonable.h>
+
+// From the STL:
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace bpp
+{
+
+class BipartitionList;
+
+/**
+ * @brief A set of distinct bipartitions, stored as packed 64 bits words.
+ *
+ * Bipartitions are stored in a single contiguous pool of 64 bits words, with
+ * one bit per element, as in BipartitionList. Each bipartition is kept in a
+ * canonical orientation, in which the bit of the first element is unset. Two
+ * bipartitions are then identical if and only if their words are equal, and
+ * the size of a bipartition is obtained by counting bits.
+ *
+ * Each bipartition is associated to a 64 bits hash of its words, and
+ * bipartitions are indexed by hash. Bipartitions with equal hashes are
+ * compared word by word, so that hash collisions never merge distinct
+ * bipartitions. Looking for a bipartition therefore takes a time proportional
+ * to the number of words, whatever the size of the set.
+ *
+ * Each distinct bipartition is stored only once, with its number of
+ * occurrences. Bipartitions are numbered according to their first occurrence.
+ *
+ * @see BipartitionList
+ */
+class BipartitionSet:
+  public virtual Clonable
+{
+  private:
+    std::vector<std::string> elements_;
+    std::unordered_map<std::string, size_t> elementIndex_;
+    size_t nbWords_;
+    uint64_t lastWordMask_;
+    std::vector<uint64_t> words_;
+    std::vector<uint64_t> hashes_;
+    std::vector<size_t> counts_;
+    std::unordered_map<uint64_t, size_t> firstWithHash_;
+    std::vector<size_t> nextWithHash_;
+    size_t totalCount_;
+
+  public:
+    /**
+     * @brief Value returned by find() when a bipartition is not in the set.
+     */
+    static const size_t NOT_FOUND;
+
+  public:
+    /**
+     * @brief Build an empty set.
+     *
+     * @param elements The element names. The position of an element in this vector is the position of its bit in bipartitions.
+     * @throw Exception If the element names are not unique.
+     */
+    BipartitionSet(const std::vector<std::string>& elements);
+
+    /**
+     * @brief Build the set of bipartitions of a tree.
+     *
+     * Elements are the leaf names of the tree, in alphabetical order.
+     *
+     * @param tree The tree.
+     * @param trivial Tell if trivial bipartitions (one element versus the others) should be included.
+     */
+    BipartitionSet(const Tree& tree, bool trivial = false);
+
+    /**
+     * @brief Build the set of bipartitions of a BipartitionList.
+     *
+     * Elements are those of the list, in the same order.
+     *
+     * @param bipL The list of bipartitions.
+     */
+    BipartitionSet(const BipartitionList& bipL);
+
+    virtual ~BipartitionSet() {}
+
+    BipartitionSet* clone() const { return new BipartitionSet(*this); }
+
+  public:
+    size_t getNumberOfElements() const { return elements_.size(); }
+
+    const std::vector<std::string>& getElementNames() const { return elements_; }
+
+    /**
+     * @return The number of 64 bits words used by each bipartition.
+     */
+    size_t getNumberOfWords() const { return nbWords_; }
+
+    /**
+     * @return The number of distinct bipartitions in the set.
+     */
+    size_t getNumberOfBipartitions() const { return counts_.size(); }
+
+    /**
+     * @return The total number of bipartitions added to the set, including repeats.
+     */
+    size_t getTotalCount() const { return totalCount_; }
+
+    /**
+     * @return The number of occurrences of bipartition i.
+     */
+    size_t getCount(size_t i) const { return counts_[i]; }
+
+    /**
+     * @return The words of bipartition i, in canonical orientation.
+     */
+    const uint64_t* getBipartition(size_t i) const { return words_.data() + i * nbWords_; }
+
+    uint64_t getHash(size_t i) const { return hashes_[i]; }
+
+    /**
+     * @return The size of the smallest of the two partitions of bipartition i (e.g. 1 for external branches).
+     */
+    size_t getPartitionSize(size_t i) const { return getPartitionSize(getBipartition(i)); }
+
+    /**
+     * @return The size of the smallest of the two partitions of a bipartition of this set's elements.
+     */
+    size_t getPartitionSize(const uint64_t* bits) const;
+
+    /**
+     * @brief Put a bipartition of this set's elements in canonical orientation.
+     *
+     * @param bits The words of the bipartition, which are modified in place.
+     */
+    void canonicalize(uint64_t* bits) const;
+
+    /**
+     * @brief Look for a bipartition.
+     *
+     * @param bits The words of the bipartition, in canonical orientation.
+     * @return The index of the bipartition, or NOT_FOUND.
+     */
+    size_t find(const uint64_t* bits) const { return find(bits, hash(bits, nbWords_)); }
+
+    /**
+     * @brief Look for a bipartition with a known hash.
+     */
+    size_t find(const uint64_t* bits, uint64_t hash) const;
+
+    bool contains(const uint64_t* bits) const { return find(bits) != NOT_FOUND; }
+
+    /**
+     * @brief Add occurrences of a bipartition.
+     *
+     * @param bits The words of the bipartition, in canonical orientation.
+     * @param count The number of occurrences to add.
+     * @return The index of the bipartition.
+     */
+    size_t add(const uint64_t* bits, size_t count = 1);
+
+    /**
+     * @brief Add all bipartitions of a tree.
+     *
+     * There is one bipartition per branch, as in BipartitionList: if the root
+     * has two sons, the branch leading to the second one is skipped, as it
+     * defines the same bipartition as the first one.
+     *
+     * @param tree The tree, whose leaves must be elements of the set.
+     * @param trivial Tell if trivial bipartitions (one element versus the others) should be added.
+     * @throw Exception If a leaf name is not an element of the set.
+     */
+    void addTree(const Tree& tree, bool trivial = false);
+
+    /**
+     * @brief Compute the bipartitions of a tree, without adding them to the set.
+     *
+     * Bipartitions are listed in the same order as in BipartitionList.
+     *
+     * @param tree The tree, whose leaves must be elements of the set.
+     * @param bits [out] The words of all bipartitions, in canonical orientation, one after the other.
+     * @param nodeIds [out] The id of the node below the branch defining each bipartition.
+     * @param trivial Tell if trivial bipartitions should be included.
+     * @throw Exception If a leaf name is not an element of the set.
+     */
+    void getTreeBipartitions(const Tree& tree, std::vector<uint64_t>& bits, std::vector<int>& nodeIds, bool trivial = false) const;
+
+    /**
+     * @return The position in this set of each name.
+     * @throw Exception If a name is not an element of the set.
+     */
+    std::vector<size_t> getElementPositions(const std::vector<std::string>& names) const;
+
+    /**
+     * @brief Convert a bipartition from a BipartitionList.
+     *
+     * @param bitBip A bipartition, as returned by BipartitionList::getBitBipartitionList.
+     * @param positions The position in this set of each element of the list, as returned by getElementPositions.
+     * @param bits [out] The words of the bipartition, in canonical orientation.
+     */
+    void importBipartition(const int* bitBip, const std::vector<size_t>& positions, uint64_t* bits) const;
+
+    /**
+     * @brief Tells whether two bipartitions of the set are compatible.
+     *
+     * @see BipartitionList::areCompatible
+     */
+    bool areCompatible(size_t i, size_t j) const { return areCompatible(getBipartition(i), getBipartition(j), nbWords_); }
+
+    /**
+     * @brief Conversion to BipartitionList.
+     *
+     * As in BipartitionList, the smallest partition of each bipartition is coded with ones.
+     *
+     * @return A BipartitionList with one copy of each distinct bipartition, in the order of the set.
+     */
+    BipartitionList* toBipartitionList() const;
+
+    /**
+     * @return A BipartitionList with the given bipartitions of the set, in the given order.
+     */
+    BipartitionList* toBipartitionList(const std::vector<size_t>& indices) const;
+
+    /**
+     * @param bits The words of the bipartitions, stored one after the other.
+     * @param nbBipartitions The number of bipartitions.
+     * @return A BipartitionList with the given bipartitions of this set's elements.
+     */
+    BipartitionList* toBipartitionList(const uint64_t* bits, size_t nbBipartitions) const;
+
+  public:
+    /**
+     * @return A 64 bits hash of an array of words.
+     */
+    static uint64_t hash(const uint64_t* bits, size_t nbWords);
+
+    /**
+     * @return The number of bits set in a word.
+     */
+    static size_t popcount(uint64_t word)
+    {
+#if defined(__GNUC__)
+      return static_cast<size_t>(__builtin_popcountll(word));
+#else
+      size_t count = 0;
+      for (; word; count++)
+        word &= word - 1;
+      return count;
+#endif
+    }
+
+    /**
+     * @brief Tells whether two bipartitions in canonical orientation are compatible.
+     *
+     * As the first element is on the same side in both bipartitions, they are
+     * compatible if the other sides are disjoint, or if one of them contains the other.
+     */
+    static bool areCompatible(const uint64_t* bits1, const uint64_t* bits2, size_t nbWords);
+
+  private:
+    void init_();
+
+    BipartitionList* toBipartitionList_(const std::vector<const uint64_t*>& bits) const;
+};
+
+} //end of namespace bpp.
+
+#endif //_BIPARTITIONSET_H_
+
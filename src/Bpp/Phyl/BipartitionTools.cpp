@@ -39,6 +39,7 @@
 
 #include "BipartitionList.h"
 #include "BipartitionTools.h"
+#include "BipartitionSet.h"
 #include "TreeTemplate.h"
 
 #include <Bpp/Exceptions.h>
@@ -176,15 +177,47 @@ BipartitionList* BipartitionTools::buildBipartitionPair(
 
 /******************************************************************************/
 
+namespace
+{
+  /**
+   * Convert bipartition i1 of the first list and bipartition i2 of the second
+   * one to packed words, over the elements of the first list.
+   */
+  void importBipartitionPair(
+    const BipartitionList& bipartL1, size_t i1,
+    const BipartitionList& bipartL2, size_t i2,
+    bool checkElements,
+    BipartitionSet& set,
+    vector<uint64_t>& bits1,
+    vector<uint64_t>& bits2)
+  {
+    if (i1 >= bipartL1.getNumberOfBipartitions())
+      throw Exception("Bipartition index exceeds BipartitionList size");
+    if (i2 >= bipartL2.getNumberOfBipartitions())
+      throw Exception("Bipartition index exceeds BipartitionList size");
+
+    if (checkElements && !VectorTools::haveSameElements(bipartL1.getElementNames(), bipartL2.getElementNames()))
+      throw Exception("Distinct bipartition element sets");
+
+    bits1.resize(set.getNumberOfWords());
+    bits2.resize(set.getNumberOfWords());
+    set.importBipartition(bipartL1.getBitBipartitionList()[i1], set.getElementPositions(bipartL1.getElementNames()), &bits1[0]);
+    set.importBipartition(bipartL2.getBitBipartitionList()[i2], set.getElementPositions(bipartL2.getElementNames()), &bits2[0]);
+  }
+}
+
+/******************************************************************************/
+
 bool BipartitionTools::areIdentical(
   const BipartitionList& bipartL1, size_t i1,
   const BipartitionList& bipartL2, size_t i2,
   bool checkElements)
 {
-  BipartitionList* twoBipL = buildBipartitionPair(bipartL1, i1, bipartL2, i2, checkElements);
-  bool test = twoBipL->areIdentical(0, 1);
-  delete twoBipL;
-  return test;
+  BipartitionSet set(bipartL1.getElementNames());
+  vector<uint64_t> bits1, bits2;
+  importBipartitionPair(bipartL1, i1, bipartL2, i2, checkElements, set, bits1, bits2);
+  // Both bipartitions are in canonical orientation:
+  return bits1 == bits2;
 }
 
 /******************************************************************************/
@@ -194,10 +227,10 @@ bool BipartitionTools::areCompatible(
   const BipartitionList& bipartL2, size_t i2,
   bool checkElements)
 {
-  BipartitionList* twoBipL = buildBipartitionPair(bipartL1, i1, bipartL2, i2, checkElements);
-  bool test = twoBipL->areCompatible(0, 1);
-  delete twoBipL;
-  return test;
+  BipartitionSet set(bipartL1.getElementNames());
+  vector<uint64_t> bits1, bits2;
+  importBipartitionPair(bipartL1, i1, bipartL2, i2, checkElements, set, bits1, bits2);
+  return BipartitionSet::areCompatible(&bits1[0], &bits2[0], set.getNumberOfWords());
 }
 
 /******************************************************************************/
@@ -206,11 +239,6 @@ BipartitionList* BipartitionTools::mergeBipartitionLists(
   const vector<BipartitionList*>& vecBipartL,
   bool checkElements)
 {
-  vector<string> elements;
-  vector<int*> mergedBitBipL;
-  int* provBitBip;
-  BipartitionList* mergedBipL;
-
   if (vecBipartL.size() == 0)
     throw Exception("Empty vector passed");
 
@@ -218,47 +246,33 @@ BipartitionList* BipartitionTools::mergeBipartitionLists(
   {
     for (size_t i = 1; i < vecBipartL.size(); ++i)
     {
-      if (!VectorTools::haveSameElements(vecBipartL[0]->getElementNames(), vecBipartL[0]->getElementNames()))
+      if (!VectorTools::haveSameElements(vecBipartL[0]->getElementNames(), vecBipartL[i]->getElementNames()))
         throw Exception("BipartitionTools::mergeBipartitionLists. Distinct bipartition element sets");
     }
   }
 
-  size_t lword  = static_cast<size_t>(BipartitionTools::LWORD);
-  size_t nbword = (vecBipartL[0]->getElementNames().size() + lword - 1) / lword;
-  size_t nbint  = nbword * lword / (CHAR_BIT * sizeof(int));
-
-  elements = vecBipartL[0]->getElementNames();
+  vector<string> elements = vecBipartL[0]->getElementNames();
   if (!vecBipartL[0]->isSorted())
     std::sort(elements.begin(), elements.end());
+  BipartitionSet set(elements);
 
+  // All bipartitions are converted to the sorted elements, without copying the lists:
+  size_t nbWords = set.getNumberOfWords();
+  vector<uint64_t> mergedBits;
+  size_t nbBipartitions = 0;
   for (size_t i = 0; i < vecBipartL.size(); i++)
   {
-    vector<int*> bitBipL;
-    if (vecBipartL[i]->isSorted())
-    {
-      bitBipL = vecBipartL[i]->getBitBipartitionList();
-    }
-    else
-    {
-      // We don't need the extra recopy here, do we?
-      // BipartitionList provBipartL(BipartitionList(vecBipartL[i]->getElementNames(), vecBipartL[i]->getBitBipartitionList()));
-      BipartitionList provBipartL(vecBipartL[i]->getElementNames(), vecBipartL[i]->getBitBipartitionList());
-      provBipartL.sortElements();
-      bitBipL = provBipartL.getBitBipartitionList();
-    }
+    vector<size_t> positions = set.getElementPositions(vecBipartL[i]->getElementNames());
+    const vector<int*>& bitBipL = vecBipartL[i]->getBitBipartitionList();
+    mergedBits.resize((nbBipartitions + bitBipL.size()) * nbWords);
     for (size_t j = 0; j < bitBipL.size(); j++)
     {
-      provBitBip = new int[nbint];
-      for (size_t k = 0; k < nbint; k++)
-      {
-        provBitBip[k] = bitBipL[j][k];
-      }
-      mergedBitBipL.push_back(provBitBip);
+      set.importBipartition(bitBipL[j], positions, &mergedBits[nbBipartitions * nbWords]);
+      nbBipartitions++;
     }
   }
 
-  mergedBipL = new BipartitionList(elements, mergedBitBipL);
-  return mergedBipL;
+  return set.toBipartitionList(mergedBits.data(), nbBipartitions);
 }
 
 /******************************************************************************/
@@ -47,6 +47,7 @@ using namespace bpp;
 
 // From the STL:
 #include <iostream>
+#include <algorithm>
 
 using namespace std;
 
@@ -59,8 +60,32 @@ void AbstractAgglomerativeDistanceMethod::setDistanceMatrix(const DistanceMatrix
   if (tree_) delete tree_;
 }
     
+void AbstractAgglomerativeDistanceMethod::setCondensedDistanceMatrix(const CondensedDistanceMatrix& matrix)
+{
+  if (matrix.size() <= 3)
+    throw Exception("AbstractAgglomerativeDistanceMethod::setCondensedDistanceMatrix(): matrix must be at least of dimension 3.");
+  matrix_ = DistanceMatrix(0);
+  compactMatrix_ = matrix;
+  currentNodes_.clear();
+  if (tree_) delete tree_;
+  tree_ = 0;
+}
+
+void AbstractAgglomerativeDistanceMethod::useFullMatrix()
+{
+  if (matrix_.size() == 0 && compactMatrix_.size() > 0)
+  {
+    DistanceMatrix* dist = compactMatrix_.toDistanceMatrix();
+    matrix_ = *dist;
+    delete dist;
+    compactMatrix_ = CondensedDistanceMatrix();
+  }
+}
+
 void AbstractAgglomerativeDistanceMethod::computeTree()
 {
+  useFullMatrix();
+
   // Initialization:
   for (size_t i = 0; i < matrix_.size(); ++i)
   {
@@ -121,3 +146,210 @@ Node* AbstractAgglomerativeDistanceMethod::getParentNode(int id, Node* son1, Nod
   return parent;
 }
 
+
+void AbstractAgglomerativeDistanceMethod::initCompactEngine()
+{
+  // If the matrix was given in condensed form, it is used directly:
+  if (matrix_.size() > 0)
+    compactMatrix_ = CondensedDistanceMatrix(matrix_);
+  size_t n = compactMatrix_.size();
+  compactNodes_.resize(n);
+  compactKeys_.resize(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    compactNodes_[i] = getLeafNode(static_cast<int>(i), compactMatrix_.getName(i));
+    compactKeys_[i] = i;
+  }
+  currentNodes_.clear();
+}
+
+size_t AbstractAgglomerativeDistanceMethod::removeCompactEntry(size_t pos)
+{
+  size_t last = compactMatrix_.removeEntry(pos);
+  compactNodes_[pos] = compactNodes_[last];
+  compactKeys_[pos] = compactKeys_[last];
+  compactNodes_.pop_back();
+  compactKeys_.pop_back();
+  return last;
+}
+
+void AbstractAgglomerativeDistanceMethod::compactFinalStep(int idRoot)
+{
+  // Sort the remaining entries according to their keys:
+  map<size_t, size_t> order;
+  for (size_t i = 0; i < compactKeys_.size(); ++i)
+  {
+    order[compactKeys_[i]] = i;
+  }
+  vector<size_t> pos;
+  for (map<size_t, size_t>::iterator it = order.begin(); it != order.end(); ++it)
+  {
+    pos.push_back(it->second);
+  }
+  matrix_ = DistanceMatrix(pos.size());
+  currentNodes_.clear();
+  for (size_t i = 0; i < pos.size(); ++i)
+  {
+    currentNodes_[i] = compactNodes_[pos[i]];
+    for (size_t j = 0; j < pos.size(); ++j)
+    {
+      matrix_(i, j) = compactMatrix_(pos[i], pos[j]);
+    }
+  }
+  compactMatrix_ = CondensedDistanceMatrix();
+  compactNodes_.clear();
+  compactKeys_.clear();
+  finalStep(idRoot);
+}
+
+namespace
+{
+  // Order of agglomerations, according to their heights.
+  struct HeightComparator
+  {
+    const vector<double>& heights;
+    HeightComparator(const vector<double>& h) : heights(h) {}
+    bool operator()(size_t i, size_t j) const { return heights[i] < heights[j]; }
+  };
+}
+
+void AbstractAgglomerativeDistanceMethod::computeTreeByNearestNeighborChain()
+{
+  if (!hasReducibleLinkage())
+    throw Exception("AbstractAgglomerativeDistanceMethod::computeTreeByNearestNeighborChain. The linkage of " + getName() + " is not reducible.");
+  initCompactEngine();
+  size_t n = compactMatrix_.size();
+
+  // Clusters are identified by a serial number: leaves are 0 to n-1,
+  // and cluster n+i is created by agglomeration i.
+  vector<size_t> serials(n);
+  vector<size_t> sizes(n, 1);
+  for (size_t i = 0; i < n; ++i)
+  {
+    serials[i] = i;
+  }
+  vector<size_t> merged1(n - 1), merged2(n - 1);
+  vector<double> heights(n - 1);
+
+  // Build the chain of nearest neighbors, and agglomerate reciprocal nearest neighbors:
+  vector<size_t> chain;
+  vector<double> newDist(n);
+  size_t nbMerges = 0;
+  while (compactMatrix_.size() > 1)
+  {
+    if (verbose_)
+      ApplicationTools::displayGauge(nbMerges, n - 2);
+    if (chain.empty())
+      chain.push_back(0);
+    size_t r = compactMatrix_.size();
+    size_t a = chain.back();
+    // The previous element of the chain is preferred in case of ties:
+    size_t b = chain.size() > 1 ? chain[chain.size() - 2] : (a == 0 ? 1 : 0);
+    double dMin = compactMatrix_(a, b);
+    const double* row = compactMatrix_.getRow(a);
+    for (size_t k = 0; k < a; ++k)
+    {
+      if (row[k] < dMin)
+      {
+        dMin = row[k];
+        b = k;
+      }
+    }
+    for (size_t k = a + 1; k < r; ++k)
+    {
+      double d = compactMatrix_.getRow(k)[a];
+      if (d < dMin)
+      {
+        dMin = d;
+        b = k;
+      }
+    }
+    if (chain.size() < 2 || b != chain[chain.size() - 2])
+    {
+      chain.push_back(b);
+      continue;
+    }
+
+    // a and b are reciprocal nearest neighbors:
+    chain.pop_back();
+    chain.pop_back();
+    merged1[nbMerges] = serials[a];
+    merged2[nbMerges] = serials[b];
+    heights[nbMerges] = dMin;
+    newDist.resize(r);
+    for (size_t k = 0; k < r; ++k)
+    {
+      if (k == a || k == b) continue;
+      newDist[k] = computeLinkage(compactMatrix_(a, k), compactMatrix_(b, k), dMin, sizes[a], sizes[b], sizes[k]);
+    }
+    newDist[a] = newDist[b] = 0;
+    compactMatrix_.setRow(a, newDist);
+    serials[a] = n + nbMerges;
+    sizes[a] += sizes[b];
+    size_t last = compactMatrix_.removeEntry(b);
+    serials[b] = serials[last];
+    sizes[b] = sizes[last];
+    serials.pop_back();
+    sizes.pop_back();
+    for (size_t i = 0; i < chain.size(); ++i)
+    {
+      if (chain[i] == last) chain[i] = b;
+    }
+    nbMerges++;
+  }
+
+  // Create nodes in order of increasing heights. Heights are first made
+  // monotonous, so that sons are always created before their father:
+  vector<double> sortHeights(heights);
+  for (size_t i = 0; i < nbMerges; ++i)
+  {
+    if (merged1[i] >= n) sortHeights[i] = std::max(sortHeights[i], sortHeights[merged1[i] - n]);
+    if (merged2[i] >= n) sortHeights[i] = std::max(sortHeights[i], sortHeights[merged2[i] - n]);
+  }
+  vector<size_t> order(nbMerges);
+  for (size_t i = 0; i < nbMerges; ++i)
+  {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(), HeightComparator(sortHeights));
+
+  vector<Node*> nodes(2 * n - 1);
+  vector<size_t> keys(2 * n - 1);
+  for (size_t i = 0; i < n; ++i)
+  {
+    nodes[i] = compactNodes_[i];
+    keys[i] = compactKeys_[i];
+  }
+  compactMatrix_ = CondensedDistanceMatrix();
+  compactNodes_.clear();
+  compactKeys_.clear();
+
+  // Each agglomeration is performed on a two-entry matrix, so that the
+  // method-specific computeBranchLengthsForPair can be used:
+  int idNextNode = static_cast<int>(n);
+  matrix_ = DistanceMatrix(2);
+  vector<size_t> pair(2);
+  pair[0] = 0;
+  pair[1] = 1;
+  for (size_t i = 0; i < nbMerges; ++i)
+  {
+    size_t m = order[i];
+    size_t s1 = merged1[m];
+    size_t s2 = merged2[m];
+    if (keys[s1] > keys[s2])
+      std::swap(s1, s2);
+    currentNodes_.clear();
+    currentNodes_[0] = nodes[s1];
+    currentNodes_[1] = nodes[s2];
+    matrix_(0, 0) = matrix_(1, 1) = 0;
+    matrix_(0, 1) = matrix_(1, 0) = heights[m];
+    if (i == nbMerges - 1)
+      break;
+    vector<double> distances = computeBranchLengthsForPair(pair);
+    nodes[s1]->setDistanceToFather(distances[0]);
+    nodes[s2]->setDistanceToFather(distances[1]);
+    nodes[n + m] = getParentNode(idNextNode++, nodes[s1], nodes[s2]);
+    keys[n + m] = keys[s1];
+  }
+  finalStep(idNextNode);
+}
@@ -42,6 +42,7 @@ knowledge of the CeCILL license and that you accept its terms.
 #define _ABSTRACTAGGLOMERATIVEDISTANCEMETHOD_H_
 
 #include "DistanceMethod.h"
+#include "CondensedDistanceMatrix.h"
 #include "../Node.h"
 #include "../TreeTemplate.h"
 
@@ -58,6 +59,14 @@ namespace bpp
  * with pivot indices and a pointer toward the corresponding subtree.
  *
  * Several methods, commons to several algorithm are provided.
+ *
+ * Methods may also use the "compact engine", which works on a condensed
+ * copy of the distance matrix where merged entries are removed by moving the
+ * last active entry in their place. The compact engine does not rely on the
+ * getBestPair / computeDistancesFromPair methods, and has to be implemented
+ * by each method in its computeTree() function. It is enabled by default,
+ * and can be disabled using setCompactEngine(false), in which case
+ * the generic algorithm is used.
  */
 class AbstractAgglomerativeDistanceMethod:
   public virtual AgglomerativeDistanceMethod
@@ -69,16 +78,34 @@ class AbstractAgglomerativeDistanceMethod:
     std::map<size_t, Node*> currentNodes_;
     bool verbose_;
     bool rootTree_;
+    bool compactEngine_;
+
+    /**
+     * @name Compact engine working storage.
+     *
+     * Entry i of the compact engine corresponds to node compactNodes_[i],
+     * which has key compactKeys_[i] in the original matrix. Merged nodes
+     * keep the smallest key of their two sons, so that the order of keys
+     * is the same as the one of currentNodes_ in the generic algorithm.
+     *
+     * @{
+     */
+    CondensedDistanceMatrix compactMatrix_;
+    std::vector<Node*> compactNodes_;
+    std::vector<size_t> compactKeys_;
+    /** @} */
 	
 	public:
 		//AbstractAgglomerativeDistanceMethod() :
     //  matrix_(0), tree_(0), currentNodes_(), verbose_(true), rootTree_(false) {}
 
 		AbstractAgglomerativeDistanceMethod(bool verbose = true, bool rootTree = false) :
-      matrix_(0), tree_(0), currentNodes_(), verbose_(verbose), rootTree_(rootTree) {}
+      matrix_(0), tree_(0), currentNodes_(), verbose_(verbose), rootTree_(rootTree), compactEngine_(true),
+      compactMatrix_(), compactNodes_(), compactKeys_() {}
 		
     AbstractAgglomerativeDistanceMethod(const DistanceMatrix& matrix, bool verbose = true, bool rootTree = false) :
-      matrix_(0), tree_(0), currentNodes_(), verbose_(verbose), rootTree_(rootTree)
+      matrix_(0), tree_(0), currentNodes_(), verbose_(verbose), rootTree_(rootTree), compactEngine_(true),
+      compactMatrix_(), compactNodes_(), compactKeys_()
     {
       setDistanceMatrix(matrix);
     }
@@ -90,7 +117,8 @@ class AbstractAgglomerativeDistanceMethod:
     }
     
     AbstractAgglomerativeDistanceMethod(const AbstractAgglomerativeDistanceMethod& a) :
-      matrix_(a.matrix_), tree_(0), currentNodes_(), verbose_(a.verbose_), rootTree_(a.rootTree_)
+      matrix_(a.matrix_), tree_(0), currentNodes_(), verbose_(a.verbose_), rootTree_(a.rootTree_), compactEngine_(a.compactEngine_),
+      compactMatrix_(), compactNodes_(), compactKeys_()
     {
       // Hard copy of inner tree:
       if (a.tree_)
@@ -107,12 +135,27 @@ class AbstractAgglomerativeDistanceMethod:
       currentNodes_.clear();
       verbose_ = a.verbose_;
       rootTree_ = a.rootTree_;
+      compactEngine_ = a.compactEngine_;
+      compactMatrix_ = CondensedDistanceMatrix();
+      compactNodes_.clear();
+      compactKeys_.clear();
       return *this;
     }
 
 	public:
 		virtual void setDistanceMatrix(const DistanceMatrix& matrix);
 
+    /**
+     * @brief Set the distance matrix to use, in condensed form.
+     *
+     * The matrix is directly used as working storage by the compact engine,
+     * and is only expanded to a square matrix if the generic algorithm is used.
+     *
+     * @param matrix The matrix to use.
+     * @throw Exception In case an incorrect matrix is provided (eg smaller than 3).
+     */
+    virtual void setCondensedDistanceMatrix(const CondensedDistanceMatrix& matrix);
+
     /**
      * @brief Get the computed tree, if there is one.
      *
@@ -144,6 +187,16 @@ class AbstractAgglomerativeDistanceMethod:
     void setVerbose(bool yn) { verbose_ = yn; }
     bool isVerbose() const { return verbose_; }
 
+    /**
+     * @param yn Enable/Disable the compact engine, for methods that implement it.
+     */
+    void setCompactEngine(bool yn) { compactEngine_ = yn; }
+
+    /**
+     * @return True if the compact engine is enabled.
+     */
+    bool usesCompactEngine() const { return compactEngine_; }
+
 	protected:
     /**
      * @name Specific methods.
@@ -217,6 +270,97 @@ class AbstractAgglomerativeDistanceMethod:
      */
 		virtual Node* getParentNode(int id, Node * son1, Node * son2);
     /** @} */
+
+    /**
+     * @name Compact engine.
+     *
+     * @{
+     */
+
+    /**
+     * @brief Initialize the compact engine storage.
+     *
+     * Copy the distance matrix into compactMatrix_ and create all leaf nodes.
+     */
+    virtual void initCompactEngine();
+
+    /**
+     * @brief Remove an entry from the compact engine storage.
+     *
+     * The last entry is moved in place of the removed one. Methods storing
+     * additional per-entry data should override this method and move their
+     * own data accordingly.
+     *
+     * @param pos The entry to remove.
+     * @return The former index of the entry now at position pos.
+     */
+    virtual size_t removeCompactEntry(size_t pos);
+
+    /**
+     * @brief Terminate the compact engine.
+     *
+     * Set up currentNodes_ and matrix_ with the remaining entries, in the
+     * order of their keys, call finalStep and release the compact storage.
+     *
+     * @param idRoot The id of the root node.
+     */
+    void compactFinalStep(int idRoot);
+
+    /**
+     * @brief Tell if the linkage used by the method is reducible.
+     *
+     * A linkage is reducible if the distance between the union of two
+     * clusters and a third one is never smaller than the smallest distance
+     * between the two clusters and the third one. For such linkages, the tree
+     * can be built using the nearest-neighbor chain algorithm.
+     *
+     * @return True if computeTreeByNearestNeighborChain can be used.
+     */
+    virtual bool hasReducibleLinkage() const { return false; }
+
+    /**
+     * @brief Lance-Williams formula of the linkage.
+     *
+     * Compute the distance between the union of clusters 1 and 2 and a third cluster.
+     *
+     * @param d1 The distance between clusters 1 and 3.
+     * @param d2 The distance between clusters 2 and 3.
+     * @param d12 The distance between clusters 1 and 2.
+     * @param n1 The number of leaves in cluster 1.
+     * @param n2 The number of leaves in cluster 2.
+     * @param n3 The number of leaves in cluster 3.
+     * @return The distance between the union of clusters 1 and 2 and cluster 3.
+     */
+    virtual double computeLinkage(double d1, double d2, double d12, size_t n1, size_t n2, size_t n3) const
+    {
+      throw Exception("AbstractAgglomerativeDistanceMethod::computeLinkage. Not implemented for " + getName() + ".");
+    }
+
+    /**
+     * @brief Compute the tree using the nearest-neighbor chain algorithm.
+     *
+     * This takes O(n^2) time and only uses the condensed matrix as storage.
+     * Pairs are agglomerated in a different order than in the generic
+     * algorithm, but nodes are created in order of increasing distance, so
+     * that the resulting tree is the same if there is no tie in the matrix.
+     * Branch lengths are computed using computeBranchLengthsForPair, and the
+     * root node is created using finalStep.
+     *
+     * This method requires hasReducibleLinkage() to return true.
+     *
+     * Reference:
+     * Murtagh F (1983), A survey of recent advances in hierarchical clustering algorithms,
+     * _The Computer Journal_ 26(4) 354-359.
+     */
+    void computeTreeByNearestNeighborChain();
+
+    /**
+     * @brief Make sure that the square distance matrix is available.
+     *
+     * If the distance matrix was set in condensed form, it is expanded.
+     */
+    void useFullMatrix();
+    /** @} */
 		
 };
 
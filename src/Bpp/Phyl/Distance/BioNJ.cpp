@@ -59,7 +59,17 @@ double BioNJ::computeDistancesFromPair(const vector<size_t>& pair, const vector<
 
 void BioNJ::computeTree()
 {
+  if (compactEngine_)
+  {
+    computeCompactTree();
+    return;
+  }
+
+  useFullMatrix();
+  sumDist_.resize(matrix_.size());
+
   // Initialization:
+  variance_ = matrix_;
   for (size_t i = 0; i < matrix_.size(); i++)
   {
     currentNodes_[i] = getLeafNode(static_cast<int>(i), matrix_.getName(i));
@@ -128,3 +138,51 @@ void BioNJ::computeTree()
   finalStep(idNextNode);
 }
 
+
+void BioNJ::initCompactEngine()
+{
+  NeighborJoining::initCompactEngine();
+  compactVariance_ = compactMatrix_;
+}
+
+size_t BioNJ::removeCompactEntry(size_t pos)
+{
+  compactVariance_.removeEntry(pos);
+  return NeighborJoining::removeCompactEntry(pos);
+}
+
+void BioNJ::computeCompactDistancesFromPair(size_t pos1, size_t pos2, const std::vector<double>& branchLengths, std::vector<double>& newDist)
+{
+  size_t r = compactMatrix_.size();
+  double v12 = compactVariance_(pos1, pos2);
+  // compute lambda
+  lambda_ = 0;
+  if (v12 == 0)
+    lambda_ = .5;
+  else
+  {
+    for (size_t k = 0; k < r; ++k)
+    {
+      if (k != pos1 && k != pos2)
+        lambda_ += (compactVariance_(pos2, k) - compactVariance_(pos1, k));
+    }
+    double div = 2 * static_cast<double>(r - 2) * v12;
+    lambda_ /= div;
+    lambda_ += .5;
+  }
+  if (lambda_ < 0.)
+    lambda_ = 0.;
+  if (lambda_ > 1.)
+    lambda_ = 1.;
+
+  vector<double> newVar(r, 0.);
+  for (size_t k = 0; k < r; ++k)
+  {
+    if (k == pos1 || k == pos2) continue;
+    double d = lambda_ * (compactMatrix_(pos1, k) - branchLengths[0]) + (1 - lambda_) * (compactMatrix_(pos2, k) - branchLengths[1]);
+    newDist[k] = positiveLengths_ ? std::max(d, 0.) : d;
+    newVar[k] = lambda_ * compactVariance_(pos1, k) + (1 - lambda_) * compactVariance_(pos2, k) - lambda_ * (1 - lambda_) * v12;
+  }
+  // The row of pos2 will be removed by removeCompactEntry:
+  compactVariance_.setRow(pos1, newVar);
+}
@@ -57,6 +57,7 @@ class BioNJ :
 {
 private:
   DistanceMatrix variance_;
+  CondensedDistanceMatrix compactVariance_;
   double lambda_;
 
 public:
@@ -70,6 +71,7 @@ public:
   BioNJ(bool rooted = false, bool positiveLengths = false, bool verbose = true) :
     NeighborJoining(rooted, positiveLengths, verbose),
     variance_(0),
+    compactVariance_(),
     lambda_(0) {}
 
   /**
@@ -83,7 +85,8 @@ public:
   BioNJ(const DistanceMatrix& matrix, bool rooted = false, bool positiveLengths = false, bool verbose = true) :
     NeighborJoining(rooted, positiveLengths, verbose),
     // Use the default constructor, because the other one call computeTree.
-    variance_(matrix),
+    variance_(0),
+    compactVariance_(),
     lambda_(0)
   {
     setDistanceMatrix(matrix);
@@ -101,10 +104,14 @@ public:
   void setDistanceMatrix(const DistanceMatrix& matrix)
   {
     NeighborJoining::setDistanceMatrix(matrix);
-    variance_ = matrix;
   }
   void computeTree();
   double computeDistancesFromPair(const std::vector<size_t>& pair, const std::vector<double>& branchLengths, size_t pos);
+
+protected:
+  void initCompactEngine();
+  size_t removeCompactEntry(size_t pos);
+  void computeCompactDistancesFromPair(size_t pos1, size_t pos2, const std::vector<double>& branchLengths, std::vector<double>& newDist);
 };
 } // end of namespace bpp.
 
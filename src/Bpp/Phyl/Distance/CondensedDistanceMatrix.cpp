@@ -0,0 +1,286 @@
+//
+// File: CondensedDistanceMatrix.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include "CondensedDistanceMatrix.h"
+
+// From bpp-seq:
+#include <Bpp/Seq/DistanceMatrix.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BPP_USE_MMAP
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+CondensedDistanceMatrix::CondensedDistanceMatrix(size_t n) :
+  distances_(getNumberOfPairs(n), 0.),
+  data_(0),
+  names_(n),
+  size_(n),
+  mappedPath_(),
+  mappedOffset_(0),
+  mapping_(0),
+  mappingLength_(0),
+  modified_(false)
+{
+  data_ = distances_.data();
+  for (size_t i = 0; i < n; ++i)
+  {
+    names_[i] = "Taxon " + TextTools::toString(i);
+  }
+}
+
+CondensedDistanceMatrix::CondensedDistanceMatrix(const std::vector<std::string>& names) :
+  distances_(getNumberOfPairs(names.size()), 0.),
+  data_(0),
+  names_(names),
+  size_(names.size()),
+  mappedPath_(),
+  mappedOffset_(0),
+  mapping_(0),
+  mappingLength_(0),
+  modified_(false)
+{
+  data_ = distances_.data();
+}
+
+CondensedDistanceMatrix::CondensedDistanceMatrix(const std::vector<std::string>& names, const std::string& path, size_t offset) :
+  distances_(),
+  data_(0),
+  names_(names),
+  size_(names.size()),
+  mappedPath_(),
+  mappedOffset_(0),
+  mapping_(0),
+  mappingLength_(0),
+  modified_(false)
+{
+  map_(path, offset);
+}
+
+CondensedDistanceMatrix::CondensedDistanceMatrix(const DistanceMatrix& dist) :
+  distances_(getNumberOfPairs(dist.size())),
+  data_(0),
+  names_(dist.getNames()),
+  size_(dist.size()),
+  mappedPath_(),
+  mappedOffset_(0),
+  mapping_(0),
+  mappingLength_(0),
+  modified_(false)
+{
+  data_ = distances_.data();
+  for (size_t i = 1; i < size_; ++i)
+  {
+    double* row = data_ + getIndex(i, 0);
+    for (size_t j = 0; j < i; ++j)
+    {
+      row[j] = dist(j, i);
+    }
+  }
+}
+
+CondensedDistanceMatrix::CondensedDistanceMatrix(const CondensedDistanceMatrix& dist) :
+  distances_(),
+  data_(0),
+  names_(),
+  size_(0),
+  mappedPath_(),
+  mappedOffset_(0),
+  mapping_(0),
+  mappingLength_(0),
+  modified_(false)
+{
+  copy_(dist);
+}
+
+CondensedDistanceMatrix& CondensedDistanceMatrix::operator=(const CondensedDistanceMatrix& dist)
+{
+  if (this != &dist)
+  {
+    unmap_();
+    copy_(dist);
+  }
+  return *this;
+}
+
+CondensedDistanceMatrix::~CondensedDistanceMatrix()
+{
+  unmap_();
+}
+
+void CondensedDistanceMatrix::copy_(const CondensedDistanceMatrix& dist)
+{
+  names_ = dist.names_;
+  size_ = dist.size_;
+  modified_ = dist.modified_;
+  if (dist.isMapped() && !dist.modified_)
+  {
+    // Share the file rather than the memory:
+    vector<double>().swap(distances_);
+    map_(dist.mappedPath_, dist.mappedOffset_);
+  }
+  else
+  {
+    size_t nbPairs = getNumberOfPairs(size_);
+    distances_.assign(dist.data_, dist.data_ + nbPairs);
+    data_ = distances_.data();
+  }
+}
+
+void CondensedDistanceMatrix::map_(const std::string& path, size_t offset)
+{
+  size_t length = getNumberOfPairs(size_) * sizeof(double);
+  mappedPath_ = path;
+  mappedOffset_ = offset;
+#ifdef BPP_USE_MMAP
+  if (length > 0)
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw IOException("CondensedDistanceMatrix::map_. Could not open file '" + path + "'.");
+    // The mapping must start on a page boundary:
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t start = offset - offset % pageSize;
+    mappingLength_ = length + offset - start;
+    void* mapping = mmap(0, mappingLength_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, static_cast<off_t>(start));
+    close(fd);
+    if (mapping == MAP_FAILED)
+      throw IOException("CondensedDistanceMatrix::map_. Could not map file '" + path + "' in memory.");
+    mapping_ = mapping;
+    data_ = reinterpret_cast<double*>(static_cast<char*>(mapping) + (offset - start));
+    return;
+  }
+#endif
+  // Read the file in memory:
+  distances_.resize(getNumberOfPairs(size_));
+  data_ = distances_.data();
+  if (length > 0)
+  {
+    ifstream input(path.c_str(), ios::in | ios::binary);
+    input.seekg(static_cast<streamoff>(offset));
+    input.read(reinterpret_cast<char*>(data_), static_cast<streamsize>(length));
+    if (!input)
+      throw IOException("CondensedDistanceMatrix::map_. Could not read file '" + path + "'.");
+  }
+}
+
+void CondensedDistanceMatrix::unmap_()
+{
+#ifdef BPP_USE_MMAP
+  if (mapping_)
+    munmap(mapping_, mappingLength_);
+#endif
+  mapping_ = 0;
+  mappingLength_ = 0;
+  mappedPath_ = "";
+  mappedOffset_ = 0;
+  data_ = distances_.data();
+}
+
+void CondensedDistanceMatrix::setRow(size_t i, const std::vector<double>& row)
+{
+  if (row.size() != size_)
+    throw DimensionException("CondensedDistanceMatrix::setRow.", row.size(), size_);
+  modified_ = true;
+  double* ri = data_ + getIndex(i, 0);
+  for (size_t j = 0; j < i; ++j)
+  {
+    ri[j] = row[j];
+  }
+  for (size_t j = i + 1; j < size_; ++j)
+  {
+    data_[getIndex(j, i)] = row[j];
+  }
+}
+
+size_t CondensedDistanceMatrix::removeEntry(size_t i)
+{
+  if (i >= size_)
+    throw IndexOutOfBoundsException("CondensedDistanceMatrix::removeEntry.", i, 0, size_ - 1);
+  size_t last = size_ - 1;
+  modified_ = true;
+  if (i < last)
+  {
+    // Copy d(last, k) to d(i, k) for all k != i. The last row is contiguous.
+    const double* rLast = data_ + getIndex(last, 0);
+    double* ri = data_ + getIndex(i, 0);
+    for (size_t k = 0; k < i; ++k)
+    {
+      ri[k] = rLast[k];
+    }
+    for (size_t k = i + 1; k < last; ++k)
+    {
+      data_[getIndex(k, i)] = rLast[k];
+    }
+    names_[i] = names_[last];
+  }
+  // The last row is also the last block in the storage:
+  size_--;
+  if (!isMapped())
+  {
+    distances_.resize(getNumberOfPairs(size_));
+    data_ = distances_.data();
+  }
+  names_.resize(size_);
+  return last;
+}
+
+DistanceMatrix* CondensedDistanceMatrix::toDistanceMatrix() const
+{
+  DistanceMatrix* dist = new DistanceMatrix(names_);
+  for (size_t i = 0; i < size_; ++i)
+  {
+    (*dist)(i, i) = 0.;
+    for (size_t j = 0; j < i; ++j)
+    {
+      (*dist)(i, j) = (*dist)(j, i) = (*this)(i, j);
+    }
+  }
+  return dist;
+}
+
@@ -0,0 +1,233 @@
+//
+// File: CondensedDistanceMatrix.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _CONDENSEDDISTANCEMATRIX_H_
+#define _CONDENSEDDISTANCEMATRIX_H_
+
+#include <Bpp/Exceptions.h>
+#include <Bpp/Text/TextTools.h>
+
+// From the STL:
+#include <vector>
+#include <string>
+
+namespace bpp
+{
+
+class DistanceMatrix;
+
+/**
+ * @brief Compact storage for symmetric distance matrices.
+ *
+ * Only the strict lower triangle of the matrix is stored, row after row,
+ * so that a matrix of dimension n takes n(n-1)/2 values instead of n^2.
+ * Diagonal elements are always 0.
+ *
+ * Entries can be removed in linear time with the removeEntry() method,
+ * which moves the last entry in place of the removed one. Agglomerative
+ * methods use this to keep their working matrix dense while clusters are
+ * merged ("active-index compaction").
+ *
+ * The values can also be stored in a file, which is then mapped in memory
+ * (on systems supporting it, the file is read in memory otherwise). The
+ * mapping is private: the matrix can be modified, but changes are never
+ * written back to the file, and only modified pages take memory.
+ * Copying a mapped matrix which was not modified creates a new mapping of
+ * the same file, and therefore does not duplicate the data.
+ *
+ * @see BinaryDistanceMatrixFormat
+ */
+class CondensedDistanceMatrix
+{
+  private:
+    std::vector<double> distances_;
+    double* data_;
+    std::vector<std::string> names_;
+    size_t size_;
+
+    /**
+     * @name Memory-mapped storage.
+     *
+     * @{
+     */
+    std::string mappedPath_;
+    size_t mappedOffset_;
+    void* mapping_;
+    size_t mappingLength_;
+    bool modified_;
+    /** @} */
+
+  public:
+    /**
+     * @brief Build a new matrix of the given dimension, filled with 0.
+     *
+     * @param n The dimension of the matrix.
+     */
+    CondensedDistanceMatrix(size_t n = 0);
+
+    /**
+     * @brief Build a new matrix filled with 0.
+     *
+     * @param names The names of the entries.
+     */
+    CondensedDistanceMatrix(const std::vector<std::string>& names);
+
+    /**
+     * @brief Build a new matrix stored in a file.
+     *
+     * @param names The names of the entries.
+     * @param path The file where the n(n-1)/2 values are stored, in native binary format.
+     * @param offset The position of the first value in the file, in bytes.
+     * @throw IOException If the file cannot be mapped or read.
+     */
+    CondensedDistanceMatrix(const std::vector<std::string>& names, const std::string& path, size_t offset);
+
+    /**
+     * @brief Build a condensed copy of a square distance matrix.
+     *
+     * Only the upper triangle of the input matrix is read.
+     *
+     * @param dist The matrix to copy.
+     */
+    CondensedDistanceMatrix(const DistanceMatrix& dist);
+
+    CondensedDistanceMatrix(const CondensedDistanceMatrix& dist);
+
+    CondensedDistanceMatrix& operator=(const CondensedDistanceMatrix& dist);
+
+    virtual ~CondensedDistanceMatrix();
+
+  public:
+    /**
+     * @return The number of distinct pairs, n(n-1)/2, in a matrix of dimension n.
+     */
+    static size_t getNumberOfPairs(size_t n) { return n < 2 ? 0 : n * (n - 1) / 2; }
+
+    /**
+     * @return The position of element (i, j) in the condensed storage, with i > j.
+     */
+    static size_t getIndex(size_t i, size_t j) { return i * (i - 1) / 2 + j; }
+
+    size_t size() const { return size_; }
+
+    const std::vector<std::string>& getNames() const { return names_; }
+
+    const std::string& getName(size_t i) const
+    {
+      if (i >= size_) throw IndexOutOfBoundsException("CondensedDistanceMatrix::getName.", i, 0, size_ - 1);
+      return names_[i];
+    }
+
+    void setName(size_t i, const std::string& name)
+    {
+      if (i >= size_) throw IndexOutOfBoundsException("CondensedDistanceMatrix::setName.", i, 0, size_ - 1);
+      names_[i] = name;
+    }
+
+    /**
+     * @return The distance between entries i and j.
+     */
+    double operator()(size_t i, size_t j) const
+    {
+      if (i == j) return 0.;
+      return i > j ? data_[getIndex(i, j)] : data_[getIndex(j, i)];
+    }
+
+    /**
+     * @brief Set the distance between two distinct entries.
+     */
+    void set(size_t i, size_t j, double d)
+    {
+      if (i == j) throw Exception("CondensedDistanceMatrix::set. Diagonal elements are always 0.");
+      modified_ = true;
+      if (i > j) data_[getIndex(i, j)] = d;
+      else data_[getIndex(j, i)] = d;
+    }
+
+    /**
+     * @return A pointer toward the first element of row i, that is, the
+     * i contiguous values d(i, 0), ..., d(i, i-1).
+     */
+    const double* getRow(size_t i) const { return data_ + getIndex(i, 0); }
+    double* getRow(size_t i)
+    {
+      modified_ = true;
+      return data_ + getIndex(i, 0);
+    }
+
+    /**
+     * @brief Set all distances of one entry.
+     *
+     * @param i The entry to update.
+     * @param row A vector of size size(), element i is ignored.
+     */
+    void setRow(size_t i, const std::vector<double>& row);
+
+    /**
+     * @brief Remove one entry from the matrix.
+     *
+     * The last entry of the matrix is moved in place of the removed one,
+     * so that all other indices are unchanged. This takes O(n) time.
+     *
+     * @param i The entry to remove.
+     * @return The former index of the entry now at position i, which equals
+     * i if the last entry was removed.
+     */
+    size_t removeEntry(size_t i);
+
+    /**
+     * @return A new square distance matrix with the same content.
+     */
+    DistanceMatrix* toDistanceMatrix() const;
+
+    /**
+     * @return True if the matrix is stored in a memory-mapped file.
+     */
+    bool isMapped() const { return mapping_ != 0; }
+
+  private:
+    void map_(const std::string& path, size_t offset);
+    void unmap_();
+    void copy_(const CondensedDistanceMatrix& dist);
+};
+
+} //end of namespace bpp.
+
+#endif //_CONDENSEDDISTANCEMATRIX_H_
+
@@ -41,7 +41,6 @@
 #include "DistanceEstimation.h"
 #include "../Tree.h"
 #include "../PatternTools.h"
-#include "../SitePatterns.h"
 
 // From bpp-core:
 #include <Bpp/App/ApplicationTools.h>
@@ -50,7 +49,6 @@
 // From bpp-seq:
 #include <Bpp/Seq/SiteTools.h>
 #include <Bpp/Seq/Sequence.h>
-#include <Bpp/Seq/Container/AlignedSequenceContainer.h>
 #include <Bpp/Seq/DistanceMatrix.h>
 
 using namespace bpp;
@@ -60,6 +58,8 @@ using namespace bpp;
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <unordered_map>
 
 using namespace std;
 
@@ -72,7 +72,7 @@ TwoTreeLikelihood::TwoTreeLikelihood(
     DiscreteDistribution* rDist,
     bool verbose) :
   AbstractDiscreteRatesAcrossSitesTreeLikelihood(rDist, verbose),
-  shrunkData_(0), seqnames_(2), model_(model), brLenParameters_(), pxy_(), dpxy_(), d2pxy_(),
+  seqnames_(2), model_(model), brLenParameters_(), pxy_(), dpxy_(), d2pxy_(),
   rootPatternLinks_(), rootWeights_(), nbSites_(0), nbClasses_(0), nbStates_(0), nbDistinctSites_(0),
   rootLikelihoods_(), rootLikelihoodsS_(), rootLikelihoodsSR_(), dLikelihoods_(), d2Likelihoods_(),
   leafLikelihoods1_(), leafLikelihoods2_(),
@@ -93,22 +93,15 @@ TwoTreeLikelihood::TwoTreeLikelihood(
   if (verbose)
     ApplicationTools::displayMessage("Double-Recursive Homogeneous Tree Likelihood");
 
-  // Initialize root patterns:
-  SitePatterns pattern(data_);
-  shrunkData_       = pattern.getSites();
-  rootWeights_      = pattern.getWeights();
-  rootPatternLinks_ = pattern.getIndices();
-  nbDistinctSites_  = shrunkData_->getNumberOfSites();
+  // Init _likelihoods:
+  if (verbose) ApplicationTools::displayTask("Init likelihoods arrays");
+  vector< vector<StateCode> > codes;
+  vector<int> states;
+  encodeSequences(*data_, codes, states);
+  initTreeLikelihoods(codes[0], codes[1], states);
   if (verbose)
     ApplicationTools::displayResult("Number of distinct sites", TextTools::toString(nbDistinctSites_));
 
-  // Init _likelihoods:
-  if (verbose) ApplicationTools::displayTask("Init likelihoods arrays recursively");
-  // Clone data for more efficiency on sequences access:
-  const SiteContainer* sequences = new AlignedSequenceContainer(*shrunkData_);
-  initTreeLikelihoods(*sequences);
-  delete sequences;
-
   brLen_ = minimumBrLen_;
   brLenConstraint_ = std::make_shared<IntervalConstraint>(1, minimumBrLen_, true);
 
@@ -117,9 +110,35 @@ TwoTreeLikelihood::TwoTreeLikelihood(
 
 /******************************************************************************/
 
+TwoTreeLikelihood::TwoTreeLikelihood(
+    const std::vector<StateCode>& codes1, const std::vector<StateCode>& codes2,
+    const std::vector<int>& states,
+    TransitionModel* model,
+    DiscreteDistribution* rDist,
+    bool verbose) :
+  AbstractDiscreteRatesAcrossSitesTreeLikelihood(rDist, verbose),
+  seqnames_(2), model_(model), brLenParameters_(), pxy_(), dpxy_(), d2pxy_(),
+  rootPatternLinks_(), rootWeights_(), nbSites_(codes1.size()), nbClasses_(0), nbStates_(0), nbDistinctSites_(0),
+  rootLikelihoods_(), rootLikelihoodsS_(), rootLikelihoodsSR_(), dLikelihoods_(), d2Likelihoods_(),
+  leafLikelihoods1_(), leafLikelihoods2_(),
+  minimumBrLen_(0.000001), brLenConstraint_(0), brLen_(0)
+{
+  if (codes2.size() != nbSites_)
+    throw DimensionException("TwoTreeLikelihood::TwoTreeLikelihood. Sequences must have the same length.", codes2.size(), nbSites_);
+  nbClasses_ = rateDistribution_->getNumberOfCategories();
+  nbStates_  = model_->getNumberOfStates();
+  initTreeLikelihoods(codes1, codes2, states);
+  if (verbose)
+    ApplicationTools::displayResult("Number of distinct sites", TextTools::toString(nbDistinctSites_));
+
+  brLen_ = minimumBrLen_;
+  brLenConstraint_ = std::make_shared<IntervalConstraint>(1, minimumBrLen_, true);
+}
+
+/******************************************************************************/
+
 TwoTreeLikelihood::TwoTreeLikelihood(const TwoTreeLikelihood& lik) :
   AbstractDiscreteRatesAcrossSitesTreeLikelihood(lik),
-  shrunkData_        (dynamic_cast<SiteContainer*>(lik.shrunkData_->clone())),
   seqnames_          (lik.seqnames_),
   model_             (lik.model_),
   brLenParameters_   (lik.brLenParameters_),
@@ -149,7 +168,6 @@ TwoTreeLikelihood::TwoTreeLikelihood(const TwoTreeLikelihood& lik) :
 TwoTreeLikelihood& TwoTreeLikelihood::operator=(const TwoTreeLikelihood& lik)
 {
   AbstractDiscreteRatesAcrossSitesTreeLikelihood::operator=(lik);
-  shrunkData_        = dynamic_cast<SiteContainer*>(lik.shrunkData_->clone());
   seqnames_          = lik.seqnames_;
   model_             = lik.model_;
   brLenParameters_   = lik.brLenParameters_;
@@ -177,9 +195,34 @@ TwoTreeLikelihood& TwoTreeLikelihood::operator=(const TwoTreeLikelihood& lik)
 
 /******************************************************************************/
 
-TwoTreeLikelihood::~TwoTreeLikelihood()
+TwoTreeLikelihood::~TwoTreeLikelihood() {}
+
+/******************************************************************************/
+
+void TwoTreeLikelihood::encodeSequences(const SequenceContainer& data, std::vector< std::vector<StateCode> >& codes, std::vector<int>& states)
 {
-  delete shrunkData_;
+  vector<string> names = data.getSequencesNames();
+  codes.resize(names.size());
+  states.clear();
+  unordered_map<int, StateCode> index;
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    const vector<int>& content = data.getSequence(names[i]).getContent();
+    vector<StateCode>& codes_i = codes[i];
+    codes_i.resize(content.size());
+    for (size_t j = 0; j < content.size(); ++j)
+    {
+      unordered_map<int, StateCode>::iterator it = index.find(content[j]);
+      if (it == index.end())
+      {
+        if (states.size() > numeric_limits<StateCode>::max())
+          throw Exception("TwoTreeLikelihood::encodeSequences. Too many distinct characters in sequences.");
+        it = index.insert(make_pair(content[j], static_cast<StateCode>(states.size()))).first;
+        states.push_back(content[j]);
+      }
+      codes_i[j] = it->second;
+    }
+  }
 }
 
 /******************************************************************************/
@@ -413,33 +456,53 @@ double TwoTreeLikelihood::getValue() const
 
 /******************************************************************************/
 
-void TwoTreeLikelihood::initTreeLikelihoods(const SequenceContainer& sequences)
+void TwoTreeLikelihood::initTreeLikelihoods(const std::vector<StateCode>& codes1, const std::vector<StateCode>& codes2, const std::vector<int>& states)
 {
-  const Sequence* seq1 = &sequences.getSequence(seqnames_[0]);
-  const Sequence* seq2 = &sequences.getSequence(seqnames_[1]);
+  // Joint histogram of the codes, computed in one pass:
+  size_t nbCodes = states.size();
+  vector<unsigned int> counts(nbCodes * nbCodes, 0);
+  rootPatternLinks_.resize(nbSites_);
+  for (size_t i = 0; i < nbSites_; i++)
+  {
+    size_t pair = static_cast<size_t>(codes1[i]) * nbCodes + codes2[i];
+    counts[pair]++;
+    rootPatternLinks_[i] = pair;
+  }
+
+  // Each pair of codes observed defines a site pattern:
+  vector<size_t> patterns(counts.size());
+  rootWeights_.clear();
+  for (size_t pair = 0; pair < counts.size(); pair++)
+  {
+    if (counts[pair] > 0)
+    {
+      patterns[pair] = rootWeights_.size();
+      rootWeights_.push_back(counts[pair]);
+    }
+  }
+  nbDistinctSites_ = rootWeights_.size();
+  for (size_t i = 0; i < nbSites_; i++)
+  {
+    rootPatternLinks_[i] = patterns[rootPatternLinks_[i]];
+  }
+
+  // Leaves likelihoods only depend on the code:
+  VVdouble initValues(nbCodes, Vdouble(nbStates_));
+  for (size_t k = 0; k < nbCodes; k++)
+  {
+    for (size_t s = 0; s < nbStates_; s++)
+    {
+      initValues[k][s] = model_->getInitValue(s, states[k]);
+    }
+  }
   leafLikelihoods1_.resize(nbDistinctSites_);
   leafLikelihoods2_.resize(nbDistinctSites_);
-  for (size_t i = 0; i < nbDistinctSites_; i++)
+  for (size_t pair = 0; pair < counts.size(); pair++)
   {
-   Vdouble* leafLikelihoods1_i = &leafLikelihoods1_[i];
-   Vdouble* leafLikelihoods2_i = &leafLikelihoods2_[i];
-   leafLikelihoods1_i->resize(nbStates_);
-   leafLikelihoods2_i->resize(nbStates_);
-   int state1 = seq1->getValue(i);
-   int state2 = seq2->getValue(i);
-    for (size_t s = 0; s < nbStates_; s++)
+    if (counts[pair] > 0)
     {
-      // Leaves likelihood are set to 1 if the char correspond to the site in the sequence,
-      // otherwise value set to 0:
-      try
-      {
-        (*leafLikelihoods1_i)[s] = model_->getInitValue(s, state1);
-        (*leafLikelihoods2_i)[s] = model_->getInitValue(s, state2);
-      }
-      catch (SequenceNotFoundException& snfe)
-      {
-        throw SequenceNotFoundException("TwoTreeLikelihood::initTreelikelihoods. Leaf name in tree not found in site conainer: ", snfe.getSequenceId());
-      }
+      leafLikelihoods1_[patterns[pair]] = initValues[pair / nbCodes];
+      leafLikelihoods2_[patterns[pair]] = initValues[pair % nbCodes];
     }
   }
 
@@ -648,9 +711,25 @@ void DistanceEstimation::computeMatrix()
 {
   size_t n = sites_->getNumberOfSequences();
   vector<string> names = sites_->getSequencesNames();
+  if (sites_->getAlphabet()->getAlphabetType() != model_->getAlphabet()->getAlphabetType())
+    throw AlphabetMismatchException("DistanceEstimation::computeMatrix. Data and model must have the same alphabet type.",
+                                    sites_->getAlphabet(),
+                                    model_->getAlphabet());
   if (dist_ != 0) delete dist_;
   dist_ = new DistanceMatrix(names);
   optimizer_->setVerbose(static_cast<unsigned int>(max(static_cast<int>(verbose_) - 2, 0)));
+
+  // Sequences are encoded once for all pairs:
+  vector< vector<TwoTreeLikelihood::StateCode> > codes;
+  vector<int> states;
+  TwoTreeLikelihood::encodeSequences(*sites_, codes, states);
+  vector<char> isGap(states.size());
+  for (size_t k = 0; k < states.size(); ++k)
+  {
+    isGap[k] = sites_->getAlphabet()->isGap(states[k]);
+  }
+  size_t nbSites = sites_->getNumberOfSites();
+
   for (size_t i = 0; i < n; ++i)
   {
     (*dist_)(i, i) = 0;
@@ -658,18 +737,24 @@ void DistanceEstimation::computeMatrix()
     {
       ApplicationTools::displayGauge(i, n - 1, '=');
     }
+    const vector<TwoTreeLikelihood::StateCode>& codes1 = codes[i];
     for (size_t j = i + 1; j < n; j++)
     {
       if (verbose_ > 1)
       {
         ApplicationTools::displayGauge(j - i - 1, n - i - 2, '=');
       }
+      const vector<TwoTreeLikelihood::StateCode>& codes2 = codes[j];
       TwoTreeLikelihood* lik =
-        new TwoTreeLikelihood(names[i], names[j], *sites_, model_.get(), rateDist_.get(), verbose_ > 3);
+        new TwoTreeLikelihood(codes1, codes2, states, model_.get(), rateDist_.get(), verbose_ > 3);
       lik->initialize();
       lik->enableDerivatives(true);
-      size_t d = SymbolListTools::getNumberOfDistinctPositions(sites_->getSequence(i), sites_->getSequence(j));
-      size_t g = SymbolListTools::getNumberOfPositionsWithoutGap(sites_->getSequence(i), sites_->getSequence(j));
+      size_t d = 0, g = 0;
+      for (size_t k = 0; k < nbSites; ++k)
+      {
+        d += (codes1[k] != codes2[k]);
+        g += !(isGap[codes1[k]] || isGap[codes2[k]]);
+      }
       lik->setParameterValue("BrLen", g == 0 ? lik->getMinimumBranchLength() : std::max(lik->getMinimumBranchLength(), static_cast<double>(d) / static_cast<double>(g)));
       // Optimization:
       optimizer_->setFunction(lik);
@@ -64,12 +64,21 @@ namespace bpp
 
 /**
  * @brief This class is a simplified version of DRHomogeneousTreeLikelihood for 2-Trees.
+ *
+ * Sequences are encoded as compact state codes, one per distinct character
+ * found in the data (see encodeSequences()). Site patterns are then obtained
+ * from the joint histogram of the codes of the two sequences, which is
+ * computed in a single pass over the alignment. As there are at most as
+ * many patterns as pairs of codes, the cost of each likelihood evaluation
+ * does not depend on the length of the alignment.
  */
   class TwoTreeLikelihood:
     public AbstractDiscreteRatesAcrossSitesTreeLikelihood  
   {
+  public:
+    typedef unsigned short StateCode;
+
   private:
-    SiteContainer* shrunkData_;
     std::vector<std::string> seqnames_;
     TransitionModel* model_;
     ParameterList brLenParameters_;
@@ -123,6 +132,27 @@ namespace bpp
       DiscreteDistribution* rDist,
       bool verbose);
 
+    /**
+     * @brief Build a new likelihood object from encoded sequences.
+     *
+     * This avoids copying the sequences when the likelihood of many pairs has
+     * to be computed from the same data set. The data are not stored, and
+     * getData() will return 0.
+     *
+     * @param codes1 The first sequence, encoded by encodeSequences().
+     * @param codes2 The second sequence, encoded by encodeSequences().
+     * @param states The alphabet state corresponding to each code.
+     * @param model  The substitution model to use.
+     * @param rDist  The rate across sites distribution to use.
+     * @param verbose Should I display some info?
+     */
+    TwoTreeLikelihood(
+      const std::vector<StateCode>& codes1, const std::vector<StateCode>& codes2,
+      const std::vector<int>& states,
+      TransitionModel* model,
+      DiscreteDistribution* rDist,
+      bool verbose);
+
     TwoTreeLikelihood(const TwoTreeLikelihood& lik);
     
     TwoTreeLikelihood& operator=(const TwoTreeLikelihood& lik);
@@ -131,6 +161,17 @@ namespace bpp
 
     virtual ~TwoTreeLikelihood();
 
+  public:
+    /**
+     * @brief Encode all sequences of a container as compact state codes.
+     *
+     * @param data   The sequences to encode.
+     * @param codes  [out] One vector of codes per sequence.
+     * @param states [out] The alphabet state corresponding to each code.
+     * @throw Exception If there are more distinct characters than available codes.
+     */
+    static void encodeSequences(const SequenceContainer& data, std::vector< std::vector<StateCode> >& codes, std::vector<int>& states);
+
   public:
 
     /**
@@ -141,6 +182,10 @@ namespace bpp
      * @{
      */
     size_t getNumberOfStates() const { return model_->getNumberOfStates(); } 
+
+    size_t getNumberOfSites() const { return nbSites_; }
+
+    const Alphabet* getAlphabet() const { return model_->getAlphabet(); }
     
     const std::vector<int>& getAlphabetStates() const { return model_->getAlphabetStates(); } 
     
@@ -256,20 +301,19 @@ namespace bpp
   protected:
     
     /**
-     * @brief This method initializes the leaves according to a sequence container.
-     *
-     * Here the container shrunkData_ is used.
-     * Likelihood is set to 1 for the state corresponding to the sequence site,
-     * otherwise it is set to 0.
+     * @brief This method compresses the sites and initializes the leaves.
      *
-     * The two likelihood arrays are initialized according to alphabet
-     * size and sequences length, and filled with 1.
+     * Each distinct pair of codes found in the two sequences defines a site pattern.
+     * Leaf likelihoods are set according to the model for the states of each pattern.
      *
-     * NB: This method is recursive.
+     * The likelihood arrays are initialized according to alphabet
+     * size and number of patterns, and filled with 1.
      *
-     * @param sequences The sequence container to use.
+     * @param codes1 The first encoded sequence.
+     * @param codes2 The second encoded sequence.
+     * @param states The alphabet state corresponding to each code.
      */
-    virtual void initTreeLikelihoods(const SequenceContainer & sequences);
+    virtual void initTreeLikelihoods(const std::vector<StateCode>& codes1, const std::vector<StateCode>& codes2, const std::vector<int>& states);
 
     void fireParameterChanged(const ParameterList & params);
     virtual void computeTreeLikelihood();
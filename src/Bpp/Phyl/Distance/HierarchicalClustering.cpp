@@ -111,8 +111,19 @@ vector<double> HierarchicalClustering::computeBranchLengthsForPair(const vector<
 }
 
 double HierarchicalClustering::computeDistancesFromPair(const vector<size_t>& pair, const vector<double>& branchLengths, size_t pos)
+{
+  size_t n1 = dynamic_cast<NodeTemplate<ClusterInfos>*>(currentNodes_[pair[0]])->getInfos().numberOfLeaves;
+  size_t n2 = dynamic_cast<NodeTemplate<ClusterInfos>*>(currentNodes_[pair[1]])->getInfos().numberOfLeaves;
+  size_t n3 = dynamic_cast<NodeTemplate<ClusterInfos>*>(currentNodes_[pos])->getInfos().numberOfLeaves;
+  return computeLinkage(matrix_(pair[0], pos), matrix_(pair[1], pos), matrix_(pair[0], pair[1]), n1, n2, n3);
+}
+
+double HierarchicalClustering::computeLinkage(double d1, double d2, double d3, size_t s1, size_t s2, size_t s3) const
 {
   double w1, w2, w3, w4;
+  double n1 = static_cast<double>(s1);
+  double n2 = static_cast<double>(s2);
+  double n3 = static_cast<double>(s3);
   if (method_ == "Single")
   {
     w1 = .5;
@@ -136,8 +147,6 @@ double HierarchicalClustering::computeDistancesFromPair(const vector<size_t>& pa
   }
   else if (method_ == "Average")
   {
-    double n1 = static_cast<double>(dynamic_cast<NodeTemplate<ClusterInfos>*>(currentNodes_[pair[0]])->getInfos().numberOfLeaves);
-    double n2 = static_cast<double>(dynamic_cast<NodeTemplate<ClusterInfos>*>(currentNodes_[pair[1]])->getInfos().numberOfLeaves);
     w1 = n1 / (n1 + n2);
     w2 = n2 / (n1 + n2);
     w3 = 0.;
@@ -145,9 +154,6 @@ double HierarchicalClustering::computeDistancesFromPair(const vector<size_t>& pa
   }
   else if (method_ == "Ward")
   {
-    double n1 = static_cast<double>(dynamic_cast<NodeTemplate<ClusterInfos>*>(currentNodes_[pair[0]])->getInfos().numberOfLeaves);
-    double n2 = static_cast<double>(dynamic_cast<NodeTemplate<ClusterInfos>*>(currentNodes_[pair[1]])->getInfos().numberOfLeaves);
-    double n3 = static_cast<double>(dynamic_cast<NodeTemplate<ClusterInfos>*>(currentNodes_[pos])->getInfos().numberOfLeaves);
     w1 = (n1 + n3) / (n1 + n2 + n3);
     w2 = (n2 + n3) / (n1 + n2 + n3);
     w3 = -n3 / (n1 + n2 + n3);
@@ -155,8 +161,6 @@ double HierarchicalClustering::computeDistancesFromPair(const vector<size_t>& pa
   }
   else if (method_ == "Centroid")
   {
-    double n1 = static_cast<double>(dynamic_cast<NodeTemplate<ClusterInfos>*>(currentNodes_[pair[0]])->getInfos().numberOfLeaves);
-    double n2 = static_cast<double>(dynamic_cast<NodeTemplate<ClusterInfos>*>(currentNodes_[pair[1]])->getInfos().numberOfLeaves);
     w1 = n1 / (n1 + n2);
     w2 = n2 / (n1 + n2);
     w3 = -n1 * n2 / pow(n1 + n2, 2.);
@@ -164,12 +168,22 @@ double HierarchicalClustering::computeDistancesFromPair(const vector<size_t>& pa
   }
   else
     throw Exception("HierarchicalClustering::computeBranchLengthsForPair. unknown method '" + method_ + "'.");
-  double d1 = matrix_(pair[0], pos);
-  double d2 = matrix_(pair[1], pos);
-  double d3 = matrix_(pair[0], pair[1]);
   return w1 * d1 + w2 * d2 + w3 * d3 + w4* std::abs(d1 - d2);
 }
 
+bool HierarchicalClustering::hasReducibleLinkage() const
+{
+  return method_ == SINGLE || method_ == COMPLETE || method_ == AVERAGE || method_ == WARD;
+}
+
+void HierarchicalClustering::computeTree()
+{
+  if (compactEngine_ && hasReducibleLinkage())
+    computeTreeByNearestNeighborChain();
+  else
+    AbstractAgglomerativeDistanceMethod::computeTree();
+}
+
 void HierarchicalClustering::finalStep(int idRoot)
 {
   NodeTemplate<ClusterInfos>* root = new NodeTemplate<ClusterInfos>(idRoot);
@@ -60,6 +60,11 @@ public:
  * @brief Hierarchical clustering.
  *
  * This class implements the complete, single, average (= UPGMA), median, ward and centroid linkage methods.
+ *
+ * The complete, single, average and ward linkages are reducible: if the
+ * compact engine is enabled (the default), the tree is built with the
+ * nearest-neighbor chain algorithm in O(n^2) time. The median and centroid
+ * linkages always use the generic algorithm.
  */
 class HierarchicalClustering :
   public AbstractAgglomerativeDistanceMethod
@@ -83,7 +88,7 @@ public:
    * @param verbose Tell if some progress information should be displayed.
    */
   HierarchicalClustering(const std::string& method, bool verbose = false) :
-    AbstractAgglomerativeDistanceMethod(verbose),
+    AbstractAgglomerativeDistanceMethod(verbose, true),
     method_(method) {}
   HierarchicalClustering(const std::string& method, const DistanceMatrix& matrix, bool verbose = false) :
     AbstractAgglomerativeDistanceMethod(matrix, verbose, true),
@@ -101,6 +106,8 @@ public:
 
   TreeTemplate<Node>* getTree() const;
 
+  void computeTree();
+
 protected:
   std::vector<size_t> getBestPair();
   std::vector<double> computeBranchLengthsForPair(const std::vector<size_t>& pair);
@@ -108,6 +115,8 @@ protected:
   void finalStep(int idRoot);
   virtual Node* getLeafNode(int id, const std::string& name);
   virtual Node* getParentNode(int id, Node* son1, Node* son2);
+  bool hasReducibleLinkage() const;
+  double computeLinkage(double d1, double d2, double d12, size_t n1, size_t n2, size_t n3) const;
 };
 } // end of namespace bpp.
 
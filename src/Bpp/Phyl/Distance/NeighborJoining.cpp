@@ -41,10 +41,14 @@
 #include "NeighborJoining.h"
 #include "../Tree.h"
 
+#include <Bpp/App/ApplicationTools.h>
+
 using namespace bpp;
 
 #include <cmath>
 #include <iostream>
+#include <algorithm>
+#include <limits>
 
 using namespace std;
 
@@ -157,3 +161,294 @@ void NeighborJoining::finalStep(int idRoot)
   tree_ = new TreeTemplate<Node>(root);
 }
 
+
+void NeighborJoining::computeTree()
+{
+  if (compactEngine_)
+    computeCompactTree();
+  else
+  {
+    useFullMatrix();
+    sumDist_.resize(matrix_.size());
+    AbstractAgglomerativeDistanceMethod::computeTree();
+  }
+}
+
+namespace
+{
+  // Order of sorted rows.
+  struct SortedDistanceComparator
+  {
+    template<class T>
+    bool operator()(const T& a, const T& b) const { return a.distance < b.distance; }
+  };
+
+  // Round a distance down to single precision.
+  float roundDown(double d)
+  {
+    float f = static_cast<float>(d);
+    if (static_cast<double>(f) > d)
+      f = std::nextafter(f, -std::numeric_limits<float>::infinity());
+    return f;
+  }
+
+  // A candidate pair, with keys k1 < k2.
+  struct CandidatePair
+  {
+    double crit;
+    size_t k1, k2;
+    size_t pos1, pos2;
+
+    CandidatePair() :
+      crit(-std::numeric_limits<double>::infinity()),
+      k1(0), k2(0), pos1(0), pos2(0) {}
+
+    // The criterion is maximized, ties are resolved in the order of keys,
+    // as in the generic algorithm.
+    bool isBetterThan(const CandidatePair& c) const
+    {
+      if (crit != c.crit) return crit > c.crit;
+      if (k1 != c.k1) return k1 < c.k1;
+      return k2 < c.k2;
+    }
+  };
+}
+
+void NeighborJoining::initCompactEngine()
+{
+  AbstractAgglomerativeDistanceMethod::initCompactEngine();
+  size_t n = compactMatrix_.size();
+  sumDist_.assign(n, 0.);
+  for (size_t i = 1; i < n; ++i)
+  {
+    const double* row = compactMatrix_.getRow(i);
+    for (size_t j = 0; j < i; ++j)
+    {
+      sumDist_[i] += row[j];
+      sumDist_[j] += row[j];
+    }
+  }
+  compactSerials_.resize(n);
+  serialPositions_.resize(2 * n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    compactSerials_[i] = i;
+    serialPositions_[i] = i;
+  }
+  for (size_t i = n; i < 2 * n; ++i)
+  {
+    serialPositions_[i] = static_cast<size_t>(-1);
+  }
+  sortedRows_.clear();
+  sortedRows_.resize(2 * n);
+  // Leaves only store distances to leaves with a lower index.
+  long ln = static_cast<long>(n);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+  for (long li = 0; li < ln; ++li)
+  {
+    size_t i = static_cast<size_t>(li);
+    vector<SortedDistance>& sortedRow = sortedRows_[i];
+    sortedRow.resize(i);
+    const double* row = compactMatrix_.getRow(i);
+    for (size_t j = 0; j < i; ++j)
+    {
+      sortedRow[j].distance = roundDown(row[j]);
+      sortedRow[j].serial = static_cast<unsigned int>(j);
+    }
+    std::sort(sortedRow.begin(), sortedRow.end(), SortedDistanceComparator());
+  }
+}
+
+size_t NeighborJoining::removeCompactEntry(size_t pos)
+{
+  serialPositions_[compactSerials_[pos]] = static_cast<size_t>(-1);
+  size_t last = AbstractAgglomerativeDistanceMethod::removeCompactEntry(pos);
+  if (last != pos)
+  {
+    sumDist_[pos] = sumDist_[last];
+    compactSerials_[pos] = compactSerials_[last];
+    serialPositions_[compactSerials_[pos]] = pos;
+  }
+  sumDist_.pop_back();
+  compactSerials_.pop_back();
+  return last;
+}
+
+void NeighborJoining::buildSortedRow_(size_t pos)
+{
+  size_t r = compactMatrix_.size();
+  vector<SortedDistance>& sortedRow = sortedRows_[compactSerials_[pos]];
+  sortedRow.resize(r - 1);
+  size_t k = 0;
+  for (size_t j = 0; j < r; ++j)
+  {
+    if (j == pos) continue;
+    sortedRow[k].distance = roundDown(compactMatrix_(pos, j));
+    sortedRow[k].serial = static_cast<unsigned int>(compactSerials_[j]);
+    k++;
+  }
+  std::sort(sortedRow.begin(), sortedRow.end(), SortedDistanceComparator());
+}
+
+void NeighborJoining::purgeSortedRows_()
+{
+  long ls = static_cast<long>(sortedRows_.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+  for (long s = 0; s < ls; ++s)
+  {
+    vector<SortedDistance>& sortedRow = sortedRows_[static_cast<size_t>(s)];
+    if (serialPositions_[static_cast<size_t>(s)] == static_cast<size_t>(-1))
+    {
+      vector<SortedDistance>().swap(sortedRow);
+      continue;
+    }
+    size_t k = 0;
+    for (size_t j = 0; j < sortedRow.size(); ++j)
+    {
+      if (serialPositions_[sortedRow[j].serial] != static_cast<size_t>(-1))
+        sortedRow[k++] = sortedRow[j];
+    }
+    sortedRow.resize(k);
+  }
+}
+
+void NeighborJoining::computeCompactDistancesFromPair(size_t pos1, size_t pos2, const std::vector<double>& branchLengths, std::vector<double>& newDist)
+{
+  for (size_t k = 0; k < compactMatrix_.size(); ++k)
+  {
+    if (k == pos1 || k == pos2) continue;
+    double d = .5 * (compactMatrix_(pos1, k) - branchLengths[0] + compactMatrix_(pos2, k) - branchLengths[1]);
+    newDist[k] = positiveLengths_ ? std::max(d, 0.) : d;
+  }
+}
+
+void NeighborJoining::computeCompactTree()
+{
+  initCompactEngine();
+  size_t n = compactMatrix_.size();
+  size_t nbStop = rootTree_ ? 2 : 3;
+  int idNextNode = static_cast<int>(n);
+  size_t nextSerial = n;
+  size_t lastPurge = n;
+  vector<double> newDist(n);
+  vector<double> d(2);
+
+  while (compactMatrix_.size() > nbStop)
+  {
+    size_t r = compactMatrix_.size();
+    if (verbose_)
+      ApplicationTools::displayGauge(n - r, n - nbStop - 1);
+
+    // Remove merged nodes from the sorted rows every time the number of nodes is halved:
+    if (2 * r < lastPurge)
+    {
+      purgeSortedRows_();
+      lastPurge = r;
+    }
+
+    double maxSum = *std::max_element(sumDist_.begin(), sumDist_.end());
+    double nm2 = static_cast<double>(r - 2);
+
+    // Find the best pair. Each pair of nodes appears in the row of the most
+    // recent of the two nodes.
+    CandidatePair best;
+    long lr = static_cast<long>(r);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+      CandidatePair localBest;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16) nowait
+#endif
+      for (long lp = 0; lp < lr; ++lp)
+      {
+        size_t p = static_cast<size_t>(lp);
+        const vector<SortedDistance>& sortedRow = sortedRows_[compactSerials_[p]];
+        double sp = sumDist_[p];
+        for (size_t j = 0; j < sortedRow.size(); ++j)
+        {
+          // Upper bound of the criterion for all remaining pairs in this row:
+          if (sp + maxSum - nm2 * static_cast<double>(sortedRow[j].distance) < localBest.crit)
+            break;
+          size_t q = serialPositions_[sortedRow[j].serial];
+          if (q == static_cast<size_t>(-1))
+            continue;
+          CandidatePair c;
+          c.k1 = compactKeys_[p];
+          c.k2 = compactKeys_[q];
+          c.pos1 = p;
+          c.pos2 = q;
+          if (c.k1 > c.k2)
+          {
+            std::swap(c.k1, c.k2);
+            std::swap(c.pos1, c.pos2);
+          }
+          c.crit = sumDist_[c.pos1] + sumDist_[c.pos2] - nm2 * compactMatrix_(p, q);
+          if (c.isBetterThan(localBest))
+            localBest = c;
+        }
+      }
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+      {
+        if (localBest.isBetterThan(best))
+          best = localBest;
+      }
+    }
+
+    if (best.crit == -std::numeric_limits<double>::infinity())
+      throw Exception("Unexpected error: no maximum criterium found.");
+
+    size_t p1 = best.pos1;
+    size_t p2 = best.pos2;
+    double d12 = compactMatrix_(p1, p2);
+    double ratio = (sumDist_[p1] - sumDist_[p2]) / nm2;
+    if (positiveLengths_)
+    {
+      d[0] = std::max(.5 * (d12 + ratio), 0.);
+      d[1] = std::max(.5 * (d12 - ratio), 0.);
+    }
+    else
+    {
+      d[0] = .5 * (d12 + ratio);
+      d[1] = .5 * (d12 - ratio);
+    }
+    Node* best1 = compactNodes_[p1];
+    Node* best2 = compactNodes_[p2];
+    best1->setDistanceToFather(d[0]);
+    best2->setDistanceToFather(d[1]);
+    Node* parent = getParentNode(idNextNode++, best1, best2);
+
+    // Update distances and sums:
+    newDist.resize(r);
+    computeCompactDistancesFromPair(p1, p2, d, newDist);
+    double newSum = 0;
+    for (size_t k = 0; k < r; ++k)
+    {
+      if (k == p1 || k == p2) continue;
+      sumDist_[k] += newDist[k] - compactMatrix_(p1, k) - compactMatrix_(p2, k);
+      newSum += newDist[k];
+    }
+    newDist[p1] = newDist[p2] = 0;
+    compactMatrix_.setRow(p1, newDist);
+    sumDist_[p1] = newSum;
+    compactNodes_[p1] = parent;
+    // The new node keeps the smallest key, which is the one of p1:
+    serialPositions_[compactSerials_[p1]] = static_cast<size_t>(-1);
+    compactSerials_[p1] = nextSerial;
+    serialPositions_[nextSerial] = p1;
+    nextSerial++;
+    removeCompactEntry(p2);
+    buildSortedRow_(serialPositions_[nextSerial - 1]);
+  }
+  sortedRows_.clear();
+  serialPositions_.clear();
+  compactSerials_.clear();
+  compactFinalStep(idNextNode);
+}
@@ -51,6 +51,18 @@ namespace bpp
  *
  * Reference:
  * N Saitou and M Nei (1987), _Molecular Biology and Evolution_ 4(4) 406-25.
+ *
+ * When the compact engine is enabled (the default), the best pair search
+ * uses the bound of the RapidNJ algorithm:
+ * for each node, distances to other nodes are cached in ascending order,
+ * and the search in a row stops as soon as the criterion cannot exceed the
+ * best one found so far. Rows are scanned in parallel if OpenMP is available.
+ * The resulting tree is the same as with the generic algorithm,
+ * provided there are no ties in the criterion.
+ *
+ * Reference:
+ * Simonsen M, Mailund T and Pedersen CNS (2008), Rapid Neighbour-Joining,
+ * _Algorithms in Bioinformatics_ (WABI 2008) LNCS 5251 113-122.
  */ 
 class NeighborJoining :
   public AbstractAgglomerativeDistanceMethod
@@ -58,6 +70,34 @@ class NeighborJoining :
 	protected:
     std::vector<double> sumDist_;
     bool positiveLengths_;
+
+    /**
+     * @brief Entry of the sorted rows used by the compact engine.
+     *
+     * The distance is rounded down to single precision, so that bounds
+     * computed from it are never lower than the exact criterion.
+     */
+    struct SortedDistance
+    {
+      float distance;
+      unsigned int serial;
+    };
+
+    /**
+     * @name Compact engine storage.
+     *
+     * Nodes are identified by a serial number, given in order of creation.
+     * sortedRows_[s] contains the distances from node s to all nodes created
+     * before it, sorted in ascending order. compactSerials_[i] is the serial of
+     * entry i of the compact matrix, and serialPositions_[s] the entry of node
+     * s, or -1 if the node was merged.
+     *
+     * @{
+     */
+    std::vector< std::vector<SortedDistance> > sortedRows_;
+    std::vector<size_t> compactSerials_;
+    std::vector<size_t> serialPositions_;
+    /** @} */
 		
 	public:
     /**
@@ -70,7 +110,10 @@ class NeighborJoining :
     NeighborJoining(bool rooted = false, bool positiveLengths = false, bool verbose = true) :
       AbstractAgglomerativeDistanceMethod(verbose, rooted),
       sumDist_(),
-      positiveLengths_(false)
+      positiveLengths_(false),
+      sortedRows_(),
+      compactSerials_(),
+      serialPositions_()
     {}
 
     /**
@@ -84,7 +127,10 @@ class NeighborJoining :
 		NeighborJoining(const DistanceMatrix& matrix, bool rooted = false, bool positiveLengths = false, bool verbose = true) :
       AbstractAgglomerativeDistanceMethod(matrix, verbose, rooted),
       sumDist_(),
-      positiveLengths_(positiveLengths) 
+      positiveLengths_(positiveLengths),
+      sortedRows_(),
+      compactSerials_(),
+      serialPositions_()
 		{
 			sumDist_.resize(matrix.size());
 			computeTree();
@@ -104,6 +150,13 @@ class NeighborJoining :
 		}
 
     virtual void outputPositiveLengths(bool yn) { positiveLengths_ = yn; }
+
+    /**
+     * @brief Compute the tree corresponding to the distance matrix.
+     *
+     * Use the compact engine if it is enabled, the generic algorithm otherwise.
+     */
+    virtual void computeTree();
 	
 	protected:
 		std::vector<size_t> getBestPair();
@@ -111,6 +164,35 @@ class NeighborJoining :
 		double computeDistancesFromPair(const std::vector<size_t>& pair, const std::vector<double>& branchLengths, size_t pos);
 		void finalStep(int idRoot);	
 
+    /**
+     * @name Compact engine.
+     *
+     * @{
+     */
+
+    /**
+     * @brief Agglomerate all nodes using the compact engine.
+     */
+    void computeCompactTree();
+
+    /**
+     * @brief Compute the distances from the pair to agglomerate in the compact engine.
+     *
+     * @param pos1 The entry of the first node of the pair.
+     * @param pos2 The entry of the second node of the pair.
+     * @param branchLengths The branch lengths of the two nodes of the pair.
+     * @param newDist [out] The distances between each remaining entry and the new node.
+     * Elements pos1 and pos2 are ignored.
+     */
+    virtual void computeCompactDistancesFromPair(size_t pos1, size_t pos2, const std::vector<double>& branchLengths, std::vector<double>& newDist);
+
+    void initCompactEngine();
+    size_t removeCompactEntry(size_t pos);
+    /** @} */
+
+  private:
+    void buildSortedRow_(size_t pos);
+    void purgeSortedRows_();
 };
 
 } //end of namespace bpp.
@@ -96,7 +96,26 @@ vector<double> PGMA::computeBranchLengthsForPair(const vector<size_t>& pair)
   return d;
 }
 
+void PGMA::computeTree()
+{
+  if (compactEngine_)
+    computeTreeByNearestNeighborChain();
+  else
+    AbstractAgglomerativeDistanceMethod::computeTree();
+}
+
 double PGMA::computeDistancesFromPair(const vector<size_t>& pair, const vector<double>& branchLengths, size_t pos)
+{
+  size_t n1 = 1, n2 = 1;
+  if (!weighted_)
+  {
+    n1 = dynamic_cast<NodeTemplate<PGMAInfos>*>(currentNodes_[pair[0]])->getInfos().numberOfLeaves;
+    n2 = dynamic_cast<NodeTemplate<PGMAInfos>*>(currentNodes_[pair[1]])->getInfos().numberOfLeaves;
+  }
+  return computeLinkage(matrix_(pair[0], pos), matrix_(pair[1], pos), matrix_(pair[0], pair[1]), n1, n2, 1);
+}
+
+double PGMA::computeLinkage(double d1, double d2, double d12, size_t n1, size_t n2, size_t n3) const
 {
   double w1, w2;
   if (weighted_)
@@ -106,10 +125,10 @@ double PGMA::computeDistancesFromPair(const vector<size_t>& pair, const vector<d
   }
   else
   {
-    w1 = static_cast<double>(dynamic_cast<NodeTemplate<PGMAInfos>*>(currentNodes_[pair[0]])->getInfos().numberOfLeaves);
-    w2 = static_cast<double>(dynamic_cast<NodeTemplate<PGMAInfos>*>(currentNodes_[pair[1]])->getInfos().numberOfLeaves);
+    w1 = static_cast<double>(n1);
+    w2 = static_cast<double>(n2);
   }
-  return (w1 * matrix_(pair[0], pos) + w2 * matrix_(pair[1], pos)) / (w1 + w2);
+  return (w1 * d1 + w2 * d2) / (w1 + w2);
 }
 
 void PGMA::finalStep(int idRoot)
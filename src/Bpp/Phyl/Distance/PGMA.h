@@ -62,6 +62,9 @@ struct PGMAInfos
  * is equivalent to the average linkage hierarchical clustering method.
  * The distance between two taxa is the average distance between all individuals in each taxa.
  * The unweighted version (named UPGMA), uses a weighted average, with the number of individuals in a group as a weight.
+ *
+ * Both linkages are reducible: if the compact engine is enabled (the default),
+ * the tree is built with the nearest-neighbor chain algorithm in O(n^2) time.
  */
 class PGMA :
   public AbstractAgglomerativeDistanceMethod
@@ -101,6 +104,8 @@ public:
 
   TreeTemplate<Node>* getTree() const;
 
+  void computeTree();
+
   void setWeighted(bool weighted) { weighted_ = weighted; }
   bool isWeighted() const { return weighted_; }
 
@@ -111,6 +116,8 @@ protected:
   void finalStep(int idRoot);
   virtual Node* getLeafNode(int id, const std::string& name);
   virtual Node* getParentNode(int id, Node* son1, Node* son2);
+  bool hasReducibleLinkage() const { return true; }
+  double computeLinkage(double d1, double d2, double d12, size_t n1, size_t n2, size_t n3) const;
 };
 } // end of namespace bpp.
 
@@ -0,0 +1,247 @@
+//
+// File: BinaryDistanceMatrixFormat.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include "BinaryDistanceMatrixFormat.h"
+
+using namespace bpp;
+
+// From the STL:
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+using namespace std;
+
+static const char BINARY_DISTANCE_MAGIC[8] = { 'B', 'P', 'P', 'D', 'I', 'S', 'T', '\0' };
+static const uint32_t BINARY_DISTANCE_VERSION = 1;
+static const uint32_t BINARY_DISTANCE_BYTE_ORDER = 0x01020304;
+
+uint64_t BinaryDistanceMatrixFormat::getRemainingLength_(istream& in)
+{
+  streampos position = in.tellg();
+  if (position == streampos(-1))
+    return numeric_limits<uint64_t>::max();
+  in.seekg(0, ios::end);
+  streampos end = in.tellg();
+  in.seekg(position);
+  if (!in || end == streampos(-1) || end < position)
+    return numeric_limits<uint64_t>::max();
+  return static_cast<uint64_t>(end - position);
+}
+
+size_t BinaryDistanceMatrixFormat::readHeader_(istream& in, vector<string>& names)
+{
+  char magic[8];
+  uint32_t version = 0, byteOrder = 0;
+  uint64_t n = 0, namesSize = 0;
+  in.read(magic, 8);
+  in.read(reinterpret_cast<char*>(&version), sizeof(version));
+  in.read(reinterpret_cast<char*>(&byteOrder), sizeof(byteOrder));
+  in.read(reinterpret_cast<char*>(&n), sizeof(n));
+  in.read(reinterpret_cast<char*>(&namesSize), sizeof(namesSize));
+  if (!in || memcmp(magic, BINARY_DISTANCE_MAGIC, 8) != 0)
+    throw IOException("BinaryDistanceMatrixFormat::readHeader_. Not a binary distance matrix file.");
+  if (byteOrder != BINARY_DISTANCE_BYTE_ORDER)
+    throw IOException("BinaryDistanceMatrixFormat::readHeader_. File was written with a different byte order.");
+  if (version != BINARY_DISTANCE_VERSION)
+    throw IOException("BinaryDistanceMatrixFormat::readHeader_. Unsupported format version: " + TextTools::toString(version) + ".");
+  // Each name takes at least one byte, and the block of names is checked against the remaining length, if known,
+  // so that a corrupted header does not trigger a huge allocation:
+  if (n > namesSize || namesSize > static_cast<uint64_t>(numeric_limits<streamsize>::max()) - 8)
+    throw IOException("BinaryDistanceMatrixFormat::readHeader_. Bad header.");
+  uint64_t blockSize = namesSize + (8 - namesSize % 8) % 8;
+  if (getRemainingLength_(in) < blockSize)
+    throw IOException("BinaryDistanceMatrixFormat::readHeader_. Block of names larger than the remaining data.");
+  // Otherwise, the block only grows as data is actually read:
+  vector<char> block;
+  while (block.size() < blockSize)
+  {
+    size_t done = block.size();
+    size_t chunk = static_cast<size_t>(min<uint64_t>(blockSize - done, 1 << 20));
+    block.resize(done + chunk);
+    in.read(&block[done], static_cast<streamsize>(chunk));
+    if (!in)
+      throw IOException("BinaryDistanceMatrixFormat::readHeader_. Unexpected end of file.");
+  }
+  names.resize(static_cast<size_t>(n));
+  size_t pos = 0;
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    size_t end = pos;
+    while (end < namesSize && block[end] != '\0') end++;
+    if (end == namesSize)
+      throw IOException("BinaryDistanceMatrixFormat::readHeader_. Bad block of names.");
+    names[i].assign(&block[pos], end - pos);
+    pos = end + 1;
+  }
+  return 8 + 2 * sizeof(uint32_t) + 2 * sizeof(uint64_t) + block.size();
+}
+
+void BinaryDistanceMatrixFormat::writeHeader_(ostream& out, const vector<string>& names)
+{
+  uint64_t n = names.size();
+  uint64_t namesSize = 0;
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    namesSize += names[i].size() + 1;
+  }
+  out.write(BINARY_DISTANCE_MAGIC, 8);
+  out.write(reinterpret_cast<const char*>(&BINARY_DISTANCE_VERSION), sizeof(BINARY_DISTANCE_VERSION));
+  out.write(reinterpret_cast<const char*>(&BINARY_DISTANCE_BYTE_ORDER), sizeof(BINARY_DISTANCE_BYTE_ORDER));
+  out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+  out.write(reinterpret_cast<const char*>(&namesSize), sizeof(namesSize));
+  for (size_t i = 0; i < names.size(); ++i)
+  {
+    out.write(names[i].c_str(), static_cast<streamsize>(names[i].size() + 1));
+  }
+  const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  out.write(padding, static_cast<streamsize>((8 - namesSize % 8) % 8));
+}
+
+DistanceMatrix* BinaryDistanceMatrixFormat::readDistanceMatrix(const string& path) const
+{
+  ifstream input(path.c_str(), ios::in | ios::binary);
+  if (!input)
+    throw IOException("BinaryDistanceMatrixFormat::readDistanceMatrix. Could not open file '" + path + "'.");
+  return readDistanceMatrix(input);
+}
+
+DistanceMatrix* BinaryDistanceMatrixFormat::readDistanceMatrix(istream& in) const
+{
+  vector<string> names;
+  readHeader_(in, names);
+  size_t n = names.size();
+  if (getRemainingLength_(in) / sizeof(double) < CondensedDistanceMatrix::getNumberOfPairs(n))
+    throw IOException("BinaryDistanceMatrixFormat::readDistanceMatrix. Unexpected end of file.");
+  unique_ptr<DistanceMatrix> dist(new DistanceMatrix(names));
+  // Rows are read one at a time:
+  vector<double> row(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (i > 0)
+      in.read(reinterpret_cast<char*>(&row[0]), static_cast<streamsize>(i * sizeof(double)));
+    if (!in)
+      throw IOException("BinaryDistanceMatrixFormat::readDistanceMatrix. Unexpected end of file.");
+    (*dist)(i, i) = 0.;
+    for (size_t j = 0; j < i; ++j)
+    {
+      (*dist)(i, j) = (*dist)(j, i) = row[j];
+    }
+  }
+  return dist.release();
+}
+
+CondensedDistanceMatrix* BinaryDistanceMatrixFormat::readCondensedDistanceMatrix(const string& path) const
+{
+  ifstream input(path.c_str(), ios::in | ios::binary);
+  if (!input)
+    throw IOException("BinaryDistanceMatrixFormat::readCondensedDistanceMatrix. Could not open file '" + path + "'.");
+  vector<string> names;
+  size_t offset = readHeader_(input, names);
+  // Check that all values are there before mapping the file:
+  input.seekg(0, ios::end);
+  size_t length = static_cast<size_t>(input.tellg());
+  input.close();
+  if (length < offset + CondensedDistanceMatrix::getNumberOfPairs(names.size()) * sizeof(double))
+    throw IOException("BinaryDistanceMatrixFormat::readCondensedDistanceMatrix. File '" + path + "' is truncated.");
+  return new CondensedDistanceMatrix(names, path, offset);
+}
+
+CondensedDistanceMatrix* BinaryDistanceMatrixFormat::readCondensedDistanceMatrix(istream& in) const
+{
+  vector<string> names;
+  readHeader_(in, names);
+  size_t nbPairs = CondensedDistanceMatrix::getNumberOfPairs(names.size());
+  if (getRemainingLength_(in) / sizeof(double) < nbPairs)
+    throw IOException("BinaryDistanceMatrixFormat::readCondensedDistanceMatrix. Unexpected end of file.");
+  unique_ptr<CondensedDistanceMatrix> dist(new CondensedDistanceMatrix(names));
+  if (nbPairs > 0)
+    in.read(reinterpret_cast<char*>(dist->getRow(1)), static_cast<streamsize>(nbPairs * sizeof(double)));
+  if (!in)
+    throw IOException("BinaryDistanceMatrixFormat::readCondensedDistanceMatrix. Unexpected end of file.");
+  return dist.release();
+}
+
+void BinaryDistanceMatrixFormat::writeDistanceMatrix(const DistanceMatrix& dist, const string& path, bool overwrite) const
+{
+  if (!overwrite)
+    throw IOException("BinaryDistanceMatrixFormat::writeDistanceMatrix. Matrices cannot be appended to a binary file.");
+  ofstream output(path.c_str(), ios::out | ios::binary);
+  writeDistanceMatrix(dist, output);
+  output.close();
+}
+
+void BinaryDistanceMatrixFormat::writeDistanceMatrix(const DistanceMatrix& dist, ostream& out) const
+{
+  writeHeader_(out, dist.getNames());
+  size_t n = dist.size();
+  vector<double> row(n);
+  for (size_t i = 1; i < n; ++i)
+  {
+    for (size_t j = 0; j < i; ++j)
+    {
+      row[j] = dist(i, j);
+    }
+    out.write(reinterpret_cast<const char*>(&row[0]), static_cast<streamsize>(i * sizeof(double)));
+  }
+  if (!out)
+    throw IOException("BinaryDistanceMatrixFormat::writeDistanceMatrix. Could not write matrix.");
+}
+
+void BinaryDistanceMatrixFormat::writeCondensedDistanceMatrix(const CondensedDistanceMatrix& dist, const string& path, bool overwrite) const
+{
+  if (!overwrite)
+    throw IOException("BinaryDistanceMatrixFormat::writeCondensedDistanceMatrix. Matrices cannot be appended to a binary file.");
+  ofstream output(path.c_str(), ios::out | ios::binary);
+  writeCondensedDistanceMatrix(dist, output);
+  output.close();
+}
+
+void BinaryDistanceMatrixFormat::writeCondensedDistanceMatrix(const CondensedDistanceMatrix& dist, ostream& out) const
+{
+  writeHeader_(out, dist.getNames());
+  size_t nbPairs = CondensedDistanceMatrix::getNumberOfPairs(dist.size());
+  // The condensed storage is written as is:
+  if (nbPairs > 0)
+    out.write(reinterpret_cast<const char*>(dist.getRow(1)), static_cast<streamsize>(nbPairs * sizeof(double)));
+  if (!out)
+    throw IOException("BinaryDistanceMatrixFormat::writeCondensedDistanceMatrix. Could not write matrix.");
+}
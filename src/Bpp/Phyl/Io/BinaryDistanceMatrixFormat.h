@@ -0,0 +1,129 @@
+//
+// File: BinaryDistanceMatrixFormat.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _BINARYDISTANCEMATRIXFORMAT_H_
+#define _BINARYDISTANCEMATRIXFORMAT_H_
+
+#include "IoDistanceMatrix.h"
+
+// From the STL:
+#include <cstdint>
+#include <vector>
+#include <string>
+
+namespace bpp
+{
+
+/**
+ * @brief Distance matrix I/O in a condensed binary format.
+ *
+ * The file starts with a header, made of:
+ * - the 8 characters "BPPDIST\0",
+ * - the format version, as a 32 bits integer,
+ * - a byte order mark (0x01020304), as a 32 bits integer,
+ * - the number of entries n, as a 64 bits integer,
+ * - the size in bytes of the block of names, as a 64 bits integer,
+ * - the names of the entries, each terminated by a null character,
+ * - padding bytes up to the next multiple of 8.
+ * It is followed by the n(n-1)/2 values of the strict lower triangle of the
+ * matrix, row after row, as double precision numbers (see CondensedDistanceMatrix).
+ *
+ * Numbers are stored in the native byte order of the machine which wrote the
+ * file, and files written on a machine with a different byte order are rejected.
+ *
+ * Condensed matrices read from a file are memory-mapped, so that very large
+ * matrices are loaded lazily by the operating system. The file should therefore
+ * not be modified while the matrix is in use.
+ */
+class BinaryDistanceMatrixFormat:
+  public AbstractIDistanceMatrix,
+  public AbstractODistanceMatrix
+{
+  public:
+    BinaryDistanceMatrixFormat() {}
+    virtual ~BinaryDistanceMatrixFormat() {}
+
+  public:
+    const std::string getFormatName() const { return "Binary"; }
+
+    const std::string getFormatDescription() const { return "Condensed binary matrix, with native byte order."; }
+
+    DistanceMatrix* readDistanceMatrix(const std::string& path) const;
+    DistanceMatrix* readDistanceMatrix(std::istream& in) const;
+
+    CondensedDistanceMatrix* readCondensedDistanceMatrix(const std::string& path) const;
+    CondensedDistanceMatrix* readCondensedDistanceMatrix(std::istream& in) const;
+
+    /**
+     * @copydoc ODistanceMatrix::writeDistanceMatrix(const DistanceMatrix&, const std::string&, bool) const
+     *
+     * Matrices cannot be appended to an existing file in this format.
+     */
+    void writeDistanceMatrix(const DistanceMatrix& dist, const std::string& path, bool overwrite = true) const;
+    void writeDistanceMatrix(const DistanceMatrix& dist, std::ostream& out) const;
+
+    /**
+     * @copydoc ODistanceMatrix::writeCondensedDistanceMatrix(const CondensedDistanceMatrix&, const std::string&, bool) const
+     *
+     * Matrices cannot be appended to an existing file in this format.
+     */
+    void writeCondensedDistanceMatrix(const CondensedDistanceMatrix& dist, const std::string& path, bool overwrite = true) const;
+    void writeCondensedDistanceMatrix(const CondensedDistanceMatrix& dist, std::ostream& out) const;
+
+  private:
+    /**
+     * @brief Read the header of the file.
+     *
+     * @param in The input stream.
+     * @param names [out] The names of the entries.
+     * @return The size of the header, that is, the position of the first value.
+     * @throw IOException If the header is corrupted or the file is truncated.
+     */
+    static size_t readHeader_(std::istream& in, std::vector<std::string>& names);
+
+    /**
+     * @return The number of bytes left in the stream, or the largest possible value if the stream is not seekable.
+     */
+    static uint64_t getRemainingLength_(std::istream& in);
+    static void writeHeader_(std::ostream& out, const std::vector<std::string>& names);
+};
+
+} //end of namespace bpp.
+
+#endif //_BINARYDISTANCEMATRIXFORMAT_H_
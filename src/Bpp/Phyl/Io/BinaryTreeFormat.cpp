@@ -0,0 +1,566 @@
+//
+// File: BinaryTreeFormat.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include "BinaryTreeFormat.h"
+
+#include <Bpp/Text/TextTools.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BPP_USE_MMAP
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char BINARY_TREE_MAGIC[8] = { 'B', 'P', 'P', 'T', 'R', 'E', 'E', '\0' };
+static const uint32_t BINARY_TREE_VERSION = 1;
+static const uint32_t BINARY_TREE_BYTE_ORDER = 0x01020304;
+
+static_assert(sizeof(BinaryTreeFormat::Property) == 24, "Unexpected padding in BinaryTreeFormat::Property.");
+
+const uint32_t BinaryTreeFormat::NO_STRING = numeric_limits<uint32_t>::max();
+
+namespace
+{
+  size_t padded(size_t size) { return (size + 7) / 8 * 8; }
+
+  void writePadded(ostream& out, const void* data, size_t size)
+  {
+    const char padding[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    if (size > 0)
+      out.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+    out.write(padding, static_cast<streamsize>(padded(size) - size));
+  }
+
+  /**
+   * Names are stored only once in the string table of a record.
+   */
+  class StringTable
+  {
+    private:
+      map<string, uint32_t> positions_;
+      string data_;
+
+    public:
+      StringTable() : positions_(), data_() {}
+
+    public:
+      uint32_t add(const string& text)
+      {
+        map<string, uint32_t>::iterator it = positions_.find(text);
+        if (it != positions_.end())
+          return it->second;
+        if (data_.size() + text.size() + 1 >= static_cast<size_t>(BinaryTreeFormat::NO_STRING))
+          throw IOException("BinaryTreeFormat::writeRecord. Too many names in tree.");
+        uint32_t position = static_cast<uint32_t>(data_.size());
+        data_ += text;
+        data_ += '\0';
+        positions_[text] = position;
+        return position;
+      }
+
+      const string& getData() const { return data_; }
+  };
+
+  void addProperties(const PropertyMap& properties, uint32_t node, bool branch, StringTable& strings, vector<BinaryTreeFormat::Property>& entries)
+  {
+    vector<PropertyKey> keys = properties.getKeys();
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+      BinaryTreeFormat::Property entry;
+      entry.node = node;
+      entry.name = 0;
+      entry.branch = branch ? 1 : 0;
+      entry.type = 0;
+      entry.reserved = 0;
+      entry.text = BinaryTreeFormat::NO_STRING;
+      entry.number = 0;
+      switch (properties.getType(keys[i]))
+      {
+      case PropertyMap::DOUBLE:
+        entry.type = BinaryTreeFormat::Property::DOUBLE;
+        properties.getDouble(keys[i], entry.number);
+        break;
+      case PropertyMap::INTEGER:
+      {
+        int value = 0;
+        properties.getInteger(keys[i], value);
+        entry.type = BinaryTreeFormat::Property::INTEGER;
+        entry.number = value;
+        break;
+      }
+      case PropertyMap::STRING:
+      {
+        string value;
+        properties.getString(keys[i], value);
+        entry.type = BinaryTreeFormat::Property::STRING;
+        entry.text = strings.add(value);
+        break;
+      }
+      case PropertyMap::OBJECT:
+        // Other objects cannot be serialized.
+        continue;
+      }
+      entry.name = strings.add(PropertyRegistry::getName(keys[i]));
+      entries.push_back(entry);
+    }
+  }
+}
+
+/******************************************************************************/
+
+size_t BinaryTreeFormat::getHeaderSize()
+{
+  return 8 + 2 * sizeof(uint32_t);
+}
+
+void BinaryTreeFormat::readHeader(istream& in)
+{
+  char magic[8];
+  uint32_t version = 0, byteOrder = 0;
+  in.read(magic, 8);
+  in.read(reinterpret_cast<char*>(&version), sizeof(version));
+  in.read(reinterpret_cast<char*>(&byteOrder), sizeof(byteOrder));
+  if (!in || memcmp(magic, BINARY_TREE_MAGIC, 8) != 0)
+    throw IOException("BinaryTreeFormat::readHeader. Not a binary tree file.");
+  if (byteOrder != BINARY_TREE_BYTE_ORDER)
+    throw IOException("BinaryTreeFormat::readHeader. File was written with a different byte order.");
+  if (version != BINARY_TREE_VERSION)
+    throw IOException("BinaryTreeFormat::readHeader. Unsupported format version: " + TextTools::toString(version) + ".");
+}
+
+void BinaryTreeFormat::writeHeader(ostream& out)
+{
+  out.write(BINARY_TREE_MAGIC, 8);
+  out.write(reinterpret_cast<const char*>(&BINARY_TREE_VERSION), sizeof(BINARY_TREE_VERSION));
+  out.write(reinterpret_cast<const char*>(&BINARY_TREE_BYTE_ORDER), sizeof(BINARY_TREE_BYTE_ORDER));
+}
+
+/******************************************************************************/
+
+void BinaryTreeFormat::writeRecord(const Tree& tree, ostream& out)
+{
+  const TreeTemplate<Node>* ttree = dynamic_cast<const TreeTemplate<Node>*>(&tree);
+  unique_ptr< TreeTemplate<Node> > copy;
+  if (!ttree)
+  {
+    copy.reset(new TreeTemplate<Node>(tree));
+    ttree = copy.get();
+  }
+  if (!ttree->getRootNode())
+    throw IOException("BinaryTreeFormat::writeRecord. Empty tree.");
+
+  // Nodes in pre-order, with the index of their father:
+  vector<const Node*> nodes;
+  vector<int32_t> fathers;
+  vector< pair<const Node*, int32_t> > stack(1, pair<const Node*, int32_t>(ttree->getRootNode(), -1));
+  while (!stack.empty())
+  {
+    const Node* node = stack.back().first;
+    int32_t father = stack.back().second;
+    stack.pop_back();
+    if (nodes.size() >= static_cast<size_t>(numeric_limits<int32_t>::max()))
+      throw IOException("BinaryTreeFormat::writeRecord. Too many nodes in tree.");
+    int32_t index = static_cast<int32_t>(nodes.size());
+    nodes.push_back(node);
+    fathers.push_back(father);
+    for (size_t i = node->getNumberOfSons(); i > 0; --i)
+    {
+      stack.push_back(pair<const Node*, int32_t>(node->getSon(i - 1), index));
+    }
+  }
+
+  size_t n = nodes.size();
+  vector<int32_t> ids(n);
+  vector<uint32_t> names(n);
+  vector<double> lengths(n);
+  vector<Property> properties;
+  StringTable strings;
+  for (size_t i = 0; i < n; ++i)
+  {
+    const Node* node = nodes[i];
+    ids[i] = node->getId();
+    names[i] = node->hasName() ? strings.add(node->getName()) : NO_STRING;
+    lengths[i] = node->hasDistanceToFather() ? node->getDistanceToFather() : numeric_limits<double>::quiet_NaN();
+    addProperties(node->getNodeProperties(), static_cast<uint32_t>(i), false, strings, properties);
+    addProperties(node->getBranchProperties(), static_cast<uint32_t>(i), true, strings, properties);
+  }
+
+  const string& table = strings.getData();
+  uint64_t header[4];
+  header[1] = n;
+  header[2] = properties.size();
+  header[3] = table.size();
+  header[0] = 3 * sizeof(uint64_t) + 3 * padded(n * sizeof(int32_t)) + n * sizeof(double)
+              + properties.size() * sizeof(Property) + padded(table.size());
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  writePadded(out, &fathers[0], n * sizeof(int32_t));
+  writePadded(out, &ids[0], n * sizeof(int32_t));
+  writePadded(out, &names[0], n * sizeof(uint32_t));
+  writePadded(out, &lengths[0], n * sizeof(double));
+  writePadded(out, properties.empty() ? 0 : &properties[0], properties.size() * sizeof(Property));
+  writePadded(out, table.data(), table.size());
+}
+
+/******************************************************************************/
+
+BinaryTreeFormat::Layout BinaryTreeFormat::getLayout(const char* data, size_t size)
+{
+  const size_t headerSize = 4 * sizeof(uint64_t);
+  if (size < headerSize)
+    throw IOException("BinaryTreeFormat::getLayout. Truncated record.");
+  const uint64_t* header = reinterpret_cast<const uint64_t*>(data);
+  if (header[0] % 8 != 0 || header[0] > size - sizeof(uint64_t))
+    throw IOException("BinaryTreeFormat::getLayout. Truncated record.");
+  if (header[1] == 0 || header[1] > static_cast<uint64_t>(numeric_limits<int32_t>::max())
+      || header[2] > static_cast<uint64_t>(numeric_limits<uint32_t>::max())
+      || header[3] >= static_cast<uint64_t>(NO_STRING))
+    throw IOException("BinaryTreeFormat::getLayout. Bad record header.");
+  Layout layout;
+  layout.nbNodes = static_cast<size_t>(header[1]);
+  layout.nbProperties = static_cast<size_t>(header[2]);
+  layout.stringsSize = static_cast<size_t>(header[3]);
+  layout.parents = headerSize;
+  layout.ids = layout.parents + padded(layout.nbNodes * sizeof(int32_t));
+  layout.names = layout.ids + padded(layout.nbNodes * sizeof(int32_t));
+  layout.lengths = layout.names + padded(layout.nbNodes * sizeof(uint32_t));
+  layout.properties = layout.lengths + layout.nbNodes * sizeof(double);
+  layout.strings = layout.properties + layout.nbProperties * sizeof(Property);
+  layout.size = layout.strings + padded(layout.stringsSize);
+  if (layout.size != header[0] + sizeof(uint64_t))
+    throw IOException("BinaryTreeFormat::getLayout. Inconsistent record size.");
+  return layout;
+}
+
+/******************************************************************************/
+
+TreeTemplate<Node>* BinaryTreeFormat::buildTree(const char* data, const Layout& layout)
+{
+  size_t n = layout.nbNodes;
+  const int32_t* fathers = reinterpret_cast<const int32_t*>(data + layout.parents);
+  const int32_t* ids = reinterpret_cast<const int32_t*>(data + layout.ids);
+  const uint32_t* names = reinterpret_cast<const uint32_t*>(data + layout.names);
+  const double* lengths = reinterpret_cast<const double*>(data + layout.lengths);
+  const Property* properties = reinterpret_cast<const Property*>(data + layout.properties);
+  const char* strings = data + layout.strings;
+
+  // Check everything first, so that no node is created from a bad record:
+  if (layout.stringsSize > 0 && strings[layout.stringsSize - 1] != '\0')
+    throw IOException("BinaryTreeFormat::buildTree. Bad string table.");
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (i == 0 ? fathers[i] != -1 : (fathers[i] < 0 || static_cast<size_t>(fathers[i]) >= i))
+      throw IOException("BinaryTreeFormat::buildTree. Bad father index for node " + TextTools::toString(i) + ".");
+    if (names[i] != NO_STRING && names[i] >= layout.stringsSize)
+      throw IOException("BinaryTreeFormat::buildTree. Bad name for node " + TextTools::toString(i) + ".");
+  }
+  for (size_t i = 0; i < layout.nbProperties; ++i)
+  {
+    const Property& property = properties[i];
+    if (property.node >= n || property.name >= layout.stringsSize || property.type < Property::DOUBLE || property.type > Property::STRING
+        || (property.type == Property::STRING && property.text >= layout.stringsSize))
+      throw IOException("BinaryTreeFormat::buildTree. Bad property entry " + TextTools::toString(i) + ".");
+  }
+
+  vector<Node*> nodes(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    nodes[i] = names[i] == NO_STRING ? new Node(ids[i]) : new Node(ids[i], string(strings + names[i]));
+    if (!std::isnan(lengths[i]))
+      nodes[i]->setDistanceToFather(lengths[i]);
+    if (i > 0)
+      nodes[static_cast<size_t>(fathers[i])]->addSon(nodes[i]);
+  }
+
+  unordered_map<uint32_t, PropertyKey> keys;
+  for (size_t i = 0; i < layout.nbProperties; ++i)
+  {
+    const Property& property = properties[i];
+    unordered_map<uint32_t, PropertyKey>::iterator it = keys.find(property.name);
+    if (it == keys.end())
+      it = keys.insert(pair<uint32_t, PropertyKey>(property.name, PropertyRegistry::getKey(string(strings + property.name)))).first;
+    Node* node = nodes[property.node];
+    switch (property.type)
+    {
+    case Property::DOUBLE:
+      if (property.branch) node->setBranchDoubleProperty(it->second, property.number);
+      else node->setNodeDoubleProperty(it->second, property.number);
+      break;
+    case Property::INTEGER:
+      if (property.branch) node->setBranchIntegerProperty(it->second, static_cast<int>(property.number));
+      else node->setNodeIntegerProperty(it->second, static_cast<int>(property.number));
+      break;
+    case Property::STRING:
+      if (property.branch) node->setBranchStringProperty(it->second, string(strings + property.text));
+      else node->setNodeStringProperty(it->second, string(strings + property.text));
+      break;
+    }
+  }
+  return new TreeTemplate<Node>(nodes[0]);
+}
+
+/******************************************************************************/
+
+bool BinaryTreeFormat::readRecord_(istream& in, vector<uint64_t>& buffer)
+{
+  uint64_t size = 0;
+  in.read(reinterpret_cast<char*>(&size), sizeof(size));
+  if (in.gcount() == 0 && in.eof())
+    return false;
+  if (!in || size % 8 != 0)
+    throw IOException("BinaryTreeFormat::readRecord_. Bad record.");
+  // The size is checked against the remaining length, if known, so that a corrupted file does not trigger a huge allocation:
+  streampos position = in.tellg();
+  if (position != streampos(-1))
+  {
+    in.seekg(0, ios::end);
+    streampos end = in.tellg();
+    in.seekg(position);
+    if (!in || end == streampos(-1) || static_cast<uint64_t>(end - position) < size)
+      throw IOException("BinaryTreeFormat::readRecord_. Record larger than the remaining data.");
+  }
+  // Otherwise, the buffer only grows as data is actually read:
+  buffer.resize(1);
+  buffer[0] = size;
+  uint64_t done = 0;
+  while (done < size)
+  {
+    uint64_t chunk = min<uint64_t>(size - done, 1 << 20);
+    buffer.resize(1 + static_cast<size_t>((done + chunk) / 8));
+    in.read(reinterpret_cast<char*>(&buffer[1]) + done, static_cast<streamsize>(chunk));
+    if (!in)
+      throw IOException("BinaryTreeFormat::readRecord_. Unexpected end of file.");
+    done += chunk;
+  }
+  return true;
+}
+
+TreeTemplate<Node>* BinaryTreeFormat::readTree(const string& path) const
+{
+  ifstream input(path.c_str(), ios::in | ios::binary);
+  if (!input)
+    throw IOException("BinaryTreeFormat::readTree. Could not open file '" + path + "'.");
+  return readTree(input);
+}
+
+TreeTemplate<Node>* BinaryTreeFormat::readTree(istream& in) const
+{
+  readHeader(in);
+  vector<uint64_t> buffer;
+  if (!readRecord_(in, buffer))
+    throw IOException("BinaryTreeFormat::readTree. No tree was found!");
+  const char* data = reinterpret_cast<const char*>(&buffer[0]);
+  return buildTree(data, getLayout(data, buffer.size() * sizeof(uint64_t)));
+}
+
+void BinaryTreeFormat::readTrees(const string& path, vector<Tree*>& trees) const
+{
+  ifstream input(path.c_str(), ios::in | ios::binary);
+  if (!input)
+    throw IOException("BinaryTreeFormat::readTrees. Could not open file '" + path + "'.");
+  readTrees(input, trees);
+}
+
+void BinaryTreeFormat::readTrees(istream& in, vector<Tree*>& trees) const
+{
+  readHeader(in);
+  vector<uint64_t> buffer;
+  while (readRecord_(in, buffer))
+  {
+    const char* data = reinterpret_cast<const char*>(&buffer[0]);
+    trees.push_back(buildTree(data, getLayout(data, buffer.size() * sizeof(uint64_t))));
+  }
+}
+
+/******************************************************************************/
+
+void BinaryTreeFormat::writeTree(const Tree& tree, const string& path, bool overwrite) const
+{
+  vector<Tree*> trees(1, const_cast<Tree*>(&tree));
+  writeTrees(trees, path, overwrite);
+}
+
+void BinaryTreeFormat::writeTree(const Tree& tree, ostream& out) const
+{
+  writeHeader(out);
+  writeRecord(tree, out);
+  if (!out)
+    throw IOException("BinaryTreeFormat::writeTree. Could not write tree.");
+}
+
+void BinaryTreeFormat::writeTrees(const vector<Tree*>& trees, const string& path, bool overwrite) const
+{
+  // Records can be appended to an existing file, after checking its header:
+  bool append = false;
+  if (!overwrite)
+  {
+    ifstream input(path.c_str(), ios::in | ios::binary);
+    if (input && input.peek() != ifstream::traits_type::eof())
+    {
+      readHeader(input);
+      append = true;
+    }
+  }
+  ofstream output(path.c_str(), append ? (ios::out | ios::binary | ios::app) : (ios::out | ios::binary));
+  if (!output)
+    throw IOException("BinaryTreeFormat::writeTrees. Could not open file '" + path + "'.");
+  if (!append)
+    writeHeader(output);
+  for (size_t i = 0; i < trees.size(); ++i)
+  {
+    writeRecord(*trees[i], output);
+  }
+  if (!output)
+    throw IOException("BinaryTreeFormat::writeTrees. Could not write trees to file '" + path + "'.");
+}
+
+void BinaryTreeFormat::writeTrees(const vector<Tree*>& trees, ostream& out) const
+{
+  writeHeader(out);
+  for (size_t i = 0; i < trees.size(); ++i)
+  {
+    writeRecord(*trees[i], out);
+  }
+  if (!out)
+    throw IOException("BinaryTreeFormat::writeTrees. Could not write trees.");
+}
+
+/******************************************************************************/
+
+BinaryTreeFile::BinaryTreeFile(const string& path) :
+  buffer_(),
+  data_(0),
+  size_(0),
+  mapping_(0),
+  offsets_(),
+  layouts_()
+{
+  ifstream input(path.c_str(), ios::in | ios::binary);
+  if (!input)
+    throw IOException("BinaryTreeFile. Could not open file '" + path + "'.");
+  BinaryTreeFormat::readHeader(input);
+  input.seekg(0, ios::end);
+  size_ = static_cast<size_t>(input.tellg());
+
+#ifdef BPP_USE_MMAP
+  input.close();
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw IOException("BinaryTreeFile. Could not open file '" + path + "'.");
+  void* mapping = mmap(0, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED)
+    throw IOException("BinaryTreeFile. Could not map file '" + path + "' in memory.");
+  mapping_ = mapping;
+  data_ = static_cast<const char*>(mapping);
+#else
+  // Read the file in memory, in a buffer aligned on 8 bytes:
+  buffer_.resize((size_ + 7) / 8);
+  input.seekg(0, ios::beg);
+  input.read(reinterpret_cast<char*>(&buffer_[0]), static_cast<streamsize>(size_));
+  if (!input)
+    throw IOException("BinaryTreeFile. Could not read file '" + path + "'.");
+  data_ = reinterpret_cast<const char*>(&buffer_[0]);
+#endif
+
+  // Only the headers of the records are read here:
+  try
+  {
+    size_t position = BinaryTreeFormat::getHeaderSize();
+    while (position < size_)
+    {
+      BinaryTreeFormat::Layout layout = BinaryTreeFormat::getLayout(data_ + position, size_ - position);
+      offsets_.push_back(position);
+      layouts_.push_back(layout);
+      position += layout.size;
+    }
+  }
+  catch (Exception& e)
+  {
+#ifdef BPP_USE_MMAP
+    munmap(mapping_, size_);
+#endif
+    throw IOException("BinaryTreeFile. Bad file '" + path + "': " + e.what());
+  }
+}
+
+BinaryTreeFile::~BinaryTreeFile()
+{
+#ifdef BPP_USE_MMAP
+  if (mapping_)
+    munmap(mapping_, size_);
+#endif
+}
+
+TreeTemplate<Node>* BinaryTreeFile::getTree(size_t i) const
+{
+  // The index is checked before the layout is used:
+  const BinaryTreeFormat::Layout& layout = getLayout(i);
+  return BinaryTreeFormat::buildTree(getRecord_(i), layout);
+}
+
+const char* BinaryTreeFile::getNodeName(size_t i, size_t node) const
+{
+  const BinaryTreeFormat::Layout& layout = getLayout(i);
+  if (node >= layout.nbNodes)
+    throw IndexOutOfBoundsException("BinaryTreeFile::getNodeName.", node, 0, layout.nbNodes - 1);
+  const char* record = getRecord_(i);
+  uint32_t name = reinterpret_cast<const uint32_t*>(record + layout.names)[node];
+  if (name == BinaryTreeFormat::NO_STRING)
+    return 0;
+  if (name >= layout.stringsSize)
+    throw IOException("BinaryTreeFile::getNodeName. Bad name for node " + TextTools::toString(node) + ".");
+  return record + layout.strings + name;
+}
+
@@ -0,0 +1,318 @@
+//
+// File: BinaryTreeFormat.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _BINARYTREEFORMAT_H_
+#define _BINARYTREEFORMAT_H_
+
+#include "IoTree.h"
+#include "../TreeTemplate.h"
+
+// From the STL:
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <iostream>
+
+namespace bpp
+{
+
+/**
+ * @brief Tree I/O in a binary format.
+ *
+ * The file starts with a header, made of:
+ * - the 8 characters "BPPTREE\0",
+ * - the format version, as a 32 bits integer,
+ * - a byte order mark (0x01020304), as a 32 bits integer.
+ * It is followed by one record per tree. A record is made of:
+ * - the size in bytes of the rest of the record, as a 64 bits integer,
+ * - the number of nodes n, as a 64 bits integer,
+ * - the number of properties p, as a 64 bits integer,
+ * - the size in bytes of the string table, as a 64 bits integer,
+ * - the index of the father of each node, as n 32 bits integers (-1 for the root),
+ * - the id of each node, as n 32 bits integers,
+ * - the position of the name of each node in the string table, as n 32 bits integers (NO_STRING for unnamed nodes),
+ * - the length of the branch leading to each node, as n double precision numbers (NaN if there is no length),
+ * - p property entries (see BinaryTreeFormat::Property),
+ * - the string table, that is, names terminated by a null character.
+ * Each section is padded with zeros up to the next multiple of 8 bytes.
+ *
+ * Nodes are stored in pre-order, starting with the root, so that the father
+ * of a node is always stored before it, and the sons of a node are stored in
+ * their original order.
+ *
+ * Node and branch properties of type Number<double>, BppInteger and BppString
+ * are stored, with their name. Other properties are not saved.
+ *
+ * Numbers are stored in the native byte order of the machine which wrote the
+ * file, and files written on a machine with a different byte order are rejected.
+ * Records are self-contained, so that trees can be appended to an existing
+ * file. See BinaryTreeFile for random access to the trees of a file.
+ */
+class BinaryTreeFormat:
+  public AbstractITree,
+  public AbstractOTree,
+  public AbstractIMultiTree,
+  public AbstractOMultiTree
+{
+  public:
+    /**
+     * @brief A node or branch property, as stored in a record.
+     */
+    struct Property
+    {
+      enum Type { DOUBLE = 1, INTEGER = 2, STRING = 3 };
+
+      uint32_t node;     // Index of the node.
+      uint32_t name;     // Position of the name of the property in the string table.
+      uint8_t branch;    // 1 for branch properties, 0 for node properties.
+      uint8_t type;      // One of Type.
+      uint16_t reserved;
+      uint32_t text;     // Position of the value in the string table, for strings.
+      double number;     // The value, for numbers.
+    };
+
+    /**
+     * @brief Value of name positions for nodes without name.
+     */
+    static const uint32_t NO_STRING;
+
+    /**
+     * @brief Position of the sections of a record.
+     *
+     * All positions are in bytes, from the beginning of the record.
+     */
+    struct Layout
+    {
+      size_t nbNodes;
+      size_t nbProperties;
+      size_t stringsSize;
+      size_t parents;
+      size_t ids;
+      size_t names;
+      size_t lengths;
+      size_t properties;
+      size_t strings;
+      size_t size;
+    };
+
+  public:
+    BinaryTreeFormat() {}
+    virtual ~BinaryTreeFormat() {}
+
+  public:
+    const std::string getFormatName() const { return "Binary"; }
+
+    const std::string getFormatDescription() const { return "Binary tree records, with native byte order."; }
+
+    /**
+     * @name The ITree interface
+     *
+     * @{
+     */
+    TreeTemplate<Node>* readTree(const std::string& path) const;
+    TreeTemplate<Node>* readTree(std::istream& in) const;
+    /** @} */
+
+    /**
+     * @name The OTree interface
+     *
+     * @{
+     */
+    void writeTree(const Tree& tree, const std::string& path, bool overwrite = true) const;
+    void writeTree(const Tree& tree, std::ostream& out) const;
+    /** @} */
+
+    /**
+     * @name The IMultiTree interface
+     *
+     * @{
+     */
+    void readTrees(const std::string& path, std::vector<Tree*>& trees) const;
+    void readTrees(std::istream& in, std::vector<Tree*>& trees) const;
+    /** @} */
+
+    /**
+     * @name The OMultiTree interface
+     *
+     * @{
+     */
+    void writeTrees(const std::vector<Tree*>& trees, const std::string& path, bool overwrite = true) const;
+    void writeTrees(const std::vector<Tree*>& trees, std::ostream& out) const;
+    /** @} */
+
+  public:
+    /**
+     * @brief Read and check the file header.
+     *
+     * @param in The input stream.
+     * @throw IOException If the stream does not start with a valid header.
+     */
+    static void readHeader(std::istream& in);
+
+    /**
+     * @brief Write the file header.
+     *
+     * @param out The output stream.
+     */
+    static void writeHeader(std::ostream& out);
+
+    /**
+     * @brief Write a tree record, without file header.
+     *
+     * @param tree The tree to write.
+     * @param out The output stream.
+     */
+    static void writeRecord(const Tree& tree, std::ostream& out);
+
+    /**
+     * @return The size in bytes of the file header.
+     */
+    static size_t getHeaderSize();
+
+    /**
+     * @brief Compute the layout of a record, and check that it fits in the given size.
+     *
+     * @param data The record, starting with its size, aligned on 8 bytes.
+     * @param size The number of bytes available.
+     * @throw IOException If the record is truncated or inconsistent.
+     */
+    static Layout getLayout(const char* data, size_t size);
+
+    /**
+     * @brief Build a tree from a record.
+     *
+     * @param data The record, aligned on 8 bytes.
+     * @param layout The layout of the record, as returned by getLayout.
+     * @return A new tree.
+     * @throw IOException If the content of the record is not valid.
+     */
+    static TreeTemplate<Node>* buildTree(const char* data, const Layout& layout);
+
+  private:
+    /**
+     * @brief Read one record in an aligned buffer.
+     *
+     * @return False if the end of the stream was reached before the record.
+     */
+    static bool readRecord_(std::istream& in, std::vector<uint64_t>& buffer);
+};
+
+/**
+ * @brief Random access to the trees of a binary tree file.
+ *
+ * The file is mapped in memory (on systems supporting it, the file is read in
+ * memory otherwise), and the position of each record is computed when the file
+ * is opened, by reading only the size of the records. The topology and branch
+ * lengths of any tree can then be accessed in place, without any copy, or the
+ * tree can be built as a TreeTemplate object.
+ *
+ * The file should not be modified while it is open.
+ *
+ * @see BinaryTreeFormat
+ */
+class BinaryTreeFile
+{
+  private:
+    std::vector<uint64_t> buffer_;
+    const char* data_;
+    size_t size_;
+    void* mapping_;
+    std::vector<size_t> offsets_;
+    std::vector<BinaryTreeFormat::Layout> layouts_;
+
+  public:
+    /**
+     * @param path The path of the file.
+     * @throw IOException If the file cannot be read, or is not a valid binary tree file.
+     */
+    BinaryTreeFile(const std::string& path);
+
+    virtual ~BinaryTreeFile();
+
+  private:
+    BinaryTreeFile(const BinaryTreeFile& file);
+    BinaryTreeFile& operator=(const BinaryTreeFile& file);
+
+  public:
+    size_t getNumberOfTrees() const { return offsets_.size(); }
+
+    /**
+     * @return A new tree built from the record of tree i.
+     */
+    TreeTemplate<Node>* getTree(size_t i) const;
+
+    /**
+     * @name Direct access to the records.
+     *
+     * Arrays are indexed by the position of the nodes in the record (the root is at position 0).
+     *
+     * @{
+     */
+    size_t getNumberOfNodes(size_t i) const { return getLayout(i).nbNodes; }
+
+    const int32_t* getFathers(size_t i) const { return reinterpret_cast<const int32_t*>(getRecord_(i) + getLayout(i).parents); }
+
+    const int32_t* getNodeIds(size_t i) const { return reinterpret_cast<const int32_t*>(getRecord_(i) + getLayout(i).ids); }
+
+    const double* getBranchLengths(size_t i) const { return reinterpret_cast<const double*>(getRecord_(i) + getLayout(i).lengths); }
+
+    /**
+     * @return The name of a node, or 0 if the node has no name.
+     */
+    const char* getNodeName(size_t i, size_t node) const;
+
+    const BinaryTreeFormat::Layout& getLayout(size_t i) const
+    {
+      if (i >= layouts_.size()) throw IndexOutOfBoundsException("BinaryTreeFile::getLayout.", i, 0, layouts_.size() - 1);
+      return layouts_[i];
+    }
+    /** @} */
+
+  private:
+    const char* getRecord_(size_t i) const
+    {
+      if (i >= offsets_.size()) throw IndexOutOfBoundsException("BinaryTreeFile::getRecord_.", i, 0, offsets_.size() - 1);
+      return data_ + offsets_[i];
+    }
+};
+
+} //end of namespace bpp.
+
+#endif //_BINARYTREEFORMAT_H_
+
@@ -38,6 +38,7 @@
 */
 
 #include "BppOMultiTreeReaderFormat.h"
+#include "BinaryTreeFormat.h"
 #include "Newick.h"
 #include "NexusIoTree.h"
 #include "Nhx.h"
@@ -59,7 +60,10 @@ IMultiTree* BppOMultiTreeReaderFormat::readIMultiTree(const std::string& descrip
   if (format == "Newick")
   {
     bool allowComments = ApplicationTools::getBooleanParameter("allow_comments", unparsedArguments_, false, "", true, warningLevel_);
-    iTrees.reset(new Newick(allowComments));
+    bool fastParser = ApplicationTools::getBooleanParameter("fast_parser", unparsedArguments_, false, "", true, warningLevel_);
+    Newick* reader = new Newick(allowComments);
+    reader->enableFastParser(fastParser);
+    iTrees.reset(reader);
   }
   else if (format == "Nhx")
   {
@@ -69,6 +73,10 @@ IMultiTree* BppOMultiTreeReaderFormat::readIMultiTree(const std::string& descrip
   {
     iTrees.reset(new NexusIOTree());
   }
+  else if (format == "Binary")
+  {
+    iTrees.reset(new BinaryTreeFormat());
+  }
   else
   {
     throw Exception("Trees format '" + format + "' unknown.");
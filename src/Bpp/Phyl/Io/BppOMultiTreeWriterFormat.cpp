@@ -38,6 +38,7 @@
 */
 
 #include "BppOMultiTreeWriterFormat.h"
+#include "BinaryTreeFormat.h"
 #include "Newick.h"
 #include "NexusIoTree.h"
 #include "Nhx.h"
@@ -69,6 +70,10 @@ OMultiTree* BppOMultiTreeWriterFormat::readOMultiTree(const std::string& descrip
   {
     oTrees.reset(new NexusIOTree());
   }
+  else if (format == "Binary")
+  {
+    oTrees.reset(new BinaryTreeFormat());
+  }
   else
   {
     throw Exception("Trees format '" + format + "' unknown.");
@@ -38,6 +38,7 @@
 */
 
 #include "BppOTreeReaderFormat.h"
+#include "BinaryTreeFormat.h"
 #include "Newick.h"
 #include "NexusIoTree.h"
 #include "Nhx.h"
@@ -59,7 +60,10 @@ ITree* BppOTreeReaderFormat::readITree(const std::string& description)
   if (format == "Newick")
   {
     bool allowComments = ApplicationTools::getBooleanParameter("allow_comments", unparsedArguments_, false, "", true, warningLevel_);
-    iTree.reset(new Newick(allowComments));
+    bool fastParser = ApplicationTools::getBooleanParameter("fast_parser", unparsedArguments_, false, "", true, warningLevel_);
+    Newick* reader = new Newick(allowComments);
+    reader->enableFastParser(fastParser);
+    iTree.reset(reader);
   }
   else if (format == "Nhx")
   {
@@ -69,6 +73,10 @@ ITree* BppOTreeReaderFormat::readITree(const std::string& description)
   {
     iTree.reset(new NexusIOTree());
   }
+  else if (format == "Binary")
+  {
+    iTree.reset(new BinaryTreeFormat());
+  }
   else
   {
     throw Exception("Tree format '" + format + "' unknown.");
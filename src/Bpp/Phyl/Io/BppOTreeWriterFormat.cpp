@@ -38,6 +38,7 @@
 */
 
 #include "BppOTreeWriterFormat.h"
+#include "BinaryTreeFormat.h"
 #include "Newick.h"
 #include "NexusIoTree.h"
 #include "Nhx.h"
@@ -69,6 +70,10 @@ OTree* BppOTreeWriterFormat::readOTree(const std::string& description)
   {
     oTree.reset(new NexusIOTree());
   }
+  else if (format == "Binary")
+  {
+    oTree.reset(new BinaryTreeFormat());
+  }
   else
   {
     throw Exception("Tree format '" + format + "' unknown.");
@@ -41,16 +41,19 @@ knowledge of the CeCILL license and that you accept its terms.
 #define _IODISTANCEMATRIX_H_
 
 #include <Bpp/Io/IoFormat.h>
+#include "../Distance/CondensedDistanceMatrix.h"
+
+// From bpp-seq:
+#include <Bpp/Seq/DistanceMatrix.h>
 
 // From the STL:
 #include <iostream>
 #include <fstream>
+#include <memory>
 
 namespace bpp
 {
 
-class DistanceMatrix;
-
 /**
  * @brief General interface for distance matrix I/O.
  */
@@ -92,6 +95,25 @@ class IDistanceMatrix:
      * @throw Exception If an error occured.
      */
     virtual DistanceMatrix* readDistanceMatrix(std::istream& in) const = 0;
+
+    /**
+     * @brief Read a distance matrix from a file, in condensed form.
+     *
+     * Formats supporting it may store the values in a memory-mapped file.
+     *
+     * @param path The file path.
+     * @return A new condensed distance matrix object.
+     * @throw Exception If an error occured.
+     */
+    virtual CondensedDistanceMatrix* readCondensedDistanceMatrix(const std::string& path) const = 0;
+    /**
+     * @brief Read a distance matrix from a stream, in condensed form.
+     *
+     * @param in The input stream.
+     * @return A new condensed distance matrix object.
+     * @throw Exception If an error occured.
+     */
+    virtual CondensedDistanceMatrix* readCondensedDistanceMatrix(std::istream& in) const = 0;
 };
 
 /**
@@ -123,10 +145,31 @@ class ODistanceMatrix:
      * @throw Exception If an error occured.
      */
     virtual void writeDistanceMatrix(const DistanceMatrix& dist, std::ostream& out) const = 0;
+
+    /**
+     * @brief Write a condensed distance matrix to a file.
+     *
+     * @param dist A condensed distance matrix object.
+     * @param path The file path.
+     * @param overwrite Tell if existing file must be overwritten.
+     * Otherwise append to the file.
+     * @throw Exception If an error occured.
+     */
+    virtual void writeCondensedDistanceMatrix(const CondensedDistanceMatrix& dist, const std::string& path, bool overwrite) const = 0;
+    /**
+     * @brief Write a condensed distance matrix to a stream.
+     *
+     * @param dist A condensed distance matrix object.
+     * @param out The output stream.
+     * @throw Exception If an error occured.
+     */
+    virtual void writeCondensedDistanceMatrix(const CondensedDistanceMatrix& dist, std::ostream& out) const = 0;
 };
 
 /**
  * @brief Partial implementation of the IDistanceMatrix interface.
+ *
+ * Condensed matrices are read through a square matrix by default.
  */
 class AbstractIDistanceMatrix:
   public virtual IDistanceMatrix
@@ -144,10 +187,25 @@ class AbstractIDistanceMatrix:
       return mat;
     }
     virtual DistanceMatrix* readDistanceMatrix(std::istream& in) const = 0;
+
+    virtual CondensedDistanceMatrix* readCondensedDistanceMatrix(const std::string& path) const
+    {
+      std::ifstream input(path.c_str(), std::ios::in);
+      CondensedDistanceMatrix* mat = readCondensedDistanceMatrix(input);
+      input.close();
+      return mat;
+    }
+    virtual CondensedDistanceMatrix* readCondensedDistanceMatrix(std::istream& in) const
+    {
+      std::unique_ptr<DistanceMatrix> mat(readDistanceMatrix(in));
+      return new CondensedDistanceMatrix(*mat);
+    }
 };
 
 /**
  * @brief Partial implementation of the ODistanceMatrix interface.
+ *
+ * Condensed matrices are written through a square matrix by default.
  */
 class AbstractODistanceMatrix:
   public virtual ODistanceMatrix
@@ -165,6 +223,19 @@ class AbstractODistanceMatrix:
       output.close();
     }
     virtual void writeDistanceMatrix(const DistanceMatrix& dist, std::ostream& out) const = 0;
+
+    virtual void writeCondensedDistanceMatrix(const CondensedDistanceMatrix& dist, const std::string& path, bool overwrite) const
+    {
+      // Open file in specified mode
+      std::ofstream output(path.c_str(), overwrite ? (std::ios::out) : (std::ios::out|std::ios::app));
+      writeCondensedDistanceMatrix(dist, output);
+      output.close();
+    }
+    virtual void writeCondensedDistanceMatrix(const CondensedDistanceMatrix& dist, std::ostream& out) const
+    {
+      std::unique_ptr<DistanceMatrix> mat(dist.toDistanceMatrix());
+      writeDistanceMatrix(*mat, out);
+    }
 };
 
 } //end of namespace bpp.
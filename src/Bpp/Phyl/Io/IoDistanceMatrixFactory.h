@@ -60,6 +60,7 @@ class IODistanceMatrixFactory
 {
 public:
   static const std::string PHYLIP_FORMAT;  
+  static const std::string BINARY_FORMAT;  
 
 public:
 
@@ -268,6 +268,50 @@ class AbstractIMultiTree:
 
 };
 
+/**
+ * @brief General interface for sequential multiple trees readers.
+ *
+ * Contrary to IMultiTree, which loads all trees in memory at once, a tree
+ * stream is a cursor over the trees of a file, which are read one at a time,
+ * or by batches. The memory used is then bounded by the size of one batch,
+ * whatever the number of trees in the file.
+ */
+class ITreeStream
+{
+  public:
+    ITreeStream() {}
+    virtual ~ITreeStream() {}
+
+  public:
+    /**
+     * @brief Read the next tree.
+     *
+     * @return A new tree object, owned by the caller, or 0 if there is no more tree to read.
+     * @throw Exception If an error occured.
+     */
+    virtual Tree* nextTree() = 0;
+
+    /**
+     * @brief Read the next trees.
+     *
+     * @param trees The output trees container. New trees, owned by the caller, are appended to it.
+     * @param maxNumber The maximum number of trees to read.
+     * @return The number of trees read, which is lower than maxNumber only if the end of the input was reached.
+     * @throw Exception If an error occured.
+     */
+    virtual size_t nextTrees(std::vector<Tree*>& trees, size_t maxNumber)
+    {
+      size_t nbTrees = 0;
+      Tree* tree = 0;
+      while (nbTrees < maxNumber && (tree = nextTree()))
+      {
+        trees.push_back(tree);
+        nbTrees++;
+      }
+      return nbTrees;
+    }
+};
+
 /**
  * @brief Partial implementation of the OTree interface.
  */
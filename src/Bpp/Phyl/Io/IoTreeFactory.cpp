@@ -38,6 +38,7 @@ knowledge of the CeCILL license and that you accept its terms.
 */
 
 #include "IoTreeFactory.h"
+#include "BinaryTreeFormat.h"
 #include "Newick.h"
 #include "NexusIoTree.h"
 #include "Nhx.h"
@@ -45,22 +46,32 @@ knowledge of the CeCILL license and that you accept its terms.
 using namespace bpp;
 
 const std::string IOTreeFactory::NEWICK_FORMAT = "Newick"; 
+const std::string IOTreeFactory::NEWICK_FAST_FORMAT = "NewickFast"; 
 const std::string IOTreeFactory::NEXUS_FORMAT = "Nexus"; 
 const std::string IOTreeFactory::NHX_FORMAT = "Nhx"; 
+const std::string IOTreeFactory::BINARY_FORMAT = "Binary"; 
 
 ITree* IOTreeFactory::createReader(const std::string& format)
 {
        if (format == NEWICK_FORMAT) return new Newick();
+  else if (format == NEWICK_FAST_FORMAT)
+  {
+    Newick* reader = new Newick();
+    reader->enableFastParser();
+    return reader;
+  }
   else if (format == NEXUS_FORMAT) return new NexusIOTree();
   else if (format == NHX_FORMAT) return new Nhx();
+  else if (format == BINARY_FORMAT) return new BinaryTreeFormat();
   else throw Exception("Format " + format + " is not supported for input.");
 }
   
 OTree* IOTreeFactory::createWriter(const std::string& format)
 {
-       if (format == NEWICK_FORMAT) return new Newick();
+       if (format == NEWICK_FORMAT || format == NEWICK_FAST_FORMAT) return new Newick();
   else if (format == NEXUS_FORMAT) return new NexusIOTree();
   else if (format == NHX_FORMAT) return new Nhx();
+  else if (format == BINARY_FORMAT) return new BinaryTreeFormat();
   else throw Exception("Format " + format + " is not supported for output.");
 }
 
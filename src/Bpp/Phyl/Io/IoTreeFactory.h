@@ -55,8 +55,10 @@ class IOTreeFactory
 {
 public:
   static const std::string NEWICK_FORMAT;  
+  static const std::string NEWICK_FAST_FORMAT;  
   static const std::string NEXUS_FORMAT;  
   static const std::string NHX_FORMAT;  
+  static const std::string BINARY_FORMAT;  
 
 public:
 
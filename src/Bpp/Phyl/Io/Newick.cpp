@@ -43,12 +43,15 @@ knowledge of the CeCILL license and that you accept its terms.
 #include "../TreeTemplateTools.h"
 
 #include <Bpp/Text/TextTools.h>
+#include <Bpp/App/ApplicationTools.h>
 
 using namespace bpp;
 
 // From the STL:
 #include <iostream>
 #include <fstream>
+#include <cstdlib>
+#include <algorithm>
 
 using namespace std;
 
@@ -70,6 +73,17 @@ TreeTemplate<Node> * Newick::readTree(istream& in) const
 {
   // Checking the existence of specified file
   if (! in) { throw IOException ("Newick::read: failed to read from stream"); }
+
+  if (fastParser_)
+  {
+    string description;
+    bool complete = readDescription(in, description);
+    if (TextTools::isEmpty(description))
+      throw IOException("Newick::read: no tree was found!");
+    if (!complete)
+      throw IOException("Newick::read: bad format, no semi-colon found.");
+    return parseTree(description);
+  }
   
   //We concatenate all line in file till we reach the ending semi colon:
   string temp, description;// Initialization
@@ -93,6 +107,193 @@ TreeTemplate<Node> * Newick::readTree(istream& in) const
 
 /******************************************************************************/
 
+bool Newick::readDescription(istream& in, string& description) const
+{
+  if (!getline(in, description, ';'))
+  {
+    description.clear();
+    return false;
+  }
+  // getline only reaches the end of the stream if no delimiter was found:
+  if (in.eof())
+    return false;
+  description += ';';
+  if (allowComments_)
+  {
+    // The semi-colon may be part of a comment:
+    string next;
+    while (count(description.begin(), description.end(), '[') > count(description.begin(), description.end(), ']'))
+    {
+      if (!getline(in, next, ';'))
+        return false;
+      description += next;
+      if (in.eof())
+        return false;
+      description += ';';
+    }
+  }
+  return true;
+}
+
+/******************************************************************************/
+
+namespace
+{
+  double parseNumber(const string& s)
+  {
+    const char* begin = s.c_str();
+    char* end = 0;
+    double value = strtod(begin, &end);
+    if (end == begin || *end != '\0')
+      throw IOException("Newick::parseTree. Invalid number: '" + s + "'.");
+    return value;
+  }
+}
+
+void Newick::setLabel_(Node& node, const string& label, bool isLeaf) const
+{
+  // The branch length follows the last colon:
+  string::size_type colon = label.rfind(':');
+  string text = TextTools::removeSurroundingWhiteSpaces(colon == string::npos ? label : label.substr(0, colon));
+  if (colon != string::npos)
+  {
+    string length = TextTools::removeSurroundingWhiteSpaces(label.substr(colon + 1));
+    if (!TextTools::isEmpty(length))
+      node.setDistanceToFather(parseNumber(length));
+  }
+  if (isLeaf)
+  {
+    node.setName(text);
+  }
+  else if (!TextTools::isEmpty(text))
+  {
+    if (useBootstrap_)
+    {
+      static const PropertyKey bootstrapKey = PropertyRegistry::getKey(TreeTools::BOOTSTRAP);
+      node.setBranchDoubleProperty(bootstrapKey, parseNumber(text));
+    }
+    else
+    {
+      node.setBranchProperty(bootstrapPropertyName_, BppString(text));
+    }
+  }
+}
+
+TreeTemplate<Node>* Newick::parseTree(const string& description) const
+{
+  // Internal nodes which are not closed yet:
+  vector<Node*> stack;
+  Node* root = 0;
+  // The last closed internal node, which may be followed by its label:
+  Node* closed = 0;
+  string label;
+  unsigned int nodeCounter = 0;
+  try
+  {
+    // An ending semi-colon is added if none is found:
+    bool done = false;
+    for (size_t i = 0; i <= description.size() && !done; ++i)
+    {
+      char c = i < description.size() ? description[i] : ';';
+      switch (c)
+      {
+      case '[':
+        if (allowComments_)
+        {
+          i = description.find(']', i);
+          if (i == string::npos)
+            throw IOException("Newick::parseTree. Bad format: unclosed comment.");
+        }
+        else
+          label += c;
+        break;
+      case '\n':
+      case '\r':
+        // Lines are concatenated.
+        break;
+      case '(':
+        if (closed || !TextTools::isEmpty(label) || (stack.empty() && root))
+          throw IOException("Newick::parseTree. Bad format: unexpected opening parenthesis after '" + label + "'.");
+        stack.push_back(new Node());
+        if (root)
+          stack[stack.size() - 2]->addSon(stack.back());
+        else
+          root = stack.back();
+        label.clear();
+        nodeCounter++;
+        break;
+      case ',':
+      case ')':
+      case ';':
+        if (closed)
+        {
+          setLabel_(*closed, label, false);
+        }
+        else
+        {
+          Node* leaf = new Node();
+          if (!stack.empty())
+            stack.back()->addSon(leaf);
+          else if (!root)
+            root = leaf;
+          else
+          {
+            delete leaf;
+            throw IOException("Newick::parseTree. Bad format: unexpected '" + label + "' after the root node.");
+          }
+          setLabel_(*leaf, label, true);
+          nodeCounter++;
+        }
+        if (verbose_)
+          ApplicationTools::displayUnlimitedGauge(nodeCounter);
+        label.clear();
+        closed = 0;
+        if (c == ',')
+        {
+          if (stack.empty())
+            throw IOException("Newick::parseTree. Bad format: unexpected comma after the root node.");
+        }
+        else if (c == ')')
+        {
+          if (stack.empty())
+            throw IOException("Newick::parseTree. Bad format: unexpected closing parenthesis.");
+          closed = stack.back();
+          stack.pop_back();
+        }
+        else
+        {
+          if (!stack.empty())
+            throw IOException("Newick::parseTree. Bad format: missing closing parenthesis.");
+          done = true;
+        }
+        break;
+      default:
+        label += c;
+      }
+    }
+  }
+  catch (...)
+  {
+    if (root)
+    {
+      TreeTemplateTools::deleteSubtree(root);
+      delete root;
+    }
+    throw;
+  }
+  TreeTemplate<Node>* tree = new TreeTemplate<Node>();
+  tree->setRootNode(root);
+  tree->resetNodesId();
+  if (verbose_)
+  {
+    (*ApplicationTools::message) << " nodes loaded.";
+    ApplicationTools::message->endLine();
+  }
+  return tree;
+}
+
+/******************************************************************************/
+
 void Newick::write_(const Tree& tree, ostream& out) const
 {
   // Checking the existence of specified file, and possibility to open it in write mode
@@ -130,6 +331,16 @@ void Newick::readTrees(istream& in, vector<Tree*>& trees) const
 {
   // Checking the existence of specified file
   if (! in) { throw IOException ("Newick::read: failed to read from stream"); }
+
+  if (fastParser_)
+  {
+    string description;
+    while (readDescription(in, description))
+    {
+      trees.push_back(parseTree(description));
+    }
+    return;
+  }
   
   // Main loop : for all file lines
   string temp, description;// Initialization
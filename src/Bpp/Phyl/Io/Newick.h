@@ -79,6 +79,13 @@ namespace bpp
  * This is achieved by calling the enableExtendedBootstrapProperty method, and providing a property name to use.
  * The additional information will be stored at each node as a property, in a String object.
  * The disableExtendedBootstrapProperty method restores the default behavior.
+ *
+ * Two parsers are available. The default one converts the description
+ * recursively, using TreeTemplateTools::parenthesisToTree. The fast parser,
+ * activated with enableFastParser(), reads the description in a single pass
+ * using an explicit stack. It creates the same trees, but runs in linear time
+ * whatever the shape of the tree, and does not overflow the call stack on
+ * very deep (e.g. caterpillar) trees.
  */
 class Newick:
   public AbstractITree,
@@ -92,6 +99,7 @@ class Newick:
     bool useBootstrap_;
     std::string bootstrapPropertyName_;
     bool verbose_;
+    bool fastParser_;
   
   public:
     
@@ -109,7 +117,8 @@ class Newick:
       writeId_(writeId),
       useBootstrap_(true),
       bootstrapPropertyName_(TreeTools::BOOTSTRAP),
-      verbose_(verbose) {}
+      verbose_(verbose),
+      fastParser_(false) {}
 
     virtual ~Newick() {}
   
@@ -126,6 +135,45 @@ class Newick:
       bootstrapPropertyName_ = TreeTools::BOOTSTRAP;
     }
 
+    /**
+     * @brief Use the single-pass parser instead of the recursive one.
+     *
+     * @param yes Tell if the fast parser should be used.
+     */
+    void enableFastParser(bool yes = true) { fastParser_ = yes; }
+
+    bool isFastParserEnabled() const { return fastParser_; }
+
+    /**
+     * @brief Tell if progress information should be displayed while reading trees.
+     */
+    void setVerbose(bool yes = true) { verbose_ = yes; }
+
+    bool isVerbose() const { return verbose_; }
+
+    /**
+     * @brief Parse a tree description in a single pass.
+     *
+     * The current settings (comments, bootstrap or extended property, verbosity) are used.
+     *
+     * @param description A tree description, with or without the ending semi-colon.
+     * @return A new tree.
+     * @throw IOException In case of bad format.
+     */
+    TreeTemplate<Node>* parseTree(const std::string& description) const;
+
+    /**
+     * @brief Read a tree description, until the next semi-colon (included).
+     *
+     * If comments are allowed, semi-colons within comments are skipped.
+     * The description can then be passed to parseTree.
+     *
+     * @param in The stream to read from.
+     * @param description [out] The description read, which is empty if the end of the stream was reached.
+     * @return True if a semi-colon was found.
+     */
+    bool readDescription(std::istream& in, std::string& description) const;
+
     /**
      * @name The IOTree interface
      *
@@ -192,6 +240,8 @@ class Newick:
     /** @} */
 
   protected:
+    void setLabel_(Node& node, const std::string& label, bool isLeaf) const;
+
     void write_(const Tree& tree, std::ostream& out) const;
     
     template<class N>
@@ -0,0 +1,189 @@
+//
+// File: NewickTreeStream.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include "NewickTreeStream.h"
+
+using namespace bpp;
+
+// From the STL:
+#include <exception>
+
+using namespace std;
+
+/******************************************************************************/
+
+NewickTreeStream::NewickTreeStream(istream& input, const Newick& reader, bool parallel, size_t batchSize) :
+  reader_(reader),
+  input_(&input),
+  file_(0),
+  parallel_(parallel),
+  batchSize_(parallel && batchSize > 0 ? batchSize : 1),
+  buffer_(),
+  bufferPosition_(0),
+  nbTreesRead_(0),
+  pendingError_()
+{
+  if (!input)
+    throw IOException("NewickTreeStream. Failed to read from stream.");
+  if (parallel_)
+    reader_.setVerbose(false);
+}
+
+/******************************************************************************/
+
+NewickTreeStream::NewickTreeStream(const string& path, const Newick& reader, bool parallel, size_t batchSize) :
+  reader_(reader),
+  input_(0),
+  file_(0),
+  parallel_(parallel),
+  batchSize_(parallel && batchSize > 0 ? batchSize : 1),
+  buffer_(),
+  bufferPosition_(0),
+  nbTreesRead_(0),
+  pendingError_()
+{
+  file_ = new ifstream(path.c_str(), ios::in);
+  if (!*file_)
+  {
+    delete file_;
+    throw IOException("NewickTreeStream. Could not open file '" + path + "'.");
+  }
+  input_ = file_;
+  if (parallel_)
+    reader_.setVerbose(false);
+}
+
+/******************************************************************************/
+
+NewickTreeStream::~NewickTreeStream()
+{
+  clearBuffer_();
+  if (file_)
+    delete file_;
+}
+
+/******************************************************************************/
+
+void NewickTreeStream::clearBuffer_()
+{
+  for (size_t i = bufferPosition_; i < buffer_.size(); ++i)
+  {
+    delete buffer_[i];
+  }
+  buffer_.clear();
+  bufferPosition_ = 0;
+}
+
+/******************************************************************************/
+
+bool NewickTreeStream::fillBuffer_()
+{
+  clearBuffer_();
+  vector<string> descriptions;
+  string description;
+  while (descriptions.size() < batchSize_ && reader_.readDescription(*input_, description))
+  {
+    descriptions.push_back(description);
+  }
+  if (descriptions.size() == 0)
+    return false;
+
+  // Trees are parsed independently, and errors are reported in the order of the input:
+  size_t nbTrees = descriptions.size();
+  buffer_.resize(nbTrees, 0);
+  vector<string> errors(nbTrees);
+  long lnbTrees = static_cast<long>(nbTrees);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) if (parallel_ && nbTrees > 1)
+#endif
+  for (long li = 0; li < lnbTrees; ++li)
+  {
+    size_t i = static_cast<size_t>(li);
+    try
+    {
+      buffer_[i] = reader_.parseTree(descriptions[i]);
+    }
+    catch (exception& e)
+    {
+      errors[i] = e.what();
+    }
+  }
+
+  for (size_t i = 0; i < nbTrees; ++i)
+  {
+    if (!buffer_[i])
+    {
+      // Trees after the first error are discarded:
+      pendingError_ = errors[i];
+      for (size_t j = i + 1; j < nbTrees; ++j)
+      {
+        delete buffer_[j];
+      }
+      buffer_.resize(i);
+      break;
+    }
+  }
+  return true;
+}
+
+/******************************************************************************/
+
+TreeTemplate<Node>* NewickTreeStream::nextTree()
+{
+  if (bufferPosition_ == buffer_.size())
+  {
+    if (!pendingError_.empty())
+    {
+      string error = pendingError_;
+      pendingError_.clear();
+      throw IOException(error);
+    }
+    if (!fillBuffer_())
+      return 0;
+    if (buffer_.size() == 0)
+      return nextTree(); // Throw the pending error.
+  }
+  TreeTemplate<Node>* tree = buffer_[bufferPosition_];
+  buffer_[bufferPosition_++] = 0;
+  nbTreesRead_++;
+  return tree;
+}
+
+/******************************************************************************/
+
@@ -0,0 +1,150 @@
+//
+// File: NewickTreeStream.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _NEWICKTREESTREAM_H_
+#define _NEWICKTREESTREAM_H_
+
+#include "IoTree.h"
+#include "Newick.h"
+
+// From the STL:
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+
+namespace bpp
+{
+
+/**
+ * @brief Read the trees of a Newick file one at a time.
+ *
+ * Tree descriptions are split on semi-colons (ignoring those within comments
+ * if comments are allowed), and parsed with the single-pass parser of the
+ * Newick class (see Newick::parseTree). Trees are returned in the order of the
+ * file.
+ *
+ * Descriptions are read by batches. In parallel mode, the descriptions of a
+ * batch are parsed concurrently (using OpenMP, if available), and the parsed
+ * trees are kept until they are retrieved. The memory used is therefore
+ * bounded by the size of a batch. Progress information is never displayed in
+ * parallel mode. If a description of the batch cannot be parsed, the trees
+ * before it are returned first, and the error is reported after them, as in
+ * sequential mode.
+ *
+ * Code example:
+ * @code
+ * NewickTreeStream stream("bootstrap.dnd", Newick(), true);
+ * Tree* tree;
+ * while ((tree = stream.nextTree()))
+ * {
+ *   ...
+ *   delete tree;
+ * }
+ * @endcode
+ */
+class NewickTreeStream:
+  public virtual ITreeStream
+{
+  private:
+    Newick reader_;
+    std::istream* input_;
+    std::ifstream* file_;
+    bool parallel_;
+    size_t batchSize_;
+    std::vector<TreeTemplate<Node>*> buffer_;
+    size_t bufferPosition_;
+    size_t nbTreesRead_;
+    std::string pendingError_;
+
+  public:
+    /**
+     * @brief Read trees from a stream.
+     *
+     * @param input The stream to read from. It must remain valid as long as trees are read.
+     * @param reader A Newick reader, whose settings (comments, bootstrap or extended property) are used.
+     * @param parallel Tell if descriptions should be parsed in parallel.
+     * @param batchSize The number of descriptions read at once. It is set to 1 if parallel is false.
+     */
+    NewickTreeStream(std::istream& input, const Newick& reader = Newick(), bool parallel = false, size_t batchSize = 256);
+
+    /**
+     * @brief Read trees from a file.
+     *
+     * @param path The file path.
+     * @param reader A Newick reader, whose settings (comments, bootstrap or extended property) are used.
+     * @param parallel Tell if descriptions should be parsed in parallel.
+     * @param batchSize The number of descriptions read at once. It is set to 1 if parallel is false.
+     * @throw IOException If the file cannot be opened.
+     */
+    NewickTreeStream(const std::string& path, const Newick& reader = Newick(), bool parallel = false, size_t batchSize = 256);
+
+    virtual ~NewickTreeStream();
+
+  private:
+    NewickTreeStream(const NewickTreeStream& stream);
+    NewickTreeStream& operator=(const NewickTreeStream& stream);
+
+  public:
+    TreeTemplate<Node>* nextTree();
+
+    /**
+     * @return The number of trees returned so far.
+     */
+    size_t getNumberOfTreesRead() const { return nbTreesRead_; }
+
+    bool isParallel() const { return parallel_; }
+
+    size_t getBatchSize() const { return batchSize_; }
+
+  private:
+    /**
+     * @brief Read and parse the next batch of descriptions.
+     *
+     * @return False if the end of the input was reached and no tree was read.
+     */
+    bool fillBuffer_();
+
+    void clearBuffer_();
+};
+
+} //end of namespace bpp.
+
+#endif  //_NEWICKTREESTREAM_H_
+
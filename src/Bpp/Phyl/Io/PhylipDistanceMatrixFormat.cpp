@@ -50,6 +50,7 @@ using namespace bpp;
 
 // From the STL:
 #include <iomanip>
+#include <cstdlib>
 
 using namespace std;
 
@@ -93,7 +94,67 @@ DistanceMatrix * PhylipDistanceMatrixFormat::readDistanceMatrix(istream& in) con
   return dist;
 }
 
+CondensedDistanceMatrix* PhylipDistanceMatrixFormat::readCondensedDistanceMatrix(istream& in) const
+{
+  string s = FileTools::getNextLine(in);
+  // the size of the matrix:
+  size_t n = TextTools::fromString<size_t>(s);
+  unique_ptr<CondensedDistanceMatrix> dist(new CondensedDistanceMatrix(n));
+  size_t rowNumber = 0;
+  size_t colNumber = 0;
+  s = FileTools::getNextLine(in);
+  while (in && rowNumber < n)
+  {
+    if (colNumber == 0)
+    { // New row
+      if (extended_) {
+        size_t pos = s.find("  ");
+        if (pos == string::npos)
+          throw Exception("PhylipDistanceMatrixFormat::readCondensedDistanceMatrix. Bad format, probably not 'extended' Phylip.");
+        dist->setName(rowNumber, s.substr(0, pos));
+        s = s.substr(pos + 2);
+      } else {
+        dist->setName(rowNumber, s.substr(0, 10));
+        s = s.size() > 11 ? s.substr(11) : "";
+      }
+    }
+    // Only the lower triangle is kept:
+    double* row = dist->getRow(rowNumber);
+    const char* p = s.c_str();
+    char* end = 0;
+    for (; colNumber < n; colNumber++)
+    {
+      double d = strtod(p, &end);
+      if (end == p) break;
+      if (colNumber < rowNumber)
+        row[colNumber] = d;
+      p = end;
+    }
+    while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+    if (*p != '\0')
+      throw Exception("PhylipDistanceMatrixFormat::readCondensedDistanceMatrix. Bad value in row " + TextTools::toString(rowNumber + 1) + ": " + string(p));
+    if (colNumber == n)
+    {
+      colNumber = 0;
+      rowNumber++;
+    }
+    s = FileTools::getNextLine(in);
+  }
+  return dist.release();
+}
+
 void PhylipDistanceMatrixFormat::writeDistanceMatrix(const DistanceMatrix& dist, ostream& out) const
+{
+  writeMatrix_(dist, out);
+}
+
+void PhylipDistanceMatrixFormat::writeCondensedDistanceMatrix(const CondensedDistanceMatrix& dist, ostream& out) const
+{
+  writeMatrix_(dist, out);
+}
+
+template<class MatrixType>
+void PhylipDistanceMatrixFormat::writeMatrix_(const MatrixType& dist, ostream& out) const
 {
   size_t n = dist.size();
   out << "   " << n << endl;
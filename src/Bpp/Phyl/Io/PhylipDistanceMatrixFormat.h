@@ -51,6 +51,10 @@ namespace bpp
  * Entry names must be 10 characters long. If 'extended' is set to true, then
  * entry names can be of any size, and should be separated from the data by at least two spaces.
  * Names should therefor not contian more than one consecutive space.
+ *
+ * When reading a condensed matrix, only the lower triangle is stored and
+ * the file is parsed line by line, so that the full square matrix is never
+ * held in memory.
  */
 class PhylipDistanceMatrixFormat:
   public AbstractIDistanceMatrix,
@@ -72,13 +76,29 @@ class PhylipDistanceMatrixFormat:
       return AbstractIDistanceMatrix::readDistanceMatrix(path); 
     }
     DistanceMatrix* readDistanceMatrix(std::istream& in) const;
-    
+
+    CondensedDistanceMatrix* readCondensedDistanceMatrix(const std::string& path) const
+    {
+      return AbstractIDistanceMatrix::readCondensedDistanceMatrix(path);
+    }
+    CondensedDistanceMatrix* readCondensedDistanceMatrix(std::istream& in) const;
+
     void writeDistanceMatrix(const DistanceMatrix& dist, const std::string& path, bool overwrite = true) const
     {
       AbstractODistanceMatrix::writeDistanceMatrix(dist, path, overwrite);
     }
     void writeDistanceMatrix(const DistanceMatrix& dist, std::ostream& out) const;
 
+    void writeCondensedDistanceMatrix(const CondensedDistanceMatrix& dist, const std::string& path, bool overwrite = true) const
+    {
+      AbstractODistanceMatrix::writeCondensedDistanceMatrix(dist, path, overwrite);
+    }
+    void writeCondensedDistanceMatrix(const CondensedDistanceMatrix& dist, std::ostream& out) const;
+
+  private:
+    template<class MatrixType>
+    void writeMatrix_(const MatrixType& dist, std::ostream& out) const;
+
 };
 
 } //end of namespace bpp.
@@ -12,11 +12,13 @@
 #include <Bpp/Numeric/Function/BrentOneDimension.h>
 #include <Bpp/Numeric/Function/PowellMultiDimensions.h>
 #include <Bpp/Text/KeyvalTools.h>
+#include <Bpp/Numeric/Random/RandomTools.h>
 
 // From bpp-phyl:
 #include <Bpp/Phyl/Tree.h>
 #include <Bpp/Phyl/Node.h>
 #include <Bpp/Phyl/TreeTools.h>
+#include <Bpp/Phyl/TreeTraversal.h>
 #include <Bpp/Phyl/Likelihood/RASTools.h>
 #include <Bpp/Phyl/Likelihood/RHomogeneousTreeLikelihood.h>
 #include <Bpp/Phyl/Likelihood/RNonHomogeneousMixedTreeLikelihood.h>
@@ -71,11 +73,10 @@ cycleNum_(0)
     // get the original total tree length
     const TreeTemplate<Node>* ttree = dynamic_cast<const TreeTemplate<Node>*>(tree);
     
-    vector <const Node*> nodes = ttree->getNodes();
+    TreeTraversal<const Node> nodes(ttree->getRootNode(), BasicTreeTraversal::PREORDER);
     for (size_t b=0; b<nodes.size(); ++b)
     {
-        if (nodes[b]->getId() != tree->getRootId())
-        
+        if (nodes[b]->hasFather())
         {
             origTreeLength_ = origTreeLength_ + nodes[b]->getDistanceToFather();
         }
@@ -96,7 +97,8 @@ cycleNum_(0)
 
     // create the stochadtic mapping data member based on the character likelihood function data member
     size_t numOfMappings = static_cast<size_t>(ApplicationTools::getIntParameter("character.num_of_mappings", bppml_->getParams(), 1000));
-    stocMapping_ = new StochasticMapping(dynamic_cast<TreeLikelihood*>(characterTreeLikelihood_), numOfMappings);
+    bool useUniformization = static_cast<bool>(ApplicationTools::getIntParameter("character.use_uniformization", bppml_->getParams(), 0));
+    stocMapping_ = new StochasticMapping(dynamic_cast<TreeLikelihood*>(characterTreeLikelihood_), numOfMappings, useUniformization ? StochasticMapping::UNIFORMIZATION_SAMPLING : StochasticMapping::REJECTION_SAMPLING);
 
     // set the previuos parameters list to the initial ones
     updatePreviousParametersValues();
@@ -206,7 +208,7 @@ void JointLikelihoodFunction::fireParameterChanged(const ParameterList& pl)
 void JointLikelihoodFunction::updateStatesInNodesNames(Tree* mapping)
 {
     string label = "state";
-    vector<Node*> nodes = (dynamic_cast<TreeTemplate<Node>*>(mapping))->getNodes(); 
+    TreeTraversal<Node> nodes((dynamic_cast<TreeTemplate<Node>*>(mapping))->getRootNode(), BasicTreeTraversal::PREORDER);
     for (auto node: nodes) 
     {
         string name = node->getName();
@@ -220,7 +222,7 @@ void JointLikelihoodFunction::updateStatesInNodesNames(Tree* mapping)
 void JointLikelihoodFunction::setPartitionByHistory(Tree* history)
 {
     sequenceTreeLikelihood_->getSubstitutionModelSet()->resetModelToNodeIds();
-    vector<const Node*> nodes = (dynamic_cast<const TreeTemplate<Node>*>(history))->getNodes();
+    TreeTraversal<const Node> nodes((dynamic_cast<const TreeTemplate<Node>*>(history))->getRootNode(), BasicTreeTraversal::PREORDER);
     for (size_t i=0; i<nodes.size(); ++i)
     {
       int nodeId = nodes[i]->getId();
@@ -264,12 +266,11 @@ void JointLikelihoodFunction::updatesequenceTreeLikelihood(const Tree* history)
 double JointLikelihoodFunction::getSequenceScalingFactor(bool verbose)
 {
     const Tree& tree = sequenceTreeLikelihood_->getTree();
-    vector <const Node*> nodes = (dynamic_cast<const TreeTemplate<Node>&>(tree)).getNodes();
+    TreeTraversal<const Node> nodes((dynamic_cast<const TreeTemplate<Node>&>(tree)).getRootNode(), BasicTreeTraversal::PREORDER);
     double treeSize = 0;
     for (size_t b=0; b<nodes.size(); ++b)
     {
-        if (nodes[b]->getId() != tree.getRootId())
-
+        if (nodes[b]->hasFather())
         {
             treeSize = treeSize + nodes[b]->getDistanceToFather();
         }
@@ -698,7 +699,7 @@ void JointLikelihoodFunction::computeAlternativeJointLikelihood()
         
         /* approximate the expected character history based on numOfMappings sampled stochastic mappings */
         bool useAnalytic =  static_cast<bool>(ApplicationTools::getIntParameter("character.use_analytic_mapping", bppml_->getParams(), 0));
-        vector<Tree*> mappings;
+        StochasticMappingStore mappings; // the mappings are materialised as trees only when needed, for debugging
         if (debug_ & !useAnalytic)
         {
             cout << "Generating stochastic mappings\n" << endl;
@@ -706,7 +707,9 @@ void JointLikelihoodFunction::computeAlternativeJointLikelihood()
         }
         if (!useAnalytic)
         {
-            stocMapping_->generateStochasticMapping(mappings);
+            // mappings are sampled in parallel, from a seed drawn from the global generator so that runs remain reproducible
+            uint64_t seed = static_cast<uint64_t>(RandomTools::giveIntRandomNumberBetweenZeroAndEntry<size_t>(numeric_limits<uint32_t>::max()));
+            stocMapping_->generateStochasticMapping(mappings, seed);
         }
         if (debug_ & !useAnalytic)
         {
@@ -743,12 +746,13 @@ void JointLikelihoodFunction::computeAlternativeJointLikelihood()
             // for each mapping, set the parittion according ot it and define it as a tree of the cloned sequence likelihood function
             ApplicationTools::displayResult("Character model log likelihood: ", TextTools::toString(-characterTreeLikelihood_->getValue(), 15));
             cout << "Computing sequence log likelihoods given the different mappings\n" << endl;
-            for (size_t h=0; h<mappings.size(); ++h)
+            for (size_t h=0; h<mappings.getNumberOfMappings(); ++h)
             {
-                    setPartitionByHistory(mappings[h]); // induce a partition of the tree based on the epxected character history
-                    updatesequenceTreeLikelihood(mappings[h]); // compute the likelihood given the mapping
+                    Tree* mapping = stocMapping_->getMappingTree(mappings, h);
+                    setPartitionByHistory(mapping); // induce a partition of the tree based on the epxected character history
+                    updatesequenceTreeLikelihood(mapping); // compute the likelihood given the mapping
                     cout << TextTools::toString(-characterTreeLikelihood_->getValue() - sequenceTreeLikelihood_->getValue(), 15) << endl;
-            
+                    delete mapping;
             }
             // the computation in exhaustive approximation will be done via python 
             bppml_->done();
@@ -770,15 +774,17 @@ void JointLikelihoodFunction::computeAlternativeJointLikelihood()
         {
             /* distance based analysis will be done via python */
             string treeStr;
-            string filepath = debugDir_ + TextTools::toString(mappings.size()) + "_mappings_in_nwk.txt";
+            string filepath = debugDir_ + TextTools::toString(mappings.getNumberOfMappings()) + "_mappings_in_nwk.txt";
             ofstream file (filepath);
-            for (size_t h=0; h<mappings.size(); ++h)
+            for (size_t h=0; h<mappings.getNumberOfMappings(); ++h)
             {
                 // write the mappings into a file
-                updateStatesInNodesNames(mappings[h]);
+                Tree* mapping = stocMapping_->getMappingTree(mappings, h);
+                updateStatesInNodesNames(mapping);
                 // write newick string to file
-                treeStr = TreeTools::treeToParenthesis(*mappings[h]);
+                treeStr = TreeTools::treeToParenthesis(*mapping);
                 file << treeStr << "\n";
+                delete mapping;
             }
         }
         if (debug_)
@@ -817,12 +823,6 @@ void JointLikelihoodFunction::computeAlternativeJointLikelihood()
 		sequenceChanged_ = true; 						// since the partition changed, the sequence likelihood has also changed
 	
 		/* free resources - now some of these parameters were defined localy - need to use friend functions otherwise can't free it */
-		size_t numOfMappings = mappings.size();
-		for (size_t h=0; h<numOfMappings; ++h)
-		{
-			if  (mappings[h]) delete mappings[h];
-		}
-		
 		if (expectedHistory) delete expectedHistory; // delete the expectedHistory, that was cloned via updatesequenceTreeLikelihood
 
 		// either nothing changed or only the sequence parameters changed
@@ -130,6 +130,23 @@ Matrix<double>* DecompositionSubstitutionCount::getAllNumbersOfSubstitutions(dou
 
 /******************************************************************************/
 
+void DecompositionSubstitutionCount::getAllNumbersOfSubstitutions(double length, std::vector<double>& counts) const
+{
+  if (length < 0)
+    throw Exception("DecompositionSubstitutionCount::getAllNumbersOfSubstitutions. Negative branch length: " + TextTools::toString(length) + ".");
+  if (getCachedCounts_(length, counts))
+    return;
+  if (length != currentLength_)
+  {
+    computeCounts_(length);
+    currentLength_ = length;
+  }
+  fillCounts_(counts_, counts);
+  cacheCounts_(length, counts);
+}
+
+/******************************************************************************/
+
 double DecompositionSubstitutionCount::getNumberOfSubstitutions(size_t initialState, size_t finalState, double length, size_t type) const
 {
   if (length < 0)
@@ -176,6 +193,7 @@ void DecompositionSubstitutionCount::setSubstitutionModel(const SubstitutionMode
   computeProducts_();
   
   //Recompute counts:
+  clearCache_();
   computeCounts_(currentLength_);
 }
 
@@ -196,6 +214,7 @@ void DecompositionSubstitutionCount::substitutionRegisterHasChanged()
   computeProducts_();
   
   //Recompute counts:
+  clearCache_();
   if (currentLength_ > 0)
     computeCounts_(currentLength_);
 }
@@ -208,6 +227,7 @@ void DecompositionSubstitutionCount::weightsHaveChanged()
     throw Exception("DecompositionSubstitutionCount::weightsHaveChanged. Incorrect alphabet type.");
 
   //Recompute counts:
+  clearCache_();
   if (currentLength_ > 0)
     computeCounts_(currentLength_);
 }
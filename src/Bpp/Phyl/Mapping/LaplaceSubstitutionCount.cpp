@@ -107,10 +107,10 @@ double LaplaceSubstitutionCount::getNumberOfSubstitutions(size_t initialState, s
 
 /******************************************************************************/
 
-Matrix<double>* LaplaceSubstitutionCount::getAllNumbersOfSubstitutions(double length, size_t type) const
+void LaplaceSubstitutionCount::updateCounts_(double length) const
 {
   if (length == currentLength_)
-    return new RowMatrix<double>(m_);
+    return;
   if (length < 0.000001) // Limit case!
   {
     size_t s = model_->getAlphabet()->getSize();
@@ -129,18 +129,44 @@ Matrix<double>* LaplaceSubstitutionCount::getAllNumbersOfSubstitutions(double le
   }
 
   currentLength_ = length;
+}
 
+/******************************************************************************/
+
+Matrix<double>* LaplaceSubstitutionCount::getAllNumbersOfSubstitutions(double length, size_t type) const
+{
+  updateCounts_(length);
   return new RowMatrix<double>(m_);
 }
 
 /******************************************************************************/
 
+void LaplaceSubstitutionCount::getAllNumbersOfSubstitutions(double length, std::vector<double>& counts) const
+{
+  if (getCachedCounts_(length, counts))
+    return;
+  updateCounts_(length);
+  size_t s = m_.getNumberOfRows();
+  counts.resize(s * s);
+  for (size_t i = 0; i < s; i++)
+  {
+    for (size_t j = 0; j < s; j++)
+    {
+      counts[i * s + j] = m_(i, j);
+    }
+  }
+  cacheCounts_(length, counts);
+}
+
+/******************************************************************************/
+
 void LaplaceSubstitutionCount::setSubstitutionModel(const SubstitutionModel* model)
 {
   model_ = model;
   size_t n = model->getAlphabet()->getSize();
   m_.resize(n, n);
   // Recompute counts:
+  clearCache_();
   computeCounts(currentLength_);
 }
 
@@ -101,6 +101,7 @@ namespace bpp
   public:
     double getNumberOfSubstitutions(size_t initialState, size_t finalState, double length, size_t type = 1) const;
     Matrix<double>* getAllNumbersOfSubstitutions(double length, size_t type = 1) const;
+    void getAllNumbersOfSubstitutions(double length, std::vector<double>& counts) const;
     std::vector<double> getNumberOfSubstitutionsForEachType(size_t initialState, size_t finalState, double length) const
     {
       std::vector<double> v(0);
@@ -120,6 +121,7 @@ namespace bpp
 
   protected:
     void computeCounts(double length) const;
+    void updateCounts_(double length) const;
     void substitutionRegisterHasChanged() {}
   };
 
@@ -55,6 +55,22 @@ Matrix<double>* NaiveSubstitutionCount::getAllNumbersOfSubstitutions(double leng
   return mat;
 }
 
+void NaiveSubstitutionCount::getAllNumbersOfSubstitutions(double length, std::vector<double>& counts) const
+{
+  size_t n = supportedChars_.size();
+  size_t nbTypes = register_->getNumberOfSubstitutionTypes();
+  counts.assign(n * n * nbTypes, 0.);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < n; ++j)
+    {
+      size_t type = register_->getType(i, j);
+      if (type > 0)
+        counts[(i * n + j) * nbTypes + type - 1] = (weights_ ? weights_->getIndex(supportedChars_[i], supportedChars_[j]) : 1.);
+    }
+  }
+}
+
 LabelSubstitutionCount::LabelSubstitutionCount(const SubstitutionModel* model) :
   AbstractSubstitutionCount(
       new TotalSubstitutionRegister(model)),
@@ -103,6 +103,8 @@ namespace bpp
     }
 
     Matrix<double>* getAllNumbersOfSubstitutions(double length, size_t type = 1) const;
+
+    void getAllNumbersOfSubstitutions(double length, std::vector<double>& counts) const;
     
     std::vector<double> getNumberOfSubstitutionsForEachType(size_t initialState, size_t finalState, double length) const
     {
@@ -155,6 +157,15 @@ namespace bpp
     {
       return dynamic_cast<Matrix<double>*>(label_.clone());
     }
+
+    void getAllNumbersOfSubstitutions(double length, std::vector<double>& counts) const
+    {
+      size_t n = label_.getNumberOfRows();
+      counts.resize(n * n);
+      for (size_t i = 0; i < n; ++i)
+        for (size_t j = 0; j < n; ++j)
+          counts[i * n + j] = label_(i, j);
+    }
     
     std::vector<double> getNumberOfSubstitutionsForEachType(size_t initialState, size_t finalState, double length) const
     {
@@ -52,3 +52,12 @@ Matrix<double>* OneJumpSubstitutionCount::getAllNumbersOfSubstitutions(double le
   return probs;
 }
 
+void OneJumpSubstitutionCount::getAllNumbersOfSubstitutions(double length, std::vector<double>& counts) const
+{
+  tmp_ = model_->getPij_t(length);
+  size_t n = model_->getNumberOfStates();
+  counts.resize(n * n);
+  for (size_t i = 0; i < n; i++) 
+    for (size_t j = 0; j < n; j++)
+      counts[i * n + j] = (i == j ? 1. - tmp_(i, j) : 1.);
+}
@@ -92,6 +92,8 @@ class OneJumpSubstitutionCount:
     }
 
     Matrix<double>* getAllNumbersOfSubstitutions(double length, size_t type = 1) const;
+
+    void getAllNumbersOfSubstitutions(double length, std::vector<double>& counts) const;
     
     std::vector<double> getNumberOfSubstitutionsForEachType(size_t initialState, size_t finalState, double length) const
     {
@@ -11,6 +11,8 @@
 #include "Reward.h"
 #include "DecompositionReward.h"
 #include "ProbabilisticRewardMapping.h"
+#include "SubstitutionRegister.h"
+#include "../Simulation/CounterRandomGenerator.h"
 #include "../Model/RateDistribution/ConstantRateDistribution.h"
 
 #include <Bpp/Text/TextTools.h>
@@ -24,6 +26,9 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
 #include <numeric> // to sum over items in a vector
 
 using namespace bpp;
@@ -31,20 +36,49 @@ using namespace std;
 
 #define STATE "state"
 
+static const PropertyKey STATE_KEY = PropertyRegistry::getKey(STATE);
+
+const short StochasticMapping::REJECTION_SAMPLING = 0;
+const short StochasticMapping::UNIFORMIZATION_SAMPLING = 1;
+
 /******************************************************************************/
 
-StochasticMapping::StochasticMapping(const TreeLikelihood* tl, size_t numOfMappings) :
+StochasticMapping::StochasticMapping(const TreeLikelihood* tl, size_t numOfMappings, short samplingMethod) :
   mappingParameters_(),
   baseTree_(),
   tl_(),
   fractionalProbabilities_(),
   ConditionalProbabilities_(),
+  fatherPositions_(),
+  preorderPositions_(),
   nodesCounter_(0),
-  numOfMappings_(numOfMappings)
+  numOfMappings_(numOfMappings),
+  samplingMethod_(REJECTION_SAMPLING),
+  uniformization_(0)
 {
+  setSamplingMethod(samplingMethod);
   tl_ = tl;
   baseTree_ = tl_->getTree().clone();                      // this calls clone - but for some reason upson deletion a segnetation fault occurs
   giveNamesToInternalNodes(baseTree_);                     // set names for the internal nodes of the tree, in case of absence
+
+  // index the nodes of the base tree by their position in its vector of nodes, which is the same in all its clones
+  TreeTemplate<Node>* ttree = dynamic_cast<TreeTemplate<Node>*>(baseTree_);
+  vector<Node*> nodes = ttree->getNodes();
+  map<const Node*, size_t> positions;
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    positions[nodes[i]] = i;
+  }
+  fatherPositions_.resize(nodes.size());
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    fatherPositions_[i] = nodes[i]->hasFather() ? positions[nodes[i]->getFather()] : i;
+  }
+  PreOrderTreeIterator treeIt(*ttree);
+  for (Node* node = treeIt.begin(); node != treeIt.end(); node = treeIt.next())
+  {
+    preorderPositions_.push_back(positions[node]);
+  }
   const SubstitutionModel* model = dynamic_cast<const SubstitutionModel*>(tl_->getModelForSite(0, 0));
   mappingParameters_ = new SimpleMutationProcess(model);   // the procedure assumes that the same model applies to all the branches of the tree
   ComputeConditionals();
@@ -58,34 +92,224 @@ StochasticMapping::~StochasticMapping()
     delete mappingParameters_;
   if (baseTree_)
     delete baseTree_; // delete the cloned base tree
+  if (uniformization_)
+    delete uniformization_;
+}
+
+/******************************************************************************/
+
+void StochasticMapping::setSamplingMethod(short samplingMethod)
+{
+  if (samplingMethod != REJECTION_SAMPLING && samplingMethod != UNIFORMIZATION_SAMPLING)
+    throw Exception("StochasticMapping::setSamplingMethod. Unknown sampling method: " + TextTools::toString(samplingMethod) + ".");
+  samplingMethod_ = samplingMethod;
 }
 
 /******************************************************************************/
 
 void StochasticMapping::generateStochasticMapping(vector<Tree*>& mappings)
 {
+  StochasticMappingStore store;
+  generateStochasticMapping(store);
+  for (size_t i = 0; i < store.getNumberOfMappings(); ++i)
+  {
+    mappings.push_back(getMappingTree(store, i));
+  }
+}
+
+/******************************************************************************/
+
+void StochasticMapping::generateStochasticMapping(StochasticMappingStore& mappings)
+{
+  if (samplingMethod_ == UNIFORMIZATION_SAMPLING)
+  {
+    // the model parameters may have changed since the last call, so the powers of the uniformized matrix are computed again
+    if (uniformization_)
+      delete uniformization_;
+    uniformization_ = 0;
+    const SubstitutionModel* model = mappingParameters_->getSubstitutionModel();
+    uniformization_ = new UniformizationSubstitutionCount(model, new TotalSubstitutionRegister(model));
+  }
+
+  vector<Node*> nodes = dynamic_cast<TreeTemplate<Node>*>(baseTree_)->getNodes();
+  if (mappings.getNumberOfNodes() != nodes.size())
+    mappings.reset(nodes.size());
+  vector<size_t> leafStates = getLeafStates(nodes);
   for (size_t i = 0; i < numOfMappings_; ++i)
   {
-    // clone the base tree to acheive the skeleton in which the mapping will be represented
-    Tree* mapping = baseTree_->clone();
-    setLeafsStates(mapping);
+    sampleMapping(mappings, nodes, leafStates, *mappingParameters_, samplingMethod_ == UNIFORMIZATION_SAMPLING ? uniformization_ : 0, 0);
+  }
+}
+
+/******************************************************************************/
+
+void StochasticMapping::generateStochasticMapping(StochasticMappingStore& mappings, uint64_t seed)
+{
+  vector<Node*> nodes = dynamic_cast<TreeTemplate<Node>*>(baseTree_)->getNodes();
+  if (mappings.getNumberOfNodes() != nodes.size())
+    mappings.reset(nodes.size());
+  vector<size_t> leafStates = getLeafStates(nodes);
+  if (samplingMethod_ == UNIFORMIZATION_SAMPLING)
+  {
+    // check once that uniformization can be used with the current model, before each thread creates its own instance
+    const SubstitutionModel* model = mappingParameters_->getSubstitutionModel();
+    UniformizationSubstitutionCount check(model, new TotalSubstitutionRegister(model));
+  }
+
+  // mappings are generated by blocks, each one in its own store, and the stores are then merged in order
+  size_t blockSize = 16;
+  size_t blocksNum = (numOfMappings_ + blockSize - 1) / blockSize;
+  vector<StochasticMappingStore> blocks(blocksNum, StochasticMappingStore(nodes.size()));
+  vector<string> errors(blocksNum);
+  long nb = static_cast<long>(blocksNum);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    // each thread samples with its own copies of the model and of the mutation process, as computing transition probabilities modifies the model
+    unique_ptr<SubstitutionModel> model(mappingParameters_->getSubstitutionModel()->clone());
+    SimpleMutationProcess process(model.get());
+    unique_ptr<UniformizationSubstitutionCount> uniformization(samplingMethod_ == UNIFORMIZATION_SAMPLING ? new UniformizationSubstitutionCount(model.get(), new TotalSubstitutionRegister(model.get())) : 0);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (long lb = 0; lb < nb; ++lb)
+    {
+      size_t b = static_cast<size_t>(lb);
+      try
+      {
+        for (size_t i = b * blockSize; i < min((b + 1) * blockSize, numOfMappings_); ++i)
+        {
+          // each mapping has its own stream of random numbers, so that it does not depend on the number of threads
+          CounterRandomGenerator generator(seed, i);
+          sampleMapping(blocks[b], nodes, leafStates, process, uniformization.get(), &generator);
+        }
+      }
+      catch (exception& e)
+      {
+        errors[b] = e.what();
+      }
+    }
+  }
+  for (size_t b = 0; b < blocksNum; ++b)
+  {
+    if (!errors[b].empty())
+      throw Exception(errors[b]);
+  }
+  for (size_t b = 0; b < blocksNum; ++b)
+  {
+    mappings.addMappings(blocks[b]);
+  }
+}
+
+/******************************************************************************/
+
+vector<size_t> StochasticMapping::getLeafStates(const vector<Node*>& nodes) const
+{
+  const SiteContainer* leafsStates = tl_->getData();
+  vector<size_t> leafStates(nodes.size(), 0);
+  for (size_t n = 0; n < nodes.size(); ++n)
+  {
+    if (nodes[n]->isLeaf())
+      leafStates[n] = static_cast<size_t>(tl_->getAlphabetStateAsInt(leafsStates->getSequence(nodes[n]->getName()).getValue(0)));
+  }
+  return leafStates;
+}
 
-    /* step 2: simulate a set of ancestral states, based on the fractional likelihoods from step 1 */
-    sampleAncestrals(mapping);
+/******************************************************************************/
 
-    /* step 3: simulate mutational history of each lineage of the phylogeny, conditional on the ancestral states */
-    sampleMutationsGivenAncestrals(mapping);
+void StochasticMapping::sampleMapping(StochasticMappingStore& mappings, const vector<Node*>& nodes, const vector<size_t>& leafStates, const SimpleMutationProcess& process, UniformizationSubstitutionCount* uniformization, CounterRandomGenerator* generator) const
+{
+  size_t index = mappings.addMapping();
+  for (size_t n = 0; n < nodes.size(); ++n)
+  {
+    if (nodes[n]->isLeaf())
+      mappings.setNodeState(index, n, leafStates[n]);
+  }
 
-    // add the mapping to the vector of mapping
-    mappings.push_back(mapping);
+  /* step 2: simulate a set of ancestral states, based on the fractional likelihoods from step 1 */
+  for (size_t k = 0; k < preorderPositions_.size(); ++k)
+  {
+    size_t n = preorderPositions_[k];
+    const Node* node = nodes[n];
+    if (!node->isLeaf())
+    {
+      size_t fatherState = node->hasFather() ? mappings.getNodeState(index, fatherPositions_[n]) : 0; // for the root, all the entries in the fatherState level are the same anyway
+      mappings.setNodeState(index, n, sampleState(ConditionalProbabilities_[node->getId()][fatherState], generator));
+    }
+  }
 
-    // reset the nodes counter
-    nodesCounter_ = dynamic_cast<TreeTemplate<Node>*>(baseTree_)->getNodes().size() - 1;
+  /* step 3: simulate mutational history of each lineage of the phylogeny, conditional on the ancestral states */
+  VDouble times;
+  vector<size_t> states;
+  for (size_t n = 0; n < nodes.size(); ++n)
+  {
+    const Node* son = nodes[n];
+    if (son->hasFather())
+    {
+      size_t fatherState = mappings.getNodeState(index, fatherPositions_[n]);
+      size_t sonState = mappings.getNodeState(index, n);
+      if (uniformization)
+        sampleBranchHistoryByUniformization(fatherState, sonState, son->getDistanceToFather(), times, states, process, *uniformization, generator);
+      else
+        sampleBranchHistoryByRejection(fatherState, sonState, son->getDistanceToFather(), times, states, process, generator);
+      for (size_t e = 0; e < times.size(); ++e)
+      {
+        mappings.addEvent(index, n, times[e], states[e]);
+      }
+    }
   }
 }
 
 /******************************************************************************/
 
+void StochasticMapping::generateStochasticMapping(vector<Tree*>& mappings, uint64_t seed)
+{
+  StochasticMappingStore store;
+  generateStochasticMapping(store, seed);
+  for (size_t i = 0; i < store.getNumberOfMappings(); ++i)
+  {
+    mappings.push_back(getMappingTree(store, i));
+  }
+}
+
+/******************************************************************************/
+
+Tree* StochasticMapping::getMappingTree(const StochasticMappingStore& mappings, size_t index) const
+{
+  TreeTemplate<Node>* mapping = dynamic_cast<TreeTemplate<Node>*>(baseTree_->clone());
+  vector<Node*> nodes = mapping->getNodes();
+  for (size_t n = 0; n < nodes.size(); ++n)
+  {
+    setNodeState(nodes[n], mappings.getNodeState(index, n));
+  }
+  size_t nodesCounter = nodes.size() - 1;
+  for (size_t n = 0; n < nodes.size(); ++n)
+  {
+    Node* son = nodes[n];
+    size_t eventsNum = mappings.getNumberOfEvents(index, n);
+    if (!son->hasFather() || eventsNum == 0)
+      continue;
+    // convert the events to a mutation path holding the time spent in each state before a transition
+    size_t curState = mappings.getNodeState(index, fatherPositions_[n]);
+    double branchLength = son->getDistanceToFather();
+    double lastTime = 0;
+    MutationPath branchMapping(mappingParameters_->getSubstitutionModel()->getAlphabet(), curState, branchLength);
+    for (size_t e = 0; e < eventsNum; ++e)
+    {
+      double time = mappings.getEventTime(index, n, e);
+      branchMapping.addEvent(curState, time - lastTime);
+      curState = mappings.getEventState(index, n, e);
+      lastTime = time;
+    }
+    son->setDistanceToFather(branchLength - lastTime);
+    updateBranchMapping(son, branchMapping, nodesCounter);
+  }
+  return mapping;
+}
+
+/******************************************************************************/
+
 void StochasticMapping::setExpectedAncestrals(Tree* expectedMapping, VVDouble& ancestralStatesFrequencies)
 {
   TreeTemplate<Node>* ttree = dynamic_cast<TreeTemplate<Node>*>(expectedMapping);
@@ -144,21 +368,54 @@ Tree* StochasticMapping::generateExpectedMapping(vector<Tree*>& mappings, size_t
           curNode = curNode->getFather();
         }
       }
-      double branchLength = node->getDistanceToFather();   // this is the length of the original branch in the base tree
-      bool updateBranch = true;
-      for (size_t state = 0; state < statesNum; ++state)
+      updateExpectedBranch(node, AverageDwellingTimes, mappings.size(), ancestralStatesFrequencies, divMethod);
+    }
+  }
+  nodesCounter_ = dynamic_cast<TreeTemplate<Node>*>(baseTree_)->getNodes().size() - 1;
+  return expectedMapping;
+}
+
+/******************************************************************************/
+
+Tree* StochasticMapping::generateExpectedMapping(const StochasticMappingStore& mappings, size_t divMethod)
+{
+  // initialize the expected history
+  nodesCounter_ = dynamic_cast<TreeTemplate<Node>*>(baseTree_)->getNodes().size() - 1;
+  Tree* expectedMapping = baseTree_->clone();
+  setLeafsStates(expectedMapping);
+
+  // compute a vector of the posterior asssignment probabilities for each inner node
+  vector<Node*> nodes = dynamic_cast<TreeTemplate<Node>*>(expectedMapping)->getNodes();
+  size_t statesNum = tl_->getNumberOfStates();
+  VVDouble ancestralStatesFrequencies(nodes.size(), VDouble(statesNum));
+  computeStatesFrequencies(ancestralStatesFrequencies, mappings);
+
+  // set the ancestral states accrdonig to the maximal posterior (i.e, conditional) probability
+  setExpectedAncestrals(expectedMapping, ancestralStatesFrequencies);
+
+  // update the expected history with the dwelling times, computed from the events of each branch
+  VDouble dwellingTimes(statesNum);
+  for (size_t n = 0; n < nodes.size(); ++n)
+  {
+    Node* node = nodes[n];
+    if (node->hasFather()) // for any node except to the root
+    {
+      double branchLength = node->getDistanceToFather();
+      fill(dwellingTimes.begin(), dwellingTimes.end(), 0);
+      for (size_t i = 0; i < mappings.getNumberOfMappings(); ++i)
       {
-        AverageDwellingTimes[state] /= static_cast<double>(mappings.size());
-        if (AverageDwellingTimes[state] == branchLength) // if one of the dwelling times equals the branch length, then there is only one state along te branch and there is no need to edit it
+        size_t curState = mappings.getNodeState(i, fatherPositions_[n]);
+        double lastTime = 0;
+        for (size_t e = 0; e < mappings.getNumberOfEvents(i, n); ++e)
         {
-          updateBranch = false;
+          double time = mappings.getEventTime(i, n, e);
+          dwellingTimes[curState] += time - lastTime;
+          curState = mappings.getEventState(i, n, e);
+          lastTime = time;
         }
+        dwellingTimes[curState] += branchLength - lastTime;
       }
-      // break the branch according to average dwelling times
-      if (updateBranch)
-      {
-        updateBranchByDwellingTimes(node, AverageDwellingTimes, ancestralStatesFrequencies, divMethod);
-      }
+      updateExpectedBranch(node, dwellingTimes, mappings.getNumberOfMappings(), ancestralStatesFrequencies, divMethod);
     }
   }
   nodesCounter_ = dynamic_cast<TreeTemplate<Node>*>(baseTree_)->getNodes().size() - 1;
@@ -167,6 +424,27 @@ Tree* StochasticMapping::generateExpectedMapping(vector<Tree*>& mappings, size_t
 
 /******************************************************************************/
 
+void StochasticMapping::updateExpectedBranch(Node* node, VDouble& dwellingTimes, size_t mappingsNum, VVDouble& ancestralStatesFrequencies, size_t divMethod)
+{
+  double branchLength = node->getDistanceToFather();   // this is the length of the original branch in the base tree
+  bool updateBranch = true;
+  for (size_t state = 0; state < dwellingTimes.size(); ++state)
+  {
+    dwellingTimes[state] /= static_cast<double>(mappingsNum);
+    if (dwellingTimes[state] == branchLength) // if one of the dwelling times equals the branch length, then there is only one state along te branch and there is no need to edit it
+    {
+      updateBranch = false;
+    }
+  }
+  // break the branch according to average dwelling times
+  if (updateBranch)
+  {
+    updateBranchByDwellingTimes(node, dwellingTimes, ancestralStatesFrequencies, divMethod);
+  }
+}
+
+/******************************************************************************/
+
 Tree* StochasticMapping::generateAnalyticExpectedMapping(size_t divMethod)
 {
   /* Compute the posterior assignment probabilities to internal nodes, based on the fractional probablities computed earlier */
@@ -298,16 +576,14 @@ Tree* StochasticMapping::generateAnalyticExpectedMapping(size_t divMethod)
 
 int StochasticMapping::getNodeState(const Node* node) const
 {
-  return (dynamic_cast<const BppInteger*>(node->getNodeProperty(STATE)))->getValue();
+  return node->getNodeIntegerProperty(STATE_KEY);
 }
 
 /******************************************************************************/
 
-void StochasticMapping::setNodeState(Node* node, size_t state)
+void StochasticMapping::setNodeState(Node* node, size_t state) const
 {
-  BppInteger* stateProperty = new BppInteger(static_cast<int>(state));
-  node->setNodeProperty(STATE, *stateProperty);
-  delete stateProperty;
+  node->setNodeIntegerProperty(STATE_KEY, static_cast<int>(state));
 }
 
 /******************************************************************************/
@@ -351,8 +627,8 @@ void StochasticMapping::computeFractionals()
   size_t statesNum = tl_->getNumberOfStates();
   const TransitionModel* model = tl_->getModelForSite(0, 0); // this calls assumes that all the sites and all the branches are assoiacted with the same node
   const SiteContainer* leafsStates = tl_->getData();
-  TreeTemplate<Node>* ttree = dynamic_cast<TreeTemplate<Node>*>(baseTree_);
-  vector<Node*> nodes = ttree->getNodes();
+  const TreeTemplate<Node>* ttree = dynamic_cast<const TreeTemplate<Node>*>(baseTree_);
+  TreeTraversal<const Node> nodes(ttree->getRootNode(), BasicTreeTraversal::POSTORDER);
 
   // compute the fractional probabilities according to Felsenstein prunnig algorithm: for each node nodes[i] and state s compute: P(Data[leafs under node[i]]|node[i] has state s]
   for (size_t i = 0; i < nodes.size(); ++i) // traverse the tree in post-order
@@ -512,73 +788,63 @@ void StochasticMapping::computeStatesFrequencies(VVDouble& ancestralStatesFreque
   }
 }
 
-
 /******************************************************************************/
 
-size_t StochasticMapping::sampleState(const VDouble& distibution)
+void StochasticMapping::computeStatesFrequencies(VVDouble& ancestralStatesFrequencies, const StochasticMappingStore& mappings)
 {
-  size_t state = 0;        // the default state is 0
-  double prob = RandomTools::giveRandomNumberBetweenZeroAndEntry(1.0);
+  size_t statesNum = tl_->getNumberOfStates();
+  const SiteContainer* leafsStates = tl_->getData();
+  vector<Node*> nodes = dynamic_cast<TreeTemplate<Node>*>(baseTree_)->getNodes();
 
-  for (size_t i = 0; i < distibution.size(); ++i)
+  // compute the node assignment probabilities based on their frequency in the mappings
+  for (size_t n = 0; n < nodes.size(); ++n)
   {
-    prob -= distibution[i];
-    if (prob < 0)  // if the the sampled probability is smaller than the probability to choose state i -> set state to be i
+    Node* node = nodes[n];
+    int nodeId = node->getId();
+    fill(ancestralStatesFrequencies[nodeId].begin(), ancestralStatesFrequencies[nodeId].end(), 0); // reset all the values to 0
+    // in leafs - don't iterate to save time, as the frequency of a state is either 0 or 1 based on the known character data
+    if (node->isLeaf())
     {
-      state = i;
-      break;
+      size_t leafState = static_cast<size_t>(tl_->getAlphabetStateAsInt(leafsStates->getSequence(node->getName()).getValue(0)));
+      ancestralStatesFrequencies[nodeId][leafState] = 1;
     }
-  }
-  return state;
-}
-
-/******************************************************************************/
-
-void StochasticMapping::sampleAncestrals(Tree* mapping)
-{
-  TreeTemplate<Node>* ttree = dynamic_cast<TreeTemplate<Node>*>(mapping);
-  PreOrderTreeIterator* treeIt = new PreOrderTreeIterator(*ttree);
-  for (Node* node = treeIt->begin(); node != treeIt->end(); node = treeIt->next())
-  {
-    if (!node->isLeaf())
+    else
     {
-      int nodeId = node->getId();
-      if (!node->hasFather())
+      for (size_t h = 0; h < mappings.getNumberOfMappings(); ++h)
       {
-        size_t rootState = sampleState(ConditionalProbabilities_[nodeId][0]); // set father state to 0 (all the entries in the fatherState level are the same anyway)
-        setNodeState(node, rootState);
+        ancestralStatesFrequencies[nodeId][mappings.getNodeState(h, n)]++;
       }
-      else
+      for (size_t nodeState = 0; nodeState < statesNum; ++nodeState)
       {
-        int fatherState = getNodeState(node->getFather());
-        size_t sonState = sampleState(ConditionalProbabilities_[nodeId][fatherState]);
-        setNodeState(node, sonState); // in the case of a leaf, the assigned state must be sampled
+        ancestralStatesFrequencies[nodeId][nodeState] /= static_cast<double>(mappings.getNumberOfMappings());
       }
     }
   }
-  delete(treeIt);
 }
 
+
 /******************************************************************************/
 
-void StochasticMapping::sampleMutationsGivenAncestrals(Tree* mapping)
+size_t StochasticMapping::sampleState(const VDouble& distibution, CounterRandomGenerator* generator) const
 {
-  TreeTemplate<Node>* ttree = dynamic_cast<TreeTemplate<Node>*>(mapping);
-  vector<Node*> nodes = ttree->getNodes();
-  nodesCounter_ = nodes.size() - 1; // intialize nodesCounter_ according ot the number of nodes in the base tree
-  for (size_t i = 0; i < nodes.size(); ++i)
+  size_t state = 0;        // the default state is 0
+  double prob = generator ? generator->drawNumber() : RandomTools::giveRandomNumberBetweenZeroAndEntry(1.0);
+
+  for (size_t i = 0; i < distibution.size(); ++i)
   {
-    Node* son = nodes[i];
-    if (son->hasFather())
+    prob -= distibution[i];
+    if (prob < 0)  // if the the sampled probability is smaller than the probability to choose state i -> set state to be i
     {
-      sampleMutationsGivenAncestralsPerBranch(son);
+      state = i;
+      break;
     }
   }
+  return state;
 }
 
 /******************************************************************************/
 
-void StochasticMapping::updateBranchMapping(Node* son, const MutationPath& branchMapping)
+void StochasticMapping::updateBranchMapping(Node* son, const MutationPath& branchMapping, size_t& nodesCounter) const
 {
   const vector<size_t> states = branchMapping.getStates();
   const VDouble times = branchMapping.getTimes();
@@ -592,9 +858,9 @@ void StochasticMapping::updateBranchMapping(Node* son, const MutationPath& branc
   {
     for (int i = eventsNum - 1; i > -1; --i) // add a new node to represent the transition
     {
-      nodesCounter_ = nodesCounter_ + 1;
-      const string name = "_mappingInternal" + TextTools::toString(nodesCounter_) + "_";
-      nextNode = new Node(static_cast<int>(nodesCounter_), name);
+      nodesCounter = nodesCounter + 1;
+      const string name = "_mappingInternal" + TextTools::toString(nodesCounter) + "_";
+      nextNode = new Node(static_cast<int>(nodesCounter), name);
       setNodeState(nextNode, states[i]);
       nextNode->setDistanceToFather(times[i]);
 
@@ -613,58 +879,124 @@ void StochasticMapping::updateBranchMapping(Node* son, const MutationPath& branc
 
 /******************************************************************************/
 
-void StochasticMapping::sampleMutationsGivenAncestralsPerBranch(Node* son, size_t maxIterNum)
+void StochasticMapping::sampleBranchHistoryByRejection(size_t fatherState, size_t sonState, double branchLength, VDouble& times, vector<size_t>& states, const SimpleMutationProcess& process, CounterRandomGenerator* generator, size_t maxIterNum) const
 {
-  Node* father = son->getFather();
-  double branchLength = son->getDistanceToFather();
-  size_t fatherState = getNodeState(father);
-  size_t sonState = getNodeState(son);
-
   /* simulate mapping on a branch until you manage to finish at the son's state */
   for (size_t i = 0; i < maxIterNum; ++i)
   {
     double disFromNode = 0.0;
     size_t curState = fatherState;
-    MutationPath tryMapping(mappingParameters_->getSubstitutionModel()->getAlphabet(), fatherState, branchLength);
+    times.clear();
+    states.clear();
 
     double timeTillChange;
     // if the father's state is not the same as the son's state -> use the correction corresponding to equation (11) in the paper
     if (fatherState != sonState)
     {   // sample timeTillChange conditional on it being smaller than branchLength
-      double u = RandomTools::giveRandomNumberBetweenZeroAndEntry(1.0);
-      double waitingTimeParam = -1 * mappingParameters_->getSubstitutionModel()->Qij(fatherState, fatherState); // get the parameter for the exoponential distribution to draw the waiting time from
+      double u = generator ? generator->drawNumber() : RandomTools::giveRandomNumberBetweenZeroAndEntry(1.0);
+      double waitingTimeParam = -1 * process.getSubstitutionModel()->Qij(fatherState, fatherState); // get the parameter for the exoponential distribution to draw the waiting time from
       double tmp = u * (1.0 - exp(branchLength * -waitingTimeParam));
       timeTillChange =  -log(1.0 - tmp) / waitingTimeParam;
       assert (timeTillChange < branchLength);
     }
     else
     {
-      timeTillChange = mappingParameters_->getTimeBeforeNextMutationEvent(fatherState); // draw the time until a transition from exponential distribution with the rate of leaving fatherState
+      timeTillChange = generator ? process.getTimeBeforeNextMutationEvent(fatherState, *generator) : process.getTimeBeforeNextMutationEvent(fatherState); // draw the time until a transition from exponential distribution with the rate of leaving fatherState
     }
 
     while (disFromNode + timeTillChange < branchLength)  // a jump occured but not passed the whole branch ->
     {
-      tryMapping.addEvent(curState, timeTillChange);                                        // add the current state and time to branch history
-
       disFromNode += timeTillChange;
-      timeTillChange = mappingParameters_->getTimeBeforeNextMutationEvent(curState);        // draw the time until a transition from exponential distribution with the rate of leaving curState
-      curState = mappingParameters_->mutate(curState);                                      // draw the state to transition to after from initial state curState based on the relative tranistion rates distribution (see MutationProcess.cpp line 50)
+      timeTillChange = generator ? process.getTimeBeforeNextMutationEvent(curState, *generator) : process.getTimeBeforeNextMutationEvent(curState); // draw the time until a transition from exponential distribution with the rate of leaving curState
+      curState = generator ? process.mutate(curState, *generator) : process.mutate(curState);                                      // draw the state to transition to after from initial state curState based on the relative tranistion rates distribution (see MutationProcess.cpp line 50)
+      times.push_back(disFromNode);                                                         // add the time and the new state to branch history
+      states.push_back(curState);
     }
     // the last jump passed the length of the branch -> finish the simulation and check if it's sucessfull (i.e, mapping is finished at the son's state)
-    if (curState != sonState) // if the simulation failed, try again
+    if (curState == sonState)
+      return;
+  }
+  // if all simulations failed -> throw an exception
+  throw Exception("could not produce simulations with father = " + TextTools::toString(fatherState) + " son " + TextTools::toString(sonState) + " branch length = " + TextTools::toString(branchLength));
+}
+
+/******************************************************************************/
+
+void StochasticMapping::sampleBranchHistoryByUniformization(size_t fatherState, size_t sonState, double branchLength, VDouble& times, vector<size_t>& states, const SimpleMutationProcess& process, UniformizationSubstitutionCount& uniformization, CounterRandomGenerator* generator) const
+{
+  const SubstitutionModel* model = process.getSubstitutionModel();
+  size_t statesNum = model->getNumberOfStates();
+  double miu = uniformization.getUniformizationRate();
+  double lam = miu * branchLength;
+
+  double pab = model->Pij_t(fatherState, sonState, branchLength);
+  if (!(pab > 0))
+    throw Exception("could not produce simulations with father = " + TextTools::toString(fatherState) + " son " + TextTools::toString(sonState) + " branch length = " + TextTools::toString(branchLength));
+
+  /* step 1: sample the number of jumps of the uniformized process, including virtual ones:
+     Pr(n | father, son) = Poisson(n; lam) * (R^n)[father][son] / Pij_t[father][son] */
+  double target = (generator ? generator->drawNumber() : RandomTools::giveRandomNumberBetweenZeroAndEntry(1.0)) * pab;
+  size_t nMax = static_cast<size_t>(ceil(4 + 6 * sqrt(lam) + lam)); // the Poisson tail is negligible beyond this point
+  double logLam = log(lam);
+  double logPoisson = -lam;
+  double cumProb = (fatherState == sonState ? exp(logPoisson) : 0);
+  size_t jumpsNum = 0;
+  size_t lastPossible = 0; // the last number of jumps with a positive probability, in case of rounding errors
+  while (cumProb < target && jumpsNum < nMax)
+  {
+    ++jumpsNum;
+    logPoisson += logLam - log(static_cast<double>(jumpsNum));
+    double prob = exp(logPoisson) * uniformization.getUniformizedMatrixPower(jumpsNum)(fatherState, sonState);
+    if (prob > 0)
+      lastPossible = jumpsNum;
+    cumProb += prob;
+  }
+  if (cumProb < target)
+    jumpsNum = lastPossible;
+
+  /* step 2: sample the times of the jumps uniformly along the branch */
+  VDouble jumpTimes(jumpsNum);
+  for (size_t i = 0; i < jumpsNum; ++i)
+  {
+    jumpTimes[i] = generator ? generator->drawNumber() * branchLength : RandomTools::giveRandomNumberBetweenZeroAndEntry(branchLength);
+  }
+  sort(jumpTimes.begin(), jumpTimes.end());
+
+  /* step 3: sample the state after each jump, conditioned on the son's state:
+     Pr(next = y | cur = x, k jumps left) = R[x][y] * (R^(k-1))[y][son] / (R^k)[x][son]
+     only actual changes of state are recorded in the mapping */
+  times.clear();
+  states.clear();
+  size_t curState = fatherState;
+  for (size_t i = 0; i < jumpsNum; ++i)
+  {
+    size_t nextState = sonState;
+    if (i + 1 < jumpsNum)
     {
-      continue;
+      size_t jumpsLeft = jumpsNum - i;
+      const RowMatrix<double>& R = uniformization.getUniformizedMatrixPower(1);
+      const RowMatrix<double>& Rk = uniformization.getUniformizedMatrixPower(jumpsLeft - 1);
+      double u = (generator ? generator->drawNumber() : RandomTools::giveRandomNumberBetweenZeroAndEntry(1.0)) * uniformization.getUniformizedMatrixPower(jumpsLeft)(curState, sonState);
+      double cumStateProb = 0;
+      for (size_t state = 0; state < statesNum; ++state)
+      {
+        double prob = R(curState, state) * Rk(state, sonState);
+        if (prob > 0)
+        {
+          nextState = state;
+          cumStateProb += prob;
+          if (u < cumStateProb)
+            break;
+        }
+      }
     }
-    else                      // if the simulation was sucessfully, add it to the build mapping
+    if (nextState != curState) // virtual jumps do not change the state
     {
-      double timeOfJump = branchLength - disFromNode;
-      son->setDistanceToFather(timeOfJump);
-      updateBranchMapping(son, tryMapping);     // add the successfull simulation to the build mapping
-      return;
+      times.push_back(jumpTimes[i]);
+      states.push_back(nextState);
+      curState = nextState;
     }
   }
-  // if all simulations failed -> throw an exception
-  throw Exception("could not produce simulations with father = " + TextTools::toString(fatherState) + " son " + TextTools::toString(sonState) + " branch length = " + TextTools::toString(branchLength));
 }
 
 /******************************************************************************/
@@ -734,5 +1066,5 @@ void StochasticMapping::updateBranchByDwellingTimes(Node* node, VDouble& dwellin
   }
 
   /* secondly, update the expected history with the dwelling times-based mutation path */
-  updateBranchMapping(node, branchMapping);
+  updateBranchMapping(node, branchMapping, nodesCounter_);
 }
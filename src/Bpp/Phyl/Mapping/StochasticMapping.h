@@ -42,6 +42,9 @@
 
 #include "../Likelihood/TreeLikelihood.h"
 #include "../Simulation/MutationProcess.h"
+#include "UniformizationSubstitutionCount.h"
+#include "StochasticMappingStore.h"
+#include "../Simulation/CounterRandomGenerator.h"
 
 // From the STL:
 #include <iostream>
@@ -67,18 +70,30 @@ protected:
   const TreeLikelihood* tl_;                       // the tree likelihood instance is used for computing the the conditional sampling probabilities of the ancestral states as well as the root assignment probabilities
   VVDouble fractionalProbabilities_;               // vector that holds the fractional probabilities per state per node in the tree, based on which the conditional and posterior probabilities are computed
   VVVDouble ConditionalProbabilities_;             // vector that holds the conditionl states assignment probabilities of the nodes in the tree (node*father_states*son_states)
+  vector<size_t> fatherPositions_;                 // the position of the father of each node in the vector of nodes of the base tree (the root is its own father)
+  vector<size_t> preorderPositions_;               // the positions of the nodes of the base tree, in pre-order
   size_t nodesCounter_;                            // counter of nodes hat allows adding unique names to the generated nodes while breaking branching in a mapping
   size_t numOfMappings_;                           // the number of stochastic mappings to generate
+  short samplingMethod_;                           // the method used to sample the history of a branch given the states at its ends
+  UniformizationSubstitutionCount* uniformization_; // holds the powers of the uniformized transition matrix, when sampling by uniformization
 
 public:
+  /* methods to sample the history of a branch conditioned on the states at its ends:
+   * REJECTION_SAMPLING simulates forward until the history ends in the son's state (Nielsen 2002),
+   * UNIFORMIZATION_SAMPLING draws the number of jumps and the intermediate states directly, without rejection.
+   * See: Hobolth, Asger and Stone, Eric A. "Simulation from endpoint-conditioned, continuous-time Markov chains on a finite state space, with applications to molecular evolution." The Annals of Applied Statistics 3.3 (2009): 1204-1231. */
+  static const short REJECTION_SAMPLING;
+  static const short UNIFORMIZATION_SAMPLING;
+
   /* constructors and destructors */
 
-  explicit StochasticMapping(const TreeLikelihood* tl, size_t numOfMappings = 10000); // it is a good general practice to use "explicit" keyword on constructors with a single argument: https://stackoverflow.com/questions/121162/what-does-the-explicit-keyword-mean
+  explicit StochasticMapping(const TreeLikelihood* tl, size_t numOfMappings = 10000, short samplingMethod = REJECTION_SAMPLING); // it is a good general practice to use "explicit" keyword on constructors with a single argument: https://stackoverflow.com/questions/121162/what-does-the-explicit-keyword-mean
 
   ~StochasticMapping();
 
   StochasticMapping(const StochasticMapping& sm) : // must pass sm by repference to avoid infinitie recusion in the copy construcor
-    mappingParameters_(sm.mappingParameters_), baseTree_(0), tl_(sm.tl_), fractionalProbabilities_(sm.fractionalProbabilities_), ConditionalProbabilities_(sm.ConditionalProbabilities_), nodesCounter_(0), numOfMappings_(sm.numOfMappings_)
+    mappingParameters_(sm.mappingParameters_), baseTree_(0), tl_(sm.tl_), fractionalProbabilities_(sm.fractionalProbabilities_), ConditionalProbabilities_(sm.ConditionalProbabilities_), fatherPositions_(sm.fatherPositions_), preorderPositions_(sm.preorderPositions_), nodesCounter_(0), numOfMappings_(sm.numOfMappings_),
+    samplingMethod_(sm.samplingMethod_), uniformization_(sm.uniformization_ ? sm.uniformization_->clone() : 0)
   { baseTree_ = sm.baseTree_->clone(); } // the tree must be cloned so that instead of copying the pointer to the tree, a new tree with a new pointer will be created
 
   /**
@@ -91,7 +106,16 @@ public:
     mappingParameters_ = sm.mappingParameters_;
     fractionalProbabilities_ = sm.fractionalProbabilities_;
     ConditionalProbabilities_ = sm.ConditionalProbabilities_;
+    fatherPositions_ = sm.fatherPositions_;
+    preorderPositions_ = sm.preorderPositions_;
     numOfMappings_ = sm.numOfMappings_;
+    samplingMethod_ = sm.samplingMethod_;
+    if (this != &sm)
+    {
+      if (uniformization_)
+        delete uniformization_;
+      uniformization_ = sm.uniformization_ ? sm.uniformization_->clone() : 0;
+    }
     return *this;
   }
 
@@ -108,6 +132,36 @@ public:
    */
   void generateStochasticMapping(vector<Tree*>& mappings);
 
+  /* generates stochastic mappings based on the sampling parameters, and stores them in a compact form, without creating any tree
+   * nodes are identified by their position in the vector of nodes of the base tree (that is, the tree of the likelihood function)
+   * @param mappings          The store to add the sampled stochastic mappings to. It is reset if its number of nodes does not match the base tree.
+   */
+  void generateStochasticMapping(StochasticMappingStore& mappings);
+
+  /* generates stochastic mappings in parallel, each one using its own stream of random numbers
+   * the i'th mapping only depends on the seed and on i, and not on the number of threads
+   * @param mappings          The store to add the sampled stochastic mappings to. It is reset if its number of nodes does not match the base tree.
+   * @param seed              The seed of the random number generator
+   */
+  void generateStochasticMapping(StochasticMappingStore& mappings, uint64_t seed);
+
+  /* the same as above, but the mappings are returned as trees that must be deleted by the calling function */
+  void generateStochasticMapping(vector<Tree*>& mappings, uint64_t seed);
+
+  /* creates the tree representation of a mapping from a store, where each substitution is represented by a node with a single son
+   * @param mappings          The store of mappings
+   * @param index             The index of the mapping in the store
+   * @return                  A new tree instance, that must be deleted by the calling function
+   */
+  Tree* getMappingTree(const StochasticMappingStore& mappings, size_t index) const;
+
+  /* sets the method used to sample the history of each branch given the states at its ends
+   * @param samplingMethod    Either REJECTION_SAMPLING or UNIFORMIZATION_SAMPLING
+   */
+  void setSamplingMethod(short samplingMethod);
+
+  short getSamplingMethod() const { return samplingMethod_; }
+
   /* creates a single expected (i.e, average) history based on a given set of mappings
    * steps correspond to Nielsen, Rasmus. "Mapping mutations on phylogenies." Systematic biology 51.5 (2002): 729-739.‏
    * the function assumes that there is only one site to simulate history for */
@@ -116,6 +170,9 @@ public:
    */
   Tree* generateExpectedMapping(vector<Tree*>& mappings, size_t divMethod = 0);
 
+  /* the same as above, but from a compact store of mappings */
+  Tree* generateExpectedMapping(const StochasticMappingStore& mappings, size_t divMethod = 0);
+
   /* creates a single expected (i.e, average) history based the rewards prvided by te algorithm of Minin and Suchard (2008)
    * the function assumes that there is only one site to simulate history for */
   /* @param divMethod         The method used in the case that the son and father share the same state (either divide the wdelling time of the staed state by 2 for  two transitions (method 0) or allocate the entire dwelling time to be adjacent to the son(method 1))
@@ -138,7 +195,7 @@ private:
    * @param node               The node to get the state of
    * @param state              The state that needs to be assigned to the node
    */
-  void setNodeState(Node* node, size_t state);
+  void setNodeState(Node* node, size_t state) const;
 
   /* set the character states of the leafs as properties of thier nodes instances
    * @param mapping - the tree to sets the properties in
@@ -161,15 +218,39 @@ private:
    */
   void computeStatesFrequencies(VVDouble& ancestralStatesFreuquencies, vector<Tree*>& mappings);
 
+  /* the same as above, but from a compact store of mappings */
+  void computeStatesFrequencies(VVDouble& ancestralStatesFreuquencies, const StochasticMappingStore& mappings);
+
+  /* breaks a branch of the expected history according to average dwelling times, unless there is a single state along the branch
+   * @param node                  The node at the bottom of the branch
+   * @param dwellingTimes         The sum over all mappings of the dwelling times of each state along the branch
+   * @param mappingsNum           The number of mappings
+   * @param ancestralStatesFrequencies The frequencies of the states at each node over all mappings
+   * @param divMethod             The method used in the case that the son and father share the same state (see updateBranchByDwellingTimes)
+   */
+  void updateExpectedBranch(Node* node, VDouble& dwellingTimes, size_t mappingsNum, VVDouble& ancestralStatesFrequencies, size_t divMethod);
+
   /* auxiliary function that samples a state based on a given discrete distribution
    * @param distibution       The distribution to sample states based on
    */
-  size_t sampleState(const VDouble& distibution); // k: best by ref
+  size_t sampleState(const VDouble& distibution, CounterRandomGenerator* generator = 0) const; // k: best by ref
 
-  /* samples ancestral states based on the conditional probabilities at each node in the base (user input) tree and the root assignment probabilities. States will be updated as nodes properties
-   * @param mapping               The tree whose nodes names should be updated according to their assigned states.
+  /* get the states of the leafs of the base tree
+   * @param nodes                 The nodes of the base tree
+   * @return                      The state of each leaf, in the same order as the nodes (0 for internal nodes)
    */
-  void sampleAncestrals(Tree* mapping);
+  vector<size_t> getLeafStates(const vector<Node*>& nodes) const;
+
+  /* samples a new mapping and adds it to a store
+   * this function does not modify the instance, so that several mappings can be sampled concurrently with distinct processes and generators
+   * @param mappings              The store to add the mapping to
+   * @param nodes                 The nodes of the base tree
+   * @param leafStates            The states of the leafs of the base tree
+   * @param process               The mutation process to sample histories with
+   * @param uniformization        The powers of the uniformized matrix of the process model, to sample by uniformization, or 0 to sample by rejection
+   * @param generator             The random number generator to use, or 0 to use RandomTools
+   */
+  void sampleMapping(StochasticMappingStore& mappings, const vector<Node*>& nodes, const vector<size_t>& leafStates, const SimpleMutationProcess& process, UniformizationSubstitutionCount* uniformization, CounterRandomGenerator* generator) const;
 
   /* set ancestral states in the expected history based on the conditional probabilities at each node in the base (user input) tree and the root assignment probabilities. States will be updated as nodes properties
    * @param expectedMapping           The expected mapping instance whose nodes names should be updated according to their assigned states.
@@ -177,22 +258,31 @@ private:
    */
   void setExpectedAncestrals(Tree* expectedMapping, VVDouble& posteriorProbabilities);
 
-  /* simulates mutations on phylogeny based the sampled ancestrals, tips data, and the simulation parameters
-   * @param mapping               The tree that should be edited according to the sampled history
-   */
-  void sampleMutationsGivenAncestrals(Tree* mapping);
-
   /* adds a branch mapping to the mapping in a tree format by repeatedly braking branches and adding internal nodes with single children
    * @param son                   The node at the bottom of the branch
-   * @param branchMapping         The branchMapping of transitions in a MutationProcess format
+   * @param branchMapping         The branchMapping of transitions in a MutationProcess format, where each event holds the state before the transition and the time spent in it
+   * @param nodesCounter          Counter of nodes that allows adding unique names to the generated nodes
+   */
+  void updateBranchMapping(Node* son, const MutationPath& branchMapping, size_t& nodesCounter) const;
+
+  /* samples the history of a branch by simulating it forward until it ends in the son's state
+   * @param fatherState           The state at the top of the branch
+   * @param sonState              The state at the bottom of the branch
+   * @param branchLength          The length of the branch
+   * @param times                 [out] The distance from the father of each substitution
+   * @param states                [out] The state after each substitution
+   * @param process               The mutation process to simulate with
+   * @param generator             The random number generator to use, or 0 to use RandomTools
+   * @param maxIterNum            Maximal number of simulation trials
    */
-  void updateBranchMapping(Node* son, const MutationPath& branchMapping);
+  void sampleBranchHistoryByRejection(size_t fatherState, size_t sonState, double branchLength, VDouble& times, vector<size_t>& states, const SimpleMutationProcess& process, CounterRandomGenerator* generator, size_t maxIterNum = 10000) const;
 
-  /* sample mutations based on the stochastic mapping parameters, the source and destination state, and the branch length, and updates the simulated history along the branch in the input tree, on the fly
-   * @param son                   Node of interest
-   * @param maxIterNum            Maximal number of imulation trials
+  /* samples the history of a branch using uniformization:
+   * the number of jumps of the uniformized process is drawn from its distribution conditioned on the end states, then the states after each jump, so that no history is rejected
+   * @param uniformization        The powers of the uniformized matrix of the process model
+   * other parameters are the same as for sampleBranchHistoryByRejection
    */
-  void sampleMutationsGivenAncestralsPerBranch(Node* son, size_t maxIterNum = 10000);
+  void sampleBranchHistoryByUniformization(size_t fatherState, size_t sonState, double branchLength, VDouble& times, vector<size_t>& states, const SimpleMutationProcess& process, UniformizationSubstitutionCount& uniformization, CounterRandomGenerator* generator) const;
 
   /* converts a vector of dwelling times to a mutation path and then updates the bracnh stemming from the given node */
   /* @param node                      The node at the bottom of the branch
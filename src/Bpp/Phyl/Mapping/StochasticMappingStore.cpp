@@ -0,0 +1,104 @@
+//
+// File: StochasticMappingStore.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include "StochasticMappingStore.h"
+
+#include <Bpp/Text/TextTools.h>
+
+using namespace bpp;
+using namespace std;
+
+/******************************************************************************/
+
+void StochasticMappingStore::reset(size_t nbNodes)
+{
+  nbNodes_ = nbNodes;
+  nodeStates_.clear();
+  eventsStart_.clear();
+  eventsNumber_.clear();
+  eventTimes_.clear();
+  eventStates_.clear();
+}
+
+/******************************************************************************/
+
+size_t StochasticMappingStore::addMapping()
+{
+  if (nbNodes_ == 0)
+    throw Exception("StochasticMappingStore::addMapping. The number of nodes of the base tree is not set.");
+  size_t index = getNumberOfMappings();
+  nodeStates_.resize(nodeStates_.size() + nbNodes_, 0);
+  eventsStart_.resize(eventsStart_.size() + nbNodes_, eventTimes_.size());
+  eventsNumber_.resize(eventsNumber_.size() + nbNodes_, 0);
+  return index;
+}
+
+/******************************************************************************/
+
+void StochasticMappingStore::addMappings(const StochasticMappingStore& store)
+{
+  if (store.nbNodes_ != nbNodes_)
+    throw Exception("StochasticMappingStore::addMappings. Stores have different numbers of nodes: " + TextTools::toString(store.nbNodes_) + " and " + TextTools::toString(nbNodes_) + ".");
+  size_t offset = eventTimes_.size();
+  nodeStates_.insert(nodeStates_.end(), store.nodeStates_.begin(), store.nodeStates_.end());
+  for (size_t i = 0; i < store.eventsStart_.size(); ++i)
+  {
+    eventsStart_.push_back(store.eventsStart_[i] + offset);
+  }
+  eventsNumber_.insert(eventsNumber_.end(), store.eventsNumber_.begin(), store.eventsNumber_.end());
+  eventTimes_.insert(eventTimes_.end(), store.eventTimes_.begin(), store.eventTimes_.end());
+  eventStates_.insert(eventStates_.end(), store.eventStates_.begin(), store.eventStates_.end());
+}
+
+/******************************************************************************/
+
+void StochasticMappingStore::addEvent(size_t mapping, size_t node, double time, size_t state)
+{
+  size_t branch = mapping * nbNodes_ + node;
+  if (eventsNumber_[branch] == 0)
+    eventsStart_[branch] = eventTimes_.size();
+  else if (eventsStart_[branch] + eventsNumber_[branch] != eventTimes_.size())
+    throw Exception("StochasticMappingStore::addEvent. The events of a branch must be added contiguously.");
+  eventTimes_.push_back(time);
+  eventStates_.push_back(static_cast<uint32_t>(state));
+  eventsNumber_[branch]++;
+}
+
+/******************************************************************************/
+
@@ -0,0 +1,164 @@
+//
+// File: StochasticMappingStore.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _STOCHASTICMAPPINGSTORE_H_
+#define _STOCHASTICMAPPINGSTORE_H_
+
+#include <Bpp/Exceptions.h>
+
+// From the STL:
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+namespace bpp
+{
+
+/**
+ * @brief Compact storage for a set of stochastic mappings.
+ *
+ * All mappings share the topology of a base tree, whose nodes are identified by
+ * their position (index) in the base tree. For each mapping, the store holds the
+ * state of each node, and for each branch the list of its substitution events.
+ * An event is a pair (time, state), where time is the distance from the father
+ * node at which the substitution occurs, and state is the state after it.
+ * Events are stored in increasing order of time, so that the state after the
+ * last event of a branch is the state of the son node.
+ *
+ * The events of all branches and mappings are kept in a pair of shared arrays,
+ * so that no tree or node object has to be created. Trees can be obtained on
+ * demand with StochasticMapping::getMappingTree.
+ *
+ * @see StochasticMapping
+ */
+class StochasticMappingStore
+{
+  private:
+    size_t nbNodes_;
+    std::vector<uint32_t> nodeStates_;
+    std::vector<size_t> eventsStart_;
+    std::vector<size_t> eventsNumber_;
+    std::vector<double> eventTimes_;
+    std::vector<uint32_t> eventStates_;
+
+  public:
+    /**
+     * @param nbNodes The number of nodes in the base tree.
+     */
+    StochasticMappingStore(size_t nbNodes = 0) :
+      nbNodes_(nbNodes), nodeStates_(), eventsStart_(), eventsNumber_(), eventTimes_(), eventStates_()
+    {}
+
+    virtual ~StochasticMappingStore() {}
+
+  public:
+    size_t getNumberOfNodes() const { return nbNodes_; }
+
+    size_t getNumberOfMappings() const { return nbNodes_ == 0 ? 0 : nodeStates_.size() / nbNodes_; }
+
+    /**
+     * @return The total number of events, for all branches and mappings.
+     */
+    size_t getNumberOfEvents() const { return eventTimes_.size(); }
+
+    /**
+     * @brief Remove all mappings, and set the number of nodes of the base tree.
+     *
+     * @param nbNodes The number of nodes in the base tree.
+     */
+    void reset(size_t nbNodes);
+
+    /**
+     * @brief Add a new mapping, with all states set to 0 and no event.
+     *
+     * @return The index of the new mapping.
+     */
+    size_t addMapping();
+
+    /**
+     * @brief Append the mappings of another store, with the same base tree.
+     *
+     * @param store The store to copy mappings from.
+     */
+    void addMappings(const StochasticMappingStore& store);
+
+    size_t getNodeState(size_t mapping, size_t node) const
+    {
+      return nodeStates_[mapping * nbNodes_ + node];
+    }
+
+    void setNodeState(size_t mapping, size_t node, size_t state)
+    {
+      nodeStates_[mapping * nbNodes_ + node] = static_cast<uint32_t>(state);
+    }
+
+    /**
+     * @brief Add an event at the end of a branch history.
+     *
+     * Events must be added in increasing order of time, and the events of a
+     * branch must be added contiguously.
+     *
+     * @param mapping The index of the mapping.
+     * @param node    The index of the node at the bottom of the branch.
+     * @param time    The distance from the father node at which the event occurs.
+     * @param state   The state after the event.
+     * @throw Exception If events of another branch were added in between.
+     */
+    void addEvent(size_t mapping, size_t node, double time, size_t state);
+
+    size_t getNumberOfEvents(size_t mapping, size_t node) const
+    {
+      return eventsNumber_[mapping * nbNodes_ + node];
+    }
+
+    double getEventTime(size_t mapping, size_t node, size_t event) const
+    {
+      return eventTimes_[eventsStart_[mapping * nbNodes_ + node] + event];
+    }
+
+    size_t getEventState(size_t mapping, size_t node, size_t event) const
+    {
+      return eventStates_[eventsStart_[mapping * nbNodes_ + node] + event];
+    }
+};
+
+} //end of namespace bpp.
+
+#endif //_STOCHASTICMAPPINGSTORE_H_
+
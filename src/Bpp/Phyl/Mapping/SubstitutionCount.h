@@ -48,6 +48,7 @@
 
 //From the STL:
 #include <vector>
+#include <memory>
 
 namespace bpp
 {
@@ -141,6 +142,18 @@ namespace bpp
      */
     virtual Matrix<double>* getAllNumbersOfSubstitutions(double length, size_t type) const = 0;
 
+    /**
+     * @brief Get the numbers of susbstitutions on a branch, for all types and all initial and final states, given the branch length.
+     *
+     * All counts are written in one go into a caller-owned array, so that no matrix is allocated.
+     * The number of substitutions of type t + 1 from state x to state y is stored at index (x * n + y) * nbTypes + t,
+     * where n is the number of states of the model (the size of the matrices returned by getAllNumbersOfSubstitutions(double, size_t)).
+     *
+     * @param length The length of the branch.
+     * @param counts [out] The array to fill, resized if needed.
+     */
+    virtual void getAllNumbersOfSubstitutions(double length, std::vector<double>& counts) const = 0;
+
     /**
      * @brief Get the numbers of susbstitutions on a branch for all types, for an initial and final states, given the branch length.
      *
@@ -170,13 +183,27 @@ namespace bpp
   protected:
     std::unique_ptr<SubstitutionRegister> register_;
 
+  private:
+    size_t cacheSize_;
+    mutable std::vector<double> cachedLengths_;
+    mutable std::vector< std::vector<double> > cachedCounts_;
+    mutable size_t cacheNext_;
+
   public:
     AbstractSubstitutionCount(SubstitutionRegister* reg):
-      register_(reg)
+      register_(reg),
+      cacheSize_(32),
+      cachedLengths_(),
+      cachedCounts_(),
+      cacheNext_(0)
     {}
 
     AbstractSubstitutionCount(const AbstractSubstitutionCount& asc):
-      register_(asc.register_.get() ? asc.register_->clone() : 0)
+      register_(asc.register_.get() ? asc.register_->clone() : 0),
+      cacheSize_(asc.cacheSize_),
+      cachedLengths_(asc.cachedLengths_),
+      cachedCounts_(asc.cachedCounts_),
+      cacheNext_(asc.cacheNext_)
     {}
 
     AbstractSubstitutionCount& operator=(const AbstractSubstitutionCount& asc) {
@@ -184,6 +211,10 @@ namespace bpp
         register_.reset(asc.register_->clone());
       else
         register_.reset();
+      cacheSize_     = asc.cacheSize_;
+      cachedLengths_ = asc.cachedLengths_;
+      cachedCounts_  = asc.cachedCounts_;
+      cacheNext_     = asc.cacheNext_;
       return *this;
     }
 
@@ -201,6 +232,7 @@ namespace bpp
     
     void setSubstitutionRegister(SubstitutionRegister* reg) {
       register_.reset(reg);
+      clearCache_();
       substitutionRegisterHasChanged();
     }
 
@@ -208,8 +240,96 @@ namespace bpp
     
     SubstitutionRegister* getSubstitutionRegister() { return register_.get(); }
 
+    /**
+     * @brief Set the number of branch lengths for which all counts are kept in cache.
+     *
+     * Counts returned by getAllNumbersOfSubstitutions(double, std::vector<double>&) are kept
+     * for the last branch lengths, so that repeated lengths are not recomputed.
+     *
+     * @param size The number of lengths to keep, 0 to disable the cache.
+     */
+    void setCacheSize(size_t size) {
+      cacheSize_ = size;
+      clearCache_();
+    }
+
+    size_t getCacheSize() const { return cacheSize_; }
+
   protected:
     virtual void substitutionRegisterHasChanged() = 0;
+
+    /**
+     * @brief Look for the counts of a branch length in the cache.
+     *
+     * @param length The length of the branch.
+     * @param counts [out] The counts, if found.
+     * @return True if the counts were found.
+     */
+    bool getCachedCounts_(double length, std::vector<double>& counts) const
+    {
+      for (size_t i = 0; i < cachedLengths_.size(); ++i)
+      {
+        if (cachedLengths_[i] == length)
+        {
+          counts = cachedCounts_[i];
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /**
+     * @brief Store the counts of a branch length in the cache, in place of the oldest ones if the cache is full.
+     */
+    void cacheCounts_(double length, const std::vector<double>& counts) const
+    {
+      if (cacheSize_ == 0)
+        return;
+      if (cachedLengths_.size() < cacheSize_)
+      {
+        cachedLengths_.push_back(length);
+        cachedCounts_.push_back(counts);
+      }
+      else
+      {
+        cachedLengths_[cacheNext_] = length;
+        cachedCounts_[cacheNext_] = counts;
+        cacheNext_ = (cacheNext_ + 1) % cacheSize_;
+      }
+    }
+
+    /**
+     * @brief Copy count matrices, one for each type, into the layout of getAllNumbersOfSubstitutions(double, std::vector<double>&).
+     *
+     * @param matrices The count matrices.
+     * @param counts [out] The array to fill, resized if needed.
+     */
+    static void fillCounts_(const std::vector< RowMatrix<double> >& matrices, std::vector<double>& counts)
+    {
+      size_t nbTypes = matrices.size();
+      size_t n = nbTypes > 0 ? matrices[0].getNumberOfRows() : 0;
+      counts.resize(n * n * nbTypes);
+      for (size_t t = 0; t < nbTypes; ++t)
+      {
+        for (size_t x = 0; x < n; ++x)
+        {
+          for (size_t y = 0; y < n; ++y)
+          {
+            counts[(x * n + y) * nbTypes + t] = matrices[t](x, y);
+          }
+        }
+      }
+    }
+
+    /**
+     * @brief Empty the cache, to be called whenever the counts change for a given length.
+     */
+    void clearCache_() const
+    {
+      cachedLengths_.clear();
+      cachedCounts_.clear();
+      cacheNext_ = 0;
+    }
   };
 
 } //end of namespace bpp.
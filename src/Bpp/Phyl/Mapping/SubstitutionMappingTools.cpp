@@ -55,11 +55,62 @@ using namespace bpp;
 
 // From the STL:
 #include <iomanip>
+#include <algorithm>
+#include <map>
+#include <memory>
 
 using namespace std;
 
 /******************************************************************************/
 
+namespace
+{
+  /**
+   * A copy of a substitution count, for use by a single thread.
+   *
+   * Computing transition probabilities modifies the substitution models, so
+   * that the count is set on copies of the models of the likelihood, which
+   * are created on first use. The count is only updated when the model changes
+   * from one branch to the next.
+   */
+  class ThreadSubstitutionCount
+  {
+    private:
+      unique_ptr<SubstitutionCount> count_;
+      map<const SubstitutionModel*, shared_ptr<SubstitutionModel> > models_;
+      const SubstitutionModel* currentModel_;
+
+    private:
+      ThreadSubstitutionCount(const ThreadSubstitutionCount&);
+      ThreadSubstitutionCount& operator=(const ThreadSubstitutionCount&);
+
+    public:
+      ThreadSubstitutionCount(const SubstitutionCount& count) :
+        count_(count.clone()), models_(), currentModel_(0)
+      {}
+
+    public:
+      /**
+       * @param model The model of the current branch.
+       * @return The substitution count, set with a copy of the model.
+       */
+      SubstitutionCount& setSubstitutionModel(const SubstitutionModel* model)
+      {
+        if (model != currentModel_)
+        {
+          shared_ptr<SubstitutionModel>& copy = models_[model];
+          if (!copy)
+            copy.reset(model->clone());
+          count_->setSubstitutionModel(copy.get());
+          currentModel_ = model;
+        }
+        return *count_;
+      }
+  };
+}
+
+/******************************************************************************/
+
 ProbabilisticSubstitutionMapping* SubstitutionMappingTools::computeSubstitutionVectors(
   const DRTreeLikelihood& drtl,
   const vector<int>& nodeIds,
@@ -114,252 +165,265 @@ ProbabilisticSubstitutionMapping* SubstitutionMappingTools::computeSubstitutionV
   if (verbose)
     ApplicationTools::displayTask("Compute joint node-pairs likelihood", true);
 
-  for (size_t l = 0; l < nbNodes; ++l)
+  vector<string> errors(nbNodes);
+  size_t nbDone = 0;
+  long nb = static_cast<long>(nbNodes);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
   {
-    // For each node,
-    const Node* currentNode = nodes[l];
-    if (nodeIds.size() > 0 && !VectorTools::contains(nodeIds, currentNode->getId()))
-      continue;
-
-    const Node* father = currentNode->getFather();
+    // Branches are independent: each thread uses its own copy of the substitution count, and its own scratch arrays.
+    ThreadSubstitutionCount threadCount(substitutionCount);
+    VVdouble substitutionsForCurrentNode(nbDistinctSites, Vdouble(nbTypes));
+    VVVdouble likelihoodsFatherConstantPart(nbDistinctSites, VVdouble(nbClasses, Vdouble(nbStates)));
+    VVdouble nxy(nbClasses);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (long ll = 0; ll < nb; ++ll)
+    {
+      size_t l = static_cast<size_t>(ll);
+      try
+      {
+        // For each node,
+        const Node* currentNode = nodes[l];
+        if (nodeIds.size() > 0 && !VectorTools::contains(nodeIds, currentNode->getId()))
+          continue;
 
-    double d = currentNode->getDistanceToFather();
+        const Node* father = currentNode->getFather();
 
-    if (verbose)
-      ApplicationTools::displayGauge(l, nbNodes - 1);
-    VVdouble substitutionsForCurrentNode(nbDistinctSites);
-    for (size_t i = 0; i < nbDistinctSites; ++i)
-    {
-      substitutionsForCurrentNode[i].resize(nbTypes);
-    }
+        double d = currentNode->getDistanceToFather();
 
-    // Now we've got to compute likelihoods in a smart manner... ;)
-    VVVdouble likelihoodsFatherConstantPart(nbDistinctSites);
-    for (size_t i = 0; i < nbDistinctSites; i++)
-    {
-      VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-      likelihoodsFatherConstantPart_i->resize(nbClasses);
-      for (size_t c = 0; c < nbClasses; c++)
-      {
-        Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-        likelihoodsFatherConstantPart_i_c->resize(nbStates);
-        double rc = rDist->getProbability(c);
-        for (size_t s = 0; s < nbStates; s++)
+        if (verbose)
         {
-          // (* likelihoodsFatherConstantPart_i_c)[s] = rc * model->freq(s);
-          // freq is already accounted in the array
-          (*likelihoodsFatherConstantPart_i_c)[s] = rc;
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+          ApplicationTools::displayGauge(nbDone++, nbNodes - 1);
+        }
+        for (size_t i = 0; i < nbDistinctSites; ++i)
+        {
+          fill(substitutionsForCurrentNode[i].begin(), substitutionsForCurrentNode[i].end(), 0.);
         }
-      }
-    }
-
-    // First, what will remain constant:
-    size_t nbSons =  father->getNumberOfSons();
-    for (size_t n = 0; n < nbSons; n++)
-    {
-      const Node* currentSon = father->getSon(n);
-      if (currentSon->getId() != currentNode->getId())
-      {
-        const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
 
-        // Now iterate over all site partitions:
-        unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentSon->getId()));
-        VVVdouble pxy;
-        bool first;
-        while (mit->hasNext())
+        // Now we've got to compute likelihoods in a smart manner... ;)
+        for (size_t i = 0; i < nbDistinctSites; i++)
         {
-          TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
-          unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
-          first = true;
-          while (sit->hasNext())
+          VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+          for (size_t c = 0; c < nbClasses; c++)
           {
-            size_t i = sit->next();
-            // We retrieve the transition probabilities for this site partition:
-            if (first)
+            Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+            double rc = rDist->getProbability(c);
+            for (size_t s = 0; s < nbStates; s++)
             {
-              pxy = drtl.getTransitionProbabilitiesPerRateClass(currentSon->getId(), i);
-              first = false;
+              // (* likelihoodsFatherConstantPart_i_c)[s] = rc * model->freq(s);
+              // freq is already accounted in the array
+              (*likelihoodsFatherConstantPart_i_c)[s] = rc;
             }
-            const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
-            VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-            for (size_t c = 0; c < nbClasses; c++)
+          }
+        }
+
+        // First, what will remain constant:
+        size_t nbSons =  father->getNumberOfSons();
+        for (size_t n = 0; n < nbSons; n++)
+        {
+          const Node* currentSon = father->getSon(n);
+          if (currentSon->getId() != currentNode->getId())
+          {
+            const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
+
+            // Now iterate over all site partitions:
+            unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentSon->getId()));
+            VVVdouble pxy;
+            bool first;
+            while (mit->hasNext())
             {
-              const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
-              Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-              VVdouble* pxy_c = &pxy[c];
-              for (size_t x = 0; x < nbStates; x++)
+              TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
+              unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
+              first = true;
+              while (sit->hasNext())
               {
-                Vdouble* pxy_c_x = &(*pxy_c)[x];
-                double likelihood = 0.;
-                for (size_t y = 0; y < nbStates; y++)
+                size_t i = sit->next();
+                // We retrieve the transition probabilities for this site partition:
+                if (first)
+                {
+                  pxy = drtl.getTransitionProbabilitiesPerRateClass(currentSon->getId(), i);
+                  first = false;
+                }
+                const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
+                VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+                for (size_t c = 0; c < nbClasses; c++)
                 {
-                  likelihood += (*pxy_c_x)[y] * (*likelihoodsFather_son_i_c)[y];
+                  const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
+                  Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+                  VVdouble* pxy_c = &pxy[c];
+                  for (size_t x = 0; x < nbStates; x++)
+                  {
+                    Vdouble* pxy_c_x = &(*pxy_c)[x];
+                    double likelihood = 0.;
+                    for (size_t y = 0; y < nbStates; y++)
+                    {
+                      likelihood += (*pxy_c_x)[y] * (*likelihoodsFather_son_i_c)[y];
+                    }
+                    (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
+                  }
                 }
-                (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
               }
             }
           }
         }
-      }
-    }
-    if (father->hasFather())
-    {
-      const Node* currentSon = father->getFather();
-      const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
-      // Now iterate over all site partitions:
-      unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(father->getId()));
-      VVVdouble pxy;
-      bool first;
-      while (mit->hasNext())
-      {
-        TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
-        unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
-        first = true;
-        while (sit->hasNext())
+        if (father->hasFather())
         {
-          size_t i = sit->next();
-          // We retrieve the transition probabilities for this site partition:
-          if (first)
-          {
-            pxy = drtl.getTransitionProbabilitiesPerRateClass(father->getId(), i);
-            first = false;
-          }
-          const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
-          VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-          for (size_t c = 0; c < nbClasses; c++)
+          const Node* currentSon = father->getFather();
+          const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
+          // Now iterate over all site partitions:
+          unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(father->getId()));
+          VVVdouble pxy;
+          bool first;
+          while (mit->hasNext())
           {
-            const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
-            Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-            VVdouble* pxy_c = &pxy[c];
-            for (size_t x = 0; x < nbStates; x++)
+            TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
+            unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
+            first = true;
+            while (sit->hasNext())
             {
-              double likelihood = 0.;
-              for (size_t y = 0; y < nbStates; y++)
+              size_t i = sit->next();
+              // We retrieve the transition probabilities for this site partition:
+              if (first)
+              {
+                pxy = drtl.getTransitionProbabilitiesPerRateClass(father->getId(), i);
+                first = false;
+              }
+              const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
+              VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+              for (size_t c = 0; c < nbClasses; c++)
               {
-                Vdouble* pxy_c_x = &(*pxy_c)[y];
-                likelihood += (*pxy_c_x)[x] * (*likelihoodsFather_son_i_c)[y];
+                const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
+                Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+                VVdouble* pxy_c = &pxy[c];
+                for (size_t x = 0; x < nbStates; x++)
+                {
+                  double likelihood = 0.;
+                  for (size_t y = 0; y < nbStates; y++)
+                  {
+                    Vdouble* pxy_c_x = &(*pxy_c)[y];
+                    likelihood += (*pxy_c_x)[x] * (*likelihoodsFather_son_i_c)[y];
+                  }
+                  (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
+                }
               }
-              (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
             }
           }
         }
-      }
-    }
-    else
-    {
-      // Account for root frequencies:
-      for (size_t i = 0; i < nbDistinctSites; i++)
-      {
-        vector<double> freqs = drtl.getRootFrequencies(i);
-        VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-        for (size_t c = 0; c < nbClasses; c++)
+        else
         {
-          Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-          for (size_t x = 0; x < nbStates; x++)
+          // Account for root frequencies:
+          for (size_t i = 0; i < nbDistinctSites; i++)
           {
-            (*likelihoodsFatherConstantPart_i_c)[x] *= freqs[x];
+            vector<double> freqs = drtl.getRootFrequencies(i);
+            VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+            for (size_t c = 0; c < nbClasses; c++)
+            {
+              Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+              for (size_t x = 0; x < nbStates; x++)
+              {
+                (*likelihoodsFatherConstantPart_i_c)[x] *= freqs[x];
+              }
+            }
           }
         }
-      }
-    }
 
 
-    // Then, we deal with the node of interest.
-    // We first average upon 'y' to save computations, and then upon 'x'.
-    // ('y' is the state at 'node' and 'x' the state at 'father'.)
+        // Then, we deal with the node of interest.
+        // We first average upon 'y' to save computations, and then upon 'x'.
+        // ('y' is the state at 'node' and 'x' the state at 'father'.)
 
-    // Iterate over all site partitions:
-    const VVVdouble* likelihoodsFather_node = &(drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentNode->getId()));
-    unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentNode->getId()));
-    VVVdouble pxy;
-    bool first;
-    while (mit->hasNext())
-    {
-      TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
-      substitutionCount.setSubstitutionModel(bmd->getSubstitutionModel());
-      // compute all nxy first:
-      VVVVdouble nxy(nbClasses);
-      for (size_t c = 0; c < nbClasses; ++c)
-      {
-        VVVdouble* nxy_c = &nxy[c];
-        double rc = rcRates[c];
-        nxy_c->resize(nbTypes);
-        for (size_t t = 0; t < nbTypes; ++t)
+        // Iterate over all site partitions:
+        const VVVdouble* likelihoodsFather_node = &(drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentNode->getId()));
+        unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentNode->getId()));
+        VVVdouble pxy;
+        bool first;
+        while (mit->hasNext())
         {
-          VVdouble* nxy_c_t = &(*nxy_c)[t];
-          Matrix<double>* nijt = substitutionCount.getAllNumbersOfSubstitutions(d * rc, t + 1);
-           
-          nxy_c_t->resize(nbStates);
-          for (size_t x = 0; x < nbStates; ++x)
+          TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
+          SubstitutionCount& count = threadCount.setSubstitutionModel(bmd->getSubstitutionModel());
+          // compute all nxy first, for all types at once:
+          for (size_t c = 0; c < nbClasses; ++c)
           {
-            Vdouble* nxy_c_t_x = &(*nxy_c_t)[x];
-            nxy_c_t_x->resize(nbStates);
-            for (size_t y = 0; y < nbStates; ++y)
-            {
-              (*nxy_c_t_x)[y] = (*nijt)(x, y);
-            }
+            count.getAllNumbersOfSubstitutions(d * rcRates[c], nxy[c]);
           }
-          delete nijt;
-        }
-      }
 
-      // Now loop over sites:
-      unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
-      first = true;
-      while (sit->hasNext())
-      {
-        size_t i = sit->next();
-        // We retrieve the transition probabilities and substitution counts for this site partition:
-        if (first)
-        {
-          pxy = drtl.getTransitionProbabilitiesPerRateClass(currentNode->getId(), i);
-          first = false;
-        }
-        const VVdouble* likelihoodsFather_node_i = &(*likelihoodsFather_node)[i];
-        VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-        for (size_t c = 0; c < nbClasses; ++c)
-        {
-          const Vdouble* likelihoodsFather_node_i_c = &(*likelihoodsFather_node_i)[c];
-          Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-          const VVdouble* pxy_c = &pxy[c];
-          VVVdouble* nxy_c = &nxy[c];
-          for (size_t x = 0; x < nbStates; ++x)
+          // Now loop over sites:
+          unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
+          first = true;
+          while (sit->hasNext())
           {
-            double* likelihoodsFatherConstantPart_i_c_x = &(*likelihoodsFatherConstantPart_i_c)[x];
-            const Vdouble* pxy_c_x = &(*pxy_c)[x];
-            for (size_t y = 0; y < nbStates; ++y)
+            size_t i = sit->next();
+            // We retrieve the transition probabilities and substitution counts for this site partition:
+            if (first)
             {
-              double likelihood_cxy = (*likelihoodsFatherConstantPart_i_c_x)
-                                      * (*pxy_c_x)[y]
-                                      * (*likelihoodsFather_node_i_c)[y];
-
-              for (size_t t = 0; t < nbTypes; ++t)
+              pxy = drtl.getTransitionProbabilitiesPerRateClass(currentNode->getId(), i);
+              first = false;
+            }
+            const VVdouble* likelihoodsFather_node_i = &(*likelihoodsFather_node)[i];
+            VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+            for (size_t c = 0; c < nbClasses; ++c)
+            {
+              const Vdouble* likelihoodsFather_node_i_c = &(*likelihoodsFather_node_i)[c];
+              Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+              const VVdouble* pxy_c = &pxy[c];
+              const Vdouble* nxy_c = &nxy[c];
+              for (size_t x = 0; x < nbStates; ++x)
               {
-                // Now the vector computation:
-                substitutionsForCurrentNode[i][t] += likelihood_cxy * (*nxy_c)[t][x][y];
-                //                                   <------------>   <--------------->
-                // Posterior probability                   |                 |
-                // for site i and rate class c *           |                 |
-                // likelihood for this site----------------+                 |
-                //                                                           |
-                // Substitution function for site i and rate class c----------+
+                double* likelihoodsFatherConstantPart_i_c_x = &(*likelihoodsFatherConstantPart_i_c)[x];
+                const Vdouble* pxy_c_x = &(*pxy_c)[x];
+                for (size_t y = 0; y < nbStates; ++y)
+                {
+                  double likelihood_cxy = (*likelihoodsFatherConstantPart_i_c_x)
+                                          * (*pxy_c_x)[y]
+                                          * (*likelihoodsFather_node_i_c)[y];
+
+                  for (size_t t = 0; t < nbTypes; ++t)
+                  {
+                    // Now the vector computation:
+                    substitutionsForCurrentNode[i][t] += likelihood_cxy * (*nxy_c)[(x * nbStates + y) * nbTypes + t];
+                    //                                   <------------>   <--------------->
+                    // Posterior probability                   |                 |
+                    // for site i and rate class c *           |                 |
+                    // likelihood for this site----------------+                 |
+                    //                                                           |
+                    // Substitution function for site i and rate class c----------+
+                  }
+                }
               }
+          
             }
           }
-          
         }
-      }
-    }
 
-    // Now we just have to copy the substitutions into the result vector:
-    for (size_t i = 0; i < nbSites; ++i)
-    {
-      for (size_t t = 0; t < nbTypes; ++t)
+        // Now we just have to copy the substitutions into the result vector:
+        for (size_t i = 0; i < nbSites; ++i)
+        {
+          for (size_t t = 0; t < nbTypes; ++t)
+          {
+            (*substitutions)(l, i, t) = substitutionsForCurrentNode[(*rootPatternLinks)[i]][t] / Lr[(*rootPatternLinks)[i]];
+          }
+        }
+      }
+      catch (exception& e)
       {
-        (*substitutions)(l, i, t) = substitutionsForCurrentNode[(*rootPatternLinks)[i]][t] / Lr[(*rootPatternLinks)[i]];
+        errors[l] = e.what();
       }
     }
   }
+  for (size_t l = 0; l < nbNodes; ++l)
+  {
+    if (!errors[l].empty())
+    {
+      delete substitutions;
+      throw Exception(errors[l]);
+    }
+  }
   if (verbose)
   {
     if (ApplicationTools::message)
@@ -427,251 +491,265 @@ ProbabilisticSubstitutionMapping* SubstitutionMappingTools::computeSubstitutionV
   if (verbose)
     ApplicationTools::displayTask("Compute joint node-pairs likelihood", true);
 
-  for (size_t l = 0; l < nbNodes; ++l)
+  vector<string> errors(nbNodes);
+  size_t nbDone = 0;
+  long nb = static_cast<long>(nbNodes);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
   {
-    // For each node,
-    const Node* currentNode = nodes[l];
-    if (nodeIds.size() > 0 && !VectorTools::contains(nodeIds, currentNode->getId()))
-      continue;
+    // Branches are independent: each thread uses its own copy of the substitution count, and its own scratch arrays.
+    ThreadSubstitutionCount threadCount(substitutionCount);
+    VVdouble substitutionsForCurrentNode(nbDistinctSites, Vdouble(nbTypes));
+    VVVdouble likelihoodsFatherConstantPart(nbDistinctSites, VVdouble(nbClasses, Vdouble(nbStates)));
+    VVdouble nxy(nbClasses);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (long ll = 0; ll < nb; ++ll)
+    {
+      size_t l = static_cast<size_t>(ll);
+      try
+      {
+        // For each node,
+        const Node* currentNode = nodes[l];
+        if (nodeIds.size() > 0 && !VectorTools::contains(nodeIds, currentNode->getId()))
+          continue;
 
-    const Node* father = currentNode->getFather();
+        const Node* father = currentNode->getFather();
 
-    double d = currentNode->getDistanceToFather();
+        double d = currentNode->getDistanceToFather();
 
-    if (verbose)
-      ApplicationTools::displayGauge(l, nbNodes - 1);
-    VVdouble substitutionsForCurrentNode(nbDistinctSites);
-    for (size_t i = 0; i < nbDistinctSites; ++i)
-    {
-      substitutionsForCurrentNode[i].resize(nbTypes);
-    }
-
-    // Now we've got to compute likelihoods in a smart manner... ;)
-    VVVdouble likelihoodsFatherConstantPart(nbDistinctSites);
-    for (size_t i = 0; i < nbDistinctSites; i++)
-    {
-      VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-      likelihoodsFatherConstantPart_i->resize(nbClasses);
-      for (size_t c = 0; c < nbClasses; c++)
-      {
-        Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-        likelihoodsFatherConstantPart_i_c->resize(nbStates);
-        double rc = rDist->getProbability(c);
-        for (size_t s = 0; s < nbStates; s++)
+        if (verbose)
         {
-          // (* likelihoodsFatherConstantPart_i_c)[s] = rc * model->freq(s);
-          // freq is already accounted in the array
-          (*likelihoodsFatherConstantPart_i_c)[s] = rc;
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+          ApplicationTools::displayGauge(nbDone++, nbNodes - 1);
+        }
+        for (size_t i = 0; i < nbDistinctSites; ++i)
+        {
+          fill(substitutionsForCurrentNode[i].begin(), substitutionsForCurrentNode[i].end(), 0.);
         }
-      }
-    }
-
-    // First, what will remain constant:
-    size_t nbSons =  father->getNumberOfSons();
-    for (size_t n = 0; n < nbSons; n++)
-    {
-      const Node* currentSon = father->getSon(n);
-      if (currentSon->getId() != currentNode->getId())
-      {
-        const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
 
-        // Now iterate over all site partitions:
-        unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentSon->getId()));
-        VVVdouble pxy;
-        bool first;
-        while (mit->hasNext())
+        // Now we've got to compute likelihoods in a smart manner... ;)
+        for (size_t i = 0; i < nbDistinctSites; i++)
         {
-          TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
-          unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
-          first = true;
-          while (sit->hasNext())
+          VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+          for (size_t c = 0; c < nbClasses; c++)
           {
-            size_t i = sit->next();
-            // We retrieve the transition probabilities for this site partition:
-            if (first)
+            Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+            double rc = rDist->getProbability(c);
+            for (size_t s = 0; s < nbStates; s++)
             {
-              pxy = drtl.getTransitionProbabilitiesPerRateClass(currentSon->getId(), i);
-              first = false;
+              // (* likelihoodsFatherConstantPart_i_c)[s] = rc * model->freq(s);
+              // freq is already accounted in the array
+              (*likelihoodsFatherConstantPart_i_c)[s] = rc;
             }
-            const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
-            VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-            for (size_t c = 0; c < nbClasses; c++)
+          }
+        }
+
+        // First, what will remain constant:
+        size_t nbSons =  father->getNumberOfSons();
+        for (size_t n = 0; n < nbSons; n++)
+        {
+          const Node* currentSon = father->getSon(n);
+          if (currentSon->getId() != currentNode->getId())
+          {
+            const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
+
+            // Now iterate over all site partitions:
+            unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentSon->getId()));
+            VVVdouble pxy;
+            bool first;
+            while (mit->hasNext())
             {
-              const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
-              Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-              VVdouble* pxy_c = &pxy[c];
-              for (size_t x = 0; x < nbStates; x++)
+              TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
+              unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
+              first = true;
+              while (sit->hasNext())
               {
-                Vdouble* pxy_c_x = &(*pxy_c)[x];
-                double likelihood = 0.;
-                for (size_t y = 0; y < nbStates; y++)
+                size_t i = sit->next();
+                // We retrieve the transition probabilities for this site partition:
+                if (first)
                 {
-                  likelihood += (*pxy_c_x)[y] * (*likelihoodsFather_son_i_c)[y];
+                  pxy = drtl.getTransitionProbabilitiesPerRateClass(currentSon->getId(), i);
+                  first = false;
+                }
+                const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
+                VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+                for (size_t c = 0; c < nbClasses; c++)
+                {
+                  const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
+                  Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+                  VVdouble* pxy_c = &pxy[c];
+                  for (size_t x = 0; x < nbStates; x++)
+                  {
+                    Vdouble* pxy_c_x = &(*pxy_c)[x];
+                    double likelihood = 0.;
+                    for (size_t y = 0; y < nbStates; y++)
+                    {
+                      likelihood += (*pxy_c_x)[y] * (*likelihoodsFather_son_i_c)[y];
+                    }
+                    (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
+                  }
                 }
-                (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
               }
             }
           }
         }
-      }
-    }
-    if (father->hasFather())
-    {
-      const Node* currentSon = father->getFather();
-      const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
-      // Now iterate over all site partitions:
-      unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(father->getId()));
-      VVVdouble pxy;
-      bool first;
-      while (mit->hasNext())
-      {
-        TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
-        unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
-        first = true;
-        while (sit->hasNext())
+        if (father->hasFather())
         {
-          size_t i = sit->next();
-          // We retrieve the transition probabilities for this site partition:
-          if (first)
-          {
-            pxy = drtl.getTransitionProbabilitiesPerRateClass(father->getId(), i);
-            first = false;
-          }
-          const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
-          VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-          for (size_t c = 0; c < nbClasses; c++)
+          const Node* currentSon = father->getFather();
+          const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
+          // Now iterate over all site partitions:
+          unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(father->getId()));
+          VVVdouble pxy;
+          bool first;
+          while (mit->hasNext())
           {
-            const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
-            Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-            VVdouble* pxy_c = &pxy[c];
-            for (size_t x = 0; x < nbStates; x++)
+            TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
+            unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
+            first = true;
+            while (sit->hasNext())
             {
-              double likelihood = 0.;
-              for (size_t y = 0; y < nbStates; y++)
+              size_t i = sit->next();
+              // We retrieve the transition probabilities for this site partition:
+              if (first)
               {
-                Vdouble* pxy_c_x = &(*pxy_c)[y];
-                likelihood += (*pxy_c_x)[x] * (*likelihoodsFather_son_i_c)[y];
+                pxy = drtl.getTransitionProbabilitiesPerRateClass(father->getId(), i);
+                first = false;
+              }
+              const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
+              VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+              for (size_t c = 0; c < nbClasses; c++)
+              {
+                const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
+                Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+                VVdouble* pxy_c = &pxy[c];
+                for (size_t x = 0; x < nbStates; x++)
+                {
+                  double likelihood = 0.;
+                  for (size_t y = 0; y < nbStates; y++)
+                  {
+                    Vdouble* pxy_c_x = &(*pxy_c)[y];
+                    likelihood += (*pxy_c_x)[x] * (*likelihoodsFather_son_i_c)[y];
+                  }
+                  (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
+                }
               }
-              (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
             }
           }
         }
-      }
-    }
-    else
-    {
-      // Account for root frequencies:
-      for (size_t i = 0; i < nbDistinctSites; i++)
-      {
-        vector<double> freqs = drtl.getRootFrequencies(i);
-        VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-        for (size_t c = 0; c < nbClasses; c++)
+        else
         {
-          Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-          for (size_t x = 0; x < nbStates; x++)
+          // Account for root frequencies:
+          for (size_t i = 0; i < nbDistinctSites; i++)
           {
-            (*likelihoodsFatherConstantPart_i_c)[x] *= freqs[x];
+            vector<double> freqs = drtl.getRootFrequencies(i);
+            VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+            for (size_t c = 0; c < nbClasses; c++)
+            {
+              Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+              for (size_t x = 0; x < nbStates; x++)
+              {
+                (*likelihoodsFatherConstantPart_i_c)[x] *= freqs[x];
+              }
+            }
           }
         }
-      }
-    }
 
 
-    // Then, we deal with the node of interest.
-    // We first average upon 'y' to save computations, and then upon 'x'.
-    // ('y' is the state at 'node' and 'x' the state at 'father'.)
+        // Then, we deal with the node of interest.
+        // We first average upon 'y' to save computations, and then upon 'x'.
+        // ('y' is the state at 'node' and 'x' the state at 'father'.)
 
-    // Iterate over all site partitions:
-    const VVVdouble* likelihoodsFather_node = &(drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentNode->getId()));
-    unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentNode->getId()));
-    VVVdouble pxy;
-    bool first;
-    while (mit->hasNext())
-    {
-      TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
-      substitutionCount.setSubstitutionModel(modelSet.getSubstitutionModelForNode(currentNode->getId()));
-
-      // compute all nxy first:
-      VVVVdouble nxy(nbClasses);
-      for (size_t c = 0; c < nbClasses; ++c)
-      {
-        VVVdouble* nxy_c = &nxy[c];
-        double rc = rcRates[c];
-        nxy_c->resize(nbTypes);
-        for (size_t t = 0; t < nbTypes; ++t)
+        // Iterate over all site partitions:
+        const VVVdouble* likelihoodsFather_node = &(drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentNode->getId()));
+        unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentNode->getId()));
+        VVVdouble pxy;
+        bool first;
+        while (mit->hasNext())
         {
-          VVdouble* nxy_c_t = &(*nxy_c)[t];
-          Matrix<double>* nijt = substitutionCount.getAllNumbersOfSubstitutions(d * rc, t + 1);
-          nxy_c_t->resize(nbStates);
-          for (size_t x = 0; x < nbStates; ++x)
+          TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
+          SubstitutionCount& count = threadCount.setSubstitutionModel(modelSet.getSubstitutionModelForNode(currentNode->getId()));
+
+          // compute all nxy first, for all types at once:
+          for (size_t c = 0; c < nbClasses; ++c)
           {
-            Vdouble* nxy_c_t_x = &(*nxy_c_t)[x];
-            nxy_c_t_x->resize(nbStates);
-            for (size_t y = 0; y < nbStates; ++y)
-            {
-              (*nxy_c_t_x)[y] = (*nijt)(x, y);
-            }
+            count.getAllNumbersOfSubstitutions(d * rcRates[c], nxy[c]);
           }
-          delete nijt;
-        }
-      }
 
-      // Now loop over sites:
-      unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
-      first = true;
-      while (sit->hasNext())
-      {
-        size_t i = sit->next();
-        // We retrieve the transition probabilities and substitution counts for this site partition:
-        if (first)
-        {
-          pxy = drtl.getTransitionProbabilitiesPerRateClass(currentNode->getId(), i);
-          first = false;
-        }
-        const VVdouble* likelihoodsFather_node_i = &(*likelihoodsFather_node)[i];
-        VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-        for (size_t c = 0; c < nbClasses; ++c)
-        {
-          const Vdouble* likelihoodsFather_node_i_c = &(*likelihoodsFather_node_i)[c];
-          Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-          const VVdouble* pxy_c = &pxy[c];
-          VVVdouble* nxy_c = &nxy[c];
-          for (size_t x = 0; x < nbStates; ++x)
+          // Now loop over sites:
+          unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
+          first = true;
+          while (sit->hasNext())
           {
-            double* likelihoodsFatherConstantPart_i_c_x = &(*likelihoodsFatherConstantPart_i_c)[x];
-            const Vdouble* pxy_c_x = &(*pxy_c)[x];
-            for (size_t y = 0; y < nbStates; ++y)
+            size_t i = sit->next();
+            // We retrieve the transition probabilities and substitution counts for this site partition:
+            if (first)
             {
-              double likelihood_cxy = (*likelihoodsFatherConstantPart_i_c_x)
-                                      * (*pxy_c_x)[y]
-                                      * (*likelihoodsFather_node_i_c)[y];
-
-              for (size_t t = 0; t < nbTypes; ++t)
+              pxy = drtl.getTransitionProbabilitiesPerRateClass(currentNode->getId(), i);
+              first = false;
+            }
+            const VVdouble* likelihoodsFather_node_i = &(*likelihoodsFather_node)[i];
+            VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+            for (size_t c = 0; c < nbClasses; ++c)
+            {
+              const Vdouble* likelihoodsFather_node_i_c = &(*likelihoodsFather_node_i)[c];
+              Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+              const VVdouble* pxy_c = &pxy[c];
+              const Vdouble* nxy_c = &nxy[c];
+              for (size_t x = 0; x < nbStates; ++x)
               {
-                // Now the vector computation:
-                substitutionsForCurrentNode[i][t] += likelihood_cxy * (*nxy_c)[t][x][y];
-                //                                   <------------>   <--------------->
-                // Posterior probability                   |                 |
-                // for site i and rate class c *           |                 |
-                // likelihood for this site----------------+                 |
-                //                                                           |
-                // Substitution function for site i and rate class c----------+
+                double* likelihoodsFatherConstantPart_i_c_x = &(*likelihoodsFatherConstantPart_i_c)[x];
+                const Vdouble* pxy_c_x = &(*pxy_c)[x];
+                for (size_t y = 0; y < nbStates; ++y)
+                {
+                  double likelihood_cxy = (*likelihoodsFatherConstantPart_i_c_x)
+                                          * (*pxy_c_x)[y]
+                                          * (*likelihoodsFather_node_i_c)[y];
+
+                  for (size_t t = 0; t < nbTypes; ++t)
+                  {
+                    // Now the vector computation:
+                    substitutionsForCurrentNode[i][t] += likelihood_cxy * (*nxy_c)[(x * nbStates + y) * nbTypes + t];
+                    //                                   <------------>   <--------------->
+                    // Posterior probability                   |                 |
+                    // for site i and rate class c *           |                 |
+                    // likelihood for this site----------------+                 |
+                    //                                                           |
+                    // Substitution function for site i and rate class c----------+
+                  }
+                }
               }
             }
           }
         }
-      }
-    }
 
-    // Now we just have to copy the substitutions into the result vector:
-    for (size_t i = 0; i < nbSites; ++i)
-    {
-      for (size_t t = 0; t < nbTypes; ++t)
+        // Now we just have to copy the substitutions into the result vector:
+        for (size_t i = 0; i < nbSites; ++i)
+        {
+          for (size_t t = 0; t < nbTypes; ++t)
+          {
+            (*substitutions)(l, i, t) = substitutionsForCurrentNode[(*rootPatternLinks)[i]][t] / Lr[(*rootPatternLinks)[i]];
+          }
+        }
+      }
+      catch (exception& e)
       {
-        (*substitutions)(l, i, t) = substitutionsForCurrentNode[(*rootPatternLinks)[i]][t] / Lr[(*rootPatternLinks)[i]];
+        errors[l] = e.what();
       }
     }
   }
+  for (size_t l = 0; l < nbNodes; ++l)
+  {
+    if (!errors[l].empty())
+    {
+      delete substitutions;
+      throw Exception(errors[l]);
+    }
+  }
   if (verbose)
   {
     if (ApplicationTools::message)
@@ -718,258 +796,271 @@ ProbabilisticSubstitutionMapping* SubstitutionMappingTools::computeSubstitutionV
   if (verbose)
     ApplicationTools::displayTask("Compute joint node-pairs likelihood", true);
 
-  for (size_t l = 0; l < nbNodes; ++l)
+  vector<string> errors(nbNodes);
+  size_t nbDone = 0;
+  long nb = static_cast<long>(nbNodes);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
   {
-    // For each node,
-    const Node* currentNode = nodes[l];
+    // Branches are independent: each thread uses its own copy of the substitution count, and its own scratch arrays.
+    ThreadSubstitutionCount threadCount(substitutionCount);
+    VVdouble substitutionsForCurrentNode(nbDistinctSites, Vdouble(nbTypes));
+    VVVdouble likelihoodsFatherConstantPart(nbDistinctSites, VVdouble(nbClasses, Vdouble(nbStates)));
+    VVdouble nxy(nbClasses);
+    RowMatrix<double> pairProbabilities(nbStates, nbStates);
+    VVVdouble subsCounts(nbStates, VVdouble(nbStates, Vdouble(nbTypes)));
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (long ll = 0; ll < nb; ++ll)
+    {
+      size_t l = static_cast<size_t>(ll);
+      try
+      {
+        // For each node,
+        const Node* currentNode = nodes[l];
 
-    const Node* father = currentNode->getFather();
+        const Node* father = currentNode->getFather();
 
-    double d = currentNode->getDistanceToFather();
+        double d = currentNode->getDistanceToFather();
 
-    if (verbose)
-      ApplicationTools::displayGauge(l, nbNodes - 1);
-    VVdouble substitutionsForCurrentNode(nbDistinctSites);
-    for (size_t i = 0; i < nbDistinctSites; ++i)
-    {
-      substitutionsForCurrentNode[i].resize(nbTypes);
-    }
-
-    // Now we've got to compute likelihoods in a smart manner... ;)
-    VVVdouble likelihoodsFatherConstantPart(nbDistinctSites);
-    for (size_t i = 0; i < nbDistinctSites; ++i)
-    {
-      VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-      likelihoodsFatherConstantPart_i->resize(nbClasses);
-      for (size_t c = 0; c < nbClasses; ++c)
-      {
-        Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-        likelihoodsFatherConstantPart_i_c->resize(nbStates);
-        double rc = rDist->getProbability(c);
-        for (size_t s = 0; s < nbStates; ++s)
+        if (verbose)
         {
-          // (* likelihoodsFatherConstantPart_i_c)[s] = rc * model->freq(s);
-          // freq is already accounted in the array
-          (*likelihoodsFatherConstantPart_i_c)[s] = rc;
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+          ApplicationTools::displayGauge(nbDone++, nbNodes - 1);
+        }
+        for (size_t i = 0; i < nbDistinctSites; ++i)
+        {
+          fill(substitutionsForCurrentNode[i].begin(), substitutionsForCurrentNode[i].end(), 0.);
         }
-      }
-    }
-
-    // First, what will remain constant:
-    size_t nbSons =  father->getNumberOfSons();
-    for (size_t n = 0; n < nbSons; ++n)
-    {
-      const Node* currentSon = father->getSon(n);
-      if (currentSon->getId() != currentNode->getId())
-      {
-        const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
 
-        // Now iterate over all site partitions:
-        unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentSon->getId()));
-        VVVdouble pxy;
-        bool first;
-        while (mit->hasNext())
+        // Now we've got to compute likelihoods in a smart manner... ;)
+        for (size_t i = 0; i < nbDistinctSites; ++i)
         {
-          TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
-          unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
-          first = true;
-          while (sit->hasNext())
+          VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+          for (size_t c = 0; c < nbClasses; ++c)
           {
-            size_t i = sit->next();
-            // We retrieve the transition probabilities for this site partition:
-            if (first)
+            Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+            double rc = rDist->getProbability(c);
+            for (size_t s = 0; s < nbStates; ++s)
             {
-              pxy = drtl.getTransitionProbabilitiesPerRateClass(currentSon->getId(), i);
-              first = false;
+              // (* likelihoodsFatherConstantPart_i_c)[s] = rc * model->freq(s);
+              // freq is already accounted in the array
+              (*likelihoodsFatherConstantPart_i_c)[s] = rc;
             }
-            const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
-            VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-            for (size_t c = 0; c < nbClasses; ++c)
+          }
+        }
+
+        // First, what will remain constant:
+        size_t nbSons =  father->getNumberOfSons();
+        for (size_t n = 0; n < nbSons; ++n)
+        {
+          const Node* currentSon = father->getSon(n);
+          if (currentSon->getId() != currentNode->getId())
+          {
+            const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
+
+            // Now iterate over all site partitions:
+            unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentSon->getId()));
+            VVVdouble pxy;
+            bool first;
+            while (mit->hasNext())
             {
-              const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
-              Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-              VVdouble* pxy_c = &pxy[c];
-              for (size_t x = 0; x < nbStates; ++x)
+              TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
+              unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
+              first = true;
+              while (sit->hasNext())
               {
-                Vdouble* pxy_c_x = &(*pxy_c)[x];
-                double likelihood = 0.;
-                for (size_t y = 0; y < nbStates; ++y)
+                size_t i = sit->next();
+                // We retrieve the transition probabilities for this site partition:
+                if (first)
                 {
-                  likelihood += (*pxy_c_x)[y] * (*likelihoodsFather_son_i_c)[y];
+                  pxy = drtl.getTransitionProbabilitiesPerRateClass(currentSon->getId(), i);
+                  first = false;
+                }
+                const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
+                VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+                for (size_t c = 0; c < nbClasses; ++c)
+                {
+                  const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
+                  Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+                  VVdouble* pxy_c = &pxy[c];
+                  for (size_t x = 0; x < nbStates; ++x)
+                  {
+                    Vdouble* pxy_c_x = &(*pxy_c)[x];
+                    double likelihood = 0.;
+                    for (size_t y = 0; y < nbStates; ++y)
+                    {
+                      likelihood += (*pxy_c_x)[y] * (*likelihoodsFather_son_i_c)[y];
+                    }
+                    (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
+                  }
                 }
-                (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
               }
             }
           }
         }
-      }
-    }
-    if (father->hasFather())
-    {
-      const Node* currentSon = father->getFather();
-      const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
-      // Now iterate over all site partitions:
-      unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(father->getId()));
-      VVVdouble pxy;
-      bool first;
-      while (mit->hasNext())
-      {
-        TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
-        unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
-        first = true;
-        while (sit->hasNext())
+        if (father->hasFather())
         {
-          size_t i = sit->next();
-          // We retrieve the transition probabilities for this site partition:
-          if (first)
+          const Node* currentSon = father->getFather();
+          const VVVdouble* likelihoodsFather_son = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentSon->getId());
+          // Now iterate over all site partitions:
+          unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(father->getId()));
+          VVVdouble pxy;
+          bool first;
+          while (mit->hasNext())
           {
-            pxy = drtl.getTransitionProbabilitiesPerRateClass(father->getId(), i);
-            first = false;
-          }
-          const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
-          VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-          for (size_t c = 0; c < nbClasses; ++c)
-          {
-            const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
-            Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-            VVdouble* pxy_c = &pxy[c];
-            for (size_t x = 0; x < nbStates; ++x)
+            TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
+            unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
+            first = true;
+            while (sit->hasNext())
             {
-              double likelihood = 0.;
-              for (size_t y = 0; y < nbStates; ++y)
+              size_t i = sit->next();
+              // We retrieve the transition probabilities for this site partition:
+              if (first)
               {
-                Vdouble* pxy_c_x = &(*pxy_c)[y];
-                likelihood += (*pxy_c_x)[x] * (*likelihoodsFather_son_i_c)[y];
+                pxy = drtl.getTransitionProbabilitiesPerRateClass(father->getId(), i);
+                first = false;
+              }
+              const VVdouble* likelihoodsFather_son_i = &(*likelihoodsFather_son)[i];
+              VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+              for (size_t c = 0; c < nbClasses; ++c)
+              {
+                const Vdouble* likelihoodsFather_son_i_c = &(*likelihoodsFather_son_i)[c];
+                Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+                VVdouble* pxy_c = &pxy[c];
+                for (size_t x = 0; x < nbStates; ++x)
+                {
+                  double likelihood = 0.;
+                  for (size_t y = 0; y < nbStates; ++y)
+                  {
+                    Vdouble* pxy_c_x = &(*pxy_c)[y];
+                    likelihood += (*pxy_c_x)[x] * (*likelihoodsFather_son_i_c)[y];
+                  }
+                  (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
+                }
               }
-              (*likelihoodsFatherConstantPart_i_c)[x] *= likelihood;
             }
           }
         }
-      }
-    }
-    else
-    {
-      // Account for root frequencies:
-      for (size_t i = 0; i < nbDistinctSites; ++i)
-      {
-        vector<double> freqs = drtl.getRootFrequencies(i);
-        VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-        for (size_t c = 0; c < nbClasses; ++c)
-        {
-          Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-          for (size_t x = 0; x < nbStates; ++x)
-          {
-            (*likelihoodsFatherConstantPart_i_c)[x] *= freqs[x];
-          }
-        }
-      }
-    }
-
-    // Then, we deal with the node of interest.
-    // We first average uppon 'y' to save computations, and then uppon 'x'.
-    // ('y' is the state at 'node' and 'x' the state at 'father'.)
-
-    // Iterate over all site partitions:
-    const VVVdouble* likelihoodsFather_node = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentNode->getId());
-    unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentNode->getId()));
-    VVVdouble pxy;
-    bool first;
-    while (mit->hasNext())
-    {
-      TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
-      substitutionCount.setSubstitutionModel(bmd->getSubstitutionModel());
-      // compute all nxy first:
-      VVVVdouble nxy(nbClasses);
-      for (size_t c = 0; c < nbClasses; ++c)
-      {
-        double rc = rcRates[c];
-        VVVdouble* nxy_c = &nxy[c];
-        nxy_c->resize(nbTypes);
-        for (size_t t = 0; t < nbTypes; ++t)
+        else
         {
-          VVdouble* nxy_c_t = &(*nxy_c)[t];
-          nxy_c_t->resize(nbStates);
-          Matrix<double>* nijt = substitutionCount.getAllNumbersOfSubstitutions(d * rc, t + 1);
-          for (size_t x = 0; x < nbStates; ++x)
+          // Account for root frequencies:
+          for (size_t i = 0; i < nbDistinctSites; ++i)
           {
-            Vdouble* nxy_c_t_x = &(*nxy_c_t)[x];
-            nxy_c_t_x->resize(nbStates);
-            for (size_t y = 0; y < nbStates; ++y)
+            vector<double> freqs = drtl.getRootFrequencies(i);
+            VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+            for (size_t c = 0; c < nbClasses; ++c)
             {
-              (*nxy_c_t_x)[y] = (*nijt)(x, y);
+              Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+              for (size_t x = 0; x < nbStates; ++x)
+              {
+                (*likelihoodsFatherConstantPart_i_c)[x] *= freqs[x];
+              }
             }
           }
-          delete nijt;
         }
-      }
 
-      // Now loop over sites:
-      unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
-      first = true;
-      while (sit->hasNext())
-      {
-        size_t i = sit->next();
-        // We retrieve the transition probabilities and substitution counts for this site partition:
-        if (first)
-        {
-          pxy = drtl.getTransitionProbabilitiesPerRateClass(currentNode->getId(), i);
-          first = false;
-        }
-        const VVdouble* likelihoodsFather_node_i = &(*likelihoodsFather_node)[i];
-        VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
-        RowMatrix<double> pairProbabilities(nbStates, nbStates);
-        MatrixTools::fill(pairProbabilities, 0.);
-        VVVdouble subsCounts(nbStates);
-        for (size_t j = 0; j < nbStates; ++j)
+        // Then, we deal with the node of interest.
+        // We first average uppon 'y' to save computations, and then uppon 'x'.
+        // ('y' is the state at 'node' and 'x' the state at 'father'.)
+
+        // Iterate over all site partitions:
+        const VVVdouble* likelihoodsFather_node = &drtl.getLikelihoodData()->getLikelihoodArray(father->getId(), currentNode->getId());
+        unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentNode->getId()));
+        VVVdouble pxy;
+        bool first;
+        while (mit->hasNext())
         {
-          subsCounts[j].resize(nbStates);
-          for (size_t k = 0; k < nbStates; ++k)
+          TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
+          SubstitutionCount& count = threadCount.setSubstitutionModel(bmd->getSubstitutionModel());
+          // compute all nxy first, for all types at once:
+          for (size_t c = 0; c < nbClasses; ++c)
           {
-            subsCounts[j][k].resize(nbTypes);
+            count.getAllNumbersOfSubstitutions(d * rcRates[c], nxy[c]);
           }
-        }
-        for (size_t c = 0; c < nbClasses; ++c)
-        {
-          const Vdouble* likelihoodsFather_node_i_c = &(*likelihoodsFather_node_i)[c];
-          Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
-          const VVdouble* pxy_c = &pxy[c];
-          VVVdouble* nxy_c = &nxy[c];
-          for (size_t x = 0; x < nbStates; ++x)
+
+          // Now loop over sites:
+          unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
+          first = true;
+          while (sit->hasNext())
           {
-            double* likelihoodsFatherConstantPart_i_c_x = &(*likelihoodsFatherConstantPart_i_c)[x];
-            const Vdouble* pxy_c_x = &(*pxy_c)[x];
-            for (size_t y = 0; y < nbStates; ++y)
+            size_t i = sit->next();
+            // We retrieve the transition probabilities and substitution counts for this site partition:
+            if (first)
             {
-              double likelihood_cxy = (*likelihoodsFatherConstantPart_i_c_x)
-                                      * (*pxy_c_x)[y]
-                                      * (*likelihoodsFather_node_i_c)[y];
-              pairProbabilities(x, y) += likelihood_cxy; // Sum over all rate classes.
-              for (size_t t = 0; t < nbTypes; ++t)
+              pxy = drtl.getTransitionProbabilitiesPerRateClass(currentNode->getId(), i);
+              first = false;
+            }
+            const VVdouble* likelihoodsFather_node_i = &(*likelihoodsFather_node)[i];
+            VVdouble* likelihoodsFatherConstantPart_i = &likelihoodsFatherConstantPart[i];
+            MatrixTools::fill(pairProbabilities, 0.);
+            for (size_t j = 0; j < nbStates; ++j)
+            {
+              for (size_t k = 0; k < nbStates; ++k)
               {
-                subsCounts[x][y][t] += likelihood_cxy * (*nxy_c)[t][x][y];
+                fill(subsCounts[j][k].begin(), subsCounts[j][k].end(), 0.);
               }
             }
+            for (size_t c = 0; c < nbClasses; ++c)
+            {
+              const Vdouble* likelihoodsFather_node_i_c = &(*likelihoodsFather_node_i)[c];
+              Vdouble* likelihoodsFatherConstantPart_i_c = &(*likelihoodsFatherConstantPart_i)[c];
+              const VVdouble* pxy_c = &pxy[c];
+              const Vdouble* nxy_c = &nxy[c];
+              for (size_t x = 0; x < nbStates; ++x)
+              {
+                double* likelihoodsFatherConstantPart_i_c_x = &(*likelihoodsFatherConstantPart_i_c)[x];
+                const Vdouble* pxy_c_x = &(*pxy_c)[x];
+                for (size_t y = 0; y < nbStates; ++y)
+                {
+                  double likelihood_cxy = (*likelihoodsFatherConstantPart_i_c_x)
+                                          * (*pxy_c_x)[y]
+                                          * (*likelihoodsFather_node_i_c)[y];
+                  pairProbabilities(x, y) += likelihood_cxy; // Sum over all rate classes.
+                  for (size_t t = 0; t < nbTypes; ++t)
+                  {
+                    subsCounts[x][y][t] += likelihood_cxy * (*nxy_c)[(x * nbStates + y) * nbTypes + t];
+                  }
+                }
+              }
+            }
+            // Now the vector computation:
+            // Here we do not average over all possible pair of ancestral states,
+            // We only consider the one with max likelihood:
+            vector<size_t> xy = MatrixTools::whichMax(pairProbabilities);
+            for (size_t t = 0; t < nbTypes; ++t)
+            {
+              substitutionsForCurrentNode[i][t] += subsCounts[xy[0]][xy[1]][t] / pairProbabilities(xy[0], xy[1]);
+            }
           }
         }
-        // Now the vector computation:
-        // Here we do not average over all possible pair of ancestral states,
-        // We only consider the one with max likelihood:
-        vector<size_t> xy = MatrixTools::whichMax(pairProbabilities);
-        for (size_t t = 0; t < nbTypes; ++t)
+        // Now we just have to copy the substitutions into the result vector:
+        for (size_t i = 0; i < nbSites; i++)
         {
-          substitutionsForCurrentNode[i][t] += subsCounts[xy[0]][xy[1]][t] / pairProbabilities(xy[0], xy[1]);
+          for (size_t t = 0; t < nbTypes; t++)
+          {
+            (*substitutions)(l, i, t) = substitutionsForCurrentNode[(*rootPatternLinks)[i]][t];
+          }
         }
       }
-    }
-    // Now we just have to copy the substitutions into the result vector:
-    for (size_t i = 0; i < nbSites; i++)
-    {
-      for (size_t t = 0; t < nbTypes; t++)
+      catch (exception& e)
       {
-        (*substitutions)(l, i, t) = substitutionsForCurrentNode[(*rootPatternLinks)[i]][t];
+        errors[l] = e.what();
       }
     }
   }
+  for (size_t l = 0; l < nbNodes; ++l)
+  {
+    if (!errors[l].empty())
+    {
+      delete substitutions;
+      throw Exception(errors[l]);
+    }
+  }
   if (verbose)
   {
     if (ApplicationTools::message)
@@ -1026,81 +1117,102 @@ ProbabilisticSubstitutionMapping* SubstitutionMappingTools::computeSubstitutionV
   if (verbose)
     ApplicationTools::displayTask("Compute substitution vectors", true);
 
-  for (size_t l = 0; l < nbNodes; l++)
+  vector<string> errors(nbNodes);
+  size_t nbDone = 0;
+  long nb = static_cast<long>(nbNodes);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
   {
-    const Node* currentNode = nodes[l];
+    // Branches are independent: each thread uses its own copy of the substitution count, and its own scratch arrays.
+    ThreadSubstitutionCount threadCount(substitutionCount);
+    VVdouble substitutionsForCurrentNode(nbDistinctSites, Vdouble(nbTypes));
+    Vdouble nxyt;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (long ll = 0; ll < nb; ++ll)
+    {
+      size_t l = static_cast<size_t>(ll);
+      try
+      {
+        const Node* currentNode = nodes[l];
 
-    const Node* father = currentNode->getFather();
+        const Node* father = currentNode->getFather();
 
-    double d = currentNode->getDistanceToFather();
+        double d = currentNode->getDistanceToFather();
 
-    vector<size_t> nodeStates = ancestors[currentNode->getId()]; // These are not 'true' ancestors ;)
-    vector<size_t> fatherStates = ancestors[father->getId()];
+        const vector<size_t>& nodeStates = ancestors.at(currentNode->getId()); // These are not 'true' ancestors ;)
+        const vector<size_t>& fatherStates = ancestors.at(father->getId());
 
-    // For each node,
-    if (verbose)
-      ApplicationTools::displayGauge(l, nbNodes - 1);
-    VVdouble substitutionsForCurrentNode(nbDistinctSites);
-    for (size_t i = 0; i < nbDistinctSites; ++i)
-    {
-      substitutionsForCurrentNode[i].resize(nbTypes);
-    }
+        // For each node,
+        if (verbose)
+        {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+          ApplicationTools::displayGauge(nbDone++, nbNodes - 1);
+        }
+        for (size_t i = 0; i < nbDistinctSites; ++i)
+        {
+          fill(substitutionsForCurrentNode[i].begin(), substitutionsForCurrentNode[i].end(), 0.);
+        }
 
-    // Here, we have no likelihood computation to do!
+        // Here, we have no likelihood computation to do!
 
-    // Then, we deal with the node of interest.
-    // ('y' is the state at 'node' and 'x' the state at 'father'.)
-    // Iterate over all site partitions:
-    unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentNode->getId()));
-    while (mit->hasNext())
-    {
-      TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
-      substitutionCount.setSubstitutionModel(bmd->getSubstitutionModel());
-      // compute all nxy first:
-      VVVdouble nxyt(nbTypes);
-      for (size_t t = 0; t < nbTypes; ++t)
-      {
-        nxyt[t].resize(nbStates);
-        Matrix<double>* nxy = substitutionCount.getAllNumbersOfSubstitutions(d, t + 1);
-        for (size_t x = 0; x < nbStates; ++x)
+        // Then, we deal with the node of interest.
+        // ('y' is the state at 'node' and 'x' the state at 'father'.)
+        // Iterate over all site partitions:
+        unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentNode->getId()));
+        while (mit->hasNext())
         {
-          nxyt[t][x].resize(nbStates);
-          for (size_t y = 0; y < nbStates; ++y)
+          TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
+          SubstitutionCount& count = threadCount.setSubstitutionModel(bmd->getSubstitutionModel());
+          // compute all nxy first, for all types at once:
+          count.getAllNumbersOfSubstitutions(d, nxyt);
+          // Now loop over sites:
+          unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
+          while (sit->hasNext())
           {
-            nxyt[t][x][y] = (*nxy)(x, y);
+            size_t i = sit->next();
+            size_t fatherState = fatherStates[i];
+            size_t nodeState   = nodeStates[i];
+            if (fatherState >= nbStates || nodeState >= nbStates)
+              for (size_t t = 0; t < nbTypes; ++t)
+              {
+                substitutionsForCurrentNode[i][t] = 0;
+              }                                                    // To be conservative! Only in case there are generic characters.
+            else
+              for (size_t t = 0; t < nbTypes; ++t)
+              {
+                substitutionsForCurrentNode[i][t] = nxyt[(fatherState * nbStates + nodeState) * nbTypes + t];
+              }
           }
         }
-        delete nxy;
-      }
-      // Now loop over sites:
-      unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
-      while (sit->hasNext())
-      {
-        size_t i = sit->next();
-        size_t fatherState = fatherStates[i];
-        size_t nodeState   = nodeStates[i];
-        if (fatherState >= nbStates || nodeState >= nbStates)
-          for (size_t t = 0; t < nbTypes; ++t)
-          {
-            substitutionsForCurrentNode[i][t] = 0;
-          }                                                    // To be conservative! Only in case there are generic characters.
-        else
-          for (size_t t = 0; t < nbTypes; ++t)
+
+        // Now we just have to copy the substitutions into the result vector:
+        for (size_t i = 0; i < nbSites; i++)
+        {
+          for (size_t t = 0; t < nbTypes; t++)
           {
-            substitutionsForCurrentNode[i][t] = nxyt[t][fatherState][nodeState];
+            (*substitutions)(l, i, t) = substitutionsForCurrentNode[(*rootPatternLinks)[i]][t];
           }
+        }
       }
-    }
-
-    // Now we just have to copy the substitutions into the result vector:
-    for (size_t i = 0; i < nbSites; i++)
-    {
-      for (size_t t = 0; t < nbTypes; t++)
+      catch (exception& e)
       {
-        (*substitutions)(l, i, t) = substitutionsForCurrentNode[(*rootPatternLinks)[i]][t];
+        errors[l] = e.what();
       }
     }
   }
+  for (size_t l = 0; l < nbNodes; ++l)
+  {
+    if (!errors[l].empty())
+    {
+      delete substitutions;
+      throw Exception(errors[l]);
+    }
+  }
   if (verbose)
   {
     if (ApplicationTools::message)
@@ -1150,102 +1262,118 @@ ProbabilisticSubstitutionMapping* SubstitutionMappingTools::computeSubstitutionV
   if (verbose)
     ApplicationTools::displayTask("Compute marginal node-pairs likelihoods", true);
 
-  for (size_t l = 0; l < nbNodes; l++)
+  vector<string> errors(nbNodes);
+  size_t nbDone = 0;
+  long nb = static_cast<long>(nbNodes);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
   {
-    const Node* currentNode = nodes[l];
+    // Branches are independent: each thread uses its own copy of the substitution count, and its own scratch arrays.
+    ThreadSubstitutionCount threadCount(substitutionCount);
+    VVdouble substitutionsForCurrentNode(nbDistinctSites, Vdouble(nbTypes));
+    VVdouble nxy(nbClasses);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (long ll = 0; ll < nb; ++ll)
+    {
+      size_t l = static_cast<size_t>(ll);
+      try
+      {
+        const Node* currentNode = nodes[l];
 
-    const Node* father = currentNode->getFather();
+        const Node* father = currentNode->getFather();
 
-    double d = currentNode->getDistanceToFather();
+        double d = currentNode->getDistanceToFather();
 
-    // For each node,
-    if (verbose)
-      ApplicationTools::displayGauge(l, nbNodes - 1);
-    VVdouble substitutionsForCurrentNode(nbDistinctSites);
-    for (size_t i = 0; i < nbDistinctSites; ++i)
-    {
-      substitutionsForCurrentNode[i].resize(nbTypes);
-    }
+        // For each node,
+        if (verbose)
+        {
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+          ApplicationTools::displayGauge(nbDone++, nbNodes - 1);
+        }
+        for (size_t i = 0; i < nbDistinctSites; ++i)
+        {
+          fill(substitutionsForCurrentNode[i].begin(), substitutionsForCurrentNode[i].end(), 0.);
+        }
 
-    // Then, we deal with the node of interest.
-    // ('y' is the state at 'node' and 'x' the state at 'father'.)
-    VVVdouble probsNode   = DRTreeLikelihoodTools::getPosteriorProbabilitiesForEachStateForEachRate(drtl, currentNode->getId());
-    VVVdouble probsFather = DRTreeLikelihoodTools::getPosteriorProbabilitiesForEachStateForEachRate(drtl, father->getId());
+        // Then, we deal with the node of interest.
+        // ('y' is the state at 'node' and 'x' the state at 'father'.)
+        VVVdouble probsNode   = DRTreeLikelihoodTools::getPosteriorProbabilitiesForEachStateForEachRate(drtl, currentNode->getId());
+        VVVdouble probsFather = DRTreeLikelihoodTools::getPosteriorProbabilitiesForEachStateForEachRate(drtl, father->getId());
 
-    // Iterate over all site partitions:
-    unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentNode->getId()));
-    while (mit->hasNext())
-    {
-      TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
-      substitutionCount.setSubstitutionModel(bmd->getSubstitutionModel());
-      // compute all nxy first:
-      VVVVdouble nxy(nbClasses);
-      for (size_t c = 0; c < nbClasses; ++c)
-      {
-        VVVdouble* nxy_c = &nxy[c];
-        double rc = rcRates[c];
-        nxy_c->resize(nbTypes);
-        for (size_t t = 0; t < nbTypes; ++t)
+        // Iterate over all site partitions:
+        unique_ptr<TreeLikelihood::ConstBranchModelIterator> mit(drtl.getNewBranchModelIterator(currentNode->getId()));
+        while (mit->hasNext())
         {
-          VVdouble* nxy_c_t = &(*nxy_c)[t];
-          Matrix<double>* nijt = substitutionCount.getAllNumbersOfSubstitutions(d * rc, t + 1);
-          nxy_c_t->resize(nbStates);
-          for (size_t x = 0; x < nbStates; ++x)
+          TreeLikelihood::ConstBranchModelDescription* bmd = mit->next();
+          SubstitutionCount& count = threadCount.setSubstitutionModel(bmd->getSubstitutionModel());
+          // compute all nxy first, for all types at once:
+          for (size_t c = 0; c < nbClasses; ++c)
           {
-            Vdouble* nxy_c_t_x = &(*nxy_c_t)[x];
-            nxy_c_t_x->resize(nbStates);
-            for (size_t y = 0; y < nbStates; ++y)
-            {
-              (*nxy_c_t_x)[y] = (*nijt)(x, y);
-            }
+            count.getAllNumbersOfSubstitutions(d * rcRates[c], nxy[c]);
           }
-          delete nijt;
-        }
-      }
 
-      // Now loop over sites:
-      unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
-      while (sit->hasNext())
-      {
-        size_t i = sit->next();
-        VVdouble* probsNode_i   = &probsNode[i];
-        VVdouble* probsFather_i = &probsFather[i];
-        for (size_t c = 0; c < nbClasses; ++c)
-        {
-          Vdouble* probsNode_i_c   = &(*probsNode_i)[c];
-          Vdouble* probsFather_i_c = &(*probsFather_i)[c];
-          VVVdouble* nxy_c = &nxy[c];
-          for (size_t x = 0; x < nbStates; ++x)
+          // Now loop over sites:
+          unique_ptr<TreeLikelihood::SiteIterator> sit(bmd->getNewSiteIterator());
+          while (sit->hasNext())
           {
-            for (size_t y = 0; y < nbStates; ++y)
+            size_t i = sit->next();
+            VVdouble* probsNode_i   = &probsNode[i];
+            VVdouble* probsFather_i = &probsFather[i];
+            for (size_t c = 0; c < nbClasses; ++c)
             {
-              double prob_cxy = (*probsFather_i_c)[x] * (*probsNode_i_c)[y];
-              // Now the vector computation:
-              for (size_t t = 0; t < nbTypes; ++t)
+              Vdouble* probsNode_i_c   = &(*probsNode_i)[c];
+              Vdouble* probsFather_i_c = &(*probsFather_i)[c];
+              const Vdouble* nxy_c = &nxy[c];
+              for (size_t x = 0; x < nbStates; ++x)
               {
-                substitutionsForCurrentNode[i][t] += prob_cxy * (*nxy_c)[t][x][y];
-                //                                   <------>   <--------------->
-                // Posterior probability                 |                |
-                // for site i and rate class c *         |                |
-                // likelihood for this site--------------+                |
-                //                                                        |
-                // Substitution function for site i and rate class c-------+
+                for (size_t y = 0; y < nbStates; ++y)
+                {
+                  double prob_cxy = (*probsFather_i_c)[x] * (*probsNode_i_c)[y];
+                  // Now the vector computation:
+                  for (size_t t = 0; t < nbTypes; ++t)
+                  {
+                    substitutionsForCurrentNode[i][t] += prob_cxy * (*nxy_c)[(x * nbStates + y) * nbTypes + t];
+                    //                                   <------>   <--------------->
+                    // Posterior probability                 |                |
+                    // for site i and rate class c *         |                |
+                    // likelihood for this site--------------+                |
+                    //                                                        |
+                    // Substitution function for site i and rate class c-------+
+                  }
+                }
               }
             }
           }
         }
-      }
-    }
 
-    // Now we just have to copy the substitutions into the result vector:
-    for (size_t i = 0; i < nbSites; ++i)
-    {
-      for (size_t t = 0; t < nbTypes; ++t)
+        // Now we just have to copy the substitutions into the result vector:
+        for (size_t i = 0; i < nbSites; ++i)
+        {
+          for (size_t t = 0; t < nbTypes; ++t)
+          {
+            (*substitutions)(l, i, t) = substitutionsForCurrentNode[(*rootPatternLinks)[i]][t];
+          }
+        }
+      }
+      catch (exception& e)
       {
-        (*substitutions)(l, i, t) = substitutionsForCurrentNode[(*rootPatternLinks)[i]][t];
+        errors[l] = e.what();
       }
     }
   }
+  for (size_t l = 0; l < nbNodes; ++l)
+  {
+    if (!errors[l].empty())
+    {
+      delete substitutions;
+      throw Exception(errors[l]);
+    }
+  }
   if (verbose)
   {
     if (ApplicationTools::message)
@@ -42,13 +42,14 @@ knowledge of the CeCILL license and that you accept its terms.
 #include "Bpp/Numeric/Matrix/MatrixTools.h"
 #include "Bpp/Numeric/NumTools.h"
 #include <vector>
+#include <algorithm>
 
 using namespace bpp;
 using namespace std;
 
 /******************************************************************************/
 
-UniformizationSubstitutionCount::UniformizationSubstitutionCount(const SubstitutionModel* model, SubstitutionRegister* reg, const AlphabetIndex2* weights) :
+UniformizationSubstitutionCount::UniformizationSubstitutionCount(const SubstitutionModel* model, SubstitutionRegister* reg, const AlphabetIndex2* weights, double tolerance) :
   AbstractSubstitutionCount(reg),
   AbstractWeightedSubstitutionCount(weights, true),
   model_(model),
@@ -58,11 +59,14 @@ UniformizationSubstitutionCount::UniformizationSubstitutionCount(const Substitut
   s_(reg->getNumberOfSubstitutionTypes()),
   miu_(0),
   counts_(reg->getNumberOfSubstitutionTypes()),
-  currentLength_(1.)
+  currentLength_(-1.),
+  tolerance_(tolerance)
 {
   //Check compatiblity between model and substitution register:
   if (model->getAlphabet()->getAlphabetType() != reg->getAlphabet()->getAlphabetType())
     throw Exception("UniformizationSubstitutionCount (constructor): alphabets do not match between register and model.");
+  if (tolerance <= 0.)
+    throw Exception("UniformizationSubstitutionCount (constructor): the tolerance must be strictly positive.");
 
   //Initialize all B matrices according to substitution register. This is done once for all,
   //unless the number of states changes:
@@ -119,40 +123,57 @@ void UniformizationSubstitutionCount::fillBMatrices_()
 
 void UniformizationSubstitutionCount::computeCounts_(double length) const
 {
+  size_t nbTypes = register_->getNumberOfSubstitutionTypes();
   double lam = miu_ * length;
-  RowMatrix<double> I;
-  MatrixTools::getId(nbStates_, I);
-  RowMatrix<double> R(model_->getGenerator());
-  MatrixTools::scale(R, 1. / miu_);
-  MatrixTools::add(R, I);
-  
-  //compute the stopping point
-  //use the tail of Poisson distribution
-  //can be approximated by 4 + 6 * sqrt(lam) + lam
-  size_t nMax = static_cast<size_t>(ceil(4 + 6 * sqrt(lam) + lam));
+  if (lam <= 0.)
+  {
+    for (size_t i = 0; i < nbTypes; ++i)
+      MatrixTools::fill(counts_[i], 0.);
+    return;
+  }
 
-  //compute the powers of R
-  power_.resize(nMax + 1);
-  power_[0] = I;
-  for (size_t i = 1; i < nMax + 1; ++i)
-    MatrixTools::mult(power_[i - 1], R, power_[i]);
+  //Long branches are split into 2^nbSquarings pieces of equal length, in order
+  //to keep the number of terms low. As errors on the pieces add up when they
+  //are composed, the tolerance on each piece is lowered accordingly.
+  size_t nbSquarings = 0;
+  while (lam > 32.)
+  {
+    lam /= 2.;
+    nbSquarings++;
+  }
+  double tolerance = tolerance_ / (pow(2., static_cast<double>(nbSquarings)) * static_cast<double>(nbSquarings + 1));
+
+  //Truncate the series adaptively, and make sure all needed terms are cached:
+  vector<double> probs;
+  size_t nMax = computePoissonProbabilities_(lam, tolerance, probs);
+  computeTerms_(nMax);
+
+  //The counts are the sum of the terms weighted by the probability of l + 1 jumps:
+  for (size_t i = 0; i < nbTypes; ++i) {
+    MatrixTools::fill(counts_[i], 0.);
+    for (size_t l = 0; l < nMax + 1; ++l)
+      MatrixTools::add(counts_[i], probs[l + 1] / miu_, s_[i][l]);
+  }
 
-  for (size_t i = 0; i < register_->getNumberOfSubstitutionTypes(); ++i) {
-    s_[i].resize(nMax + 1);
-    MatrixTools::mult(bMatrices_[i], power_[0], s_[i][0]);
-    RowMatrix<double> tmp(nbStates_, nbStates_);
-    for (size_t l = 1; l < nMax + 1; ++l) {
-      MatrixTools::mult(R, s_[i][l - 1], s_[i][l]);
-      MatrixTools::mult(bMatrices_[i], power_[l], tmp);
-      MatrixTools::add(s_[i][l], tmp);
-    }
-    MatrixTools::fill(counts_[i], 0);
-    for (size_t l = 0; l < nMax + 1; ++l) {
-      tmp = s_[i][l];
-      //double f = (pow(lam, static_cast<double>(l + 1)) * exp(-lam) / static_cast<double>(NumTools::fact(l + 1))) / miu_;
-      double logF = static_cast<double>(l + 1) * log(lam) - lam - log(miu_) - NumTools::logFact(static_cast<double>(l + 1));
-      MatrixTools::scale(tmp, exp(logF));
-      MatrixTools::add(counts_[i], tmp);
+  if (nbSquarings > 0) {
+    //Transition probabilities of one piece, with the same truncation:
+    RowMatrix<double> pieceP(nbStates_, nbStates_);
+    MatrixTools::fill(pieceP, 0.);
+    for (size_t l = 0; l < nMax + 1; ++l)
+      MatrixTools::add(pieceP, probs[l], power_[l]);
+
+    //Compose pieces two by two, using counts(2t) = counts(t).P(t) + P(t).counts(t):
+    RowMatrix<double> tmp1;
+    RowMatrix<double> tmp2;
+    for (size_t k = 0; k < nbSquarings; ++k) {
+      for (size_t i = 0; i < nbTypes; ++i) {
+        MatrixTools::mult(counts_[i], pieceP, tmp1);
+        MatrixTools::mult(pieceP, counts_[i], tmp2);
+        MatrixTools::add(tmp1, tmp2);
+        counts_[i] = tmp1;
+      }
+      MatrixTools::mult(pieceP, pieceP, tmp1);
+      pieceP = tmp1;
     }
   }
 
@@ -175,6 +196,48 @@ void UniformizationSubstitutionCount::computeCounts_(double length) const
 
 /******************************************************************************/
 
+void UniformizationSubstitutionCount::computeTerms_(size_t n) const
+{
+  //Terms are s_l = sum over k of R^k.B.R^(l-k), computed by recursion as s_l = R.s_(l-1) + B.R^l.
+  getUniformizedMatrixPower(n);
+  RowMatrix<double> tmp;
+  for (size_t i = 0; i < s_.size(); ++i) {
+    for (size_t l = s_[i].size(); l < n + 1; ++l) {
+      s_[i].push_back(RowMatrix<double>());
+      if (l == 0) {
+        s_[i][0] = bMatrices_[i];
+      } else {
+        MatrixTools::mult(power_[1], s_[i][l - 1], s_[i][l]);
+        MatrixTools::mult(bMatrices_[i], power_[l], tmp);
+        MatrixTools::add(s_[i][l], tmp);
+      }
+    }
+  }
+}
+
+/******************************************************************************/
+
+size_t UniformizationSubstitutionCount::computePoissonProbabilities_(double lam, double tolerance, vector<double>& probs)
+{
+  double scale = max(1., lam);
+  //Past 2 * lam, probabilities decrease faster than a geometric series of ratio 1/2,
+  //so that the remaining ones sum to less than the last one computed:
+  probs.assign(1, exp(-lam));
+  while (static_cast<double>(probs.size()) <= 2. * lam + 1. || probs.back() * scale >= tolerance / 2.)
+    probs.push_back(probs.back() * lam / static_cast<double>(probs.size()));
+
+  //Now find the smallest n such that P(X > n) is small enough:
+  size_t n = probs.size() - 1;
+  double tail = probs.back();
+  while (n > 0 && (tail + probs[n]) * scale <= tolerance) {
+    tail += probs[n];
+    n--;
+  }
+  return n;
+}
+
+/******************************************************************************/
+
 Matrix<double>* UniformizationSubstitutionCount::getAllNumbersOfSubstitutions(double length, size_t type) const
 {
   if (length < 0)
@@ -189,6 +252,23 @@ Matrix<double>* UniformizationSubstitutionCount::getAllNumbersOfSubstitutions(do
 
 /******************************************************************************/
 
+void UniformizationSubstitutionCount::getAllNumbersOfSubstitutions(double length, std::vector<double>& counts) const
+{
+  if (length < 0)
+    throw Exception("UniformizationSubstitutionCount::getAllNumbersOfSubstitutions. Negative branch length: " + TextTools::toString(length) + ".");
+  if (getCachedCounts_(length, counts))
+    return;
+  if (length != currentLength_)
+  {
+    computeCounts_(length);
+    currentLength_ = length;
+  }
+  fillCounts_(counts_, counts);
+  cacheCounts_(length, counts);
+}
+
+/******************************************************************************/
+
 double UniformizationSubstitutionCount::getNumberOfSubstitutions(size_t initialState, size_t finalState, double length, size_t type) const
 {
   if (length < 0)
@@ -221,6 +301,43 @@ std::vector<double> UniformizationSubstitutionCount::getNumberOfSubstitutionsFor
     
 /******************************************************************************/
 
+const RowMatrix<double>& UniformizationSubstitutionCount::getUniformizedMatrixPower(size_t n) const
+{
+  if (power_.size() < 2)
+  {
+    RowMatrix<double> I;
+    MatrixTools::getId(nbStates_, I);
+    RowMatrix<double> R(model_->getGenerator());
+    MatrixTools::scale(R, 1. / miu_);
+    MatrixTools::add(R, I);
+    power_.resize(2);
+    power_[0] = I;
+    power_[1] = R;
+  }
+  while (power_.size() <= n)
+  {
+    power_.push_back(RowMatrix<double>());
+    MatrixTools::mult(power_[power_.size() - 2], power_[1], power_.back());
+  }
+  return power_[n];
+}
+
+/******************************************************************************/
+
+void UniformizationSubstitutionCount::setTolerance(double tolerance)
+{
+  if (tolerance <= 0.)
+    throw Exception("UniformizationSubstitutionCount::setTolerance. The tolerance must be strictly positive: " + TextTools::toString(tolerance) + ".");
+  tolerance_ = tolerance;
+
+  //Recompute counts:
+  clearCache_();
+  if (currentLength_ >= 0)
+    computeCounts_(currentLength_);
+}
+
+/******************************************************************************/
+
 void UniformizationSubstitutionCount::setSubstitutionModel(const SubstitutionModel* model)
 {
   //Check compatiblity between model and substitution register:
@@ -247,7 +364,12 @@ void UniformizationSubstitutionCount::setSubstitutionModel(const SubstitutionMod
     throw Exception("UniformizationSubstitutionCount::setSubstitutionModel(). The maximum diagonal values of generator is above 10000. Abort, chose another mapping method.");
 
   //Recompute counts:
-  computeCounts_(currentLength_);
+  power_.clear();
+  for (size_t i = 0; i < s_.size(); ++i)
+    s_[i].clear();
+  clearCache_();
+  if (currentLength_ >= 0)
+    computeCounts_(currentLength_);
 }
 
 /******************************************************************************/
@@ -263,6 +385,9 @@ void UniformizationSubstitutionCount::substitutionRegisterHasChanged()
   fillBMatrices_();
   
   //Recompute counts:
+  for (size_t i = 0; i < s_.size(); ++i)
+    s_[i].clear();
+  clearCache_();
   if (currentLength_ > 0)
     computeCounts_(currentLength_);
 }
@@ -278,6 +403,7 @@ void UniformizationSubstitutionCount::weightsHaveChanged()
   //fillBMatrices_();
   
   //Recompute counts:
+  clearCache_();
   if (currentLength_ > 0)
     computeCounts_(currentLength_);
 }
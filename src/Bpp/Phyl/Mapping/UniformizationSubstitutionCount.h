@@ -52,6 +52,15 @@ namespace bpp
  *
  * The code is adapted from the original R code by Paula Tataru and Asger Hobolth.
  *
+ * The expected counts are a Poisson mixture of terms which do not depend on the
+ * branch length. These terms, as well as the powers of the uniformized matrix, are
+ * computed on demand and kept until the model or register changes, so that a new
+ * branch length only requires weighted sums of cached matrices. The Poisson series is
+ * truncated adaptively, according to a tolerance on the absolute error of the
+ * expected counts (before conditioning on the final state). Long branches, that
+ * is with more than 32 expected jumps of the uniformized chain, are computed as
+ * compositions of shorter ones, by repeated squaring.
+ *
  * @author Julien Dutheil
  */
 class UniformizationSubstitutionCount:
@@ -67,9 +76,16 @@ class UniformizationSubstitutionCount:
     double miu_;
     mutable std::vector< RowMatrix<double> > counts_;
     mutable double currentLength_;
+    double tolerance_;
   
   public:
-    UniformizationSubstitutionCount(const SubstitutionModel* model, SubstitutionRegister* reg, const AlphabetIndex2* weights = 0);
+    /**
+     * @param model     The substitution model.
+     * @param reg       The register describing the types of substitutions to count.
+     * @param weights   Optional weights of the counts.
+     * @param tolerance The maximum error on the expected counts, see setTolerance.
+     */
+    UniformizationSubstitutionCount(const SubstitutionModel* model, SubstitutionRegister* reg, const AlphabetIndex2* weights = 0, double tolerance = 1e-12);
     
     UniformizationSubstitutionCount(const UniformizationSubstitutionCount& usc) :
       AbstractSubstitutionCount(usc), 
@@ -81,7 +97,8 @@ class UniformizationSubstitutionCount:
       s_(usc.s_),
       miu_(usc.miu_),
       counts_(usc.counts_),
-      currentLength_(usc.currentLength_)
+      currentLength_(usc.currentLength_),
+      tolerance_(usc.tolerance_)
     {}        
     
     UniformizationSubstitutionCount& operator=(const UniformizationSubstitutionCount& usc)
@@ -96,6 +113,7 @@ class UniformizationSubstitutionCount:
       miu_            = usc.miu_;
       counts_         = usc.counts_;
       currentLength_  = usc.currentLength_;
+      tolerance_      = usc.tolerance_;
       return *this;
     }        
     
@@ -107,11 +125,43 @@ public:
     double getNumberOfSubstitutions(size_t initialState, size_t finalState, double length, size_t type = 1) const;
 
     Matrix<double>* getAllNumbersOfSubstitutions(double length, size_t type = 1) const;
+
+    void getAllNumbersOfSubstitutions(double length, std::vector<double>& counts) const;
     
     std::vector<double> getNumberOfSubstitutionsForEachType(size_t initialState, size_t finalState, double length) const;
    
     void setSubstitutionModel(const SubstitutionModel* model);
 
+    /**
+     * @return The rate of the uniformized process, that is the largest exit rate of the model.
+     */
+    double getUniformizationRate() const { return miu_; }
+
+    /**
+     * @brief Get a power of the transition matrix of the uniformized chain, R = I + Q / miu.
+     *
+     * Powers are computed on demand and cached, they are shared with the computation of the counts.
+     * The returned reference may be invalidated by a later call for a higher power.
+     *
+     * @param n The exponent.
+     * @return The matrix R^n.
+     */
+    const RowMatrix<double>& getUniformizedMatrixPower(size_t n) const;
+
+    /**
+     * @brief Set the accuracy of the counts.
+     *
+     * The Poisson series is truncated so that the absolute error on the expected
+     * number of substitutions, jointly with the final state, is below the tolerance.
+     * Smaller values require more terms.
+     *
+     * @param tolerance The maximum error, strictly positive.
+     * @throw Exception If the tolerance is not strictly positive.
+     */
+    void setTolerance(double tolerance);
+
+    double getTolerance() const { return tolerance_; }
+
   protected:
     void computeCounts_(double length) const;
     void substitutionRegisterHasChanged();
@@ -122,6 +172,23 @@ public:
     void initBMatrices_();
     void fillBMatrices_();
 
+    /**
+     * @brief Compute and cache the terms of the series, up to a given order.
+     *
+     * @param n The highest order needed.
+     */
+    void computeTerms_(size_t n) const;
+
+    /**
+     * @brief Compute Poisson probabilities and the truncation point of the series.
+     *
+     * @param lam       The mean of the Poisson distribution.
+     * @param tolerance The maximum error due to truncation.
+     * @param probs     [out] The Poisson probabilities, from 0 to at least the truncation point + 1.
+     * @return The truncation point n, such that max(1, lam) * P(X > n) is below the tolerance.
+     */
+    static size_t computePoissonProbabilities_(double lam, double tolerance, std::vector<double>& probs);
+
 };
 
 } //end of namespace bpp.
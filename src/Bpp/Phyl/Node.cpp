@@ -57,14 +57,10 @@ Node::Node(const Node& node):
   id_(node.id_), name_(0),
   sons_(), father_(0),
   //, sons_(node.sons_), father_(node.father_),
-  distanceToFather_(0), nodeProperties_(), branchProperties_()
+  distanceToFather_(0), nodeProperties_(node.nodeProperties_), branchProperties_(node.branchProperties_)
 {
   name_             = node.hasName() ? new string(* node.name_) : 0;
   distanceToFather_ = node.hasDistanceToFather() ? new double(* node.distanceToFather_) : 0;
-  for (map<string, Clonable *>::iterator i = node.nodeProperties_.begin(); i != node.nodeProperties_.end(); i++)
-    nodeProperties_[i->first] = i->second->clone();
-  for (map<string, Clonable *>::iterator i = node.branchProperties_.begin(); i != node.branchProperties_.end(); i++)
-    branchProperties_[i->first] = i->second->clone();
 }
 
 /** Assignation operator: *****************************************************/
@@ -78,18 +74,8 @@ Node& Node::operator=(const Node & node)
   if(distanceToFather_) delete distanceToFather_;
   distanceToFather_ = node.hasDistanceToFather() ? new double(* node.distanceToFather_) : 0;
   //sons_             = node.sons_;
-  for(map<string, Clonable *>::iterator i = node.nodeProperties_.begin(); i != node.nodeProperties_.end(); i++)
-  {
-    Clonable * p = nodeProperties_[i->first];
-    if(p) delete p;
-    nodeProperties_[i->first] = i->second->clone();
-  }
-  for(map<string, Clonable *>::iterator i = node.branchProperties_.begin(); i != node.branchProperties_.end(); i++)
-  {
-    Clonable * p = branchProperties_[i->first];
-    if(p) delete p;
-    branchProperties_[i->first] = i->second->clone();
-  }
+  nodeProperties_.update(node.nodeProperties_);
+  branchProperties_.update(node.branchProperties_);
   return * this;
 }
       
@@ -140,13 +126,16 @@ size_t Node::getSonPosition(const Node* son) const
 
 bool Node::hasBootstrapValue() const
 {
-  return hasBranchProperty(TreeTools::BOOTSTRAP);
+  static const PropertyKey bootstrapKey = PropertyRegistry::getKey(TreeTools::BOOTSTRAP);
+  return branchProperties_.has(bootstrapKey);
 }
 
 double Node::getBootstrapValue() const
 {
-  if(hasBranchProperty(TreeTools::BOOTSTRAP))
-    return dynamic_cast<const Number<double> *>(getBranchProperty(TreeTools::BOOTSTRAP))->getValue();
+  static const PropertyKey bootstrapKey = PropertyRegistry::getKey(TreeTools::BOOTSTRAP);
+  double value = 0;
+  if(branchProperties_.getDouble(bootstrapKey, value))
+    return value;
   else
     throw PropertyNotFoundException("", TreeTools::BOOTSTRAP, this);
 }
@@ -41,6 +41,7 @@
 #define _NODE_H_
 
 #include "TreeExceptions.h"
+#include "PropertyMap.h"
 
 #include <Bpp/Clonable.h>
 #include <Bpp/Utils/MapTools.h>
@@ -76,7 +77,7 @@ namespace bpp
  * - A std::vector of pointer toward son nodes;
  * - The distance from the father node:
  * - A property map, that may contain any information to link to each node, e.g. bootstrap
- * value or GC content.
+ * value or GC content, and a similar map for the branch leading to the node (see PropertyMap).
  *
  * Methods are provided to help the building of trees from scratch.
  * Trees are more easily built from root to leaves:
@@ -96,8 +97,8 @@ protected:
   std::vector<Node*> sons_;
   Node* father_;
   double* distanceToFather_;
-  mutable std::map<std::string, Clonable*> nodeProperties_;
-  mutable std::map<std::string, Clonable*> branchProperties_;
+  PropertyMap nodeProperties_;
+  PropertyMap branchProperties_;
 
 public:
   /**
@@ -165,6 +166,7 @@ public:
    * @brief Assignation operator.
    *
    * @warning This operator copies all fields, excepted father and son node pointers.
+   * Properties of this node which are not set in the copied node are kept.
    *
    * @param node the node to copy.
    * @return A reference toward this node.
@@ -178,14 +180,6 @@ public:
   {
     if (name_) delete name_;
     if (distanceToFather_) delete distanceToFather_;
-    for (std::map<std::string, Clonable*>::iterator i = nodeProperties_.begin(); i != nodeProperties_.end(); i++)
-    {
-      delete i->second;
-    }
-    for (std::map<std::string, Clonable*>::iterator i = branchProperties_.begin(); i != branchProperties_.end(); i++)
-    {
-      delete i->second;
-    }
   }
 
 public:
@@ -504,6 +498,12 @@ public:
   /**
    * @name Node properties:
    *
+   * Properties can be accessed by name, or by key (see PropertyRegistry).
+   * Numbers (Number<double>, BppInteger) and BppString properties are stored
+   * by value, and can be accessed without creating any object with the
+   * getNodeDoubleProperty, getNodeIntegerProperty and getNodeStringProperty
+   * methods. All const methods are safe to call concurrently.
+   *
    * @{
    */
 
@@ -519,50 +519,70 @@ public:
    */
   virtual void setNodeProperty(const std::string& name, const Clonable& property)
   {
-    if (hasNodeProperty(name))
-      delete nodeProperties_[name];
-    nodeProperties_[name] = property.clone();
+    nodeProperties_.set(PropertyRegistry::getKey(name), property);
+  }
+
+  virtual void setNodeProperty(PropertyKey key, const Clonable& property)
+  {
+    nodeProperties_.set(key, property);
   }
 
   virtual Clonable* getNodeProperty(const std::string& name)
   {
-    if (hasNodeProperty(name))
-      return nodeProperties_[name];
-    else
+    PropertyKey key;
+    Clonable* property = PropertyRegistry::findKey(name, key) ? nodeProperties_.get(key) : 0;
+    if (!property)
       throw PropertyNotFoundException("", name, this);
+    return property;
   }
 
   virtual const Clonable* getNodeProperty(const std::string& name) const
   {
-    if (hasNodeProperty(name))
-      return const_cast<const Clonable*>(nodeProperties_[name]);
-    else
+    PropertyKey key;
+    const Clonable* property = PropertyRegistry::findKey(name, key) ? nodeProperties_.get(key) : 0;
+    if (!property)
       throw PropertyNotFoundException("", name, this);
+    return property;
+  }
+
+  virtual Clonable* getNodeProperty(PropertyKey key)
+  {
+    Clonable* property = nodeProperties_.get(key);
+    if (!property)
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+    return property;
+  }
+
+  virtual const Clonable* getNodeProperty(PropertyKey key) const
+  {
+    const Clonable* property = nodeProperties_.get(key);
+    if (!property)
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+    return property;
   }
 
   virtual Clonable* removeNodeProperty(const std::string& name)
   {
-    if (hasNodeProperty(name))
-    {
-      Clonable* removed = nodeProperties_[name];
-      nodeProperties_.erase(name);
-      return removed;
-    }
-    else
+    PropertyKey key;
+    Clonable* removed = PropertyRegistry::findKey(name, key) ? nodeProperties_.release(key) : 0;
+    if (!removed)
       throw PropertyNotFoundException("", name, this);
+    return removed;
   }
 
   virtual void deleteNodeProperty(const std::string& name)
   {
-    if (hasNodeProperty(name))
-    {
-      delete nodeProperties_[name];
-      nodeProperties_.erase(name);
-    }
-    else
+    PropertyKey key;
+    if (!PropertyRegistry::findKey(name, key) || !nodeProperties_.erase(key))
       throw PropertyNotFoundException("", name, this);
   }
 
+  virtual void deleteNodeProperty(PropertyKey key)
+  {
+    if (!nodeProperties_.erase(key))
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+  }
+
   /**
    * @brief Remove all node properties.
    *
@@ -570,7 +590,7 @@ public:
    */
   virtual void removeNodeProperties()
   {
-    nodeProperties_.clear();
+    nodeProperties_.releaseAll();
   }
 
   /**
@@ -578,22 +598,89 @@ public:
    */
   virtual void deleteNodeProperties()
   {
-    for (std::map<std::string, Clonable*>::iterator i = nodeProperties_.begin(); i != nodeProperties_.end(); i++)
-    {
-      delete i->second;
-    }
-    nodeProperties_.clear();
+    nodeProperties_.deleteAll();
   }
 
-  virtual bool hasNodeProperty(const std::string& name) const { return nodeProperties_.find(name) != nodeProperties_.end(); }
+  virtual bool hasNodeProperty(const std::string& name) const
+  {
+    PropertyKey key;
+    return PropertyRegistry::findKey(name, key) && nodeProperties_.has(key);
+  }
+
+  virtual bool hasNodeProperty(PropertyKey key) const { return nodeProperties_.has(key); }
+
+  virtual std::vector<std::string> getNodePropertyNames() const { return nodeProperties_.getNames(); }
+
+  /**
+   * @return All node properties, e.g. to iterate over their keys and types.
+   */
+  virtual const PropertyMap& getNodeProperties() const { return nodeProperties_; }
+
+  /**
+   * @brief Set/add a numerical node property, stored as a Number<double>.
+   */
+  virtual void setNodeDoubleProperty(PropertyKey key, double value) { nodeProperties_.setDouble(key, value); }
 
-  virtual std::vector<std::string> getNodePropertyNames() const { return MapTools::getKeys(nodeProperties_); }
+  /**
+   * @brief Set/add an integer node property, stored as a BppInteger.
+   */
+  virtual void setNodeIntegerProperty(PropertyKey key, int value) { nodeProperties_.setInteger(key, value); }
+
+  /**
+   * @brief Set/add a text node property, stored as a BppString.
+   */
+  virtual void setNodeStringProperty(PropertyKey key, const std::string& value) { nodeProperties_.setString(key, value); }
+
+  /**
+   * @return The value of a numerical node property.
+   * @throw PropertyNotFoundException If the property is not set.
+   * @throw Exception If the property is not a number.
+   */
+  virtual double getNodeDoubleProperty(PropertyKey key) const
+  {
+    double value = 0;
+    if (!nodeProperties_.getDouble(key, value))
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+    return value;
+  }
+
+  /**
+   * @return The value of an integer node property.
+   * @throw PropertyNotFoundException If the property is not set.
+   * @throw Exception If the property is not an integer.
+   */
+  virtual int getNodeIntegerProperty(PropertyKey key) const
+  {
+    int value = 0;
+    if (!nodeProperties_.getInteger(key, value))
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+    return value;
+  }
+
+  /**
+   * @return The value of a text node property.
+   * @throw PropertyNotFoundException If the property is not set.
+   * @throw Exception If the property is not a BppString.
+   */
+  virtual std::string getNodeStringProperty(PropertyKey key) const
+  {
+    std::string value;
+    if (!nodeProperties_.getString(key, value))
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+    return value;
+  }
 
   /** @} */
 
   /**
    * @name Branch properties:
    *
+   * Properties can be accessed by name, or by key (see PropertyRegistry).
+   * Numbers (Number<double>, BppInteger) and BppString properties are stored
+   * by value, and can be accessed without creating any object with the
+   * getBranchDoubleProperty, getBranchIntegerProperty and getBranchStringProperty
+   * methods. All const methods are safe to call concurrently.
+   *
    * @{
    */
 
@@ -609,50 +696,70 @@ public:
    */
   virtual void setBranchProperty(const std::string& name, const Clonable& property)
   {
-    if (hasBranchProperty(name))
-      delete branchProperties_[name];
-    branchProperties_[name] = property.clone();
+    branchProperties_.set(PropertyRegistry::getKey(name), property);
+  }
+
+  virtual void setBranchProperty(PropertyKey key, const Clonable& property)
+  {
+    branchProperties_.set(key, property);
   }
 
   virtual Clonable* getBranchProperty(const std::string& name)
   {
-    if (hasBranchProperty(name))
-      return branchProperties_[name];
-    else
+    PropertyKey key;
+    Clonable* property = PropertyRegistry::findKey(name, key) ? branchProperties_.get(key) : 0;
+    if (!property)
       throw PropertyNotFoundException("", name, this);
+    return property;
   }
 
   virtual const Clonable* getBranchProperty(const std::string& name) const
   {
-    if (hasBranchProperty(name))
-      return const_cast<const Clonable*>(branchProperties_[name]);
-    else
+    PropertyKey key;
+    const Clonable* property = PropertyRegistry::findKey(name, key) ? branchProperties_.get(key) : 0;
+    if (!property)
       throw PropertyNotFoundException("", name, this);
+    return property;
+  }
+
+  virtual Clonable* getBranchProperty(PropertyKey key)
+  {
+    Clonable* property = branchProperties_.get(key);
+    if (!property)
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+    return property;
+  }
+
+  virtual const Clonable* getBranchProperty(PropertyKey key) const
+  {
+    const Clonable* property = branchProperties_.get(key);
+    if (!property)
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+    return property;
   }
 
   virtual Clonable* removeBranchProperty(const std::string& name)
   {
-    if (hasBranchProperty(name))
-    {
-      Clonable* removed = branchProperties_[name];
-      branchProperties_.erase(name);
-      return removed;
-    }
-    else
+    PropertyKey key;
+    Clonable* removed = PropertyRegistry::findKey(name, key) ? branchProperties_.release(key) : 0;
+    if (!removed)
       throw PropertyNotFoundException("", name, this);
+    return removed;
   }
 
   virtual void deleteBranchProperty(const std::string& name)
   {
-    if (hasBranchProperty(name))
-    {
-      delete branchProperties_[name];
-      branchProperties_.erase(name);
-    }
-    else
+    PropertyKey key;
+    if (!PropertyRegistry::findKey(name, key) || !branchProperties_.erase(key))
       throw PropertyNotFoundException("", name, this);
   }
 
+  virtual void deleteBranchProperty(PropertyKey key)
+  {
+    if (!branchProperties_.erase(key))
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+  }
+
   /**
    * @brief Remove all branch properties.
    *
@@ -660,7 +767,7 @@ public:
    */
   virtual void removeBranchProperties()
   {
-    branchProperties_.clear();
+    branchProperties_.releaseAll();
   }
 
   /**
@@ -668,16 +775,77 @@ public:
    */
   virtual void deleteBranchProperties()
   {
-    for (std::map<std::string, Clonable*>::iterator i = branchProperties_.begin(); i != branchProperties_.end(); i++)
-    {
-      delete i->second;
-    }
-    branchProperties_.clear();
+    branchProperties_.deleteAll();
+  }
+
+  virtual bool hasBranchProperty(const std::string& name) const
+  {
+    PropertyKey key;
+    return PropertyRegistry::findKey(name, key) && branchProperties_.has(key);
   }
 
-  virtual bool hasBranchProperty(const std::string& name) const { return branchProperties_.find(name) != branchProperties_.end(); }
+  virtual bool hasBranchProperty(PropertyKey key) const { return branchProperties_.has(key); }
 
-  virtual std::vector<std::string> getBranchPropertyNames() const { return MapTools::getKeys(branchProperties_); }
+  virtual std::vector<std::string> getBranchPropertyNames() const { return branchProperties_.getNames(); }
+
+  /**
+   * @return All branch properties, e.g. to iterate over their keys and types.
+   */
+  virtual const PropertyMap& getBranchProperties() const { return branchProperties_; }
+
+  /**
+   * @brief Set/add a numerical branch property, stored as a Number<double>.
+   */
+  virtual void setBranchDoubleProperty(PropertyKey key, double value) { branchProperties_.setDouble(key, value); }
+
+  /**
+   * @brief Set/add an integer branch property, stored as a BppInteger.
+   */
+  virtual void setBranchIntegerProperty(PropertyKey key, int value) { branchProperties_.setInteger(key, value); }
+
+  /**
+   * @brief Set/add a text branch property, stored as a BppString.
+   */
+  virtual void setBranchStringProperty(PropertyKey key, const std::string& value) { branchProperties_.setString(key, value); }
+
+  /**
+   * @return The value of a numerical branch property.
+   * @throw PropertyNotFoundException If the property is not set.
+   * @throw Exception If the property is not a number.
+   */
+  virtual double getBranchDoubleProperty(PropertyKey key) const
+  {
+    double value = 0;
+    if (!branchProperties_.getDouble(key, value))
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+    return value;
+  }
+
+  /**
+   * @return The value of an integer branch property.
+   * @throw PropertyNotFoundException If the property is not set.
+   * @throw Exception If the property is not an integer.
+   */
+  virtual int getBranchIntegerProperty(PropertyKey key) const
+  {
+    int value = 0;
+    if (!branchProperties_.getInteger(key, value))
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+    return value;
+  }
+
+  /**
+   * @return The value of a text branch property.
+   * @throw PropertyNotFoundException If the property is not set.
+   * @throw Exception If the property is not a BppString.
+   */
+  virtual std::string getBranchStringProperty(PropertyKey key) const
+  {
+    std::string value;
+    if (!branchProperties_.getString(key, value))
+      throw PropertyNotFoundException("", PropertyRegistry::getName(key), this);
+    return value;
+  }
 
   virtual bool hasBootstrapValue() const;
 
@@ -0,0 +1,403 @@
+//
+// File: PropertyMap.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include "PropertyMap.h"
+
+#include <Bpp/Exceptions.h>
+#include <Bpp/BppString.h>
+#include <Bpp/Numeric/Number.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <typeinfo>
+#include <unordered_map>
+
+using namespace std;
+
+/******************************************************************************/
+
+namespace
+{
+  // Function-local statics, so that keys can be created during static initialization.
+  mutex& registryMutex()
+  {
+    static mutex m;
+    return m;
+  }
+
+  unordered_map<string, PropertyKey>& registryKeys()
+  {
+    static unordered_map<string, PropertyKey> keys;
+    return keys;
+  }
+
+  deque<string>& registryNames()
+  {
+    static deque<string> names;
+    return names;
+  }
+}
+
+PropertyKey PropertyRegistry::getKey(const std::string& name)
+{
+  lock_guard<mutex> lock(registryMutex());
+  unordered_map<string, PropertyKey>& keys = registryKeys();
+  unordered_map<string, PropertyKey>::iterator it = keys.find(name);
+  if (it != keys.end())
+    return it->second;
+  PropertyKey key = static_cast<PropertyKey>(registryNames().size());
+  registryNames().push_back(name);
+  keys[name] = key;
+  return key;
+}
+
+bool PropertyRegistry::findKey(const std::string& name, PropertyKey& key)
+{
+  lock_guard<mutex> lock(registryMutex());
+  unordered_map<string, PropertyKey>& keys = registryKeys();
+  unordered_map<string, PropertyKey>::iterator it = keys.find(name);
+  if (it == keys.end())
+    return false;
+  key = it->second;
+  return true;
+}
+
+std::string PropertyRegistry::getName(PropertyKey key)
+{
+  lock_guard<mutex> lock(registryMutex());
+  deque<string>& names = registryNames();
+  if (key >= names.size())
+    throw IndexOutOfBoundsException("PropertyRegistry::getName. Invalid key.", key, 0, names.size());
+  return names[key];
+}
+
+/******************************************************************************/
+
+PropertyMap::PropertyMap(const PropertyMap& map) :
+  entries_(map.entries_)
+{
+  for (size_t i = 0; i < entries_.size(); ++i)
+  {
+    if (entries_[i].type == OBJECT)
+      entries_[i].object = entries_[i].object->clone();
+    entries_[i].cache.store(0);
+  }
+}
+
+PropertyMap& PropertyMap::operator=(const PropertyMap& map)
+{
+  if (this != &map)
+  {
+    deleteAll();
+    entries_ = map.entries_;
+    for (size_t i = 0; i < entries_.size(); ++i)
+    {
+      if (entries_[i].type == OBJECT)
+        entries_[i].object = entries_[i].object->clone();
+      entries_[i].cache.store(0);
+    }
+  }
+  return *this;
+}
+
+void PropertyMap::update(const PropertyMap& map)
+{
+  if (this == &map)
+    return;
+  for (size_t i = 0; i < map.entries_.size(); ++i)
+  {
+    const Entry& source = map.entries_[i];
+    Clonable* object = source.type == OBJECT ? source.object->clone() : 0;
+    Entry& entry = insert_(source.key);
+    entry.type = source.type;
+    entry.number = source.number;
+    entry.text = source.text;
+    entry.object = object;
+  }
+}
+
+/******************************************************************************/
+
+PropertyMap::Entry& PropertyMap::insert_(PropertyKey key)
+{
+  Entry* entry = find_(key);
+  if (entry)
+  {
+    deleteObjects_(*entry);
+    entry->text.clear();
+    return *entry;
+  }
+  entries_.push_back(Entry(key));
+  return entries_.back();
+}
+
+void PropertyMap::set(PropertyKey key, const Clonable& property)
+{
+  // Only the exact types are stored by value, so that they can be restored later on:
+  const type_info& type = typeid(property);
+  if (type == typeid(Number<double>))
+    setDouble(key, dynamic_cast<const Number<double>&>(property).getValue());
+  else if (type == typeid(BppInteger))
+    setInteger(key, dynamic_cast<const BppInteger&>(property).getValue());
+  else if (type == typeid(BppString))
+    setString(key, dynamic_cast<const BppString&>(property).toSTL());
+  else
+  {
+    Clonable* object = property.clone();
+    Entry& entry = insert_(key);
+    entry.type = OBJECT;
+    entry.object = object;
+  }
+}
+
+void PropertyMap::setDouble(PropertyKey key, double value)
+{
+  Entry& entry = insert_(key);
+  entry.type = DOUBLE;
+  entry.number = value;
+}
+
+void PropertyMap::setInteger(PropertyKey key, int value)
+{
+  Entry& entry = insert_(key);
+  entry.type = INTEGER;
+  entry.number = value;
+}
+
+void PropertyMap::setString(PropertyKey key, const std::string& value)
+{
+  Entry& entry = insert_(key);
+  entry.type = STRING;
+  entry.text = value;
+}
+
+/******************************************************************************/
+
+Clonable* PropertyMap::createObject_(const Entry& entry)
+{
+  switch (entry.type)
+  {
+  case DOUBLE:
+    return new Number<double>(entry.number);
+  case INTEGER:
+    return new BppInteger(static_cast<int>(entry.number));
+  case STRING:
+    return new BppString(entry.text);
+  case OBJECT:
+    break;
+  }
+  return entry.object;
+}
+
+Clonable* PropertyMap::toObject_(Entry& entry)
+{
+  if (entry.type != OBJECT)
+  {
+    // An object already returned by the const accessor is reused, so that its address does not change:
+    Clonable* cached = entry.cache.exchange(0);
+    entry.object = cached ? cached : createObject_(entry);
+    entry.text.clear();
+    entry.type = OBJECT;
+  }
+  return entry.object;
+}
+
+void PropertyMap::deleteObjects_(Entry& entry)
+{
+  if (entry.type == OBJECT)
+    delete entry.object;
+  entry.object = 0;
+  delete entry.cache.exchange(0);
+}
+
+Clonable* PropertyMap::get(PropertyKey key)
+{
+  Entry* entry = find_(key);
+  return entry ? toObject_(*entry) : 0;
+}
+
+const Clonable* PropertyMap::get(PropertyKey key) const
+{
+  const Entry* entry = find_(key);
+  if (!entry)
+    return 0;
+  if (entry->type == OBJECT)
+    return entry->object;
+  Clonable* cached = entry->cache.load();
+  if (cached)
+    return cached;
+  // Concurrent readers may both create an object, but only one is kept:
+  Clonable* object = createObject_(*entry);
+  if (!entry->cache.compare_exchange_strong(cached, object))
+  {
+    delete object;
+    return cached;
+  }
+  return object;
+}
+
+bool PropertyMap::getDouble(PropertyKey key, double& value) const
+{
+  const Entry* entry = find_(key);
+  if (!entry)
+    return false;
+  if (entry->type == DOUBLE || entry->type == INTEGER)
+  {
+    value = entry->number;
+    return true;
+  }
+  const Number<double>* d = entry->type == OBJECT ? dynamic_cast<const Number<double>*>(entry->object) : 0;
+  if (d)
+  {
+    value = d->getValue();
+    return true;
+  }
+  const Number<int>* i = entry->type == OBJECT ? dynamic_cast<const Number<int>*>(entry->object) : 0;
+  if (!i)
+    throw Exception("PropertyMap::getDouble. Property '" + PropertyRegistry::getName(key) + "' is not a number.");
+  value = i->getValue();
+  return true;
+}
+
+bool PropertyMap::getInteger(PropertyKey key, int& value) const
+{
+  const Entry* entry = find_(key);
+  if (!entry)
+    return false;
+  if (entry->type == INTEGER)
+  {
+    value = static_cast<int>(entry->number);
+    return true;
+  }
+  const Number<int>* i = entry->type == OBJECT ? dynamic_cast<const Number<int>*>(entry->object) : 0;
+  if (!i)
+    throw Exception("PropertyMap::getInteger. Property '" + PropertyRegistry::getName(key) + "' is not an integer.");
+  value = i->getValue();
+  return true;
+}
+
+bool PropertyMap::getString(PropertyKey key, std::string& value) const
+{
+  const Entry* entry = find_(key);
+  if (!entry)
+    return false;
+  if (entry->type == STRING)
+  {
+    value = entry->text;
+    return true;
+  }
+  const BppString* s = entry->type == OBJECT ? dynamic_cast<const BppString*>(entry->object) : 0;
+  if (!s)
+    throw Exception("PropertyMap::getString. Property '" + PropertyRegistry::getName(key) + "' is not a string.");
+  value = s->toSTL();
+  return true;
+}
+
+/******************************************************************************/
+
+Clonable* PropertyMap::release(PropertyKey key)
+{
+  Entry* entry = find_(key);
+  if (!entry)
+    return 0;
+  Clonable* object = toObject_(*entry);
+  entries_.erase(entries_.begin() + (entry - &entries_[0]));
+  return object;
+}
+
+bool PropertyMap::erase(PropertyKey key)
+{
+  Entry* entry = find_(key);
+  if (!entry)
+    return false;
+  deleteObjects_(*entry);
+  entries_.erase(entries_.begin() + (entry - &entries_[0]));
+  return true;
+}
+
+void PropertyMap::deleteAll()
+{
+  for (size_t i = 0; i < entries_.size(); ++i)
+  {
+    deleteObjects_(entries_[i]);
+  }
+  entries_.clear();
+}
+
+vector<string> PropertyMap::getNames() const
+{
+  vector<string> names(entries_.size());
+  for (size_t i = 0; i < entries_.size(); ++i)
+  {
+    names[i] = PropertyRegistry::getName(entries_[i].key);
+  }
+  sort(names.begin(), names.end());
+  return names;
+}
+
+vector<PropertyKey> PropertyMap::getKeys() const
+{
+  vector<PropertyKey> keys(entries_.size());
+  for (size_t i = 0; i < entries_.size(); ++i)
+  {
+    keys[i] = entries_[i].key;
+  }
+  return keys;
+}
+
+PropertyMap::Type PropertyMap::getType(PropertyKey key) const
+{
+  const Entry* entry = find_(key);
+  if (!entry)
+    throw Exception("PropertyMap::getType. No property '" + PropertyRegistry::getName(key) + "'.");
+  if (entry->type != OBJECT)
+    return entry->type;
+  const type_info& type = typeid(*entry->object);
+  if (type == typeid(Number<double>))
+    return DOUBLE;
+  if (type == typeid(BppInteger))
+    return INTEGER;
+  if (type == typeid(BppString))
+    return STRING;
+  return OBJECT;
+}
@@ -0,0 +1,303 @@
+//
+// File: PropertyMap.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _PROPERTYMAP_H_
+#define _PROPERTYMAP_H_
+
+#include <Bpp/Clonable.h>
+
+// From the STL:
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace bpp
+{
+
+/**
+ * @brief Integer identifier of a property name.
+ *
+ * @see PropertyRegistry
+ */
+typedef unsigned int PropertyKey;
+
+/**
+ * @brief Global table of property names.
+ *
+ * Each property name is associated to a unique integer key, which is valid
+ * for the whole life of the program. Code accessing the same property on many
+ * nodes should get the key once, and then use the key-based methods of the
+ * Node class, which do not involve any string comparison.
+ *
+ * All methods are thread-safe.
+ */
+class PropertyRegistry
+{
+  public:
+    /**
+     * @return The key associated to a property name. A new key is created if the name was never seen before.
+     * @param name The name of the property.
+     */
+    static PropertyKey getKey(const std::string& name);
+
+    /**
+     * @brief Look for the key of a property name, without registering it.
+     *
+     * @param name The name of the property.
+     * @param key  [out] The key of the property, if found.
+     * @return True if the name has already been registered.
+     */
+    static bool findKey(const std::string& name, PropertyKey& key);
+
+    /**
+     * @return The name associated to a key.
+     * @param key A key returned by getKey.
+     * @throw IndexOutOfBoundsException If the key is not valid.
+     */
+    static std::string getName(PropertyKey key);
+};
+
+/**
+ * @brief Flat storage for node and branch properties.
+ *
+ * Properties are stored in a small vector indexed by PropertyKey.
+ * Properties of the most common types (Number<double>, BppInteger and
+ * BppString) are stored by value, without any heap-allocated object, so
+ * that copying a map does not clone them one by one. Other properties are
+ * stored as Clonable objects, as before.
+ *
+ * When a value property is accessed as a Clonable object, the corresponding
+ * object is created, so that the returned pointer remains valid until the
+ * property is modified or removed. The non-const accessor replaces the value by
+ * the object, so that changes made through the pointer are kept. The const
+ * accessor leaves the value as is, and keeps the object aside: it is created
+ * only once, atomically, so that all const methods are safe to use concurrently.
+ */
+class PropertyMap
+{
+  public:
+    /**
+     * @brief Storage types of the properties.
+     *
+     * DOUBLE, INTEGER and STRING correspond to Number<double>, BppInteger and
+     * BppString properties, OBJECT to any other Clonable object.
+     */
+    enum Type { OBJECT, DOUBLE, INTEGER, STRING };
+
+  private:
+
+    struct Entry
+    {
+      PropertyKey key;
+      Type type;
+      double number;
+      std::string text;
+      Clonable* object;
+      // Object created by the const accessor for a property stored by value:
+      mutable std::atomic<Clonable*> cache;
+
+      Entry(PropertyKey k) :
+        key(k), type(DOUBLE), number(0), text(), object(0), cache(0) {}
+
+      // Shallow copies: the objects are owned, and cloned if needed, by the PropertyMap.
+      Entry(const Entry& entry) :
+        key(entry.key), type(entry.type), number(entry.number), text(entry.text), object(entry.object), cache(entry.cache.load()) {}
+
+      Entry& operator=(const Entry& entry)
+      {
+        key = entry.key;
+        type = entry.type;
+        number = entry.number;
+        text = entry.text;
+        object = entry.object;
+        cache.store(entry.cache.load());
+        return *this;
+      }
+    };
+
+    std::vector<Entry> entries_;
+
+  public:
+    PropertyMap() : entries_() {}
+
+    PropertyMap(const PropertyMap& map);
+
+    PropertyMap& operator=(const PropertyMap& map);
+
+    virtual ~PropertyMap() { deleteAll(); }
+
+  public:
+    bool empty() const { return entries_.empty(); }
+
+    size_t size() const { return entries_.size(); }
+
+    bool has(PropertyKey key) const { return find_(key) != 0; }
+
+    /**
+     * @brief Set a property from an object.
+     *
+     * The object is copied: by value if possible, using its clone() method otherwise.
+     */
+    void set(PropertyKey key, const Clonable& property);
+
+    void setDouble(PropertyKey key, double value);
+
+    void setInteger(PropertyKey key, int value);
+
+    void setString(PropertyKey key, const std::string& value);
+
+    /**
+     * @brief Copy all properties of another map.
+     *
+     * Properties with the same keys are replaced, and the other ones are kept.
+     */
+    void update(const PropertyMap& map);
+
+    /**
+     * @return The property as an object, or 0 if there is no such property.
+     * A property stored by value is replaced by the returned object.
+     */
+    Clonable* get(PropertyKey key);
+
+    /**
+     * @return The property as an object, or 0 if there is no such property.
+     * A property stored by value is kept as is, and the returned object is
+     * created the first time only.
+     */
+    const Clonable* get(PropertyKey key) const;
+
+    /**
+     * @brief Get a numerical property.
+     *
+     * @param key   The key of the property.
+     * @param value [out] The value of the property, if found.
+     * @return False if there is no such property.
+     * @throw Exception If the property is not a number.
+     */
+    bool getDouble(PropertyKey key, double& value) const;
+
+    /**
+     * @brief Get an integer property.
+     *
+     * @see getDouble
+     * @throw Exception If the property is not an integer.
+     */
+    bool getInteger(PropertyKey key, int& value) const;
+
+    /**
+     * @brief Get a string property.
+     *
+     * @see getDouble
+     * @throw Exception If the property is not a BppString.
+     */
+    bool getString(PropertyKey key, std::string& value) const;
+
+    /**
+     * @brief Remove a property from the map, without deleting it.
+     *
+     * @return The property as an object, now owned by the caller, or 0 if there is no such property.
+     */
+    Clonable* release(PropertyKey key);
+
+    /**
+     * @brief Remove and delete a property.
+     *
+     * @return False if there is no such property.
+     */
+    bool erase(PropertyKey key);
+
+    /**
+     * @brief Remove all properties, without deleting the objects, including the ones returned by the const accessor.
+     */
+    void releaseAll() { entries_.clear(); }
+
+    /**
+     * @brief Remove and delete all properties.
+     */
+    void deleteAll();
+
+    /**
+     * @return The names of all properties, in alphabetical order.
+     */
+    std::vector<std::string> getNames() const;
+
+    /**
+     * @return The keys of all properties, in insertion order.
+     */
+    std::vector<PropertyKey> getKeys() const;
+
+    /**
+     * @return The type of a property. Objects of exactly one of the value
+     * types, created by get(), are reported with this type, not as OBJECT.
+     * @param key The key of the property.
+     * @throw Exception If there is no such property.
+     */
+    Type getType(PropertyKey key) const;
+
+  private:
+    Entry* find_(PropertyKey key)
+    {
+      for (size_t i = 0; i < entries_.size(); ++i)
+      {
+        if (entries_[i].key == key) return &entries_[i];
+      }
+      return 0;
+    }
+
+    const Entry* find_(PropertyKey key) const
+    {
+      for (size_t i = 0; i < entries_.size(); ++i)
+      {
+        if (entries_[i].key == key) return &entries_[i];
+      }
+      return 0;
+    }
+
+    Entry& insert_(PropertyKey key);
+
+    static Clonable* createObject_(const Entry& entry);
+
+    static Clonable* toObject_(Entry& entry);
+
+    static void deleteObjects_(Entry& entry);
+};
+
+} // end of namespace bpp.
+
+#endif // _PROPERTYMAP_H_
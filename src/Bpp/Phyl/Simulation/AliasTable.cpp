@@ -0,0 +1,101 @@
+//
+// File: AliasTable.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include "AliasTable.h"
+
+#include <Bpp/Exceptions.h>
+
+using namespace bpp;
+using namespace std;
+
+/******************************************************************************/
+
+AliasTable::AliasTable(const vector<double>& weights) :
+  probabilities_(weights.size()),
+  aliases_(weights.size())
+{
+  size_t n = weights.size();
+  if (n == 0)
+    throw Exception("AliasTable. The distribution has no outcome.");
+  double sum = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    if (weights[i] > 0) sum += weights[i];
+  }
+  if (!(sum > 0))
+    throw Exception("AliasTable. All probabilities are null.");
+
+  // Scale probabilities so that they average to one, and sort columns in under- and overfull:
+  vector<size_t> small, large;
+  for (size_t i = 0; i < n; i++)
+  {
+    probabilities_[i] = weights[i] > 0 ? weights[i] * static_cast<double>(n) / sum : 0.;
+    aliases_[i] = static_cast<uint32_t>(i);
+    if (probabilities_[i] < 1.)
+      small.push_back(i);
+    else
+      large.push_back(i);
+  }
+  // Fill each underfull column with the excess of an overfull one:
+  while (!small.empty() && !large.empty())
+  {
+    size_t s = small.back();
+    small.pop_back();
+    size_t l = large.back();
+    aliases_[s] = static_cast<uint32_t>(l);
+    probabilities_[l] -= 1. - probabilities_[s];
+    if (probabilities_[l] < 1.)
+    {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // Remaining columns are full, up to rounding errors:
+  for (size_t i = 0; i < large.size(); i++)
+  {
+    probabilities_[large[i]] = 1.;
+  }
+  for (size_t i = 0; i < small.size(); i++)
+  {
+    probabilities_[small[i]] = 1.;
+  }
+}
+
+/******************************************************************************/
+
@@ -0,0 +1,109 @@
+//
+// File: AliasTable.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _ALIASTABLE_H_
+#define _ALIASTABLE_H_
+
+// From the STL:
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace bpp
+{
+
+/**
+ * @brief Alias table for sampling from a discrete distribution in constant time.
+ *
+ * The table is built in linear time with the method of Vose (1991): each of
+ * the n outcomes owns a column, which also holds the excess probability of
+ * at most one other outcome, its alias.
+ * A draw then costs a single uniform random number, which is used to choose
+ * the column and, with its remaining bits, to choose between the outcome and
+ * its alias. This is much faster than a scan of the cumulative distribution
+ * when the number of outcomes is large, as for codon models for instance.
+ *
+ * @see Vose MD (1991), A linear algorithm for generating random numbers with
+ * a given distribution, IEEE Transactions on Software Engineering 17(9):972-975.
+ */
+class AliasTable
+{
+  private:
+    std::vector<double> probabilities_;
+    std::vector<uint32_t> aliases_;
+
+  public:
+    AliasTable() : probabilities_(), aliases_() {}
+
+    /**
+     * @brief Build the table of a distribution.
+     *
+     * @param weights The probabilities of each outcome. They do not need to sum
+     * to one, and negative values, which may arise from rounding errors, are
+     * considered as null.
+     * @throw Exception If there are no outcomes, or if all weights are null.
+     */
+    AliasTable(const std::vector<double>& weights);
+
+  public:
+    /**
+     * @return The number of outcomes of the distribution.
+     */
+    size_t getNumberOfOutcomes() const { return probabilities_.size(); }
+
+    /**
+     * @brief Draw an outcome.
+     *
+     * @param u A random number uniformly distributed in [0, 1).
+     * @return The index of the outcome.
+     */
+    size_t draw(double u) const
+    {
+      size_t n = probabilities_.size();
+      double x = u * static_cast<double>(n);
+      size_t i = static_cast<size_t>(x);
+      if (i >= n) i = n - 1;
+      return x - static_cast<double>(i) < probabilities_[i] ? i : aliases_[i];
+    }
+};
+
+} //end of namespace bpp.
+
+#endif //_ALIASTABLE_H_
+
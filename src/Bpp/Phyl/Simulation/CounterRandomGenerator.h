@@ -0,0 +1,182 @@
+//
+// File: CounterRandomGenerator.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _COUNTERRANDOMGENERATOR_H_
+#define _COUNTERRANDOMGENERATOR_H_
+
+// From the STL:
+#include <cstddef>
+#include <cmath>
+#include <stdint.h>
+
+namespace bpp
+{
+
+/**
+ * @brief Counter-based random number generator.
+ *
+ * This generator implements the Philox4x32-10 function of Salmon et al (2011):
+ * the n-th block of random bits of a stream is a bijective function of
+ * (n, stream), keyed by a seed, so that the generator has no state apart
+ * from a counter.
+ * Independent streams are therefore obtained for free, one per site or per
+ * task for instance, and the numbers drawn in one stream do not depend on the
+ * order in which streams are used or on how they are shared between threads.
+ *
+ * Unlike RandomTools, this class is not a global generator: each instance
+ * should be used by a single thread.
+ *
+ * @see Salmon JK, Moraes MA, Dror RO and Shaw DE (2011), Parallel random numbers:
+ * as easy as 1, 2, 3, Proceedings of the International Conference for High
+ * Performance Computing, Networking, Storage and Analysis.
+ */
+class CounterRandomGenerator
+{
+  private:
+    uint32_t key_[2];
+    uint32_t counter_[4];
+    uint32_t buffer_[4];
+    size_t position_;
+
+  public:
+    /**
+     * @param seed   The key of the generator.
+     * @param stream The index of the stream to draw numbers from.
+     */
+    CounterRandomGenerator(uint64_t seed, uint64_t stream = 0) :
+      key_(), counter_(), buffer_(), position_(4)
+    {
+      key_[0] = static_cast<uint32_t>(seed);
+      key_[1] = static_cast<uint32_t>(seed >> 32);
+      setStream(stream);
+    }
+
+  public:
+    /**
+     * @brief Start over at the beginning of another stream, with the same seed.
+     *
+     * @param stream The index of the new stream.
+     */
+    void setStream(uint64_t stream)
+    {
+      counter_[0] = 0;
+      counter_[1] = 0;
+      counter_[2] = static_cast<uint32_t>(stream);
+      counter_[3] = static_cast<uint32_t>(stream >> 32);
+      position_ = 4;
+    }
+
+    /**
+     * @return 32 random bits.
+     */
+    uint32_t drawWord()
+    {
+      if (position_ == 4)
+      {
+        philox(counter_, key_, buffer_);
+        if (++counter_[0] == 0) ++counter_[1];
+        position_ = 0;
+      }
+      return buffer_[position_++];
+    }
+
+    /**
+     * @return A random number uniformly distributed in [0, 1), with 53 random bits.
+     */
+    double drawNumber()
+    {
+      uint32_t a = drawWord() >> 5;
+      uint32_t b = drawWord() >> 6;
+      return (static_cast<double>(a) * 67108864. + static_cast<double>(b)) / 9007199254740992.;
+    }
+
+    /**
+     * @param n The upper bound.
+     * @return A random integer uniformly distributed in [0, n).
+     */
+    size_t drawInteger(size_t n)
+    {
+      size_t i = static_cast<size_t>(drawNumber() * static_cast<double>(n));
+      return i < n ? i : n - 1;
+    }
+
+    /**
+     * @param mean The mean of the distribution.
+     * @return A random number drawn from an exponential distribution.
+     */
+    double drawExponential(double mean)
+    {
+      return -mean * std::log(1. - drawNumber());
+    }
+
+    /**
+     * @brief The Philox4x32-10 bijection.
+     *
+     * @param counter The counter to encrypt.
+     * @param key     The key.
+     * @param result  [out] The 128 resulting random bits.
+     */
+    static void philox(const uint32_t counter[4], const uint32_t key[2], uint32_t result[4])
+    {
+      uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+      uint32_t k0 = key[0], k1 = key[1];
+      for (unsigned int r = 0; r < 10; ++r)
+      {
+        uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+        uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+        uint32_t hi0 = static_cast<uint32_t>(p0 >> 32), lo0 = static_cast<uint32_t>(p0);
+        uint32_t hi1 = static_cast<uint32_t>(p1 >> 32), lo1 = static_cast<uint32_t>(p1);
+        c0 = hi1 ^ c1 ^ k0;
+        c1 = lo1;
+        c2 = hi0 ^ c3 ^ k1;
+        c3 = lo0;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+      }
+      result[0] = c0;
+      result[1] = c1;
+      result[2] = c2;
+      result[3] = c3;
+    }
+};
+
+} //end of namespace bpp.
+
+#endif //_COUNTERRANDOMGENERATOR_H_
+
@@ -86,6 +86,25 @@ double AbstractMutationProcess::getTimeBeforeNextMutationEvent(size_t state) con
 
 /******************************************************************************/
 
+size_t AbstractMutationProcess::mutate(size_t state, CounterRandomGenerator& generator) const
+{
+  double alea = generator.drawNumber();
+  for (size_t j = 0; j < size_; j++)
+  {
+    if (alea < repartition_[state][j]) return j;
+  }
+  throw Exception("AbstractMutationProcess::mutate. Repartition function is incomplete for state " + TextTools::toString(state));
+}
+
+/******************************************************************************/
+
+double AbstractMutationProcess::getTimeBeforeNextMutationEvent(size_t state, CounterRandomGenerator& generator) const
+{
+  return generator.drawExponential(-1. / model_->Qij(state, state));
+}
+
+/******************************************************************************/
+
 size_t AbstractMutationProcess::evolve(size_t initialState, double time) const
 {
   double t = 0;
@@ -119,6 +138,24 @@ MutationPath AbstractMutationProcess::detailedEvolve(size_t initialState, double
 
 /******************************************************************************/
 
+MutationPath AbstractMutationProcess::detailedEvolve(size_t initialState, double time, CounterRandomGenerator& generator) const
+{
+  MutationPath mp(model_->getAlphabet(), initialState, time);
+  double t = 0;
+  size_t currentState = initialState;
+
+  t += getTimeBeforeNextMutationEvent(currentState, generator);
+  while (t < time)
+  {
+    currentState = mutate(currentState, generator);
+    mp.addEvent(currentState, t);
+    t += getTimeBeforeNextMutationEvent(currentState, generator);
+  }
+  return mp;
+}
+
+/******************************************************************************/
+
 SimpleMutationProcess::SimpleMutationProcess(const SubstitutionModel* model) :
   AbstractMutationProcess(model)
 {
@@ -42,6 +42,7 @@ knowledge of the CeCILL license and that you accept its terms.
 
 #include "../Model/SubstitutionModel.h"
 #include "../Mapping/SubstitutionRegister.h"
+#include "CounterRandomGenerator.h"
 
 #include <Bpp/Numeric/VectorTools.h>
 
@@ -235,6 +236,23 @@ class MutationProcess
      * @return A random time before next mutation event.
      */
     virtual double getTimeBeforeNextMutationEvent(size_t state) const = 0;
+
+    /**
+     * @brief The same as mutate(state), but drawing random numbers from a given generator.
+     *
+     * @param state     The current state of the character.
+     * @param generator The random number generator to use.
+     */
+    virtual size_t mutate(size_t state, CounterRandomGenerator& generator) const = 0;
+
+    /**
+     * @brief The same as getTimeBeforeNextMutationEvent(state), but drawing random numbers from a given generator.
+     *
+     * @param state     The actual state of the chain;
+     * @param generator The random number generator to use.
+     * @return A random time before next mutation event.
+     */
+    virtual double getTimeBeforeNextMutationEvent(size_t state, CounterRandomGenerator& generator) const = 0;
     
     /**
      * @brief Simulation a character evolution during a specified time
@@ -257,6 +275,20 @@ class MutationProcess
      */
     virtual MutationPath detailedEvolve(size_t initialState, double time) const = 0;
 
+    /**
+     * @brief The same as detailedEvolve(initialState, time), but drawing
+     * random numbers from a given generator instead of RandomTools.
+     *
+     * This method does not modify the process, and can hence be called
+     * concurrently with distinct generators.
+     *
+     * @param initialState The state before beginning evolution.
+     * @param time         The time during which evolution must occure.
+     * @param generator    The random number generator to use.
+     * @return The resulting mutation path.
+     */
+    virtual MutationPath detailedEvolve(size_t initialState, double time, CounterRandomGenerator& generator) const = 0;
+
     /**
      * @brief Get the substitution model associated to the mutation process.
      *
@@ -324,8 +356,11 @@ class AbstractMutationProcess :
     size_t mutate(size_t state) const;
     size_t mutate(size_t state, unsigned int n) const;
     double getTimeBeforeNextMutationEvent(size_t state) const;
+    size_t mutate(size_t state, CounterRandomGenerator& generator) const;
+    double getTimeBeforeNextMutationEvent(size_t state, CounterRandomGenerator& generator) const;
     size_t evolve(size_t initialState, double time) const;
     MutationPath detailedEvolve(size_t initialState, double time) const;
+    MutationPath detailedEvolve(size_t initialState, double time, CounterRandomGenerator& generator) const;
     const SubstitutionModel* getSubstitutionModel() const { return model_; }
 };
 
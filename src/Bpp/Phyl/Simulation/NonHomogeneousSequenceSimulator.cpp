@@ -49,6 +49,9 @@
 // From SeqLib:
 #include <Bpp/Seq/Container/VectorSiteContainer.h>
 
+// From the STL:
+#include <algorithm>
+
 using namespace bpp;
 using namespace std;
 
@@ -71,7 +74,15 @@ NonHomogeneousSequenceSimulator::NonHomogeneousSequenceSimulator(
   nbClasses_(rate_->getNumberOfCategories()),
   nbStates_(modelSet_->getNumberOfStates()),
   continuousRates_(false),
-  outputInternalSequences_(false)
+  outputInternalSequences_(false),
+  aliasSampling_(false),
+  rootCumFreqs_(),
+  rootAlias_(),
+  preorder_(),
+  fatherPositions_(),
+  modelIndices_(),
+  outputPositions_(),
+  outputModels_()
 {
   if (!modelSet->isFullySetUpFor(*tree))
     throw Exception("NonHomogeneousSequenceSimulator(constructor). Model set is not fully specified.");
@@ -97,7 +108,15 @@ NonHomogeneousSequenceSimulator::NonHomogeneousSequenceSimulator(
   nbClasses_(rate_->getNumberOfCategories()),
   nbStates_(model->getNumberOfStates()),
   continuousRates_(false),
-  outputInternalSequences_(false)
+  outputInternalSequences_(false),
+  aliasSampling_(false),
+  rootCumFreqs_(),
+  rootAlias_(),
+  preorder_(),
+  fatherPositions_(),
+  modelIndices_(),
+  outputPositions_(),
+  outputModels_()
 {
   FixedFrequencySet* fSet = new FixedFrequencySet(model->shareStateMap(), model->getFrequencies());
   fSet->setNamespace("anc.");
@@ -158,26 +177,112 @@ void NonHomogeneousSequenceSimulator::init()
       }
     }
   }
+
+  rootCumFreqs_ = modelSet_->getRootFrequencies();
+  for (size_t i = 1; i < rootCumFreqs_.size(); i++)
+  {
+    rootCumFreqs_[i] += rootCumFreqs_[i - 1];
+  }
+  if (aliasSampling_)
+    initAliasTables_();
+
+  // Flatten the tree for the seeded simulations:
+  preorder_.clear();
+  fatherPositions_.clear();
+  modelIndices_.clear();
+  initPreorder_(tree_.getRootNode(), 0);
+  initOutput_();
 }
 
 /******************************************************************************/
 
-Site* NonHomogeneousSequenceSimulator::simulateSite() const
+void NonHomogeneousSequenceSimulator::initAliasTables_()
 {
-  // Draw an initial state randomly according to equilibrum frequencies:
-  size_t initialStateIndex = 0;
-  double r = RandomTools::giveRandomNumberBetweenZeroAndEntry(1.);
-  double cumprob = 0;
-  vector<double> freqs = modelSet_->getRootFrequencies();
-  for (size_t i = 0; i < nbStates_; i++)
+  rootAlias_ = AliasTable(modelSet_->getRootFrequencies());
+  vector<SNode*> nodes = tree_.getNodes();
+  for (size_t i = 0; i < nodes.size(); i++)
   {
-    cumprob += freqs[i];
-    if (r <= cumprob)
+    if (!nodes[i]->hasFather()) continue;
+    SimData& data = nodes[i]->getInfos();
+    data.aliases.resize(nbClasses_);
+    for (size_t c = 0; c < nbClasses_; c++)
     {
-      initialStateIndex = i;
-      break;
+      data.aliases[c].resize(nbStates_);
+      for (size_t x = 0; x < nbStates_; x++)
+      {
+        // Recover the transition probabilities from their cumulative values:
+        const Vdouble& cumpxy = data.cumpxy[c][x];
+        Vdouble pxy(nbStates_);
+        pxy[0] = cumpxy[0];
+        for (size_t y = 1; y < nbStates_; y++)
+        {
+          pxy[y] = cumpxy[y] - cumpxy[y - 1];
+        }
+        data.aliases[c][x] = AliasTable(pxy);
+      }
     }
   }
+}
+
+/******************************************************************************/
+
+void NonHomogeneousSequenceSimulator::enableAliasSampling(bool yn)
+{
+  if (yn == aliasSampling_) return;
+  aliasSampling_ = yn;
+  if (aliasSampling_)
+    initAliasTables_();
+  else
+  {
+    rootAlias_ = AliasTable();
+    vector<SNode*> nodes = tree_.getNodes();
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+      vector< vector<AliasTable> >().swap(nodes[i]->getInfos().aliases);
+    }
+  }
+}
+
+/******************************************************************************/
+
+void NonHomogeneousSequenceSimulator::initPreorder_(const SNode* node, size_t fatherPosition)
+{
+  size_t position = preorder_.size();
+  preorder_.push_back(node);
+  fatherPositions_.push_back(fatherPosition);
+  modelIndices_.push_back(node->hasFather() ? modelSet_->getModelIndexForNode(node->getId()) : 0);
+  for (size_t i = 0; i < node->getNumberOfSons(); i++)
+  {
+    initPreorder_(node->getSon(i), position);
+  }
+}
+
+/******************************************************************************/
+
+void NonHomogeneousSequenceSimulator::initOutput_()
+{
+  map<const SNode*, size_t> positions;
+  for (size_t i = 0; i < preorder_.size(); i++)
+  {
+    positions[preorder_[i]] = i;
+  }
+  vector<SNode*> nodes = outputInternalSequences_ ? tree_.getNodes() : leaves_;
+  outputPositions_.resize(nodes.size());
+  outputModels_.resize(nodes.size());
+  for (size_t i = 0; i < nodes.size(); i++)
+  {
+    outputPositions_[i] = positions[nodes[i]];
+    // The root has no model, so we take the one of the previous node in the output:
+    outputModels_[i] = (nodes[i]->hasFather() || i == 0) ? nodes[i]->getInfos().model : nodes[i - 1]->getInfos().model;
+  }
+}
+
+/******************************************************************************/
+
+Site* NonHomogeneousSequenceSimulator::simulateSite() const
+{
+  // Draw an initial state randomly according to equilibrum frequencies:
+  size_t initialStateIndex = drawRootState_(RandomTools::giveRandomNumberBetweenZeroAndEntry(1.));
   return simulateSite(initialStateIndex);
 }
 
@@ -284,19 +389,7 @@ Site* NonHomogeneousSequenceSimulator::simulateSite(size_t ancestralStateIndex,
 Site* NonHomogeneousSequenceSimulator::simulateSite(double rate) const
 {
   // Draw an initial state randomly according to equilibrum frequencies:
-  size_t ancestralStateIndex = 0;
-  double r = RandomTools::giveRandomNumberBetweenZeroAndEntry(1.);
-  double cumprob = 0;
-  vector<double> freqs = modelSet_->getRootFrequencies();
-  for (size_t i = 0; i < nbStates_; i++)
-  {
-    cumprob += freqs[i];
-    if (r <= cumprob)
-    {
-      ancestralStateIndex = i;
-      break;
-    }
-  }
+  size_t ancestralStateIndex = drawRootState_(RandomTools::giveRandomNumberBetweenZeroAndEntry(1.));
   // Make this state evolve:
   return simulateSite(ancestralStateIndex, rate);
 }
@@ -308,18 +401,7 @@ SiteContainer* NonHomogeneousSequenceSimulator::simulate(size_t numberOfSites) c
   vector<size_t> ancestralStateIndices(numberOfSites, 0);
   for (size_t j = 0; j < numberOfSites; j++)
   {
-    double r = RandomTools::giveRandomNumberBetweenZeroAndEntry(1.);
-    double cumprob = 0;
-    vector<double> freqs = modelSet_->getRootFrequencies();
-    for (size_t i = 0; i < nbStates_; i++)
-    {
-      cumprob += freqs[i];
-      if (r <= cumprob)
-      {
-        ancestralStateIndices[j] = i;
-        break;
-      }
-    }
+    ancestralStateIndices[j] = drawRootState_(RandomTools::giveRandomNumberBetweenZeroAndEntry(1.));
   }
   if (continuousRates_)
   {
@@ -355,19 +437,7 @@ SiteContainer* NonHomogeneousSequenceSimulator::simulate(size_t numberOfSites) c
 RASiteSimulationResult* NonHomogeneousSequenceSimulator::dSimulateSite() const
 {
   // Draw an initial state randomly according to equilibrum frequencies:
-  size_t ancestralStateIndex = 0;
-  double r = RandomTools::giveRandomNumberBetweenZeroAndEntry(1.);
-  double cumprob = 0;
-  vector<double> freqs = modelSet_->getRootFrequencies();
-  for (size_t i = 0; i < nbStates_; i++)
-  {
-    cumprob += freqs[i];
-    if (r <= cumprob)
-    {
-      ancestralStateIndex = i;
-      break;
-    }
-  }
+  size_t ancestralStateIndex = drawRootState_(RandomTools::giveRandomNumberBetweenZeroAndEntry(1.));
 
   return dSimulateSite(ancestralStateIndex);
 }
@@ -412,19 +482,7 @@ RASiteSimulationResult* NonHomogeneousSequenceSimulator::dSimulateSite(size_t an
 RASiteSimulationResult* NonHomogeneousSequenceSimulator::dSimulateSite(double rate) const
 {
   // Draw an initial state randomly according to equilibrum frequencies:
-  size_t ancestralStateIndex = 0;
-  double r = RandomTools::giveRandomNumberBetweenZeroAndEntry(1.);
-  double cumprob = 0;
-  vector<double> freqs = modelSet_->getRootFrequencies();
-  for (size_t i = 0; i < nbStates_; i++)
-  {
-    cumprob += freqs[i];
-    if (r <= cumprob)
-    {
-      ancestralStateIndex = i;
-      break;
-    }
-  }
+  size_t ancestralStateIndex = drawRootState_(RandomTools::giveRandomNumberBetweenZeroAndEntry(1.));
   return dSimulateSite(ancestralStateIndex, rate);
 }
 
@@ -432,13 +490,7 @@ RASiteSimulationResult* NonHomogeneousSequenceSimulator::dSimulateSite(double ra
 
 size_t NonHomogeneousSequenceSimulator::evolve(const SNode* node, size_t initialStateIndex, size_t rateClass) const
 {
-  const Vdouble* cumpxy_node_c_x_ = &node->getInfos().cumpxy[rateClass][initialStateIndex];
-  double rand = RandomTools::giveRandomNumberBetweenZeroAndEntry(1.);
-  for (size_t y = 0; y < nbStates_; y++)
-  {
-    if (rand < (*cumpxy_node_c_x_)[y]) return y;
-  }
-  throw Exception("HomogeneousSequenceSimulator::evolve. The impossible happened! rand = " + TextTools::toString(rand) + ".");
+  return drawState_(node->getInfos(), rateClass, initialStateIndex, RandomTools::giveRandomNumberBetweenZeroAndEntry(1.));
 }
 
 /******************************************************************************/
@@ -466,19 +518,10 @@ void NonHomogeneousSequenceSimulator::multipleEvolve(
     const vector<size_t>& rateClasses,
     std::vector<size_t>& finalStateIndices) const
 {
-  const VVVdouble* cumpxy_node_ = &node->getInfos().cumpxy;
+  const SimData& data = node->getInfos();
   for (size_t i = 0; i < initialStateIndices.size(); i++)
   {
-    const Vdouble* cumpxy_node_c_x_ = &(*cumpxy_node_)[rateClasses[i]][initialStateIndices[i]];
-    double rand = RandomTools::giveRandomNumberBetweenZeroAndEntry(1.);
-    for (size_t y = 0; y < nbStates_; y++)
-    {
-      if (rand < (*cumpxy_node_c_x_)[y])
-      {
-        finalStateIndices[i] = y;
-        break;
-      }
-    }
+    finalStateIndices[i] = drawState_(data, rateClasses[i], initialStateIndices[i], RandomTools::giveRandomNumberBetweenZeroAndEntry(1.));
   }
 }
 
@@ -516,78 +559,126 @@ void NonHomogeneousSequenceSimulator::evolveInternal(SNode* node, double rate) c
 
 /******************************************************************************/
 
-void NonHomogeneousSequenceSimulator::multipleEvolveInternal(SNode* node, const vector<size_t>& rateClasses) const
+SiteContainer* NonHomogeneousSequenceSimulator::multipleEvolve(
+    const std::vector<size_t>& initialStateIndices,
+    const vector<size_t>& rateClasses) const
 {
-  if (!node->hasFather())
+  size_t nbSites = initialStateIndices.size();
+  vector< vector<int> > contents(outputPositions_.size(), vector<int>(nbSites));
+  if (nbStates_ <= 256)
+    multipleEvolve_<uint8_t>(initialStateIndices, rateClasses, contents);
+  else
+    multipleEvolve_<uint16_t>(initialStateIndices, rateClasses, contents);
+
+  // Now create a SiteContainer object:
+  AlignedSequenceContainer* sites = new AlignedSequenceContainer(alphabet_);
+  for (size_t k = 0; k < contents.size(); k++)
   {
-    cerr << "DEBUG: NonHomogeneousSequenceSimulator::multipleEvolveInternal. Forbidden call of method on root node." << endl;
-    return;
+    sites->addSequence(BasicSequence(seqNames_[k], contents[k], alphabet_), false);
+    vector<int>().swap(contents[k]); // free memory as soon as possible
   }
-  const vector<size_t>* initialStates = &node->getFather()->getInfos().states;
-  size_t n = initialStates->size();
-  node->getInfos().states.resize(n); // allocation.
-  multipleEvolve(node, node->getFather()->getInfos().states, rateClasses, node->getInfos().states);
-  for (size_t i = 0; i < node->getNumberOfSons(); i++)
+  return sites;
+}
+
+/******************************************************************************/
+
+template<class T>
+void NonHomogeneousSequenceSimulator::multipleEvolve_(
+    const vector<size_t>& initialStateIndices,
+    const vector<size_t>& rateClasses,
+    vector< vector<int> >& contents) const
+{
+  size_t nbSites = initialStateIndices.size();
+  size_t nbNodes = preorder_.size();
+  size_t chunkSize = 4096;
+  vector<size_t> chunkClasses;
+  vector<double> uniforms;
+  vector<T> nodeStates;
+  for (size_t first = 0; first < nbSites; first += chunkSize)
   {
-    multipleEvolveInternal(node->getSon(i), rateClasses);
+    size_t n = min(chunkSize, nbSites - first);
+    chunkClasses.assign(rateClasses.begin() + static_cast<ptrdiff_t>(first), rateClasses.begin() + static_cast<ptrdiff_t>(first + n));
+    nodeStates.resize(nbNodes * n);
+    for (size_t j = 0; j < n; j++)
+    {
+      nodeStates[j] = static_cast<T>(initialStateIndices[first + j]);
+    }
+    uniforms.resize((nbNodes - 1) * n);
+    for (size_t i = 0; i < uniforms.size(); i++)
+    {
+      uniforms[i] = RandomTools::giveRandomNumberBetweenZeroAndEntry(1.);
+    }
+    evolveSites_(chunkClasses, n, uniforms, nodeStates);
+    for (size_t k = 0; k < contents.size(); k++)
+    {
+      const T* states = &nodeStates[outputPositions_[k] * n];
+      for (size_t j = 0; j < n; j++)
+      {
+        contents[k][first + j] = outputModels_[k]->getAlphabetStateAsInt(states[j]);
+      }
+    }
   }
 }
 
 /******************************************************************************/
 
-SiteContainer* NonHomogeneousSequenceSimulator::multipleEvolve(
-    const std::vector<size_t>& initialStateIndices,
-    const vector<size_t>& rateClasses) const
+template<class T>
+void NonHomogeneousSequenceSimulator::evolveSites_(
+    const vector<size_t>& rateClasses,
+    size_t nbSites,
+    const vector<double>& uniforms,
+    vector<T>& states) const
 {
-  // Launch recursion:
-  SNode* root = tree_.getRootNode();
-  root->getInfos().states = initialStateIndices;
-  for (size_t i = 0; i < root->getNumberOfSons(); i++)
+  // Bucket sites by rate class, so that each branch and class uses a single set of tables:
+  vector<size_t> classStarts(nbClasses_ + 1, 0);
+  for (size_t j = 0; j < nbSites; j++)
   {
-    multipleEvolveInternal(root->getSon(i), rateClasses);
+    classStarts[rateClasses[j] + 1]++;
   }
-  // Now create a SiteContainer object:
-  AlignedSequenceContainer* sites = new AlignedSequenceContainer(alphabet_);
-  size_t nbSites = initialStateIndices.size();
-  const TransitionModel* model = 0;
-  if (outputInternalSequences_) {
-    vector<SNode*> nodes = tree_.getNodes();
-    size_t n = nbNodes_ + 1 ;
-    for (size_t i = 0; i < n; i++)
+  for (size_t c = 0; c < nbClasses_; c++)
+  {
+    classStarts[c + 1] += classStarts[c];
+  }
+  vector<size_t> order(nbSites);
+  vector<size_t> next(classStarts.begin(), classStarts.end() - 1);
+  for (size_t j = 0; j < nbSites; j++)
+  {
+    order[next[rateClasses[j]]++] = j;
+  }
+
+  for (size_t i = 1; i < preorder_.size(); i++)
+  {
+    const SimData& data = preorder_[i]->getInfos();
+    const T* fatherStates = &states[fatherPositions_[i] * nbSites];
+    T* nodeStates = &states[i * nbSites];
+    const double* u = &uniforms[(i - 1) * nbSites];
+    for (size_t c = 0; c < nbClasses_; c++)
     {
-      vector<int> content(nbSites);
-      vector<size_t>& states = nodes[i]->getInfos().states;
-      if (i == n - 1) { // If at the root, there is no model, so we take the model of node n-1.
-        model = nodes[i-1]->getInfos().model;
-      }
-      else {
-        model = nodes[i]->getInfos().model;
-      }
-      for (size_t j = 0; j < nbSites; j++)
+      if (aliasSampling_)
       {
-        content[j] = model->getAlphabetStateAsInt(states[j]);
+        const vector<AliasTable>& tables = data.aliases[c];
+        for (size_t k = classStarts[c]; k < classStarts[c + 1]; k++)
+        {
+          size_t j = order[k];
+          nodeStates[j] = static_cast<T>(tables[fatherStates[j]].draw(u[j]));
+        }
       }
-      if (nodes[i]->isLeaf())
-        sites->addSequence(BasicSequence(nodes[i]->getName(), content, alphabet_), false);
       else
-        sites->addSequence(BasicSequence(TextTools::toString(nodes[i]->getId()), content, alphabet_), false);
-    }
-  }
-    else {
-    size_t n = leaves_.size();
-    for (size_t i = 0; i < n; i++)
-    {
-      vector<int> content(nbSites);
-      vector<size_t>& states = leaves_[i]->getInfos().states;
-      model = leaves_[i]->getInfos().model;
-      for (size_t j = 0; j < nbSites; j++)
       {
-        content[j] = model->getAlphabetStateAsInt(states[j]);
+        const VVdouble& cumpxy = data.cumpxy[c];
+        for (size_t k = classStarts[c]; k < classStarts[c + 1]; k++)
+        {
+          size_t j = order[k];
+          const Vdouble& row = cumpxy[fatherStates[j]];
+          size_t y = 0;
+          while (y < nbStates_ && !(u[j] < row[y])) y++;
+          if (y == nbStates_)
+            throw Exception("NonHomogeneousSequenceSimulator::evolveSites_. The impossible happened! rand = " + TextTools::toString(u[j]) + ".");
+          nodeStates[j] = static_cast<T>(y);
+        }
       }
-      sites->addSequence(BasicSequence(leaves_[i]->getName(), content, alphabet_), false);
     }
   }
-  return sites;
 }
 
 /******************************************************************************/
@@ -655,6 +746,359 @@ void NonHomogeneousSequenceSimulator::outputInternalSequences(bool yn) {
       seqNames_[i] = leaves_[i]->getName();
     }
   }
+  initOutput_();
+}
+
+/******************************************************************************/
+
+SiteContainer* NonHomogeneousSequenceSimulator::simulate(size_t numberOfSites, uint64_t seed) const
+{
+  return simulate_(numberOfSites, 0, 0, seed);
+}
+
+/******************************************************************************/
+
+SiteContainer* NonHomogeneousSequenceSimulator::simulate(const vector<double>& rates, uint64_t seed) const
+{
+  return simulate_(rates.size(), &rates, 0, seed);
+}
+
+/******************************************************************************/
+
+SiteContainer* NonHomogeneousSequenceSimulator::simulate(const vector<double>& rates, const vector<size_t>& states, uint64_t seed) const
+{
+  if (states.size() != rates.size())
+    throw Exception("NonHomogeneousSequenceSimulator::simulate. 'rates' and 'states' must have the same length.");
+  return simulate_(rates.size(), &rates, &states, seed);
+}
+
+/******************************************************************************/
+
+SiteContainer* NonHomogeneousSequenceSimulator::simulate(const vector<size_t>& states, uint64_t seed) const
+{
+  return simulate_(states.size(), 0, &states, seed);
+}
+
+/******************************************************************************/
+
+SiteContainer* NonHomogeneousSequenceSimulator::simulate_(
+    size_t numberOfSites,
+    const vector<double>* rates,
+    const vector<size_t>* states,
+    uint64_t seed) const
+{
+  SimulatedSiteBlock block;
+  simulateBlock_(0, numberOfSites, rates, states, seed, block);
+
+  // Now create a SiteContainer object:
+  AlignedSequenceContainer* sites = new AlignedSequenceContainer(alphabet_);
+  vector<int> content(numberOfSites);
+  for (size_t k = 0; k < outputPositions_.size(); k++)
+  {
+    const uint16_t* codes = block.getStates(k);
+    for (size_t j = 0; j < numberOfSites; j++)
+    {
+      content[j] = outputModels_[k]->getAlphabetStateAsInt(codes[j]);
+    }
+    sites->addSequence(BasicSequence(seqNames_[k], content, alphabet_), false);
+  }
+  return sites;
+}
+
+/******************************************************************************/
+
+void NonHomogeneousSequenceSimulator::simulate(size_t numberOfSites, uint64_t seed, SimulatedSiteBlock& states) const
+{
+  simulateBlock_(0, numberOfSites, 0, 0, seed, states);
+}
+
+/******************************************************************************/
+
+void NonHomogeneousSequenceSimulator::simulate(size_t numberOfSites, uint64_t seed, SimulationSink& sink, size_t blockSize) const
+{
+  if (blockSize == 0)
+    throw Exception("NonHomogeneousSequenceSimulator::simulate. Block size must be positive.");
+  sink.begin(seqNames_, outputModels_, numberOfSites);
+  SimulatedSiteBlock block;
+  for (size_t first = 0; first < numberOfSites; first += blockSize)
+  {
+    simulateBlock_(first, min(blockSize, numberOfSites - first), 0, 0, seed, block);
+    sink.addBlock(block);
+  }
+  sink.end();
+}
+
+/******************************************************************************/
+
+void NonHomogeneousSequenceSimulator::simulateBlock_(
+    size_t firstSite,
+    size_t numberOfSites,
+    const vector<double>* rates,
+    const vector<size_t>* states,
+    uint64_t seed,
+    SimulatedSiteBlock& block) const
+{
+  if (nbStates_ > 65536)
+    throw Exception("NonHomogeneousSequenceSimulator::simulateBlock_. Too many states for a compact output.");
+  bool continuous = rates || continuousRates_;
+  if (!continuous)
+  {
+    if (nbStates_ <= 256)
+      simulateBlock_<uint8_t>(firstSite, numberOfSites, states, seed, block);
+    else
+      simulateBlock_<uint16_t>(firstSite, numberOfSites, states, seed, block);
+    return;
+  }
+  size_t nbOutput = outputPositions_.size();
+  block.resize(firstSite, nbOutput, numberOfSites);
+
+  // Sites are processed by chunks, but each site has its own random stream:
+  size_t chunkSize = 256;
+  size_t nbChunks = (numberOfSites + chunkSize - 1) / chunkSize;
+  vector<string> errors(nbChunks);
+  long nb = static_cast<long>(nbChunks);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    vector<size_t> siteStates(preorder_.size());
+    vector< unique_ptr<TransitionModel> > models;
+    for (size_t i = 0; i < modelSet_->getNumberOfModels(); i++)
+    {
+      models.push_back(unique_ptr<TransitionModel>(modelSet_->getModel(i)->clone()));
+    }
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (long lc = 0; lc < nb; ++lc)
+    {
+      size_t c = static_cast<size_t>(lc);
+      try
+      {
+        size_t end = min(numberOfSites, (c + 1) * chunkSize);
+        for (size_t j = c * chunkSize; j < end; j++)
+        {
+          size_t site = firstSite + j;
+          CounterRandomGenerator generator(seed, site);
+          siteStates[0] = states ? (*states)[site] : drawRootState_(generator.drawNumber());
+          evolveSite_(rates ? (*rates)[site] : drawRate_(generator), models, generator, siteStates);
+          for (size_t k = 0; k < nbOutput; k++)
+          {
+            block.setState(k, j, siteStates[outputPositions_[k]]);
+          }
+        }
+      }
+      catch (exception& e)
+      {
+        errors[c] = e.what();
+      }
+    }
+  }
+  for (size_t i = 0; i < errors.size(); i++)
+  {
+    if (!errors[i].empty())
+      throw Exception(errors[i]);
+  }
+}
+
+/******************************************************************************/
+
+template<class T>
+void NonHomogeneousSequenceSimulator::simulateBlock_(
+    size_t firstSite,
+    size_t numberOfSites,
+    const vector<size_t>* states,
+    uint64_t seed,
+    SimulatedSiteBlock& block) const
+{
+  size_t nbNodes = preorder_.size();
+  size_t nbOutput = outputPositions_.size();
+  block.resize(firstSite, nbOutput, numberOfSites);
+
+  // Sites are processed by chunks, but each site has its own random stream.
+  // The numbers are drawn in the same order as in a site by site simulation:
+  // root state, rate class, then branches in pre-order.
+  size_t chunkSize = 256;
+  size_t nbChunks = (numberOfSites + chunkSize - 1) / chunkSize;
+  vector<string> errors(nbChunks);
+  long nb = static_cast<long>(nbChunks);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    vector<size_t> rateClasses(chunkSize);
+    vector<double> uniforms((nbNodes - 1) * chunkSize);
+    vector<T> nodeStates(nbNodes * chunkSize);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (long lc = 0; lc < nb; ++lc)
+    {
+      size_t c = static_cast<size_t>(lc);
+      try
+      {
+        size_t first = c * chunkSize;
+        size_t n = min(chunkSize, numberOfSites - first);
+        for (size_t j = 0; j < n; j++)
+        {
+          size_t site = firstSite + first + j;
+          CounterRandomGenerator generator(seed, site);
+          nodeStates[j] = static_cast<T>(states ? (*states)[site] : drawRootState_(generator.drawNumber()));
+          rateClasses[j] = generator.drawInteger(nbClasses_);
+          for (size_t i = 1; i < nbNodes; i++)
+          {
+            uniforms[(i - 1) * n + j] = generator.drawNumber();
+          }
+        }
+        evolveSites_(rateClasses, n, uniforms, nodeStates);
+        for (size_t k = 0; k < nbOutput; k++)
+        {
+          const T* codes = &nodeStates[outputPositions_[k] * n];
+          for (size_t j = 0; j < n; j++)
+          {
+            block.setState(k, first + j, codes[j]);
+          }
+        }
+      }
+      catch (exception& e)
+      {
+        errors[c] = e.what();
+      }
+    }
+  }
+  for (size_t i = 0; i < errors.size(); i++)
+  {
+    if (!errors[i].empty())
+      throw Exception(errors[i]);
+  }
+}
+
+/******************************************************************************/
+
+vector<RASiteSimulationResult*> NonHomogeneousSequenceSimulator::dSimulateSites(size_t numberOfSites, uint64_t seed) const
+{
+  // Mutation processes do not change during simulation, and can be shared:
+  vector< unique_ptr<SimpleMutationProcess> > processes(modelSet_->getNumberOfModels());
+  for (size_t i = 0; i < processes.size(); i++)
+  {
+    const SubstitutionModel* model = dynamic_cast<const SubstitutionModel*>(modelSet_->getModel(i));
+    if (!model)
+      throw Exception("NonHomogeneousSequenceSimulator::dSimulateSites : detailed simulation not possible for non-markovian model");
+    processes[i].reset(new SimpleMutationProcess(model));
+  }
+
+  vector<RASiteSimulationResult*> results(numberOfSites, 0);
+  size_t blockSize = 256;
+  size_t nbBlocks = (numberOfSites + blockSize - 1) / blockSize;
+  vector<string> errors(nbBlocks);
+  long nb = static_cast<long>(nbBlocks);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    vector<size_t> siteStates(preorder_.size());
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (long lb = 0; lb < nb; ++lb)
+    {
+      size_t b = static_cast<size_t>(lb);
+      try
+      {
+        size_t end = min(numberOfSites, (b + 1) * blockSize);
+        for (size_t j = b * blockSize; j < end; j++)
+        {
+          CounterRandomGenerator generator(seed, j);
+          siteStates[0] = drawRootState_(generator.drawNumber());
+          double rate = continuousRates_ ? drawRate_(generator) : rate_->getCategory(generator.drawInteger(nbClasses_));
+          results[j] = new RASiteSimulationResult(templateTree_, alphabet_, siteStates[0], rate);
+          // Nodes are visited in the same order as in dEvolve:
+          for (size_t i = 1; i < preorder_.size(); i++)
+          {
+            const SNode* node = preorder_[i];
+            MutationPath mp = processes[modelIndices_[i]]->detailedEvolve(siteStates[fatherPositions_[i]], node->getDistanceToFather() * rate, generator);
+            siteStates[i] = mp.getFinalState();
+            results[j]->addNode(node->getId(), mp);
+          }
+        }
+      }
+      catch (exception& e)
+      {
+        errors[b] = e.what();
+      }
+    }
+  }
+  for (size_t i = 0; i < errors.size(); i++)
+  {
+    if (!errors[i].empty())
+    {
+      for (size_t j = 0; j < results.size(); j++)
+      {
+        delete results[j];
+      }
+      throw Exception(errors[i]);
+    }
+  }
+  return results;
+}
+
+/******************************************************************************/
+
+size_t NonHomogeneousSequenceSimulator::drawRootState_(double r) const
+{
+  if (aliasSampling_)
+    return rootAlias_.draw(r);
+  for (size_t i = 0; i < nbStates_; i++)
+  {
+    if (r <= rootCumFreqs_[i])
+      return i;
+  }
+  return 0;
+}
+
+/******************************************************************************/
+
+size_t NonHomogeneousSequenceSimulator::drawState_(const SimData& data, size_t rateClass, size_t initialStateIndex, double rand) const
+{
+  if (aliasSampling_)
+    return data.aliases[rateClass][initialStateIndex].draw(rand);
+  const Vdouble& cumpxy = data.cumpxy[rateClass][initialStateIndex];
+  for (size_t y = 0; y < nbStates_; y++)
+  {
+    if (rand < cumpxy[y]) return y;
+  }
+  throw Exception("NonHomogeneousSequenceSimulator::drawState_. The impossible happened! rand = " + TextTools::toString(rand) + ".");
+}
+
+/******************************************************************************/
+
+double NonHomogeneousSequenceSimulator::drawRate_(CounterRandomGenerator& generator) const
+{
+  // Inverse transform sampling within the bounds of the distribution:
+  double pMin = rate_->pProb(rate_->getLowerBound());
+  double pMax = rate_->pProb(rate_->getUpperBound());
+  return rate_->qProb(pMin + generator.drawNumber() * (pMax - pMin));
+}
+
+/******************************************************************************/
+
+void NonHomogeneousSequenceSimulator::evolveSite_(double rate, const vector< unique_ptr<TransitionModel> >& models, CounterRandomGenerator& generator, vector<size_t>& states) const
+{
+  for (size_t i = 1; i < preorder_.size(); i++)
+  {
+    const Matrix<double>& P = models[modelIndices_[i]]->getPij_t(rate * preorder_[i]->getDistanceToFather());
+    size_t x = states[fatherPositions_[i]];
+    double rand = generator.drawNumber();
+    double cumpxy = 0;
+    size_t y = 0;
+    while (y < nbStates_ && !(rand < (cumpxy += P(x, y))))
+    {
+      y++;
+    }
+    if (y == nbStates_)
+      throw Exception("NonHomogeneousSequenceSimulator::evolveSite_. The impossible happened! rand = " + TextTools::toString(rand) + ".");
+    states[i] = y;
+  }
 }
 
 /******************************************************************************/
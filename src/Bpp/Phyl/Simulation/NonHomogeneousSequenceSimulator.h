@@ -43,6 +43,9 @@ knowledge of the CeCILL license and that you accept its terms.
 
 #include "DetailedSiteSimulator.h"
 #include "SequenceSimulator.h"
+#include "CounterRandomGenerator.h"
+#include "AliasTable.h"
+#include "SimulationSink.h"
 #include "../TreeTemplate.h"
 #include "../NodeTemplate.h"
 #include "../Model/SubstitutionModel.h"
@@ -57,6 +60,7 @@ knowledge of the CeCILL license and that you accept its terms.
 
 // From the STL:
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "../Model/SubstitutionModelSet.h"
@@ -68,19 +72,19 @@ class SimData
 {
   public:
     size_t state;
-    std::vector<size_t> states;
     VVVdouble cumpxy;
+    std::vector< std::vector<AliasTable> > aliases;
     const TransitionModel* model;
 
   public:
-    SimData(): state(), states(), cumpxy(), model(0) {}
-    SimData(const SimData& sd): state(sd.state), states(sd.states), cumpxy(), model(sd.model) {}
+    SimData(): state(), cumpxy(), aliases(), model(0) {}
+    SimData(const SimData& sd): state(sd.state), cumpxy(), aliases(), model(sd.model) {}
     SimData& operator=(const SimData& sd)
     {
-      state  = sd.state;
-      states = sd.states;
-      cumpxy = sd.cumpxy;
-      model  = sd.model;
+      state   = sd.state;
+      cumpxy  = sd.cumpxy;
+      aliases = sd.aliases;
+      model   = sd.model;
       return *this;
     }
 };
@@ -91,6 +95,9 @@ typedef NodeTemplate<SimData> SNode;
  * @brief Site and sequences simulation under non-homogeneous models.
  *
  * Rate across sites variation is supported, using a DiscreteDistribution object or by specifying explicitely the rate of the sites to simulate.
+ *
+ * Seeded methods are also provided, which simulate sites in parallel and
+ * reproducibly, independently of the RandomTools generator.
  */
 class NonHomogeneousSequenceSimulator:
   public DetailedSiteSimulator,
@@ -122,6 +129,34 @@ class NonHomogeneousSequenceSimulator:
     // Should we ouptut internal sequences as well?
     bool outputInternalSequences_;
 
+    /**
+     * @brief Should we draw states from alias tables instead of cumulative probabilities?
+     */
+    bool aliasSampling_;
+
+    std::vector<double> rootCumFreqs_;
+    AliasTable rootAlias_;
+
+    /**
+     * @name The tree in pre-order, for the seeded simulation methods.
+     *
+     * The root comes first, and every node after its father, so that a site
+     * can be simulated in a single pass, with local states only.
+     *
+     * @{
+     */
+    std::vector<const SNode*> preorder_;
+    std::vector<size_t> fatherPositions_;
+    std::vector<size_t> modelIndices_;
+    /** @} */
+
+    /**
+     * @brief For each output sequence, the position of the corresponding node
+     * in preorder_, and the model used to convert its states.
+     */
+    std::vector<size_t> outputPositions_;
+    std::vector<const TransitionModel*> outputModels_;
+
     /**
      * @name Stores intermediate results.
      *
@@ -147,38 +182,53 @@ class NonHomogeneousSequenceSimulator:
     }
 
     NonHomogeneousSequenceSimulator(const NonHomogeneousSequenceSimulator& nhss) :
-      modelSet_       (nhss.modelSet_),
+      modelSet_       (nhss.ownModelSet_ ? nhss.modelSet_->clone() : nhss.modelSet_),
       alphabet_       (nhss.alphabet_),
       supportedStates_(nhss.supportedStates_),
       rate_           (nhss.rate_),
       templateTree_   (nhss.templateTree_),
       tree_           (nhss.tree_),
       ownModelSet_    (nhss.ownModelSet_),
-      leaves_         (nhss.leaves_),
+      leaves_         (tree_.getLeaves()),
       seqNames_       (nhss.seqNames_),
       nbNodes_        (nhss.nbNodes_),
       nbClasses_      (nhss.nbClasses_),
       nbStates_       (nhss.nbStates_),
       continuousRates_(nhss.continuousRates_),
-      outputInternalSequences_(nhss.outputInternalSequences_)
-    {}
+      outputInternalSequences_(nhss.outputInternalSequences_),
+      aliasSampling_  (nhss.aliasSampling_),
+      rootCumFreqs_   (),
+      rootAlias_      (),
+      preorder_       (),
+      fatherPositions_(),
+      modelIndices_   (),
+      outputPositions_(),
+      outputModels_   ()
+    {
+      // Node data are not copied with the tree:
+      init();
+    }
 
     NonHomogeneousSequenceSimulator& operator=(const NonHomogeneousSequenceSimulator& nhss)
     {
-      modelSet_        = nhss.modelSet_;
+      if (this == &nhss) return *this;
+      if (ownModelSet_ && modelSet_) delete modelSet_;
+      modelSet_        = nhss.ownModelSet_ ? nhss.modelSet_->clone() : nhss.modelSet_;
       alphabet_        = nhss.alphabet_;
       supportedStates_ = nhss.supportedStates_;
       rate_            = nhss.rate_;
       templateTree_    = nhss.templateTree_;
       tree_            = nhss.tree_;
       ownModelSet_     = nhss.ownModelSet_;
-      leaves_          = nhss.leaves_;
+      leaves_          = tree_.getLeaves();
       seqNames_        = nhss.seqNames_;
       nbNodes_         = nhss.nbNodes_;
       nbClasses_       = nhss.nbClasses_;
       nbStates_        = nhss.nbStates_;
       continuousRates_ = nhss.continuousRates_;
       outputInternalSequences_ = nhss.outputInternalSequences_;
+      aliasSampling_   = nhss.aliasSampling_;
+      init();
       return *this;
     }
 
@@ -192,6 +242,12 @@ class NonHomogeneousSequenceSimulator:
      */
     void init();
 
+    void initPreorder_(const SNode* node, size_t fatherPosition);
+
+    void initOutput_();
+
+    void initAliasTables_();
+
   public:
 
     /**
@@ -232,6 +288,94 @@ class NonHomogeneousSequenceSimulator:
     SiteContainer* simulate(size_t numberOfSites) const;
     /** @} */
 
+    /**
+     * @name Seeded simulations.
+     *
+     * These methods do not use RandomTools: the random numbers of site i are
+     * drawn from stream i of a CounterRandomGenerator built with the given
+     * seed. Sites are simulated in parallel when OpenMP is enabled, and the
+     * result is bit-identical whatever the number of threads.
+     *
+     * With continuous rates, each thread works with its own copy of the models,
+     * as computing transition probabilities is not thread-safe.
+     *
+     * @{
+     */
+
+    /**
+     * @brief Simulate sites with random ancestral states and rates.
+     *
+     * @param numberOfSites The number of sites to simulate.
+     * @param seed          The seed of the random streams.
+     * @return A container with all simulated sites.
+     */
+    SiteContainer* simulate(size_t numberOfSites, uint64_t seed) const;
+
+    /**
+     * @brief Simulate sites with given rates and random ancestral states.
+     *
+     * @param rates The rates to use, one for each site to simulate.
+     * @param seed  The seed of the random streams.
+     * @return A container with all simulated sites.
+     */
+    SiteContainer* simulate(const std::vector<double>& rates, uint64_t seed) const;
+
+    /**
+     * @brief Simulate sites with given rates and ancestral states.
+     *
+     * @param rates  The rates to use, one for each site to simulate.
+     * @param states The ancestral states to use, one for each site to simulate.
+     * @param seed   The seed of the random streams.
+     * @return A container with all simulated sites.
+     */
+    SiteContainer* simulate(const std::vector<double>& rates, const std::vector<size_t>& states, uint64_t seed) const;
+
+    /**
+     * @brief Simulate sites with given ancestral states and random rates.
+     *
+     * @param states The ancestral states to use, one for each site to simulate.
+     * @param seed   The seed of the random streams.
+     * @return A container with all simulated sites.
+     */
+    SiteContainer* simulate(const std::vector<size_t>& states, uint64_t seed) const;
+
+    /**
+     * @brief Get detailed simulation results for several sites.
+     *
+     * @param numberOfSites The number of sites to simulate.
+     * @param seed          The seed of the random streams.
+     * @return A vector of newly created results, one per site.
+     */
+    std::vector<RASiteSimulationResult*> dSimulateSites(size_t numberOfSites, uint64_t seed) const;
+
+    /**
+     * @brief Simulate sites into a compact buffer of states.
+     *
+     * Sites are the same as with simulate(numberOfSites, seed), but no Site
+     * or Sequence object is created: the buffer holds model state indices,
+     * one row per output sequence, which is suitable for in-process
+     * computations.
+     *
+     * @param numberOfSites The number of sites to simulate.
+     * @param seed          The seed of the random streams.
+     * @param states        [out] The simulated states.
+     */
+    void simulate(size_t numberOfSites, uint64_t seed, SimulatedSiteBlock& states) const;
+
+    /**
+     * @brief Simulate sites by blocks, and pass each block to a sink as soon as it is produced.
+     *
+     * Memory use is bounded by the size of a block, whatever the number of
+     * sites. Sites are the same as with simulate(numberOfSites, seed).
+     *
+     * @param numberOfSites The number of sites to simulate.
+     * @param seed          The seed of the random streams.
+     * @param sink          The sink receiving the blocks.
+     * @param blockSize     The maximum number of sites in a block.
+     */
+    void simulate(size_t numberOfSites, uint64_t seed, SimulationSink& sink, size_t blockSize = 100000) const;
+    /** @} */
+
     /**
      * @name SiteSimulator and SequenceSimulator interface
      *
@@ -279,6 +423,29 @@ class NonHomogeneousSequenceSimulator:
      */
     void enableContinuousRates(bool yn) { continuousRates_ = yn; }
 
+    /**
+     * @brief Enable the use of alias tables to draw states.
+     *
+     * By default, states are drawn by scanning cumulative probabilities,
+     * which takes a time linear in the number of states.
+     * With this option, an alias table is built for each branch, rate class
+     * and parent state, as well as for the root frequencies, and each draw
+     * takes a constant time. This is faster for large state spaces, such as
+     * codons, at the cost of twice the memory.
+     *
+     * Transition probabilities are not precomputed with continuous rates,
+     * so that only the root state benefits from alias tables in this case.
+     *
+     * @param yn Tell if we should use alias tables.
+     * @see AliasTable
+     */
+    void enableAliasSampling(bool yn);
+
+    /**
+     * @return True if states are drawn from alias tables.
+     */
+    bool aliasSamplingEnabled() const { return aliasSampling_; }
+
     /**
      * @brief Sets whether we will output the internal sequences or not.
      *
@@ -321,6 +488,25 @@ class NonHomogeneousSequenceSimulator:
         const std::vector<size_t>& initialStates,
         const std::vector<size_t>& rateClasses) const;
 
+    /**
+     * @brief Evolve several sites along all branches, with states stored in a nodes x sites matrix.
+     *
+     * Sites are grouped by rate class, so that each branch and class is processed
+     * in a single loop sharing the same transition tables.
+     *
+     * @param rateClasses The rate class of each site.
+     * @param nbSites     The number of sites.
+     * @param uniforms    Random numbers uniformly distributed in [0, 1), one per branch and site,
+     * stored branch by branch in pre-order: the number of node i and site j is at (i - 1) * nbSites + j.
+     * @param states      [in, out] The states of all nodes, stored node by node in pre-order.
+     * The first row, for the root, must be set before calling this function.
+     */
+    template<class T>
+    void evolveSites_(const std::vector<size_t>& rateClasses, size_t nbSites, const std::vector<double>& uniforms, std::vector<T>& states) const;
+
+    template<class T>
+    void multipleEvolve_(const std::vector<size_t>& initialStates, const std::vector<size_t>& rateClasses, std::vector< std::vector<int> >& contents) const;
+
     void dEvolve(size_t initialState, double rate, RASiteSimulationResult& rassr) const;
 
     /**
@@ -337,10 +523,6 @@ class NonHomogeneousSequenceSimulator:
      * This method uses the states_ variable for saving ancestral states.
      */
     void evolveInternal(SNode* node, double rate) const;
-    /**
-     * This method uses the multipleStates_ variable for saving ancestral states.
-     */
-     void multipleEvolveInternal(SNode* node, const std::vector<size_t>& rateClasses) const;
 
     /**
      * This method uses the states_ variable for saving ancestral states.
@@ -348,6 +530,48 @@ class NonHomogeneousSequenceSimulator:
     void dEvolveInternal(SNode * node, double rate, RASiteSimulationResult & rassr) const;
     /** @} */
 
+    /**
+     * @brief Draw a root state, from the root frequencies.
+     *
+     * @param r A random number uniformly distributed in [0, 1).
+     */
+    size_t drawRootState_(double r) const;
+
+    /**
+     * @brief Draw the state at the end of a branch.
+     *
+     * @param data              The data of the node at the end of the branch.
+     * @param rateClass         The rate class of the site.
+     * @param initialStateIndex The state at the start of the branch.
+     * @param rand              A random number uniformly distributed in [0, 1).
+     */
+    size_t drawState_(const SimData& data, size_t rateClass, size_t initialStateIndex, double rand) const;
+
+    /**
+     * @name Thread-safe methods used by the seeded simulations.
+     *
+     * States are stored in a vector indexed by the positions in preorder_.
+     *
+     * @{
+     */
+    SiteContainer* simulate_(size_t numberOfSites, const std::vector<double>* rates, const std::vector<size_t>* states, uint64_t seed) const;
+
+    /**
+     * @brief Simulate sites firstSite to firstSite + numberOfSites - 1.
+     *
+     * Rates and ancestral states, if any, are indexed by site in the whole simulation.
+     */
+    void simulateBlock_(size_t firstSite, size_t numberOfSites, const std::vector<double>* rates, const std::vector<size_t>* states, uint64_t seed, SimulatedSiteBlock& block) const;
+
+
+    template<class T>
+    void simulateBlock_(size_t firstSite, size_t numberOfSites, const std::vector<size_t>* states, uint64_t seed, SimulatedSiteBlock& block) const;
+
+    double drawRate_(CounterRandomGenerator& generator) const;
+
+    void evolveSite_(double rate, const std::vector< std::unique_ptr<TransitionModel> >& models, CounterRandomGenerator& generator, std::vector<size_t>& states) const;
+    /** @} */
+
 };
 
 } //end of namespace bpp.
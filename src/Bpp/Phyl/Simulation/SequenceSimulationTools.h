@@ -53,6 +53,11 @@ namespace bpp
 
 /**
  * @brief Tools for sites and sequences simulation.
+ *
+ * These functions simulate sites one after the other using the global
+ * RandomTools generator. For reproducible simulations in parallel, see the
+ * seeded methods of NonHomogeneousSequenceSimulator, which also accept
+ * rates and ancestral states for each site.
  */
 class SequenceSimulationTools
 {
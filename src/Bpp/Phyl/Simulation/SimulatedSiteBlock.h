@@ -0,0 +1,132 @@
+//
+// File: SimulatedSiteBlock.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _SIMULATEDSITEBLOCK_H_
+#define _SIMULATEDSITEBLOCK_H_
+
+// From the STL:
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+namespace bpp
+{
+
+/**
+ * @brief Compact storage of simulated states, for a block of consecutive sites.
+ *
+ * States are stored as model state indices, that is, the indices used by
+ * TransitionModel objects and not alphabet codes, in a sequences x sites
+ * matrix of 16-bit integers, one row per sequence.
+ * This is four times smaller than Site objects, and rows can be handed
+ * directly to in-process computations.
+ */
+class SimulatedSiteBlock
+{
+  private:
+    size_t firstSite_;
+    size_t numberOfSequences_;
+    size_t numberOfSites_;
+    std::vector<uint16_t> states_;
+
+  public:
+    SimulatedSiteBlock() :
+      firstSite_(0),
+      numberOfSequences_(0),
+      numberOfSites_(0),
+      states_()
+    {}
+
+  public:
+    /**
+     * @brief Set the dimensions of the block.
+     *
+     * Memory is reused when the block is resized to a smaller size.
+     *
+     * @param firstSite         The index of the first site of the block, in the whole simulation.
+     * @param numberOfSequences The number of sequences.
+     * @param numberOfSites     The number of sites.
+     */
+    void resize(size_t firstSite, size_t numberOfSequences, size_t numberOfSites)
+    {
+      firstSite_ = firstSite;
+      numberOfSequences_ = numberOfSequences;
+      numberOfSites_ = numberOfSites;
+      states_.resize(numberOfSequences * numberOfSites);
+    }
+
+    /**
+     * @return The index of the first site of the block, in the whole simulation.
+     */
+    size_t getFirstSite() const { return firstSite_; }
+
+    size_t getNumberOfSequences() const { return numberOfSequences_; }
+
+    size_t getNumberOfSites() const { return numberOfSites_; }
+
+    /**
+     * @param sequence The index of the sequence.
+     * @param site     The index of the site, relative to the block.
+     * @return The model state index of the sequence at this site.
+     */
+    size_t getState(size_t sequence, size_t site) const
+    {
+      return states_[sequence * numberOfSites_ + site];
+    }
+
+    void setState(size_t sequence, size_t site, size_t state)
+    {
+      states_[sequence * numberOfSites_ + site] = static_cast<uint16_t>(state);
+    }
+
+    /**
+     * @param sequence The index of the sequence.
+     * @return A pointer toward the states of the sequence, for all sites in the block.
+     */
+    const uint16_t* getStates(size_t sequence) const
+    {
+      // Not &states_[...], which is undefined for a block without sites:
+      return states_.data() + sequence * numberOfSites_;
+    }
+};
+
+} //end of namespace bpp.
+
+#endif //_SIMULATEDSITEBLOCK_H_
+
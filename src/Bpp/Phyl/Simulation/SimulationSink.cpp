@@ -0,0 +1,112 @@
+//
+// File: SimulationSink.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include "SimulationSink.h"
+
+// From the STL:
+#include <algorithm>
+
+using namespace bpp;
+using namespace std;
+
+/******************************************************************************/
+
+void PhylipSimulationSink::begin(const vector<string>& names, const vector<const TransitionModel*>& models, size_t numberOfSites)
+{
+  if (names.size() != models.size())
+    throw Exception("PhylipSimulationSink::begin. There must be as many models as names.");
+  if (names.size() == 0)
+    throw Exception("PhylipSimulationSink::begin. No sequence to write.");
+  // Pad names, so that sequences are aligned:
+  size_t width = 0;
+  for (size_t i = 0; i < names.size(); i++)
+  {
+    width = max(width, names[i].size());
+  }
+  names_.resize(names.size());
+  for (size_t i = 0; i < names.size(); i++)
+  {
+    names_[i] = names[i] + string(width - names[i].size() + 2, ' ');
+  }
+  // Characters of each state, for each sequence:
+  characters_.resize(models.size());
+  for (size_t i = 0; i < models.size(); i++)
+  {
+    const Alphabet* alphabet = models[i]->getAlphabet();
+    characters_[i].resize(models[i]->getNumberOfStates());
+    for (size_t s = 0; s < characters_[i].size(); s++)
+    {
+      characters_[i][s] = alphabet->intToChar(models[i]->getAlphabetStateAsInt(s));
+    }
+  }
+  firstBlock_ = true;
+  *output_ << names.size() << " " << numberOfSites * models[0]->getAlphabet()->getStateCodingSize() << endl;
+}
+
+/******************************************************************************/
+
+void PhylipSimulationSink::addBlock(const SimulatedSiteBlock& block)
+{
+  if (!firstBlock_)
+    *output_ << "\n";
+  string line;
+  for (size_t i = 0; i < block.getNumberOfSequences(); i++)
+  {
+    line.clear();
+    if (firstBlock_)
+      line += names_[i];
+    const uint16_t* states = block.getStates(i);
+    for (size_t j = 0; j < block.getNumberOfSites(); j++)
+    {
+      line += characters_[i][states[j]];
+    }
+    *output_ << line << "\n";
+  }
+  firstBlock_ = false;
+}
+
+/******************************************************************************/
+
+void PhylipSimulationSink::end()
+{
+  output_->flush();
+}
+
+/******************************************************************************/
+
@@ -0,0 +1,139 @@
+//
+// File: SimulationSink.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _SIMULATIONSINK_H_
+#define _SIMULATIONSINK_H_
+
+#include "SimulatedSiteBlock.h"
+#include "../Model/SubstitutionModel.h"
+
+// From the STL:
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bpp
+{
+
+/**
+ * @brief The SimulationSink interface.
+ *
+ * A sink receives simulated sites block after block, as they are produced,
+ * so that large data sets can be processed or written without being stored
+ * as a whole.
+ *
+ * @see NonHomogeneousSequenceSimulator::simulate(size_t, uint64_t, SimulationSink&, size_t)
+ */
+class SimulationSink
+{
+  public:
+    SimulationSink() {}
+    virtual ~SimulationSink() {}
+
+  public:
+    /**
+     * @brief Called once, before the first block.
+     *
+     * @param names         The names of the simulated sequences.
+     * @param models        For each sequence, a model which can convert its states into alphabet states.
+     * @param numberOfSites The total number of sites that will be simulated.
+     */
+    virtual void begin(const std::vector<std::string>& names, const std::vector<const TransitionModel*>& models, size_t numberOfSites) = 0;
+
+    /**
+     * @brief Receive a block of sites.
+     *
+     * Blocks are sent in the order of the sites.
+     * The block is only valid during the call.
+     *
+     * @param block The simulated states.
+     */
+    virtual void addBlock(const SimulatedSiteBlock& block) = 0;
+
+    /**
+     * @brief Called once, after the last block.
+     */
+    virtual void end() = 0;
+};
+
+/**
+ * @brief A sink writing sites to a stream, in interleaved Phylip format.
+ *
+ * Each block is written as an interleaved block of the alignment, so that
+ * only one block has to be kept in memory. Names are written with the first
+ * block, and may be longer than 10 characters, as in the extended Phylip format.
+ */
+class PhylipSimulationSink:
+  public SimulationSink
+{
+  private:
+    std::ostream* output_;
+    std::vector<std::string> names_;
+    std::vector< std::vector<std::string> > characters_;
+    bool firstBlock_;
+
+  public:
+    /**
+     * @param output The stream to write to. It must exist during the whole simulation.
+     */
+    PhylipSimulationSink(std::ostream& output) :
+      output_(&output),
+      names_(),
+      characters_(),
+      firstBlock_(true)
+    {}
+
+    virtual ~PhylipSimulationSink() {}
+
+  private:
+    PhylipSimulationSink(const PhylipSimulationSink&);
+    PhylipSimulationSink& operator=(const PhylipSimulationSink&);
+
+  public:
+    void begin(const std::vector<std::string>& names, const std::vector<const TransitionModel*>& models, size_t numberOfSites);
+
+    void addBlock(const SimulatedSiteBlock& block);
+
+    void end();
+};
+
+} //end of namespace bpp.
+
+#endif //_SIMULATIONSINK_H_
+
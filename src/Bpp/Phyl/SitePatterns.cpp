@@ -45,6 +45,10 @@
 #include <Bpp/Seq/Container/VectorSiteContainer.h>
 
 using namespace bpp;
+
+// From the STL:
+#include <unordered_map>
+
 using namespace std;
 
 /******************************************************************************/
@@ -59,50 +63,73 @@ SitePatterns::SitePatterns(const SiteContainer* sequences, bool own) :
   own_(own)
 {
   size_t nbSites = sequences->getNumberOfSites();
-  vector<SortableSite> ss(nbSites);
+  // Containers may build sites on demand, so they are retrieved sequentially:
+  vector<const Site*> allSites(nbSites);
   for (size_t i = 0; i < nbSites; i++)
   {
-    const Site* currentSite = &sequences->getSite(i);
-    SortableSite* ssi = &ss[i];
-    ssi->siteS = currentSite->toString();
-    ssi->siteP = currentSite;
-    ssi->originalPosition = i;
+    allSites[i] = &sequences->getSite(i);
   }
 
-  if (nbSites > 0)
+  vector<size_t> hashes(nbSites);
+  long lnbSites = static_cast<long>(nbSites);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+  for (long li = 0; li < lnbSites; li++)
   {
-    // Quick sort according to site contents:
-    sort(ss.begin(), ss.end());
-
-    // Now build patterns:
-
-    SortableSite* ss0 = &ss[0];
-    const Site* previousSite = ss0->siteP;
-    indices_.resize(nbSites);
-    indices_[ss0->originalPosition] = 0;
-    sites_.push_back(previousSite);
-    weights_.push_back(1);
+    size_t i = static_cast<size_t>(li);
+    hashes[i] = hashSite_(allSites[i]->getContent());
+  }
 
-    unsigned int currentPos = 0;
-    for (unsigned int i = 1; i < nbSites; i++)
+  // Now build patterns. Patterns sharing the same hash are chained:
+  const size_t none = static_cast<size_t>(-1);
+  unordered_map<size_t, size_t> firstPatterns;
+  vector<size_t> nextPatterns;
+  indices_.resize(nbSites);
+  for (size_t i = 0; i < nbSites; i++)
+  {
+    const vector<int>& content = allSites[i]->getContent();
+    unordered_map<size_t, size_t>::iterator it = firstPatterns.find(hashes[i]);
+    size_t pos = none, last = none;
+    if (it != firstPatterns.end())
     {
-      SortableSite* ssi = &ss[i];
-      const Site* currentSite = ssi->siteP;
-      bool siteExists = SiteTools::areSitesIdentical(*currentSite, *previousSite);
-      if (siteExists)
+      for (size_t p = it->second; p != none; p = nextPatterns[p])
       {
-        weights_[currentPos]++;
+        if (sites_[p]->getContent() == content)
+        {
+          pos = p;
+          break;
+        }
+        last = p;
       }
+    }
+    if (pos == none)
+    {
+      pos = sites_.size();
+      sites_.push_back(allSites[i]);
+      weights_.push_back(0);
+      nextPatterns.push_back(none);
+      if (it == firstPatterns.end())
+        firstPatterns[hashes[i]] = pos;
       else
-      {
-        sites_.push_back(currentSite);
-        weights_.push_back(1);
-        currentPos++;
-      }
-      indices_[ssi->originalPosition] = currentPos;
-      previousSite = currentSite;
+        nextPatterns[last] = pos;
     }
+    weights_[pos]++;
+    indices_[i] = pos;
+  }
+}
+
+/******************************************************************************/
+
+size_t SitePatterns::hashSite_(const std::vector<int>& content)
+{
+  size_t h = content.size();
+  for (size_t i = 0; i < content.size(); i++)
+  {
+    // Combine as in boost::hash_combine:
+    h ^= static_cast<size_t>(static_cast<unsigned int>(content[i])) + 0x9e3779b9 + (h << 6) + (h >> 2);
   }
+  return h;
 }
 
 /******************************************************************************/
@@ -65,46 +65,15 @@ namespace bpp
  * 'sites' points toward a unique site
  * 'weights' is the number of sites identical to this sites
  * 'indices' are the positions in the original container
+ *
+ * Patterns are identified by hashing the integer content of each site, which
+ * is done in parallel if OpenMP is available. Sites with equal hashes are then
+ * compared element-wise, so that hash collisions do not merge distinct sites.
+ * Patterns are numbered according to their first occurrence in the container.
  */
 class SitePatterns :
   public virtual Clonable
 {
-  private:
-    /**
-     * @brief Class used for site pattern sorting.
-     */
-    class SortableSite
-    {
-	    public:
-        std::string siteS; 
-		    const Site* siteP;
-		    size_t originalPosition;
-	    
-      public:
-		    SortableSite() : siteS(), siteP(0), originalPosition(0) {}
-        SortableSite(const SortableSite& ss) : siteS(ss.siteS), siteP(ss.siteP), originalPosition(ss.originalPosition) {}
-        SortableSite& operator=(const SortableSite& ss)
-        {
-          siteS = ss.siteS;
-          siteP = ss.siteP;
-          originalPosition = ss.originalPosition;
-          return *this;
-        }
-
-        bool operator<(const SortableSite& ss) const { return siteS < ss.siteS; }
-
-		    virtual ~SortableSite() {}
-    };
-
-    ///**
-    // * @brief Class used for site pattern sorting.
-    // */
-    //struct SSComparator :
-    //  std::binary_function<SortableSite, SortableSite, bool>
-    //{
-	  //  bool operator()(const SortableSite& ss1, const SortableSite& ss2) const { return ss1.siteS < ss2.siteS; }
-    //};
-
   private: 
     std::vector<std::string> names_;
     std::vector<const Site *> sites_;
@@ -173,6 +142,9 @@ class SitePatterns :
      * @return A new container with each unique site.
      */
 		SiteContainer* getSites() const;
+
+  private:
+    static size_t hashSite_(const std::vector<int>& content);
     
 };
 
@@ -41,12 +41,11 @@
 #define _TREEITERATORS_H
 
 #include "TreeTemplate.h"
+#include "TreeTraversal.h"
 #include "Node.h"
 
 // From the STL:
-#include <string>
 #include <vector>
-#include <map>
 
 /**
  * @brief The phylogenetic tree iterator class.
@@ -58,10 +57,20 @@
  * Pre-Order
  * In-Order
  *
+ * The order is computed once when the iterator is created, using a
+ * TreeTraversal object. Iterating does not modify the nodes, and does not
+ * allocate memory. The nodes can be edited during the traversal, but the
+ * topology of the tree should not be changed.
+ *
+ * In in-order, nodes with a single son are visited before their son. Former
+ * versions of the in-order iterator, which started at the leftmost leaf,
+ * visited the single-son ancestors of this leaf after it.
+ *
  * For more information on using trees in BIo++, 
  * @see Node
  * @see NodeTemplate
  * @see TreeTools
+ * @see TreeTraversal
  */
 
 namespace bpp
@@ -70,39 +79,26 @@ namespace bpp
     class TreeIterator                  // abstract class from which each iterator type inherits
     {
         protected:
-        TreeTemplate<Node>& tree_;      // The tree to iterate over its nodes. Can't be const because user should be allowed to edit the nodes of the tree during the traversal.
-        Node* curNode_;                 // A pointer to the current node visited by the iterator. Can't be const because user should be allowed to edit the nodes of the tree during the traversal.
+        TreeTraversal<Node> traversal_; // The nodes to visit, in order. Not const because user should be allowed to edit the nodes of the tree during the traversal.
+        size_t pos_;                    // The position of the current node in the traversal.
 
         public:
         /* contructors and destructors */
-        explicit TreeIterator(TreeTemplate<Node>& tree):
-            tree_(tree),
-            curNode_(tree.getRootNode()) // The pointer to the initial node is initialized as 0 since it's actual assignment depents on which traversal is chosen
-            { init(); }
-
-        explicit TreeIterator(TreeIterator& tree_iterator):
-        tree_(tree_iterator.tree_),
-        curNode_(tree_.getRootNode())
-        {}
-
-        TreeIterator& operator=(const TreeIterator& tree_iterator);
-        
+        TreeIterator(TreeTemplate<Node>& tree, BasicTreeTraversal::Order order):
+            traversal_(tree.getRootNode(), order),
+            pos_(0)
+            {}
+
         virtual ~TreeIterator() {}      // No need to delete anything - the pointer to the node should not be deleted because the node doesn't belong to the tree iterator
                                         // must be virtual to assume that upon deletion, the destructor of any inheriting class is called as well (see https://www.geeksforgeeks.org/virtual-destructor/)
 
-        void setNodeStatus(Node* node, bool visited); // sets the visitation status of a node
-        void init(); 
-                                         // function to initialize nodes properties
         /* iterating functions */
         Node* begin();     
-        virtual Node* next() = 0;                     // Set as virtual because the function should be implemented separately in each iterator type
+        Node* next();
         TreeIterator& operator++();
         Node* end(){ return NULL; }
 
-        protected:
-        void clearProperties();
-        int getLastVisitedSon(Node* node);
-        void setLastVisitedSon(Node* node, int visitedSon);
+        const TreeTraversal<Node>& getTraversal() const { return traversal_; }
     };
 
 
@@ -112,14 +108,9 @@ namespace bpp
 
         /* constrcutors and destrcutors */
         explicit PostOrderTreeIterator(TreeTemplate<Node>& tree):
-        TreeIterator(tree) {
-            curNode_ = tree_.getNodes()[0]; // Get the leftmost leaf of the tree
-        }
+        TreeIterator(tree, BasicTreeTraversal::POSTORDER) {}
 
         ~PostOrderTreeIterator() {};           // Inherited from TreeIterator
-
-        Node* getLeftMostPredessesor(Node* startNode);
-        Node* next();
     };
 
 
@@ -129,13 +120,9 @@ namespace bpp
 
         /* constrcutors and destrcutors */
         explicit PreOrderTreeIterator(TreeTemplate<Node>& tree):
-        TreeIterator(tree) {
-            curNode_ = tree_.getRootNode();
-        }
+        TreeIterator(tree, BasicTreeTraversal::PREORDER) {}
 
         ~PreOrderTreeIterator() {};           // Inherited from TreeIterator
-
-        Node* next();
     };
 
 
@@ -145,15 +132,9 @@ namespace bpp
 
         /* constrcutors and destrcutors */
         explicit InOrderTreeIterator(TreeTemplate<Node>& tree):
-        TreeIterator(tree) {
-            curNode_ = tree_.getNodes()[0];  // Get the leftmost leaf of the tree
-        }
+        TreeIterator(tree, BasicTreeTraversal::INORDER) {}
 
         ~InOrderTreeIterator() {};           // Inherited from TreeIterator
-
-        Node* doStep(Node* node);
-        Node* next();
-
     }; 
 
 
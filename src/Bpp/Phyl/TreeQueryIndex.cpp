@@ -0,0 +1,272 @@
+//
+// File: TreeQueryIndex.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include "TreeQueryIndex.h"
+#include "TreeExceptions.h"
+
+#include <Bpp/Exceptions.h>
+#include <Bpp/Text/TextTools.h>
+
+using namespace bpp;
+
+// From the STL:
+#include <algorithm>
+
+using namespace std;
+
+/******************************************************************************/
+
+const size_t TreeQueryIndex::NO_POSITION = static_cast<size_t>(-1);
+
+/******************************************************************************/
+
+TreeQueryIndex::TreeQueryIndex(const Tree& tree) :
+  ids_(),
+  fathers_(),
+  depths_(),
+  distancesToRoot_(),
+  nbMissingLengths_(),
+  firstOccurrences_(),
+  sparseTable_(),
+  logs_(),
+  positionIndex_(),
+  sparsePositionIndex_()
+{
+  size_t nbNodes = tree.getNumberOfNodes();
+  if (nbNodes >= static_cast<size_t>(UINT32_MAX))
+    throw Exception("TreeQueryIndex. Too many nodes: " + TextTools::toString(nbNodes));
+  ids_.reserve(nbNodes);
+  fathers_.reserve(nbNodes);
+  depths_.reserve(nbNodes);
+  distancesToRoot_.reserve(nbNodes);
+  nbMissingLengths_.reserve(nbNodes);
+  firstOccurrences_.reserve(nbNodes);
+  vector<uint32_t> tour;
+  tour.reserve(2 * nbNodes);
+
+  // Pre-order numbering and Euler tour, with an explicit stack of nodes and their sons:
+  vector< pair<size_t, vector<int> > > stack;
+  vector<size_t> nextSons;
+  int id = tree.getRootId();
+  size_t father = NO_POSITION;
+  while (true)
+  {
+    size_t position = ids_.size();
+    ids_.push_back(id);
+    fathers_.push_back(father);
+    if (father == NO_POSITION)
+    {
+      depths_.push_back(0);
+      distancesToRoot_.push_back(0.);
+      nbMissingLengths_.push_back(0);
+    }
+    else
+    {
+      depths_.push_back(depths_[father] + 1);
+      bool hasLength = tree.hasDistanceToFather(id);
+      distancesToRoot_.push_back(distancesToRoot_[father] + (hasLength ? tree.getDistanceToFather(id) : 0.));
+      nbMissingLengths_.push_back(nbMissingLengths_[father] + (hasLength ? 0 : 1));
+    }
+    firstOccurrences_.push_back(tour.size());
+    tour.push_back(static_cast<uint32_t>(position));
+    stack.push_back(make_pair(position, tree.getSonsId(id)));
+    nextSons.push_back(0);
+
+    // Go back up to the first node with sons left to visit, which is added again to the tour:
+    while (!stack.empty() && nextSons.back() == stack.back().second.size())
+    {
+      stack.pop_back();
+      nextSons.pop_back();
+      if (!stack.empty())
+        tour.push_back(static_cast<uint32_t>(stack.back().first));
+    }
+    if (stack.empty())
+      break;
+    father = stack.back().first;
+    id = stack.back().second[nextSons.back()++];
+  }
+
+  // Node positions by id:
+  positionIndex_.assign(ids_.size(), NO_POSITION);
+  for (size_t i = 0; i < ids_.size(); i++)
+  {
+    indexPosition_(ids_[i], i);
+  }
+
+  // Sparse table over the Euler tour:
+  size_t size = tour.size();
+  logs_.assign(size + 1, 0);
+  for (size_t i = 2; i <= size; i++)
+  {
+    logs_[i] = static_cast<uint8_t>(logs_[i / 2] + 1);
+  }
+  sparseTable_.resize(static_cast<size_t>(logs_[size]) + 1);
+  sparseTable_[0].swap(tour);
+  for (size_t k = 1; k < sparseTable_.size(); k++)
+  {
+    const vector<uint32_t>& previous = sparseTable_[k - 1];
+    vector<uint32_t>& level = sparseTable_[k];
+    size_t half = static_cast<size_t>(1) << (k - 1);
+    level.resize(size - 2 * half + 1);
+    for (size_t i = 0; i < level.size(); i++)
+    {
+      level[i] = static_cast<uint32_t>(shallowest_(previous[i], previous[i + half]));
+    }
+  }
+}
+
+/******************************************************************************/
+
+void TreeQueryIndex::indexPosition_(int id, size_t position)
+{
+  bool duplicated;
+  if (id >= 0 && static_cast<size_t>(id) < positionIndex_.size())
+  {
+    size_t& slot = positionIndex_[static_cast<size_t>(id)];
+    duplicated = (slot != NO_POSITION);
+    slot = position;
+  }
+  else
+    duplicated = !sparsePositionIndex_.insert(make_pair(id, position)).second;
+  if (duplicated)
+    throw Exception("TreeQueryIndex. Duplicated node id: " + TextTools::toString(id));
+}
+
+/******************************************************************************/
+
+size_t TreeQueryIndex::getPosition(int nodeId) const
+{
+  if (nodeId >= 0 && static_cast<size_t>(nodeId) < positionIndex_.size())
+  {
+    size_t position = positionIndex_[static_cast<size_t>(nodeId)];
+    if (position != NO_POSITION)
+      return position;
+  }
+  else
+  {
+    unordered_map<int, size_t>::const_iterator it = sparsePositionIndex_.find(nodeId);
+    if (it != sparsePositionIndex_.end())
+      return it->second;
+  }
+  throw NodeNotFoundException("TreeQueryIndex::getPosition.", nodeId);
+}
+
+/******************************************************************************/
+
+size_t TreeQueryIndex::getLastCommonAncestorPosition(size_t position1, size_t position2) const
+{
+  size_t first = firstOccurrences_[position1];
+  size_t last = firstOccurrences_[position2];
+  if (first > last)
+    std::swap(first, last);
+  size_t k = logs_[last - first + 1];
+  const vector<uint32_t>& level = sparseTable_[k];
+  return shallowest_(level[first], level[last + 1 - (static_cast<size_t>(1) << k)]);
+}
+
+/******************************************************************************/
+
+double TreeQueryIndex::getDistanceBetweenPositions(size_t position1, size_t position2) const
+{
+  size_t ancestor = getLastCommonAncestorPosition(position1, position2);
+  if (nbMissingLengths_[position1] + nbMissingLengths_[position2] > 2 * nbMissingLengths_[ancestor])
+  {
+    // Find the first branch without length, for the error message:
+    for (size_t position : { position1, position2 })
+    {
+      for ( ; position != ancestor; position = fathers_[position])
+      {
+        if (nbMissingLengths_[position] > nbMissingLengths_[fathers_[position]])
+          throw NodeException("TreeQueryIndex::getDistanceBetweenAnyTwoNodes. Branch length lacking.", ids_[position]);
+      }
+    }
+  }
+  return distancesToRoot_[position1] + distancesToRoot_[position2] - 2. * distancesToRoot_[ancestor];
+}
+
+/******************************************************************************/
+
+int TreeQueryIndex::getLastCommonAncestor(const vector<int>& nodeIds) const
+{
+  if (nodeIds.size() == 0)
+    throw Exception("TreeQueryIndex::getLastCommonAncestor(). You must provide at least one node id.");
+  size_t ancestor = getPosition(nodeIds[0]);
+  for (size_t i = 1; i < nodeIds.size(); i++)
+  {
+    ancestor = getLastCommonAncestorPosition(ancestor, getPosition(nodeIds[i]));
+  }
+  return ids_[ancestor];
+}
+
+/******************************************************************************/
+
+size_t TreeQueryIndex::getNumberOfBranchesBetween(int nodeId1, int nodeId2) const
+{
+  size_t position1 = getPosition(nodeId1);
+  size_t position2 = getPosition(nodeId2);
+  size_t ancestor = getLastCommonAncestorPosition(position1, position2);
+  return depths_[position1] + depths_[position2] - 2 * depths_[ancestor];
+}
+
+/******************************************************************************/
+
+vector<int> TreeQueryIndex::getPathBetweenAnyTwoNodes(int nodeId1, int nodeId2, bool includeAncestor) const
+{
+  size_t position1 = getPosition(nodeId1);
+  size_t position2 = getPosition(nodeId2);
+  size_t ancestor = getLastCommonAncestorPosition(position1, position2);
+  vector<int> path;
+  path.reserve(depths_[position1] + depths_[position2] + 1 - 2 * depths_[ancestor]);
+  for (size_t position = position1; position != ancestor; position = fathers_[position])
+  {
+    path.push_back(ids_[position]);
+  }
+  if (includeAncestor)
+    path.push_back(ids_[ancestor]);
+  size_t middle = path.size();
+  for (size_t position = position2; position != ancestor; position = fathers_[position])
+  {
+    path.push_back(ids_[position]);
+  }
+  std::reverse(path.begin() + static_cast<ptrdiff_t>(middle), path.end());
+  return path;
+}
+
+/******************************************************************************/
+
@@ -0,0 +1,208 @@
+//
+// File: TreeQueryIndex.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _TREEQUERYINDEX_H_
+#define _TREEQUERYINDEX_H_
+
+#include "Tree.h"
+
+// From the STL:
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace bpp
+{
+
+/**
+ * @brief Constant time queries on the topology and branch lengths of a tree.
+ *
+ * The index is built once in O(n log n) for a tree with n nodes, after which
+ * the last common ancestor of any two nodes, their depth, and the number of
+ * branches and the patristic distance between them are obtained in constant
+ * time:
+ * - nodes are numbered in pre-order ("positions", the root being at position 0),
+ * - the Euler tour of the tree lists each node every time it is visited, and the
+ *   last common ancestor of two nodes is the shallowest node of the tour between
+ *   their first occurrences. This range minimum is found in constant time with a
+ *   sparse table, storing the shallowest node of each range of 2^k consecutive
+ *   elements of the tour,
+ * - the distance between two nodes is obtained from the distances to the root
+ *   of the two nodes and of their last common ancestor.
+ *
+ * This saves walking ancestor lists for each query, as TreeTools::getLastCommonAncestor
+ * and TreeTools::getDistanceBetweenAnyTwoNodes do.
+ *
+ * The index is a snapshot of the tree at the time it was built, and must be
+ * rebuilt if the topology, the node ids or the branch lengths are modified.
+ * TreeTemplate::getQueryIndex() maintains such an index for a tree. Once built,
+ * the index is never modified, and can be queried by several threads.
+ *
+ * Branches without length are allowed, but distances cannot be computed along
+ * paths which contain such branches.
+ *
+ * @see TreeTemplate::getQueryIndex
+ */
+class TreeQueryIndex
+{
+  private:
+    std::vector<int> ids_;
+    std::vector<size_t> fathers_;
+    std::vector<size_t> depths_;
+    std::vector<double> distancesToRoot_;
+    // Number of branches without length between each node and the root:
+    std::vector<size_t> nbMissingLengths_;
+    std::vector<size_t> firstOccurrences_;
+    // Level k stores, for each position i of the Euler tour, the shallowest node in [i, i + 2^k):
+    std::vector< std::vector<uint32_t> > sparseTable_;
+    // Floor of the base 2 logarithm of each range length:
+    std::vector<uint8_t> logs_;
+    std::vector<size_t> positionIndex_;
+    std::unordered_map<int, size_t> sparsePositionIndex_;
+
+  public:
+    /**
+     * @brief Value of the position of the father of the root.
+     */
+    static const size_t NO_POSITION;
+
+  public:
+    /**
+     * @param tree The tree to index.
+     * @throw Exception If the tree contains duplicated node ids.
+     */
+    TreeQueryIndex(const Tree& tree);
+
+    virtual ~TreeQueryIndex() {}
+
+  public:
+    size_t getNumberOfNodes() const { return ids_.size(); }
+
+    /**
+     * @return The position of a node in pre-order.
+     * @throw NodeNotFoundException If the tree has no node with this id.
+     */
+    size_t getPosition(int nodeId) const;
+
+    /**
+     * @return The id of the node at a given position in pre-order.
+     */
+    int getNodeId(size_t position) const { return ids_[position]; }
+
+    /**
+     * @return The position of the father of the node at a given position, or NO_POSITION for the root.
+     */
+    size_t getFatherPosition(size_t position) const { return fathers_[position]; }
+
+    /**
+     * @return The number of branches between a node and the root.
+     */
+    size_t getDepth(int nodeId) const { return depths_[getPosition(nodeId)]; }
+
+    /**
+     * @return The sum of the branch lengths between a node and the root.
+     * @throw NodeException If a branch between the node and the root has no length.
+     */
+    double getDistanceToRoot(int nodeId) const { return getDistanceBetweenPositions(getPosition(nodeId), 0); }
+
+    /**
+     * @return The id of the last common ancestor of two nodes.
+     */
+    int getLastCommonAncestor(int nodeId1, int nodeId2) const
+    {
+      return ids_[getLastCommonAncestorPosition(getPosition(nodeId1), getPosition(nodeId2))];
+    }
+
+    /**
+     * @return The id of the last common ancestor of a set of nodes.
+     * @throw Exception If the set of nodes is empty.
+     */
+    int getLastCommonAncestor(const std::vector<int>& nodeIds) const;
+
+    /**
+     * @return The number of branches between two nodes.
+     */
+    size_t getNumberOfBranchesBetween(int nodeId1, int nodeId2) const;
+
+    /**
+     * @return The sum of all branch lengths between two nodes.
+     * @throw NodeException If a branch between the two nodes has no length.
+     */
+    double getDistanceBetweenAnyTwoNodes(int nodeId1, int nodeId2) const
+    {
+      return getDistanceBetweenPositions(getPosition(nodeId1), getPosition(nodeId2));
+    }
+
+    /**
+     * @brief Get the ids of the nodes between two nodes.
+     *
+     * The path is the same as the one returned by TreeTools::getPathBetweenAnyTwoNodes,
+     * but it is computed in a time proportional to its length.
+     *
+     * @param nodeId1 The id of the first node.
+     * @param nodeId2 The id of the second node.
+     * @param includeAncestor Tell if the common ancestor must be included in the vector.
+     * @return The ids of the nodes from the first node to the second one.
+     */
+    std::vector<int> getPathBetweenAnyTwoNodes(int nodeId1, int nodeId2, bool includeAncestor = true) const;
+
+    /**
+     * @name Queries on node positions, which avoid id lookups in bulk queries.
+     *
+     * @{
+     */
+    size_t getLastCommonAncestorPosition(size_t position1, size_t position2) const;
+
+    double getDistanceBetweenPositions(size_t position1, size_t position2) const;
+    /** @} */
+
+  private:
+    void indexPosition_(int id, size_t position);
+
+    size_t shallowest_(size_t position1, size_t position2) const
+    {
+      return depths_[position1] <= depths_[position2] ? position1 : position2;
+    }
+};
+
+} //end of namespace bpp.
+
+#endif //_TREEQUERYINDEX_H_
+
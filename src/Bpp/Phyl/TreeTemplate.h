@@ -43,12 +43,16 @@
 
 #include "TreeExceptions.h"
 #include "TreeTemplateTools.h"
+#include "TreeQueryIndex.h"
 #include "Tree.h"
 
 // From the STL:
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <memory>
+#include <unordered_map>
 
 namespace bpp
 {
@@ -84,6 +88,22 @@ namespace bpp
  * The TreeTools::getMaxId() method may also prove useful in this respect.
  * The resetNodesId() method can also be used to re-initialize all ids.
  *
+ * Nodes are indexed by their id, so that getNode(int) and all methods taking a node id
+ * as argument run in constant time. The index is kept up to date by all methods of this
+ * class. Nodes added or modified through the Node interface (new sons, new ids) are
+ * indexed again when they are first looked for. Nodes deleted through the Node
+ * interface, however, must be notified by calling updateNodeIndex(), as the index would
+ * otherwise point toward deleted nodes. The functions of TreeTemplateTools which delete
+ * nodes of a tree (dropLeaf, dropSubtree, unresolveUncertainNodes) do it. As the index is
+ * never modified by lookups through a const tree, a const tree can be safely accessed by
+ * several threads.
+ *
+ * A TreeQueryIndex, for constant time queries on common ancestors and distances between
+ * nodes, is also built on request, and deleted whenever the topology, the node ids or the
+ * branch lengths are modified by a method of this class, so that references to it remain
+ * valid as long as the tree is not modified. Modifications through the Node interface must
+ * be notified by calling resetQueryIndex().
+ *
  * @see Node
  * @see NodeTemplate
  * @see TreeTools
@@ -100,31 +120,58 @@ private:
   N* root_;
   std::string name_;
 
+  /**
+   * @brief Node index: node with id i is stored at position i,
+   * unless ids are negative or sparse, in which case they are stored in sparseNodeIndex_.
+   */
+  mutable std::vector<N*> nodeIndex_;
+  mutable std::unordered_map<int, N*> sparseNodeIndex_;
+
+  /**
+   * @brief Index for queries on ancestors and distances, built on request.
+   */
+  mutable std::unique_ptr<TreeQueryIndex> queryIndex_;
+
 public:
   // Constructors and destructor:
   TreeTemplate() : root_(0),
-    name_() {}
+    name_(),
+    nodeIndex_(),
+    sparseNodeIndex_(),
+    queryIndex_() {}
 
   TreeTemplate(const TreeTemplate<N>& t) :
     root_(0),
-    name_(t.name_)
+    name_(t.name_),
+    nodeIndex_(),
+    sparseNodeIndex_(),
+    queryIndex_()
   {
     // Perform a hard copy of the nodes:
     root_ = TreeTemplateTools::cloneSubtree<N>(*t.getRootNode());
+    updateNodeIndex();
   }
 
   TreeTemplate(const Tree& t) :
     root_(0),
-    name_(t.getName())
+    name_(t.getName()),
+    nodeIndex_(),
+    sparseNodeIndex_(),
+    queryIndex_()
   {
     // Create new nodes from an existing tree:
     root_ = TreeTemplateTools::cloneSubtree<N>(t, t.getRootId());
+    updateNodeIndex();
   }
 
   TreeTemplate(N* root) : root_(root),
-    name_()
+    name_(),
+    nodeIndex_(),
+    sparseNodeIndex_(),
+    queryIndex_()
   {
     root_->removeFather(); // In case this is a subtree from somewhere else...
+    updateNodeIndex();
   }
 
   TreeTemplate<N>& operator=(const TreeTemplate<N>& t)
@@ -133,6 +180,8 @@ public:
     if (root_) { TreeTemplateTools::deleteSubtree(root_); delete root_; }
     root_ = TreeTemplateTools::cloneSubtree<N>(*t.getRootNode());
     name_ = t.name_;
+    queryIndex_.reset();
+    updateNodeIndex();
     return *this;
   }
 
@@ -197,7 +246,7 @@ public:
 
   void deleteNodeName(int nodeId) { return getNode(nodeId)->deleteName(); }
 
-  bool hasNode(int nodeId) const { return TreeTemplateTools::hasNodeWithId(*root_, nodeId); }
+  bool hasNode(int nodeId) const { return getIndexedNode_(nodeId) || TreeTemplateTools::hasNodeWithId(*root_, nodeId); }
 
   bool isLeaf(int nodeId) const { return getNode(nodeId)->isLeaf(); }
 
@@ -205,9 +254,9 @@ public:
 
   double getDistanceToFather(int nodeId) const { return getNode(nodeId)->getDistanceToFather(); }
 
-  void setDistanceToFather(int nodeId, double length) { getNode(nodeId)->setDistanceToFather(length); }
+  void setDistanceToFather(int nodeId, double length) { getNode(nodeId)->setDistanceToFather(length); queryIndex_.reset(); }
 
-  void deleteDistanceToFather(int nodeId) { getNode(nodeId)->deleteDistanceToFather(); }
+  void deleteDistanceToFather(int nodeId) { getNode(nodeId)->deleteDistanceToFather(); queryIndex_.reset(); }
 
   bool hasDistanceToFather(int nodeId) const { return getNode(nodeId)->hasDistanceToFather(); }
 
@@ -277,6 +326,7 @@ public:
       // Remove the root:
       root_->removeSons();
       son1->addSon(son2);
+      unindexNode_(root_);
       delete root_;
       setRootNode(son1);
       return true;
@@ -290,6 +340,9 @@ public:
     {
       nodes[i]->setId(static_cast<int>(i));
     }
+    sparseNodeIndex_.clear();
+    nodeIndex_.assign(nodes.begin(), nodes.end());
+    queryIndex_.reset();
   }
 
   bool isMultifurcating() const
@@ -364,6 +417,7 @@ public:
     {
       TreeTemplateTools::setBranchLengths(*root_->getSon(i), brLen);
     }
+    queryIndex_.reset();
   }
 
   void setVoidBranchLengths(double brLen)
@@ -372,6 +426,7 @@ public:
     {
       TreeTemplateTools::setVoidBranchLengths(*root_->getSon(i), brLen);
     }
+    queryIndex_.reset();
   }
 
   void scaleTree(double factor)
@@ -380,6 +435,7 @@ public:
     {
       TreeTemplateTools::scaleTree(*root_->getSon(i), factor);
     }
+    queryIndex_.reset();
   }
 
   int getNextId()
@@ -392,6 +448,7 @@ public:
     std::vector<N*> nodes = TreeTemplateTools::searchNodeWithId<N>(*root_, parentId);
     if (nodes.size() == 0) throw NodeNotFoundException("TreeTemplate:swapNodes(): Node with id not found.", TextTools::toString(parentId));
     for (size_t i = 0; i < nodes.size(); i++) { nodes[i]->swap(i1, i2); }
+    queryIndex_.reset();
   }
 
 
@@ -400,7 +457,7 @@ public:
    *
    * @{
    */
-  virtual void setRootNode(N* root) { root_ = root; root_->removeFather(); }
+  virtual void setRootNode(N* root) { root_ = root; root_->removeFather(); queryIndex_.reset(); updateNodeIndex(); }
 
   virtual N* getRootNode() { return root_; }
 
@@ -418,6 +475,16 @@ public:
 
   virtual std::vector<N*> getInnerNodes() { return TreeTemplateTools::getInnerNodes(*root_); }
 
+  /**
+   * @brief Get a node from its id.
+   *
+   * @param id The id of the node.
+   * @param checkId If true, the whole tree is searched to check that the id is unique,
+   * and the node index is updated if it does not point toward the node found.
+   * @return A pointer toward the node with the given id.
+   * @throw NodeNotFoundException If no node has this id.
+   * @throw Exception If checkId is true and several nodes have this id.
+   */
   virtual N* getNode(int id, bool checkId = false)
   {
     if (checkId) {
@@ -425,9 +492,15 @@ public:
       TreeTemplateTools::searchNodeWithId<N>(*root_, id, nodes);
       if (nodes.size() > 1) throw Exception("TreeTemplate::getNode(): Non-unique id! (" + TextTools::toString(id) + ").");
       if (nodes.size() == 0) throw NodeNotFoundException("TreeTemplate::getNode(): Node with id not found.", TextTools::toString(id));
+      if (getIndexedNode_(id) != nodes[0]) updateNodeIndex();
       return nodes[0];
     } else {
-      N* node = dynamic_cast<N*>(TreeTemplateTools::searchFirstNodeWithId(*root_, id));
+      N* node = getIndexedNode_(id);
+      if (!node) {
+        // The node may have been added or modified since the index was built:
+        updateNodeIndex();
+        node = getIndexedNode_(id);
+      }
       if (node)
         return node;
       else
@@ -437,6 +510,7 @@ public:
 
   virtual const N* getNode(int id, bool checkId = false) const
   {
+    // The index is never modified here, so that a const tree can be read by several threads:
     if (checkId) {
       std::vector<const N*> nodes;
       TreeTemplateTools::searchNodeWithId<const N>(*root_, id, nodes);
@@ -444,7 +518,12 @@ public:
       if (nodes.size() == 0) throw NodeNotFoundException("TreeTemplate::getNode(): Node with id not found.", TextTools::toString(id));
       return nodes[0];
     } else {
-      const N* node = dynamic_cast<const N*>(TreeTemplateTools::searchFirstNodeWithId(*root_, id));
+      const N* node = getIndexedNode_(id);
+      if (!node)
+      {
+        // The node may have been added or modified since the index was built:
+        node = dynamic_cast<const N*>(TreeTemplateTools::searchFirstNodeWithId(*const_cast<const N*>(root_), id));
+      }
       if (node)
         return node;
       else
@@ -452,6 +531,84 @@ public:
     }
   }
 
+  /**
+   * @brief Rebuild the index of nodes by id.
+   *
+   * This method must be called if nodes were deleted from this tree through the Node interface.
+   * The query index is not modified, as nodes are also indexed again after lookup failures:
+   * resetQueryIndex() must be called if the topology was modified.
+   */
+  void updateNodeIndex() const
+  {
+    nodeIndex_.clear();
+    sparseNodeIndex_.clear();
+    if (!root_) return;
+    // Pre-order traversal, so that the first node found by searchFirstNodeWithId is indexed in case of duplicated ids:
+    std::vector<N*> nodes;
+    std::vector<N*> stack(1, root_);
+    while (!stack.empty())
+    {
+      N* node = stack.back();
+      stack.pop_back();
+      nodes.push_back(node);
+      for (size_t i = node->getNumberOfSons(); i > 0; --i)
+        stack.push_back(node->getSon(i - 1));
+    }
+    nodeIndex_.resize(nodes.size(), 0);
+    for (size_t i = 0; i < nodes.size(); ++i)
+      indexNode_(nodes[i], false);
+  }
+
+  /**
+   * @brief Check the index of nodes by id against the tree.
+   *
+   * @return True if all nodes of the tree are indexed, and if the index contains no other node.
+   */
+  bool isNodeIndexValid() const
+  {
+    std::vector<const N*> nodes = getNodes();
+    std::set<const N*> treeNodes(nodes.begin(), nodes.end());
+    // Indexed nodes must belong to the tree (their address is checked first, as they might have been deleted):
+    for (size_t i = 0; i < nodeIndex_.size(); ++i)
+    {
+      if (nodeIndex_[i] && (treeNodes.find(nodeIndex_[i]) == treeNodes.end() || nodeIndex_[i]->getId() != static_cast<int>(i)))
+        return false;
+    }
+    for (typename std::unordered_map<int, N*>::const_iterator it = sparseNodeIndex_.begin(); it != sparseNodeIndex_.end(); ++it)
+    {
+      if (treeNodes.find(it->second) == treeNodes.end() || it->second->getId() != it->first)
+        return false;
+    }
+    // All ids in the tree must be indexed:
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+      if (!getIndexedNode_(nodes[i]->getId())) return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Get an index for constant time queries on common ancestors and distances between nodes.
+   *
+   * The index is built on the first call, and kept until the tree is modified.
+   * As building the index modifies this object, it should be requested once
+   * before the tree is queried by several threads.
+   *
+   * @return The query index of this tree.
+   */
+  const TreeQueryIndex& getQueryIndex() const
+  {
+    if (!queryIndex_) queryIndex_.reset(new TreeQueryIndex(*this));
+    return *queryIndex_;
+  }
+
+  /**
+   * @brief Delete the query index.
+   *
+   * This method must be called if the topology or the branch lengths of this tree were modified through the Node interface.
+   */
+  void resetQueryIndex() const { queryIndex_.reset(); }
+
   virtual N* getNode(const std::string& name)
   {
     std::vector<N*> nodes;
@@ -495,6 +652,7 @@ public:
     newRoot->deleteDistanceToFather();
     newRoot->deleteBranchProperties();
     root_ = newRoot;
+    queryIndex_.reset();
   }
 
   void newOutGroup(N* outGroup)
@@ -521,6 +679,8 @@ public:
     root_->setId(rootId);
     root_->addSon(oldRoot);
     root_->addSon(outGroup);
+    indexNode_(root_, true);
+    queryIndex_.reset();
     // Check lengths:
     if (outGroup->hasDistanceToFather())
     {
@@ -531,6 +691,54 @@ public:
   }
 
   /** @} */
+
+private:
+  /**
+   * @return The node indexed with the given id, or 0 if there is none.
+   */
+  N* getIndexedNode_(int id) const
+  {
+    N* node = 0;
+    if (id >= 0 && static_cast<size_t>(id) < nodeIndex_.size())
+      node = nodeIndex_[static_cast<size_t>(id)];
+    else if (!sparseNodeIndex_.empty())
+    {
+      typename std::unordered_map<int, N*>::const_iterator it = sparseNodeIndex_.find(id);
+      if (it != sparseNodeIndex_.end()) node = it->second;
+    }
+    // The id of the node may have been changed since it was indexed:
+    return (node && node->getId() == id) ? node : 0;
+  }
+
+  /**
+   * @param node The node to index.
+   * @param replace Should a node already indexed with the same id be replaced?
+   */
+  void indexNode_(N* node, bool replace) const
+  {
+    int id = node->getId();
+    if (id >= 0 && static_cast<size_t>(id) < nodeIndex_.size())
+    {
+      N*& slot = nodeIndex_[static_cast<size_t>(id)];
+      if (replace || !slot) slot = node;
+    }
+    else if (replace || sparseNodeIndex_.find(id) == sparseNodeIndex_.end())
+      sparseNodeIndex_[id] = node;
+  }
+
+  void unindexNode_(N* node) const
+  {
+    int id = node->getId();
+    if (id >= 0 && static_cast<size_t>(id) < nodeIndex_.size())
+    {
+      if (nodeIndex_[static_cast<size_t>(id)] == node) nodeIndex_[static_cast<size_t>(id)] = 0;
+    }
+    else
+    {
+      typename std::unordered_map<int, N*>::iterator it = sparseNodeIndex_.find(id);
+      if (it != sparseNodeIndex_.end() && it->second == node) sparseNodeIndex_.erase(it);
+    }
+  }
 };
 } // end of namespace bpp.
 
@@ -380,8 +380,8 @@ string TreeTemplateTools::nodeToParenthesis(const Node& node, bool writeId)
   }
   else
   {
-    if (node.hasBranchProperty(TreeTools::BOOTSTRAP))
-      s << (dynamic_cast<const Number<double>*>(node.getBranchProperty(TreeTools::BOOTSTRAP))->getValue());
+    if (node.hasBootstrapValue())
+      s << node.getBootstrapValue();
   }
   if (node.hasDistanceToFather())
     s << ":" << node.getDistanceToFather();
@@ -409,8 +409,8 @@ string TreeTemplateTools::nodeToParenthesis(const Node& node, bool bootstrap, co
 
     if (bootstrap)
     {
-      if (node.hasBranchProperty(TreeTools::BOOTSTRAP))
-        s << (dynamic_cast<const Number<double>*>(node.getBranchProperty(TreeTools::BOOTSTRAP))->getValue());
+      if (node.hasBootstrapValue())
+        s << node.getBootstrapValue();
     }
     else
     {
@@ -485,8 +485,8 @@ string TreeTemplateTools::treeToParenthesis(const TreeTemplate<Node>& tree, bool
   s << ")";
   if (bootstrap)
   {
-    if (node->hasBranchProperty(TreeTools::BOOTSTRAP))
-      s << (dynamic_cast<const Number<double>*>(node->getBranchProperty(TreeTools::BOOTSTRAP))->getValue());
+    if (node->hasBootstrapValue())
+      s << node->getBootstrapValue();
   }
   else
   {
@@ -762,87 +762,9 @@ double TreeTemplateTools::getDistanceBetweenAnyTwoNodes(const Node& node1, const
 
 /******************************************************************************/
 
-void TreeTemplateTools::processDistsInSubtree_(const Node* node, DistanceMatrix& matrix, vector< std::pair<string, double> >& distsToNodeFather)
-{
-  distsToNodeFather.clear();
-
-  // node-is-leaf case
-  if (node->getNumberOfSons() == 0)
-  {
-    distsToNodeFather.push_back(make_pair(node->getName(), node->getDistanceToFather()));
-    return;
-  }
-
-  // For all leaves in node's subtree, get leaf-to-node distances.
-  // Leaves are classified upon node's sons.
-  map<const Node*, vector< pair<string, double> > > leavesDists;
-  for (size_t i = 0; i < node->getNumberOfSons(); ++i)
-  {
-    const Node* son = node->getSon(i);
-    processDistsInSubtree_(son, matrix, leavesDists[son]); // recursivity
-  }
-  // Write leaf-leaf distances to the distance matrix.
-  // Only pairs in which the two leaves belong to different
-  // sons are considered.
-  for (size_t son1_loc = 0; son1_loc < node->getNumberOfSons(); ++son1_loc)
-  {
-    for (size_t son2_loc = 0; son2_loc < son1_loc; ++son2_loc)
-    {
-      const Node* son1 = node->getSon(son1_loc);
-      const Node* son2 = node->getSon(son2_loc);
-
-      for (vector< pair<string, double> >::iterator son1_leaf = leavesDists[son1].begin();
-           son1_leaf != leavesDists[son1].end();
-           ++son1_leaf)
-      {
-        for (vector< pair<string, double> >::iterator son2_leaf = leavesDists[son2].begin();
-             son2_leaf != leavesDists[son2].end();
-             ++son2_leaf)
-        {
-          matrix(son1_leaf->first, son2_leaf->first) =
-            matrix(son2_leaf->first, son1_leaf->first) =
-              ( son1_leaf->second + son2_leaf->second );
-        }
-      }
-    }
-  }
-
-  // node-is-root case
-  if (!node->hasFather())
-  {
-    // node-is-root-and-leaf case
-    if (node->isLeaf() )
-    {
-      string root_name = node->getName();
-      for (vector< pair<string, double> >::iterator other_leaf = leavesDists[node->getSon(0)].begin();
-           other_leaf != leavesDists[node->getSon(0)].end();
-           ++other_leaf)
-      {
-        matrix(root_name, other_leaf->first) = matrix( other_leaf->first, root_name) = other_leaf->second;
-      }
-    }
-
-    return;
-  }
-
-  // Get distances from node's father to considered leaves
-  distsToNodeFather.clear();
-  double nodeToFather = node->getDistanceToFather();
-  for (map<const Node*, vector<pair<string, double> > >::iterator son = leavesDists.begin(); son != leavesDists.end(); ++son)
-  {
-    for (vector< pair<string, double> >::iterator leaf = (son->second).begin(); leaf != (son->second).end(); ++leaf)
-    {
-      distsToNodeFather.push_back(make_pair(leaf->first, (leaf->second + nodeToFather)));
-    }
-  }
-}
-
 DistanceMatrix* TreeTemplateTools::getDistanceMatrix(const TreeTemplate<Node>& tree)
 {
-  DistanceMatrix* matrix = new DistanceMatrix(tree.getLeavesNames());
-  vector< pair<string, double> > distsToRoot;
-  processDistsInSubtree_(tree.getRootNode(), *matrix, distsToRoot);
-  return matrix;
+  return TreeTools::getDistanceMatrix(tree);
 }
 
 /******************************************************************************/
@@ -1207,6 +1129,16 @@ void TreeTemplateTools::unresolveUncertainNodes(Node& subtree, double threshold,
   }
 }
 
+/******************************************************************************/
+
+void TreeTemplateTools::unresolveUncertainNodes(TreeTemplate<Node>& tree, double threshold, const std::string& property)
+{
+  unresolveUncertainNodes(*tree.getRootNode(), threshold, property);
+  // Deleted nodes must be removed from the indexes before any lookup:
+  tree.updateNodeIndex();
+  tree.resetQueryIndex();
+}
+
 
 /******************************************************************************/
 
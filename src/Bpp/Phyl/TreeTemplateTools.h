@@ -48,6 +48,7 @@
 // From the STL:
 #include <string>
 #include <vector>
+#include <utility>
 
 namespace bpp
 {
@@ -254,6 +255,9 @@ public:
       // Dunno what to do in that case :(
       throw Exception("TreeTemplateTools::dropLeaf. Parent node as only one child, I don't know what to do in that case :(");
     }
+    // Deleted nodes must be removed from the indexes:
+    tree.updateNodeIndex();
+    tree.resetQueryIndex();
   }
 
   /**
@@ -309,6 +313,9 @@ public:
       // Dunno what to do in that case :(
       throw Exception("TreeTemplateTools::dropSubtree. Parent node as only one child, I don't know what to do in that case :(");
     }
+    // Deleted nodes must be removed from the indexes:
+    tree.updateNodeIndex();
+    tree.resetQueryIndex();
   }
 
   /**
@@ -353,11 +360,23 @@ public:
   template<class N>
   static void getNodes(N& node, std::vector<N*>& nodes)
   {
-    for (size_t i = 0; i < node.getNumberOfSons(); i++)
+    // Post-order traversal with an explicit stack, so that very deep trees can be handled:
+    std::vector< std::pair<N*, size_t> > stack(1, std::make_pair(&node, size_t(0)));
+    while (!stack.empty())
     {
-      getNodes<N>(*node.getSon(i), nodes);
+      N* current = stack.back().first;
+      size_t i = stack.back().second;
+      if (i < current->getNumberOfSons())
+      {
+        stack.back().second++;
+        stack.push_back(std::make_pair(current->getSon(i), size_t(0)));
+      }
+      else
+      {
+        nodes.push_back(current);
+        stack.pop_back();
+      }
     }
-    nodes.push_back(&node);
   }
 
   /**
@@ -769,18 +788,21 @@ public:
   }
 
   /**
-   * @brief Recursively delete a subtree structure.
+   * @brief Delete a subtree structure.
+   *
+   * The basal node itself is not deleted.
    *
    * @param node The basal node of the subtree.
    */
   template<class N>
   static void deleteSubtree(N* node)
   {
-    for (size_t i = 0; i < node->getNumberOfSons(); ++i)
+    std::vector<N*> nodes;
+    getNodes<N>(*node, nodes);
+    // The basal node comes last:
+    for (size_t i = 0; i + 1 < nodes.size(); ++i)
     {
-      N* son = node->getSon(i);
-      deleteSubtree(son);
-      delete son;
+      delete nodes[i];
     }
   }
 
@@ -894,33 +916,16 @@ public:
    * A new DistanceMatrix object is created, and a pointer toward it is returned.
    * The destruction of this matrix is left up to the user.
    *
-   * From version 1.9 of Bio++, this function has been rewritten in a more efficient way
-   * and does not use getDistanceBetweenAnyTwoNodes anymore, but makes use of a more clever
-   * pass on the tree. The new function now works well on trees with thousands of leaves.
-   *
-   * @see getDistanceBetweenAnyTwoNodes
+   * This function is equivalent to TreeTools::getDistanceMatrix, which uses a
+   * TreeQueryIndex to compute each distance in constant time.
    *
-   * @author Nicolas Rochette
+   * @see TreeTools::getDistanceMatrix
    *
    * @param tree The tree to use.
    * @return The distance matrix computed from tree.
    */
   static DistanceMatrix* getDistanceMatrix(const TreeTemplate<Node>& tree);
 
-private:
-  /**
-   * @brief Inner function used by getDistanceMatrix.
-   *
-   * (1) Retrieves leaf-leaf distances in node's subtree and
-   *  writes them in the distance matrix.
-   * (2) Returns distances from node's father to those leaves.
-   *
-   * @param node The current node in the recursion.
-   * @param matrix The output matrix which will be filled.
-   * @param distsToNodeFather Intermediate computations contianing the distances of the node to the leaves.
-   */
-  static void processDistsInSubtree_(const Node* node, DistanceMatrix& matrix, std::vector< std::pair<std::string, double> >& distsToNodeFather);
-
 public:
   /** @} */
 
@@ -1230,6 +1235,8 @@ public:
    * the branch length of the removed node is added to the length of its son nodes,
    * so that pairwise phylogenetic distances are conserved along the tree.
    * Leaves are not checked. Node with missing values are ignored.
+   * As nodes are deleted, this function must not be used on a subtree of a TreeTemplate object,
+   * which indexes its nodes: use the function taking the tree as argument instead.
    *
    * @author Julien Dutheil.
    *
@@ -1239,6 +1246,17 @@ public:
    */
   static void unresolveUncertainNodes(Node& subtree, double threshold, const std::string& property = TreeTools::BOOTSTRAP);
 
+  /**
+   * @brief Unresolve nodes with low confidence value in a tree.
+   *
+   * Same as the function above, applied to the whole tree, the node index of which is updated.
+   *
+   * @param tree      The tree where nodes should be collapsed.
+   * @param threshold The minimum value for which a node is considered to be confident.
+   * @param property  The branch property to be considered as a confidence value (bootstrap values by default).
+   */
+  static void unresolveUncertainNodes(TreeTemplate<Node>& tree, double threshold, const std::string& property = TreeTools::BOOTSTRAP);
+
 private:
   struct OrderTreeData_
   {
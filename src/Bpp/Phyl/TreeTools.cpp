@@ -40,6 +40,12 @@
 #include "TreeTools.h"
 #include "Tree.h"
 #include "BipartitionTools.h"
+#include "BipartitionSet.h"
+#include "BipartitionCounter.h"
+#include "TreeTemplate.h"
+#include "TreeTraversal.h"
+#include "TreeQueryIndex.h"
+#include "Io/IoTree.h"
 #include "Model/Nucleotide/JCnuc.h"
 #include "Distance/DistanceEstimation.h"
 #include "Distance/BioNJ.h"
@@ -64,6 +70,11 @@ using namespace bpp;
 // From the STL:
 #include <iostream>
 #include <sstream>
+#include <map>
+#include <algorithm>
+#include <climits>
+#include <memory>
+#include <unordered_map>
 
 using namespace std;
 
@@ -697,13 +708,51 @@ double TreeTools::convertToClockTree2(Tree& tree, int nodeId)
 DistanceMatrix* TreeTools::getDistanceMatrix(const Tree& tree)
 {
   vector<string> names = tree.getLeavesNames();
-  DistanceMatrix* mat = new DistanceMatrix(names);
+  TreeQueryIndex index(tree);
+
+  /* position of each leaf in the index */
+  unordered_map<string, size_t> leafPositions;
+  for (size_t i = 0; i < index.getNumberOfNodes(); i++)
+  {
+    int id = index.getNodeId(i);
+    if (tree.isLeaf(id))
+      leafPositions.insert(make_pair(tree.getNodeName(id), i));
+  }
+  vector<size_t> positions(names.size());
   for (size_t i = 0; i < names.size(); i++)
   {
+    positions[i] = leafPositions[names[i]];
+  }
+
+  /* each distance is obtained in constant time, rows are filled in parallel */
+  DistanceMatrix* mat = new DistanceMatrix(names);
+  vector<string> errors(names.size());
+  long nbLeaves = static_cast<long>(names.size());
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (long li = 0; li < nbLeaves; ++li)
+  {
+    size_t i = static_cast<size_t>(li);
     (*mat)(i, i) = 0;
-    for (size_t j = 0; j < i; j++)
+    try
     {
-      (*mat)(i, j) = (*mat)(j, i) = getDistanceBetweenAnyTwoNodes(tree, tree.getLeafId(names[i]), tree.getLeafId(names[j]));
+      for (size_t j = 0; j < i; j++)
+      {
+        (*mat)(i, j) = (*mat)(j, i) = index.getDistanceBetweenPositions(positions[i], positions[j]);
+      }
+    }
+    catch (exception& e)
+    {
+      errors[i] = e.what();
+    }
+  }
+  for (size_t i = 0; i < errors.size(); i++)
+  {
+    if (!errors[i].empty())
+    {
+      delete mat;
+      throw Exception(errors[i]);
     }
   }
   return mat;
@@ -884,62 +933,295 @@ bool TreeTools::haveSameTopology(const Tree& tr1, const Tree& tr2)
 
 /******************************************************************************/
 
-int TreeTools::robinsonFouldsDistance(const Tree& tr1, const Tree& tr2, bool checkNames, int* missing_in_tr2, int* missing_in_tr1)
+namespace
 {
-  BipartitionList* bipL1, * bipL2;
-  size_t i, j;
-  vector<size_t> size1, size2;
-  vector<bool> bipOK2;
+  /**
+   * Clusters of a tree, for Day's algorithm.
+   *
+   * The tree is traversed as an unrooted tree, starting from a reference
+   * leaf, so that each branch defines a cluster: the leaves on the side of the
+   * branch which does not contain the reference leaf. The two trees to compare
+   * are traversed from the same reference leaf, so that their clusters
+   * correspond to their bipartitions. Nodes with a single son define the same
+   * cluster as their son, and trivial clusters (one leaf, or all leaves but
+   * the reference one) are ignored.
+   *
+   * Leaves of the first tree are numbered in the order of the traversal, so
+   * that each of its clusters is an interval of leaf numbers. A cluster of the
+   * second tree is then found in the first tree if and only if its leaf
+   * numbers form an interval, and this interval is a cluster of the first
+   * tree. Clusters of the first tree are stored in two tables, indexed by the
+   * first leaf of the clusters which are the last son of their father, and by
+   * the last leaf of the other ones: no two clusters share the same entry, so
+   * that the lookup takes a constant time.
+   */
+  class DayClusterTable
+  {
+    private:
+      struct Frame
+      {
+        const Node* node;
+        const Node* from;
+        size_t next;
+        size_t left, right, size, nbSons;
+        bool hasPending;
+        size_t pendingLeft, pendingRight;
+      };
+
+      const Node* reference_;
+      size_t nbLeaves_;
+      unordered_map<string, size_t> ranks_;
+      // Clusters are stored as their [left, right] interval, and NONE for empty entries:
+      vector< pair<size_t, size_t> > byLeft_;
+      vector< pair<size_t, size_t> > byRight_;
+      size_t nbClusters_;
+
+    public:
+      static const size_t NONE;
+
+    private:
+      DayClusterTable(const DayClusterTable&);
+      DayClusterTable& operator=(const DayClusterTable&);
+
+    public:
+      /**
+       * Build the table of clusters of the first tree.
+       */
+      DayClusterTable(const Node* root) :
+        reference_(0), nbLeaves_(0), ranks_(), byLeft_(), byRight_(), nbClusters_(0)
+      {
+        reference_ = findReferenceLeaf_(root);
+        // Leaves are numbered first, so that trivial clusters can be recognized:
+        traverse_(reference_, true);
+        nbLeaves_ = ranks_.size() + 1;
+        byLeft_.assign(nbLeaves_, pair<size_t, size_t>(NONE, NONE));
+        byRight_.assign(nbLeaves_, pair<size_t, size_t>(NONE, NONE));
+        traverse_(reference_, false);
+      }
 
+      const Node* getReferenceLeaf() const { return reference_; }
 
-  if (checkNames && !VectorTools::haveSameElements(tr1.getLeavesNames(), tr2.getLeavesNames()))
-    throw Exception("Distinct leaf sets between trees ");
+      size_t getNumberOfLeaves() const { return nbLeaves_; }
 
-  /* prepare things */
-  int missing1 = 0;
-  int missing2 = 0;
+      size_t getNumberOfClusters() const { return nbClusters_; }
 
-  bipL1 = new BipartitionList(tr1, true);
-  bipL1->removeTrivialBipartitions();
-  bipL1->sortByPartitionSize();
-  bipL2 = new BipartitionList(tr2, true);
-  bipL2->removeTrivialBipartitions();
-  bipL2->sortByPartitionSize();
+      /**
+       * Count the clusters of another tree, and those shared with the first tree.
+       *
+       * @param reference The leaf of the other tree with the same name as the reference leaf of the first tree.
+       */
+      void compare(const Node* reference, size_t& nbClusters, size_t& nbShared) const
+      {
+        nbClusters = 0;
+        nbShared = 0;
+        vector<Frame> stack;
+        stack.push_back(makeFrame_(reference, 0));
+        while (true)
+        {
+          Frame& frame = stack.back();
+          const Node* neighbor = getNeighbor_(frame);
+          if (neighbor)
+          {
+            stack.push_back(makeFrame_(neighbor, frame.node));
+            continue;
+          }
+          Frame done = frame;
+          stack.pop_back();
+          if (stack.empty())
+            break;
+          if (done.nbSons == 0)
+          {
+            if (done.node->getNumberOfSons() > 0)
+              continue; // Root with a single son.
+            unordered_map<string, size_t>::const_iterator it = ranks_.find(done.node->getName());
+            if (it == ranks_.end() || done.node == reference)
+              throw Exception("TreeTools::robinsonFouldsDistance. Distinct leaf sets between trees.");
+            done.left = done.right = it->second;
+            done.size = 1;
+          }
+          else if (done.nbSons > 1 && done.size < nbLeaves_ - 1)
+          {
+            nbClusters++;
+            if (done.right - done.left + 1 == done.size
+                && ((byLeft_[done.left].first == done.left && byLeft_[done.left].second == done.right)
+                    || (byRight_[done.right].first == done.left && byRight_[done.right].second == done.right)))
+              nbShared++;
+          }
+          addSon_(stack.back(), done);
+        }
+      }
 
+    private:
+      static const Node* findReferenceLeaf_(const Node* root)
+      {
+        const Node* node = root;
+        while (node->getNumberOfSons() > 0)
+        {
+          node = node->getSon(0);
+        }
+        return node;
+      }
 
-  for (i = 0; i < bipL1->getNumberOfBipartitions(); i++)
-  {
-    size1.push_back(bipL1->getPartitionSize(i));
-  }
-  for (i = 0; i < bipL2->getNumberOfBipartitions(); i++)
-  {
-    size2.push_back(bipL2->getPartitionSize(i));
-  }
+      static Frame makeFrame_(const Node* node, const Node* from)
+      {
+        Frame frame;
+        frame.node = node;
+        frame.from = from;
+        frame.next = 0;
+        frame.left = NONE;
+        frame.right = 0;
+        frame.size = 0;
+        frame.nbSons = 0;
+        frame.hasPending = false;
+        frame.pendingLeft = frame.pendingRight = 0;
+        return frame;
+      }
 
-  for (i = 0; i < bipL2->getNumberOfBipartitions(); i++)
-  {
-    bipOK2.push_back(false);
-  }
+      /**
+       * @return The next neighbor of a node, not counting the node it is visited from, or 0.
+       */
+      static const Node* getNeighbor_(Frame& frame)
+      {
+        size_t nbSons = frame.node->getNumberOfSons();
+        while (frame.next <= nbSons)
+        {
+          size_t k = frame.next++;
+          const Node* neighbor;
+          if (k < nbSons)
+            neighbor = frame.node->getSon(k);
+          else
+            neighbor = frame.node->hasFather() ? frame.node->getFather() : 0;
+          if (neighbor && neighbor != frame.from)
+            return neighbor;
+        }
+        return 0;
+      }
 
-  /* main loops */
+      static void addSon_(Frame& father, const Frame& son)
+      {
+        if (son.size == 0)
+          return;
+        father.left = std::min(father.left, son.left);
+        father.right = std::max(father.right, son.right);
+        father.size += son.size;
+        father.nbSons++;
+      }
 
-  for (i = 0; i < bipL1->getNumberOfBipartitions(); i++)
-  {
-    for (j = 0; j < bipL2->getNumberOfBipartitions(); j++)
-    {
-      if (bipOK2[j])
-        continue;
-      if (size1[i] == size2[j] && BipartitionTools::areIdentical(*bipL1, i, *bipL2, j))
+      /**
+       * Traverse the first tree, either to number its leaves, or to store its clusters.
+       */
+      void traverse_(const Node* reference, bool numbering)
       {
-        bipOK2[j] = true;
-        break;
+        vector<Frame> stack;
+        stack.push_back(makeFrame_(reference, 0));
+        while (true)
+        {
+          Frame& frame = stack.back();
+          const Node* neighbor = getNeighbor_(frame);
+          if (neighbor)
+          {
+            stack.push_back(makeFrame_(neighbor, frame.node));
+            continue;
+          }
+          Frame done = frame;
+          stack.pop_back();
+          if (stack.empty())
+            break;
+          Frame& father = stack.back();
+          if (done.nbSons == 0)
+          {
+            if (done.node->getNumberOfSons() > 0)
+              continue; // Root with a single son.
+            if (numbering)
+            {
+              size_t rank = ranks_.size();
+              if (!ranks_.insert(make_pair(done.node->getName(), rank)).second)
+                throw Exception("TreeTools::robinsonFouldsDistance. Duplicated leaf name: " + done.node->getName());
+              done.left = done.right = rank;
+            }
+            else
+              done.left = done.right = ranks_[done.node->getName()];
+            done.size = 1;
+          }
+          else if (!numbering)
+          {
+            // The last son of the node is now known:
+            if (done.nbSons > 1 && done.hasPending)
+              store_(done.pendingLeft, done.pendingRight, true);
+          }
+          if (!numbering && done.size > 0)
+          {
+            // The previous son of the father, if any, was not its last one:
+            if (father.hasPending)
+              store_(father.pendingLeft, father.pendingRight, false);
+            father.hasPending = false;
+            if (done.nbSons > 1 && done.size < nbLeaves_ - 1)
+            {
+              father.hasPending = true;
+              father.pendingLeft = done.left;
+              father.pendingRight = done.right;
+            }
+            else if (done.nbSons == 1 && done.hasPending)
+            {
+              // A node with a single son defines the same cluster as its son:
+              father.hasPending = true;
+              father.pendingLeft = done.pendingLeft;
+              father.pendingRight = done.pendingRight;
+            }
+          }
+          addSon_(father, done);
+        }
+      }
+
+      void store_(size_t left, size_t right, bool last)
+      {
+        pair<size_t, size_t>& entry = last ? byLeft_[left] : byRight_[right];
+        entry.first = left;
+        entry.second = right;
+        nbClusters_++;
       }
+  };
+
+  const size_t DayClusterTable::NONE = static_cast<size_t>(-1);
+}
+
+int TreeTools::robinsonFouldsDistance(const Tree& tr1, const Tree& tr2, bool checkNames, int* missing_in_tr2, int* missing_in_tr1)
+{
+  if (checkNames && !VectorTools::haveSameElements(tr1.getLeavesNames(), tr2.getLeavesNames()))
+    throw Exception("Distinct leaf sets between trees ");
+
+  const TreeTemplate<Node>* ttr1 = dynamic_cast<const TreeTemplate<Node>*>(&tr1);
+  const TreeTemplate<Node>* ttr2 = dynamic_cast<const TreeTemplate<Node>*>(&tr2);
+  unique_ptr< TreeTemplate<Node> > tmp1(ttr1 ? 0 : new TreeTemplate<Node>(tr1));
+  unique_ptr< TreeTemplate<Node> > tmp2(ttr2 ? 0 : new TreeTemplate<Node>(tr2));
+  if (!ttr1) ttr1 = tmp1.get();
+  if (!ttr2) ttr2 = tmp2.get();
+
+  /* clusters of the first tree */
+  DayClusterTable table(ttr1->getRootNode());
+
+  /* the same reference leaf is used for the second tree */
+  const string& name = table.getReferenceLeaf()->getName();
+  const Node* reference = 0;
+  TreeTraversal<const Node> traversal(ttr2->getRootNode(), BasicTreeTraversal::PREORDER);
+  size_t nbLeaves2 = 0;
+  for (size_t i = 0; i < traversal.size(); i++)
+  {
+    if (traversal[i]->getNumberOfSons() == 0)
+    {
+      nbLeaves2++;
+      if (!reference && traversal[i]->getName() == name)
+        reference = traversal[i];
     }
-    if (j == bipL2->getNumberOfBipartitions())
-      missing2++;
   }
+  if (!reference || nbLeaves2 != table.getNumberOfLeaves())
+    throw Exception("TreeTools::robinsonFouldsDistance. Distinct leaf sets between trees.");
+
+  size_t nbClusters2, nbShared;
+  table.compare(reference, nbClusters2, nbShared);
 
-  missing1 = static_cast<int>(bipL2->getNumberOfBipartitions()) - static_cast<int>(bipL1->getNumberOfBipartitions()) + missing2;
+  int missing2 = static_cast<int>(table.getNumberOfClusters() - nbShared);
+  int missing1 = static_cast<int>(nbClusters2 - nbShared);
 
   if (missing_in_tr1)
     *missing_in_tr1 = missing1;
@@ -950,76 +1232,139 @@ int TreeTools::robinsonFouldsDistance(const Tree& tr1, const Tree& tr2, bool che
 
 /******************************************************************************/
 
-BipartitionList* TreeTools::bipartitionOccurrences(const vector<Tree*>& vecTr, vector<size_t>& bipScore)
+DistanceMatrix* TreeTools::robinsonFouldsDistances(const vector<Tree*>& vecTr, bool normalize, bool checkNames)
 {
-  vector<BipartitionList*> vecBipL;
-  BipartitionList* mergedBipL;
-  vector<size_t> bipSize;
-  size_t nbBip;
+  if (vecTr.size() == 0)
+    throw Exception("TreeTools::robinsonFouldsDistances. Empty vector passed");
 
-  /*  build and merge bipartitions */
-  for (size_t i = 0; i < vecTr.size(); i++)
+  vector<string> elements = vecTr[0]->getLeavesNames();
+  if (checkNames)
   {
-    vecBipL.push_back(new BipartitionList(*vecTr[i]));
+    for (size_t i = 1; i < vecTr.size(); i++)
+    {
+      if (!VectorTools::haveSameElements(vecTr[i]->getLeavesNames(), elements))
+        throw Exception("TreeTools::robinsonFouldsDistances. Distinct leaf sets between trees");
+    }
   }
-  mergedBipL = BipartitionTools::mergeBipartitionLists(vecBipL);
-  for (size_t i = 0; i < vecTr.size(); i++)
-  {
-    delete vecBipL[i];
+  std::sort(elements.begin(), elements.end());
+  BipartitionSet bipS(elements);
+  size_t nbWords = bipS.getNumberOfWords();
+
+  /* each tree is coded once, as the sorted indices of its non-trivial bipartitions in a common set */
+  size_t nbTrees = vecTr.size();
+  vector< vector<size_t> > indices(nbTrees);
+  const size_t batchSize = 256;
+  vector< vector<uint64_t> > bits(std::min(batchSize, nbTrees));
+  vector<string> errors(bits.size());
+  for (size_t first = 0; first < nbTrees; first += batchSize)
+  {
+    size_t nb = std::min(batchSize, nbTrees - first);
+    long lnb = static_cast<long>(nb);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (long li = 0; li < lnb; ++li)
+    {
+      size_t i = static_cast<size_t>(li);
+      vector<int> nodeIds;
+      try
+      {
+        bipS.getTreeBipartitions(*vecTr[first + i], bits[i], nodeIds);
+      }
+      catch (exception& e)
+      {
+        errors[i] = e.what();
+      }
+    }
+    // Bipartitions are added in the order of the trees, as the set is not thread-safe:
+    for (size_t i = 0; i < nb; i++)
+    {
+      if (!errors[i].empty())
+        throw Exception(errors[i]);
+      vector<size_t>& treeIndices = indices[first + i];
+      treeIndices.resize(bits[i].size() / nbWords);
+      for (size_t j = 0; j < treeIndices.size(); j++)
+      {
+        treeIndices[j] = bipS.add(&bits[i][j * nbWords]);
+      }
+      // Nodes with a single son define the same bipartition as their son, which is counted once:
+      std::sort(treeIndices.begin(), treeIndices.end());
+      treeIndices.erase(std::unique(treeIndices.begin(), treeIndices.end()), treeIndices.end());
+    }
   }
 
-  mergedBipL->removeTrivialBipartitions();
-  nbBip = mergedBipL->getNumberOfBipartitions();
-  bipScore.clear();
-  for (size_t i = 0; i < nbBip; i++)
+  /* distances between all pairs of trees */
+  vector<string> names(nbTrees);
+  for (size_t i = 0; i < nbTrees; i++)
   {
-    bipSize.push_back(mergedBipL->getPartitionSize(i));
-    bipScore.push_back(1);
+    names[i] = vecTr[i]->getName();
+    if (names[i].empty())
+      names[i] = "Tree" + TextTools::toString(i + 1);
   }
-
-  /* compare bipartitions */
-  for (size_t i = nbBip; i > 0; i--)
+  DistanceMatrix* matrix = new DistanceMatrix(names);
+  long lnbTrees = static_cast<long>(nbTrees);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (long li = 0; li < lnbTrees; ++li)
   {
-    if (bipScore[i - 1] == 0)
-      continue;
-    for (size_t j = i - 1; j > 0; j--)
+    size_t i = static_cast<size_t>(li);
+    const vector<size_t>& indices1 = indices[i];
+    (*matrix)(i, i) = 0;
+    for (size_t j = i + 1; j < nbTrees; j++)
     {
-      if (bipScore[j - 1] && bipSize[i - 1] == bipSize[j - 1] && mergedBipL->areIdentical(i - 1, j - 1))
+      const vector<size_t>& indices2 = indices[j];
+      size_t nbShared = 0;
+      for (size_t k1 = 0, k2 = 0; k1 < indices1.size() && k2 < indices2.size(); )
       {
-        bipScore[i - 1]++;
-        bipScore[j - 1] = 0;
+        if (indices1[k1] < indices2[k2])
+          k1++;
+        else if (indices2[k2] < indices1[k1])
+          k2++;
+        else
+        {
+          nbShared++;
+          k1++;
+          k2++;
+        }
       }
+      size_t total = indices1.size() + indices2.size();
+      double d = static_cast<double>(total - 2 * nbShared);
+      if (normalize)
+        d = (total > 0 ? d / static_cast<double>(total) : 0.);
+      (*matrix)(i, j) = (*matrix)(j, i) = d;
     }
   }
+  return matrix;
+}
 
-  /* keep only distinct bipartitions */
-  for (size_t i = nbBip; i > 0; i--)
-  {
-    if (bipScore[i - 1] == 0)
-    {
-      bipScore.erase(bipScore.begin() + static_cast<ptrdiff_t>(i - 1));
-      mergedBipL->deleteBipartition(i - 1);
-    }
-  }
+/******************************************************************************/
 
-  /* add terminal branches */
-  mergedBipL->addTrivialBipartitions(false);
-  for (size_t i = 0; i < mergedBipL->getNumberOfElements(); i++)
-  {
-    bipScore.push_back(vecTr.size());
-  }
+BipartitionList* TreeTools::bipartitionOccurrences(const vector<Tree*>& vecTr, vector<size_t>& bipScore)
+{
+  if (vecTr.size() == 0)
+    throw Exception("TreeTools::bipartitionOccurrences. Empty vector passed");
+
+  BipartitionCounter counter(false);
+  counter.addTrees(vecTr);
+  return counter.getBipartitions(bipScore);
+}
 
-  return mergedBipL;
+/******************************************************************************/
+
+BipartitionList* TreeTools::bipartitionOccurrences(ITreeStream& trees, vector<size_t>& bipScore, size_t& nbTrees)
+{
+  BipartitionCounter counter(false);
+  counter.addTrees(trees);
+  nbTrees = counter.getNumberOfTrees();
+  return counter.getBipartitions(bipScore);
 }
 
 /******************************************************************************/
 
 TreeTemplate<Node>* TreeTools::thresholdConsensus(const vector<Tree*>& vecTr, double threshold, bool checkNames)
 {
-  vector<size_t> bipScore;
   vector<string> tr0leaves;
-  BipartitionList* bipL;
-  double score;
 
   if (vecTr.size() == 0)
     throw Exception("TreeTools::thresholdConsensus. Empty vector passed");
@@ -1035,33 +1380,21 @@ TreeTemplate<Node>* TreeTools::thresholdConsensus(const vector<Tree*>& vecTr, do
     }
   }
 
-  bipL = bipartitionOccurrences(vecTr, bipScore);
+  BipartitionCounter counter(false);
+  counter.addTrees(vecTr);
+  return counter.getConsensus(threshold);
+}
 
-  for (size_t i = bipL->getNumberOfBipartitions(); i > 0; i--)
-  {
-    if (bipL->getPartitionSize(i - 1) == 1)
-      continue;
-    score = static_cast<int>(bipScore[i - 1]) / static_cast<double>(vecTr.size());
-    if (score <= threshold && score != 1.)
-    {
-      bipL->deleteBipartition(i - 1);
-      continue;
-    }
-    if (score > 0.5)
-      continue;
-    for (size_t j = bipL->getNumberOfBipartitions(); j > i; j--)
-    {
-      if (!bipL->areCompatible(i - 1, j - 1))
-      {
-        bipL->deleteBipartition(i - 1);
-        break;
-      }
-    }
-  }
+/******************************************************************************/
 
-  TreeTemplate<Node>* tr = bipL->toTree();
-  delete bipL;
-  return tr;
+TreeTemplate<Node>* TreeTools::thresholdConsensus(ITreeStream& trees, double threshold, bool checkNames)
+{
+  BipartitionCounter counter(checkNames);
+  counter.addTrees(trees);
+  if (counter.getNumberOfTrees() == 0)
+    throw Exception("TreeTools::thresholdConsensus. Empty stream passed");
+
+  return counter.getConsensus(threshold);
 }
 
 /******************************************************************************/
@@ -1087,6 +1420,27 @@ TreeTemplate<Node>* TreeTools::strictConsensus(const vector<Tree*>& vecTr, bool
 
 /******************************************************************************/
 
+TreeTemplate<Node>* TreeTools::fullyResolvedConsensus(ITreeStream& trees, bool checkNames)
+{
+  return thresholdConsensus(trees, 0., checkNames);
+}
+
+/******************************************************************************/
+
+TreeTemplate<Node>* TreeTools::majorityConsensus(ITreeStream& trees, bool checkNames)
+{
+  return thresholdConsensus(trees, 0.5, checkNames);
+}
+
+/******************************************************************************/
+
+TreeTemplate<Node>* TreeTools::strictConsensus(ITreeStream& trees, bool checkNames)
+{
+  return thresholdConsensus(trees, 1., checkNames);
+}
+
+/******************************************************************************/
+
 Tree* TreeTools::MRP(const vector<Tree*>& vecTr)
 {
   // matrix representation
@@ -1118,34 +1472,21 @@ Tree* TreeTools::MRP(const vector<Tree*>& vecTr)
 
 void TreeTools::computeBootstrapValues(Tree& tree, const vector<Tree*>& vecTr, bool verbose, int format)
 {
-  vector<int> index;
-  BipartitionList bpTree(tree, true, &index);
-  vector<size_t> occurences;
-  BipartitionList* bpList = bipartitionOccurrences(vecTr, occurences);
-
-  vector< Number<double> > bootstrapValues(bpTree.getNumberOfBipartitions());
+  if (vecTr.size() == 0)
+    throw Exception("TreeTools::bipartitionOccurrences. Empty vector passed");
 
-  for (size_t i = 0; i < bpTree.getNumberOfBipartitions(); i++)
-  {
-    if (verbose)
-      ApplicationTools::displayGauge(i, bpTree.getNumberOfBipartitions() - 1, '=');
-    for (size_t j = 0; j < bpList->getNumberOfBipartitions(); j++)
-    {
-      if (BipartitionTools::areIdentical(bpTree, i, *bpList, j))
-      {
-        bootstrapValues[i] = format >= 0 ? round(static_cast<double>(occurences[j]) * pow(10., 2 + format) / static_cast<double>(vecTr.size())) / pow(10., format) : static_cast<double>(occurences[j]);
-        break;
-      }
-    }
-  }
+  BipartitionCounter counter(false);
+  counter.addTrees(vecTr);
+  counter.setBootstrapValues(tree, verbose, format);
+}
 
-  for (size_t i = 0; i < index.size(); i++)
-  {
-    if (!tree.isLeaf(index[i]))
-      tree.setBranchProperty(index[i], BOOTSTRAP, bootstrapValues[i]);
-  }
+/******************************************************************************/
 
-  delete bpList;
+void TreeTools::computeBootstrapValues(Tree& tree, ITreeStream& trees, bool verbose, int format)
+{
+  BipartitionCounter counter(false);
+  counter.addTrees(trees);
+  counter.setBootstrapValues(tree, verbose, format);
 }
 
 /******************************************************************************/
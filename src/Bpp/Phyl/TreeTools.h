@@ -55,6 +55,8 @@ knowledge of the CeCILL license and that you accept its terms.
 namespace bpp
 {
 
+class ITreeStream;
+
 /**
  * @brief Generic utilitary methods dealing with trees.
  *
@@ -154,6 +156,7 @@ class TreeTools
      * @brief Get the id of the last common ancestors of all specified nodes.
      *
      * Nodes id need not correspond to leaves.
+     * For repeated queries on the same tree, use a TreeQueryIndex.
      *
      * @author Simon Carrignon
      * @param tree The tree to use.
@@ -383,6 +386,7 @@ class TreeTools
      * @brief Get the total distance between two nodes.
      *
      * Sum all branch lengths between two nodes.
+     * For repeated queries on the same tree, use a TreeQueryIndex.
      *
      * @param tree The tree to consider.
      * @param nodeId1 First node id.
@@ -399,7 +403,10 @@ class TreeTools
      * A new DistanceMatrix object is created, and a pointer toward it is returned.
      * The destruction of this matrix is left up to the user.
      *
-     * @see getDistanceBetweenAnyTwoNodes
+     * A TreeQueryIndex is built for the tree, so that each distance is obtained
+     * in constant time, and rows are filled in parallel if OpenMP is enabled.
+     *
+     * @see TreeQueryIndex
      *
      * @param tree The tree to use.
      * @return The distance matrix computed from tree.
@@ -585,6 +592,13 @@ class TreeTools
     /**
      * @brief Calculates the Robinson-Foulds topological distance between two trees
      *
+     * Bipartitions are compared with Day's algorithm, in a time linear in the number of leaves:
+     * the leaves of the first tree are numbered so that its bipartitions are intervals,
+     * stored in a table, and each bipartition of the second tree is looked for in constant time.
+     * Nodes with a single son and trivial bipartitions are ignored.
+     *
+     * W. H. E. Day, Optimal algorithms for comparing trees with labeled leaves, Journal of Classification 2:7-28 (1985).
+     *
      * The two trees must share a common set of leaves (checked if checkNames is true)
      * Three numbers are calculated:
      *
@@ -599,6 +613,25 @@ class TreeTools
      */
     static int robinsonFouldsDistance(const Tree& tr1, const Tree& tr2, bool checkNames = true, int* missing_in_tr2 = NULL, int* missing_in_tr1 = NULL);
 
+    /**
+     * @brief Calculates the Robinson-Foulds distances between all pairs of trees
+     *
+     * The non-trivial bipartitions of each tree are computed only once, and
+     * indexed in a common BipartitionSet. Distances are then obtained by
+     * comparing sorted bipartition indices. Trees are processed in parallel if
+     * OpenMP is enabled.
+     *
+     * The normalized distance is the number of bipartitions found in only one of
+     * the two trees, divided by the total number of bipartitions of the two trees.
+     *
+     * @param vecTr The trees to compare, which must share a common set of leaves (checked if checkNames is true).
+     * @param normalize Tell if the normalized distance should be computed.
+     * @param checkNames Tell whether we should check the trees first.
+     * @return A new distance matrix, named after the trees (or Tree1, Tree2, etc. for trees without a name), that can be used with distance methods.
+     * @throw Exception If checkNames is set to true and trees do not share the same leaves names.
+     */
+    static DistanceMatrix* robinsonFouldsDistances(const std::vector<Tree*>& vecTr, bool normalize = false, bool checkNames = true);
+
     /**
      * @brief Counts the total number of occurrences of every bipartition from the input trees
      *
@@ -612,6 +645,20 @@ class TreeTools
      */
     static BipartitionList* bipartitionOccurrences(const std::vector<Tree*>& vecTr, std::vector<size_t>& bipScore);
 
+    /**
+     * @brief Counts the total number of occurrences of every bipartition from a stream of trees
+     *
+     * Same as the vector version, but trees are read, processed and deleted one at a time,
+     * so that only distinct bipartitions are stored in memory.
+     *
+     * @param trees The input trees (must share a common set of leaves).
+     * @param bipScore Output as the numbers of occurrences of the returned distinct bipartitions
+     * @param nbTrees Output as the number of trees read.
+     * @return A BipartitionList object including only distinct bipartitions
+     * @throw Exception If the stream is empty.
+     */
+    static BipartitionList* bipartitionOccurrences(ITreeStream& trees, std::vector<size_t>& bipScore, size_t& nbTrees);
+
     /**
      * @brief General greedy consensus tree method
      *
@@ -620,6 +667,10 @@ class TreeTools
      * A bipartition is included if it is compatible with all previously included bipartitions, and if its score
      * is higher than a threshold.
      *
+     * Bipartitions are counted in a single pass, in parallel if OpenMP is enabled.
+     * To build several consensus trees, or to compute bootstrap values, from the
+     * same trees, use a BipartitionCounter directly.
+     *
      * @author Nicolas Galtier
      * @param vecTr Vector of input trees (must share a common set of leaves - checked if checkNames is true)
      * @param threshold Minimal acceptable score =number of occurrence of a bipartition/number of trees (0.<=threshold<=1.)
@@ -627,6 +678,17 @@ class TreeTools
      */
     static TreeTemplate<Node>* thresholdConsensus(const std::vector<Tree*>& vecTr, double threshold, bool checkNames = true);
 
+    /**
+     * @brief General greedy consensus tree method, from a stream of trees
+     *
+     * Trees are read one at a time, and deleted once their bipartitions have been counted.
+     *
+     * @param trees The input trees (must share a common set of leaves - checked if checkNames is true)
+     * @param threshold Minimal acceptable score =number of occurrence of a bipartition/number of trees (0.<=threshold<=1.)
+     * @param checkNames Tell whether we should check the trees first.
+     */
+    static TreeTemplate<Node>* thresholdConsensus(ITreeStream& trees, double threshold, bool checkNames = true);
+
     /**
      * @brief Fully-resolved greedy consensus tree method
      *
@@ -638,6 +700,7 @@ class TreeTools
      * @param checkNames Tell whether we should check the trees first.
      */
     static TreeTemplate<Node>* fullyResolvedConsensus(const std::vector<Tree*>& vecTr, bool checkNames = true);
+    static TreeTemplate<Node>* fullyResolvedConsensus(ITreeStream& trees, bool checkNames = true);
 
     /**
      * @brief Majority consensus tree method
@@ -649,6 +712,7 @@ class TreeTools
      * @param checkNames Tell whether we should check the trees first.
      */
     static TreeTemplate<Node>* majorityConsensus(const std::vector<Tree*>& vecTr, bool checkNames = true);
+    static TreeTemplate<Node>* majorityConsensus(ITreeStream& trees, bool checkNames = true);
 
     /**
      * @brief Strict consensus tree method
@@ -660,6 +724,7 @@ class TreeTools
      * @param checkNames Tell whether we should check the trees first.
      */
     static TreeTemplate<Node>* strictConsensus(const std::vector<Tree*>& vecTr, bool checkNames = true);
+    static TreeTemplate<Node>* strictConsensus(ITreeStream& trees, bool checkNames = true);
 
     /** @} */
 
@@ -684,8 +749,16 @@ class TreeTools
      * @param verbose Tell if a progress bar should be displayed.
      * @param format  If null or positive, bootstrap values are reported as percentage, with the given number of decimal digits.
      *                If negative, bootstrap calues are the raw number of tree occurrences.
+     * @see BipartitionCounter::setBootstrapValues
      */
     static void computeBootstrapValues(Tree& tree, const std::vector<Tree*>& vecTr, bool verbose = true, int format = 0);
+
+    /**
+     * @brief Compute bootstrap values from a stream of trees.
+     *
+     * @see computeBootstrapValues(Tree&, const std::vector<Tree*>&, bool, int)
+     */
+    static void computeBootstrapValues(Tree& tree, ITreeStream& trees, bool verbose = true, int format = 0);
 	
     /**
      * @brief Determine the mid-point position of the root along the branch that already contains the root. Consequently, the topology of the rooted tree remains identical.
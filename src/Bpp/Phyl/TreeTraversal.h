@@ -0,0 +1,171 @@
+//
+// File: TreeTraversal.h
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#ifndef _TREETRAVERSAL_H_
+#define _TREETRAVERSAL_H_
+
+// From the STL:
+#include <vector>
+#include <utility>
+
+namespace bpp
+{
+
+/**
+ * @brief Traversal orders shared by all TreeTraversal instances.
+ */
+class BasicTreeTraversal
+{
+  public:
+    enum Order
+    {
+      /** Father first, then sons from left to right. */
+      PREORDER,
+      /** Sons from left to right, then father. */
+      POSTORDER,
+      /**
+       * Sons 0 to n/2-1, then father, then sons n/2 to n-1.
+       * A node with a single son is hence listed before its son.
+       */
+      INORDER
+    };
+
+  public:
+    virtual ~BasicTreeTraversal() {}
+};
+
+/**
+ * @brief A traversal plan for a (sub)tree.
+ *
+ * The nodes are listed once, in the requested order, using an explicit
+ * stack. The nodes themselves are never modified, so that several plans can
+ * be computed concurrently on a constant tree, using N = const Node.
+ *
+ * The plan is a snapshot of the topology at the time it was computed: it
+ * must be updated with build() if nodes are added or removed. Calling
+ * build() on an existing plan reuses its storage.
+ *
+ * @code
+ * TreeTraversal<const Node> traversal(tree.getRootNode(), BasicTreeTraversal::POSTORDER);
+ * for (const Node* node : traversal) { ... }
+ * @endcode
+ *
+ * @see TreeIterator
+ */
+template<class N>
+class TreeTraversal :
+  public BasicTreeTraversal
+{
+  public:
+    typedef typename std::vector<N*>::const_iterator const_iterator;
+
+  private:
+    Order order_;
+    std::vector<N*> nodes_;
+    std::vector< std::pair<N*, size_t> > stack_;
+
+  public:
+    /**
+     * @param root  The node where the traversal starts.
+     * @param order The traversal order.
+     */
+    TreeTraversal(N* root, Order order) :
+      order_(order),
+      nodes_(),
+      stack_()
+    {
+      build(root);
+    }
+
+    virtual ~TreeTraversal() {}
+
+  public:
+    /**
+     * @brief Compute the traversal starting at a given node.
+     *
+     * @param root The node where the traversal starts, or 0 for an empty traversal.
+     */
+    void build(N* root)
+    {
+      nodes_.clear();
+      if (!root) return;
+      // Each stack element is a node together with the position of the next son to visit:
+      stack_.clear();
+      stack_.push_back(std::make_pair(root, size_t(0)));
+      if (order_ == PREORDER) nodes_.push_back(root);
+      while (!stack_.empty())
+      {
+        N* node = stack_.back().first;
+        size_t k = stack_.back().second;
+        size_t nbSons = node->getNumberOfSons();
+        if (order_ == INORDER && k == nbSons / 2)
+          nodes_.push_back(node);
+        if (k < nbSons)
+        {
+          stack_.back().second++;
+          N* son = node->getSon(k);
+          if (order_ == PREORDER) nodes_.push_back(son);
+          stack_.push_back(std::make_pair(son, size_t(0)));
+        }
+        else
+        {
+          if (order_ == POSTORDER) nodes_.push_back(node);
+          stack_.pop_back();
+        }
+      }
+    }
+
+    Order getOrder() const { return order_; }
+
+    /**
+     * @return All nodes, in traversal order.
+     */
+    const std::vector<N*>& getNodes() const { return nodes_; }
+
+    size_t size() const { return nodes_.size(); }
+
+    N* operator[](size_t i) const { return nodes_[i]; }
+
+    const_iterator begin() const { return nodes_.begin(); }
+    const_iterator end() const { return nodes_.end(); }
+};
+
+} // end of namespace bpp.
+
+#endif // _TREETRAVERSAL_H_
@@ -0,0 +1,146 @@
+//
+// File: test_alias_sampling.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include <Bpp/Seq/Alphabet/DNA.h>
+#include <Bpp/Phyl/TreeTemplate.h>
+#include <Bpp/Phyl/Model/Nucleotide/GTR.h>
+#include <Bpp/Phyl/Model/RateDistribution/GammaDiscreteRateDistribution.h>
+#include <Bpp/Phyl/Simulation/HomogeneousSequenceSimulator.h>
+#include <Bpp/Phyl/Simulation/AliasTable.h>
+#include <Bpp/Phyl/Simulation/CounterRandomGenerator.h>
+#include <iostream>
+
+using namespace bpp;
+using namespace std;
+
+//Critical value of the chi-square test at level 0.001, using the normal approximation:
+double critical(size_t df) {
+  return static_cast<double>(df) + 3.09 * sqrt(2. * static_cast<double>(df));
+}
+
+//Two-sample chi-square statistic:
+double chi2(const vector<double>& a, const vector<double>& b, size_t& df) {
+  double chi = 0;
+  df = 0;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i] + b[i] > 0) {
+      chi += (a[i] - b[i]) * (a[i] - b[i]) / (a[i] + b[i]);
+      df++;
+    }
+  }
+  if (df > 0) df--;
+  return chi;
+}
+
+int main() {
+  //Alias tables against the exact distributions:
+  CounterRandomGenerator generator(1);
+  size_t sizes[] = {1, 4, 61, 400};
+  for (size_t k = 0; k < 4; ++k) {
+    size_t n = sizes[k];
+    vector<double> weights(n);
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+      weights[i] = (n > 1 && generator.drawNumber() < 0.2) ? 0 : generator.drawNumber();
+      sum += weights[i];
+    }
+    AliasTable table(weights);
+    size_t nbDraws = 1000000;
+    vector<double> counts(n, 0);
+    for (size_t i = 0; i < nbDraws; ++i)
+      counts[table.draw(generator.drawNumber())]++;
+    double chi = 0;
+    size_t df = 0;
+    for (size_t i = 0; i < n; ++i) {
+      double expected = static_cast<double>(nbDraws) * weights[i] / sum;
+      if (expected > 0) {
+        chi += (counts[i] - expected) * (counts[i] - expected) / expected;
+        df++;
+      } else if (counts[i] > 0) {
+        cerr << "Outcome with null probability drawn." << endl;
+        return 1;
+      }
+    }
+    if (df > 0) df--;
+    cout << n << " outcomes: chi2 = " << chi << ", df = " << df << endl;
+    if (df > 0 && chi > critical(df))
+      return 1;
+  }
+
+  //Simulations with and without alias tables:
+  TreeTemplate<Node>* tree = TreeTemplateTools::parenthesisToTree("((A:0.1, B:0.2):0.3,C:0.1,D:0.5);");
+  NucleicAlphabet* alphabet = new DNA();
+  SubstitutionModel* model = new GTR(alphabet, 1, 0.2, 0.3, 0.4, 0.4, 0.1, 0.35, 0.35, 0.2);
+  DiscreteDistribution* rdist = new GammaDiscreteRateDistribution(4, 0.5);
+  HomogeneousSequenceSimulator simulator(model, rdist, tree);
+  HomogeneousSequenceSimulator aliasSimulator(model, rdist, tree);
+  aliasSimulator.enableAliasSampling(true);
+
+  size_t nbSites = 200000;
+  unique_ptr<SiteContainer> sites(simulator.simulate(nbSites, 42));
+  unique_ptr<SiteContainer> aliasSites(aliasSimulator.simulate(nbSites, 42));
+  size_t nbSeqs = sites->getNumberOfSequences();
+  for (size_t i = 0; i < nbSeqs; ++i) {
+    for (size_t j = i + 1; j < nbSeqs; ++j) {
+      //Compare joint distributions of pairs of leaves:
+      vector<double> counts(16, 0), aliasCounts(16, 0);
+      const vector<int>& si = sites->getSequence(i).getContent();
+      const vector<int>& sj = sites->getSequence(j).getContent();
+      const vector<int>& ai = aliasSites->getSequence(i).getContent();
+      const vector<int>& aj = aliasSites->getSequence(j).getContent();
+      for (size_t k = 0; k < nbSites; ++k) {
+        counts[static_cast<size_t>(si[k] * 4 + sj[k])]++;
+        aliasCounts[static_cast<size_t>(ai[k] * 4 + aj[k])]++;
+      }
+      size_t df;
+      double chi = chi2(counts, aliasCounts, df);
+      cout << sites->getSequence(i).getName() << "-" << sites->getSequence(j).getName() << ": chi2 = " << chi << ", df = " << df << endl;
+      if (chi > critical(df))
+        return 1;
+    }
+  }
+
+  //-------------
+  delete tree;
+  delete alphabet;
+  delete model;
+  delete rdist;
+
+  return 0;
+}
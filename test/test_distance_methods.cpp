@@ -0,0 +1,185 @@
+//
+// File: test_distance_methods.cpp
+// Created by: agent
+// Created on: Sun Oct 18 2026
+//
+
+/*
+Copyright or © or Copr. Bio++ Development Team, (November 17, 2004)
+
+This software is a computer program whose purpose is to provide classes
+for numerical calculus. This file is part of the Bio++ project.
+
+This software is governed by the CeCILL  license under French law and
+abiding by the rules of distribution of free software.  You can  use, 
+modify and/ or redistribute the software under the terms of the CeCILL
+license as circulated by CEA, CNRS and INRIA at the following URL
+"http://www.cecill.info". 
+
+As a counterpart to the access to the source code and  rights to copy,
+modify and redistribute granted by the license, users are provided only
+with a limited warranty  and the software's author,  the holder of the
+economic rights,  and the successive licensors  have only  limited
+liability. 
+
+In this respect, the user's attention is drawn to the risks associated
+with loading,  using,  modifying and/or developing or reproducing the
+software by the user in light of its specific status of free software,
+that may mean  that it is complicated to manipulate,  and  that  also
+therefore means  that it is reserved for developers  and  experienced
+professionals having in-depth computer knowledge. Users are therefore
+encouraged to load and test the software's suitability as regards their
+requirements in conditions enabling the security of their systems and/or 
+data to be ensured and,  more generally, to use and operate it in the 
+same conditions as regards security. 
+
+The fact that you are presently reading this means that you have had
+knowledge of the CeCILL license and that you accept its terms.
+*/
+
+#include <Bpp/Numeric/Random/RandomTools.h>
+#include <Bpp/Phyl/TreeTemplate.h>
+#include <Bpp/Phyl/TreeTemplateTools.h>
+#include <Bpp/Phyl/TreeTools.h>
+#include <Bpp/Phyl/Distance/NeighborJoining.h>
+#include <Bpp/Phyl/Distance/BioNJ.h>
+#include <Bpp/Phyl/Distance/PGMA.h>
+#include <Bpp/Phyl/Distance/HierarchicalClustering.h>
+#include <Bpp/Phyl/Io/BinaryDistanceMatrixFormat.h>
+#include <Bpp/Seq/DistanceMatrix.h>
+#include <Bpp/Exceptions.h>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iostream>
+
+using namespace bpp;
+using namespace std;
+
+// Check that the compact engine returns the same topology as the generic algorithm.
+bool testMethod(AbstractAgglomerativeDistanceMethod& method, const DistanceMatrix& dist)
+{
+  method.setCompactEngine(true);
+  method.setCondensedDistanceMatrix(CondensedDistanceMatrix(dist));
+  method.computeTree();
+  Tree* compactTree = method.getTree();
+  method.setCompactEngine(false);
+  method.setDistanceMatrix(dist);
+  method.computeTree();
+  Tree* genericTree = method.getTree();
+  //The position of the root is arbitrary when the last three nodes are joined:
+  compactTree->unroot();
+  genericTree->unroot();
+  int rf = TreeTools::robinsonFouldsDistance(*compactTree, *genericTree);
+  delete compactTree;
+  delete genericTree;
+  if (rf != 0) {
+    cerr << method.getName() << ": RF distance between compact and generic trees is " << rf << endl;
+    return false;
+  }
+  return true;
+}
+
+// Check that a matrix written in binary format is read back identically, and can be used directly.
+bool testBinaryFormat(const DistanceMatrix& dist)
+{
+  BinaryDistanceMatrixFormat format;
+  format.writeDistanceMatrix(dist, "test_distance_methods.bin", true);
+  CondensedDistanceMatrix* condensed = format.readCondensedDistanceMatrix("test_distance_methods.bin");
+  bool test = (condensed->size() == dist.size());
+  for (size_t i = 0; test && i < dist.size(); ++i)
+  {
+    test = (condensed->getName(i) == dist.getName(i));
+    for (size_t j = 0; test && j < dist.size(); ++j)
+      test = ((*condensed)(i, j) == dist(i, j));
+  }
+  if (test) {
+    NeighborJoining nj(false, false, false);
+    nj.setCondensedDistanceMatrix(*condensed);
+    nj.computeTree();
+    delete nj.getTree();
+  } else {
+    cerr << "Binary format: matrix read differs from matrix written." << endl;
+  }
+  delete condensed;
+  return test;
+}
+
+// Check that corrupted headers and truncated files are reported, and do not trigger huge allocations.
+bool testCorruptedBinaryFormat(const DistanceMatrix& dist)
+{
+  BinaryDistanceMatrixFormat format;
+  ostringstream output;
+  format.writeDistanceMatrix(dist, output);
+  string data = output.str();
+  // Number of entries, size of the block of names, and end of the data:
+  vector<string> corrupted(3, data);
+  uint64_t n = (static_cast<uint64_t>(1) << 40);
+  corrupted[0].replace(16, sizeof(n), reinterpret_cast<const char*>(&n), sizeof(n));
+  uint64_t namesSize = (static_cast<uint64_t>(1) << 60);
+  corrupted[1].replace(24, sizeof(namesSize), reinterpret_cast<const char*>(&namesSize), sizeof(namesSize));
+  corrupted[2].resize(data.size() - sizeof(double));
+  for (size_t i = 0; i < corrupted.size(); ++i)
+  {
+    for (unsigned int k = 0; k < 2; ++k)
+    {
+      istringstream input(corrupted[i]);
+      try {
+        if (k == 0)
+          delete format.readDistanceMatrix(input);
+        else
+          delete format.readCondensedDistanceMatrix(input);
+        cerr << "Binary format: corrupted file " << i << " was read without error." << endl;
+        return false;
+      } catch (IOException& ex) {}
+    }
+  }
+  return true;
+}
+
+int main() {
+  for (unsigned int j = 0; j < 50; ++j) {
+    //Generate a random tree with random branch lengths:
+    vector<string> leaves(5 + j * 2);
+    for (size_t i = 0; i < leaves.size(); ++i)
+      leaves[i] = "leaf" + TextTools::toString(i);
+    TreeTemplate<Node>* tree = TreeTemplateTools::getRandomTree(leaves, false);
+    vector<Node*> nodes = tree->getNodes();
+    for (size_t i = 0; i < nodes.size(); ++i)
+      if (nodes[i]->hasFather())
+        nodes[i]->setDistanceToFather(0.01 + RandomTools::giveRandomNumberBetweenZeroAndEntry(0.5));
+
+    //Patristic distances with some noise:
+    DistanceMatrix* dist = TreeTemplateTools::getDistanceMatrix(*tree);
+    for (size_t i = 0; i < dist->size(); ++i)
+      for (size_t k = 0; k < i; ++k)
+        (*dist)(i, k) = (*dist)(k, i) = (*dist)(i, k) * (0.9 + RandomTools::giveRandomNumberBetweenZeroAndEntry(0.2));
+
+    NeighborJoining nj(false, false, false);
+    if (!testMethod(nj, *dist)) return 1;
+    NeighborJoining njRooted(true, true, false);
+    if (!testMethod(njRooted, *dist)) return 1;
+    BioNJ bionj(false, false, false);
+    if (!testMethod(bionj, *dist)) return 1;
+    PGMA upgma(false);
+    upgma.setVerbose(false);
+    if (!testMethod(upgma, *dist)) return 1;
+    PGMA wpgma(true);
+    wpgma.setVerbose(false);
+    if (!testMethod(wpgma, *dist)) return 1;
+    HierarchicalClustering single(HierarchicalClustering::SINGLE);
+    if (!testMethod(single, *dist)) return 1;
+    HierarchicalClustering complete(HierarchicalClustering::COMPLETE);
+    if (!testMethod(complete, *dist)) return 1;
+    HierarchicalClustering ward(HierarchicalClustering::WARD);
+    if (!testMethod(ward, *dist)) return 1;
+    if (!testBinaryFormat(*dist)) return 1;
+    if (!testCorruptedBinaryFormat(*dist)) return 1;
+
+    delete dist;
+    delete tree;
+  }
+  cout << "Compact and generic agglomeration engines give identical topologies." << endl;
+  return 0;
+}
@@ -193,6 +193,56 @@ int main() {
     delete m;
   }
 
+  //Check that counts for all types at once, computed or cached, match the count matrices:
+  vector<double> allCounts;
+  size_t nbDetTypes = detReg->getNumberOfSubstitutionTypes();
+  for (size_t k = 0; k < 2 * vd.size(); ++k)
+  {
+    double d = vd[k % vd.size()];
+    sCountUniDet->getAllNumbersOfSubstitutions(d, allCounts);
+    for (size_t t = 0; t < nbDetTypes; ++t)
+    {
+      m = sCountUniDet->getAllNumbersOfSubstitutions(d, t + 1);
+      size_t s = m->getNumberOfRows();
+      for (size_t x = 0; x < s; ++x)
+      {
+        for (size_t y = 0; y < s; ++y)
+        {
+          if (abs(allCounts[(x * s + y) * nbDetTypes + t] - (*m)(x, y)) > 0.000001)
+          {
+            cerr << "Error, counts for all types do not match count matrices." << endl;
+            return 1;
+          }
+        }
+      }
+      delete m;
+    }
+  }
+
+  //Check that uniformization agrees with decomposition, including on long branches, which are computed by squaring:
+  double tl[] = {0.001, 1, 50, 200};
+  for (auto d : tl)
+  {
+    for (size_t t = 0; t < nbDetTypes; ++t)
+    {
+      Matrix<double>* mu = sCountUniDet->getAllNumbersOfSubstitutions(d, t + 1);
+      Matrix<double>* md = sCountDecDet->getAllNumbersOfSubstitutions(d, t + 1);
+      for (size_t x = 0; x < mu->getNumberOfRows(); ++x)
+      {
+        for (size_t y = 0; y < mu->getNumberOfColumns(); ++y)
+        {
+          if (abs((*mu)(x, y) - (*md)(x, y)) > 0.000001 * max(1., (*md)(x, y)))
+          {
+            cerr << "Error, uniformization and decomposition counts differ for length " << d << "." << endl;
+            return 1;
+          }
+        }
+      }
+      delete mu;
+      delete md;
+    }
+  }
+
   //Check per branch:
   
   //1. Total:
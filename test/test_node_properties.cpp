@@ -0,0 +1,177 @@
+//
+// File: test_node_properties.cpp
+// Created by: agent
+// Created on: Mon Oct 19 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include <Bpp/Numeric/Number.h>
+#include <Bpp/BppString.h>
+#include <Bpp/Phyl/Node.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace bpp;
+using namespace std;
+
+//A property which is not stored by value:
+class Tag:
+  public virtual Clonable
+{
+  public:
+    vector<int> values;
+
+  public:
+    Tag(const vector<int>& v) : values(v) {}
+    Tag* clone() const { return new Tag(*this); }
+};
+
+double getDouble(const Clonable* property)
+{
+  const Number<double>* number = dynamic_cast<const Number<double>*>(property);
+  return number ? number->getValue() : -1.;
+}
+
+int main() {
+  PropertyKey xKey = PropertyRegistry::getKey("x");
+  PropertyKey nKey = PropertyRegistry::getKey("n");
+  PropertyKey sKey = PropertyRegistry::getKey("s");
+  PropertyKey tKey = PropertyRegistry::getKey("t");
+  if (PropertyRegistry::getName(xKey) != "x" || PropertyRegistry::getKey("x") != xKey)
+    return 1;
+
+  //Round trips, by name and by key:
+  Node node(0, "A");
+  node.setNodeProperty("x", Number<double>(1.5));
+  node.setNodeProperty("n", BppInteger(7));
+  node.setNodeProperty("s", BppString("text"));
+  node.setNodeProperty("t", Tag(vector<int>(3, 2)));
+  node.setBranchProperty("x", Number<double>(0.5));
+  const Node& cnode = node;
+  if (getDouble(cnode.getNodeProperty("x")) != 1.5 || cnode.getNodeDoubleProperty(xKey) != 1.5
+      || getDouble(cnode.getBranchProperty(xKey)) != 0.5 || cnode.getBranchDoubleProperty(xKey) != 0.5)
+    return 1;
+  const BppInteger* n = dynamic_cast<const BppInteger*>(cnode.getNodeProperty("n"));
+  if (!n || n->getValue() != 7 || cnode.getNodeIntegerProperty(nKey) != 7 || cnode.getNodeDoubleProperty(nKey) != 7.)
+    return 1;
+  const BppString* s = dynamic_cast<const BppString*>(cnode.getNodeProperty("s"));
+  if (!s || s->toSTL() != "text" || cnode.getNodeStringProperty(sKey) != "text")
+    return 1;
+  const Tag* t = dynamic_cast<const Tag*>(cnode.getNodeProperty(tKey));
+  if (!t || t->values != vector<int>(3, 2))
+    return 1;
+  if (cnode.getNodePropertyNames() != vector<string>({ "n", "s", "t", "x" }) || cnode.hasBranchProperty("n"))
+    return 1;
+  try {
+    cnode.getNodeStringProperty(xKey);
+    cerr << "A number was read as a string." << endl;
+    return 1;
+  } catch (PropertyNotFoundException& e) {
+    return 1;
+  } catch (Exception& e) {}
+  try {
+    cnode.getBranchProperty("s");
+    cerr << "A missing property was found." << endl;
+    return 1;
+  } catch (PropertyNotFoundException& e) {}
+
+  //Const accessors always return the same object, and leave the value as is:
+  const Clonable* x1 = cnode.getNodeProperty(xKey);
+  if (cnode.getNodeProperty("x") != x1 || cnode.getNodeDoubleProperty(xKey) != 1.5)
+    return 1;
+  //The non-const accessor keeps that object, and changes made through it are seen by typed accessors:
+  Number<double>* x2 = dynamic_cast<Number<double>*>(node.getNodeProperty("x"));
+  if (x2 != x1)
+    return 1;
+  *x2 = Number<double>(2.5);
+  if (cnode.getNodeDoubleProperty(xKey) != 2.5 || getDouble(cnode.getNodeProperty("x")) != 2.5)
+    return 1;
+  node.setNodeDoubleProperty(xKey, 3.5);
+  if (getDouble(cnode.getNodeProperty("x")) != 3.5)
+    return 1;
+
+  //Concurrent reads of a const node all get the same object:
+  Node shared(2, "C");
+  shared.setBranchProperty("x", Number<double>(0.25));
+  const Node& cshared = shared;
+  vector<const Clonable*> objects(100);
+#pragma omp parallel for
+  for (int i = 0; i < 100; ++i)
+    objects[static_cast<size_t>(i)] = cshared.getBranchProperty(xKey);
+  for (size_t i = 0; i < objects.size(); ++i) {
+    if (objects[i] != objects[0] || getDouble(objects[i]) != 0.25)
+      return 1;
+  }
+
+  //Release vs. erase:
+  unique_ptr<Clonable> released(node.removeNodeProperty("n"));
+  const BppInteger* r = dynamic_cast<const BppInteger*>(released.get());
+  if (!r || r->getValue() != 7 || node.hasNodeProperty("n") || node.hasNodeProperty(nKey))
+    return 1;
+  released.reset(node.removeNodeProperty("t"));
+  if (!dynamic_cast<Tag*>(released.get()) || node.hasNodeProperty("t"))
+    return 1;
+  node.deleteNodeProperty("s");
+  if (node.hasNodeProperty("s"))
+    return 1;
+  try {
+    node.deleteNodeProperty("s");
+    cerr << "A missing property was deleted." << endl;
+    return 1;
+  } catch (PropertyNotFoundException& e) {}
+
+  //Copies are independent:
+  node.setNodeProperty("t", Tag(vector<int>(2, 1)));
+  Node copy(node);
+  dynamic_cast<Tag*>(copy.getNodeProperty("t"))->values.push_back(0);
+  copy.setNodeDoubleProperty(xKey, 4.5);
+  if (dynamic_cast<const Tag*>(cnode.getNodeProperty("t"))->values.size() != 2 || cnode.getNodeDoubleProperty(xKey) != 3.5
+      || copy.getNodeDoubleProperty(xKey) != 4.5 || copy.getBranchDoubleProperty(xKey) != 0.5 || copy.getName() != "A")
+    return 1;
+
+  //Assignment replaces the properties of the copied node, and keeps the other ones:
+  Node other(1, "B");
+  other.setNodeProperty("n", BppInteger(3));
+  other.setNodeProperty("x", Number<double>(0.));
+  other = node;
+  if (other.getNodeIntegerProperty(nKey) != 3 || other.getNodeDoubleProperty(xKey) != 3.5
+      || dynamic_cast<const Tag*>(other.getNodeProperty("t"))->values.size() != 2 || other.getId() != 0)
+    return 1;
+
+  cout << "Node properties are correctly stored." << endl;
+  return 0;
+}
@@ -39,6 +39,7 @@ knowledge of the CeCILL license and that you accept its terms.
 
 #include <Bpp/Numeric/Matrix/MatrixTools.h>
 #include <Bpp/Seq/Alphabet/AlphabetTools.h>
+#include <Bpp/Seq/Io/Phylip.h>
 #include <Bpp/Phyl/TreeTemplate.h>
 #include <Bpp/Phyl/Model/Nucleotide/T92.h>
 #include <Bpp/Phyl/Model/FrequencySet/NucleotideFrequencySet.h>
@@ -49,6 +50,11 @@ knowledge of the CeCILL license and that you accept its terms.
 #include <Bpp/Phyl/Likelihood/RNonHomogeneousTreeLikelihood.h>
 #include <Bpp/Phyl/OptimizationTools.h>
 #include <iostream>
+#include <sstream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace bpp;
 using namespace std;
@@ -143,6 +149,125 @@ int main() {
   }
   delete modelSet3;
 
+  //Seeded simulations must not depend on the global generator nor on the number of threads:
+
+  cout << "Seeded check:" << endl;
+
+  unique_ptr<SiteContainer> sites3(simulator.simulate(1000, 42));
+  RandomTools::giveRandomNumberBetweenZeroAndEntry(1.);
+  NonHomogeneousSequenceSimulator simulator2(simulator);
+  unique_ptr<SiteContainer> sites4(simulator2.simulate(1000, 42));
+  unique_ptr<SiteContainer> sites5(simulator.simulate(1000, 43));
+  bool sameAs4 = true, sameAs5 = true;
+  for (size_t i = 0; i < sites3->getNumberOfSequences(); ++i) {
+    sameAs4 = sameAs4 && sites3->getSequence(i).getContent() == sites4->getSequence(i).getContent();
+    sameAs5 = sameAs5 && sites3->getSequence(i).getContent() == sites5->getSequence(i).getContent();
+  }
+  if (!sameAs4 || sameAs5)
+    return 1;
+
+  //Compact and streamed outputs must contain the same sites:
+  SimulatedSiteBlock states;
+  simulator.simulate(1000, 42, states);
+  for (size_t i = 0; i < sites3->getNumberOfSequences(); ++i) {
+    for (size_t j = 0; j < 1000; ++j) {
+      if (modelSet->getModel(0)->getAlphabetStateAsInt(states.getState(i, j)) != sites3->getSequence(i)[j])
+        return 1;
+    }
+  }
+  ostringstream phylip;
+  PhylipSimulationSink sink(phylip);
+  simulator.simulate(1000, 42, sink, 300);
+  string firstLine = phylip.str().substr(0, phylip.str().find('\n'));
+  if (firstLine != TextTools::toString(seqNames.size()) + " 1000")
+    return 1;
+  Phylip phylipReader(true, false);
+  istringstream phylipInput(phylip.str());
+  unique_ptr<SiteContainer> sites6(phylipReader.readAlignment(phylipInput, alphabet));
+  if (sites6->getNumberOfSequences() != sites3->getNumberOfSequences() || sites6->getNumberOfSites() != 1000)
+    return 1;
+  for (size_t i = 0; i < sites3->getNumberOfSequences(); ++i) {
+    if (sites6->getSequence(i).getName() != sites3->getSequence(i).getName()
+        || sites6->getSequence(i).toString() != sites3->getSequence(i).toString())
+      return 1;
+  }
+  unique_ptr<SiteContainer> noSites(simulator.simulate(0, 42));
+  if (noSites->getNumberOfSequences() != seqNames.size() || noSites->getNumberOfSites() != 0)
+    return 1;
+
+  //Sites simulated in batches must not depend on how they are grouped into blocks, with several rate classes:
+
+  cout << "Batch check:" << endl;
+
+  DiscreteDistribution* gamma = new GammaDiscreteRateDistribution(4, 0.5);
+  NonHomogeneousSequenceSimulator gammaSimulator(modelSet, gamma, tree);
+  ostringstream phylip1, phylip2, phylip3;
+  PhylipSimulationSink sink1(phylip1), sink2(phylip2), sink3(phylip3);
+  gammaSimulator.simulate(1000, 42, sink1, 1);
+  gammaSimulator.simulate(1000, 42, sink2, 300);
+  gammaSimulator.simulate(1000, 42, sink3);
+  if (phylip1.str() != phylip2.str() || phylip1.str() != phylip3.str())
+    return 1;
+
+  //Seeded simulations must not depend on the number of threads, with discrete, continuous or given rates:
+
+  cout << "Thread check:" << endl;
+
+  NonHomogeneousSequenceSimulator continuousSimulator(modelSet, gamma, tree);
+  continuousSimulator.enableContinuousRates(true);
+  vector<double> siteRates(1000);
+  for (size_t j = 0; j < siteRates.size(); ++j)
+    siteRates[j] = RandomTools::giveRandomNumberBetweenZeroAndEntry(2.);
+  vector<string> threadSequences[2];
+#ifdef _OPENMP
+  int maxThreads = omp_get_max_threads();
+#endif
+  for (unsigned int k = 0; k < 2; ++k) {
+#ifdef _OPENMP
+    omp_set_num_threads(k == 0 ? 1 : 4);
+#endif
+    unique_ptr<SiteContainer> discreteSites(gammaSimulator.simulate(1000, 42));
+    unique_ptr<SiteContainer> continuousSites(continuousSimulator.simulate(1000, 42));
+    unique_ptr<SiteContainer> givenRateSites(simulator.simulate(siteRates, 42));
+    for (size_t i = 0; i < discreteSites->getNumberOfSequences(); ++i) {
+      threadSequences[k].push_back(discreteSites->getSequence(i).toString());
+      threadSequences[k].push_back(continuousSites->getSequence(i).toString());
+      threadSequences[k].push_back(givenRateSites->getSequence(i).toString());
+    }
+  }
+#ifdef _OPENMP
+  omp_set_num_threads(maxThreads);
+#endif
+  //Continuous rates are drawn, and change the simulated sites:
+  if (threadSequences[0] != threadSequences[1] || threadSequences[0][0] == threadSequences[0][1])
+    return 1;
+
+  //On a tree with null branch lengths, all sequences are equal, and states follow the root frequencies:
+  TreeTemplate<Node>* tree0 = TreeTemplateTools::parenthesisToTree("((A:0, B:0):0,C:0,D:0);");
+  FrequencySet* rootFreqs0 = new GCFrequencySet(alphabet, 0.3);
+  SubstitutionModelSet* modelSet0 = SubstitutionModelSetTools::createHomogeneousModelSet(new T92(alphabet, 3.), rootFreqs0, tree0);
+  NonHomogeneousSequenceSimulator simulator0(modelSet0, gamma, tree0);
+  size_t n0 = 100000;
+  SimulatedSiteBlock states0;
+  simulator0.simulate(n0, 7, states0);
+  vector<double> rootFrequencies = modelSet0->getRootFrequencies();
+  vector<double> counts(rootFrequencies.size(), 0.);
+  for (size_t j = 0; j < n0; ++j) {
+    for (size_t i = 1; i < states0.getNumberOfSequences(); ++i) {
+      if (states0.getState(i, j) != states0.getState(0, j))
+        return 1;
+    }
+    counts[states0.getState(0, j)]++;
+  }
+  for (size_t x = 0; x < counts.size(); ++x) {
+    cout << rootFrequencies[x] << "\t" << counts[x] / static_cast<double>(n0) << endl;
+    if (abs(counts[x] / static_cast<double>(n0) - rootFrequencies[x]) > 0.01)
+      return 1;
+  }
+  delete modelSet0;
+  delete tree0;
+  delete gamma;
+
   //-------------
   delete tree;
   delete alphabet;
@@ -0,0 +1,115 @@
+//
+// File: test_site_patterns.cpp
+// Created by: agent
+// Created on: Mon Oct 19 2026
+//
+
+/*
+   Copyright or © or Copr. Bio++ Development Team, (November 16, 2004)
+
+   This software is a computer program whose purpose is to provide classes
+   for phylogenetic data analysis.
+
+   This software is governed by the CeCILL  license under French law and
+   abiding by the rules of distribution of free software.  You can  use,
+   modify and/ or redistribute the software under the terms of the CeCILL
+   license as circulated by CEA, CNRS and INRIA at the following URL
+   "http://www.cecill.info".
+
+   As a counterpart to the access to the source code and  rights to copy,
+   modify and redistribute granted by the license, users are provided only
+   with a limited warranty  and the software's author,  the holder of the
+   economic rights,  and the successive licensors  have only  limited
+   liability.
+
+   In this respect, the user's attention is drawn to the risks associated
+   with loading,  using,  modifying and/or developing or reproducing the
+   software by the user in light of its specific status of free software,
+   that may mean  that it is complicated to manipulate,  and  that  also
+   therefore means  that it is reserved for developers  and  experienced
+   professionals having in-depth computer knowledge. Users are therefore
+   encouraged to load and test the software's suitability as regards their
+   requirements in conditions enabling the security of their systems and/or
+   data to be ensured and,  more generally, to use and operate it in the
+   same conditions as regards security.
+
+   The fact that you are presently reading this means that you have had
+   knowledge of the CeCILL license and that you accept its terms.
+ */
+
+#include <Bpp/Numeric/Random/RandomTools.h>
+#include <Bpp/Text/TextTools.h>
+#include <Bpp/Seq/Alphabet/DNA.h>
+#include <Bpp/Seq/Container/VectorSiteContainer.h>
+#include <Bpp/Phyl/SitePatterns.h>
+#include <iostream>
+#include <memory>
+#include <set>
+
+using namespace bpp;
+using namespace std;
+
+//Check patterns against their definition: each site maps to a pattern with the same content,
+//weights count the sites of each pattern, and patterns are all different.
+bool checkPatterns(const SiteContainer& sites) {
+  SitePatterns patterns(&sites);
+  unique_ptr<SiteContainer> patternSites(patterns.getSites());
+  const vector<unsigned int>& weights = patterns.getWeights();
+  const vector<size_t>& indices = patterns.getIndices();
+  size_t nbPatterns = patternSites->getNumberOfSites();
+  if (indices.size() != sites.getNumberOfSites() || weights.size() != nbPatterns) {
+    cerr << "Wrong number of indices or weights." << endl;
+    return false;
+  }
+  vector<unsigned int> counts(nbPatterns, 0);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    if (indices[i] >= nbPatterns || patternSites->getSite(indices[i]).getContent() != sites.getSite(i).getContent()) {
+      cerr << "Site " << i << " is not mapped to a pattern with the same content." << endl;
+      return false;
+    }
+    counts[indices[i]]++;
+  }
+  if (counts != weights) {
+    cerr << "Weights do not match the number of sites of each pattern." << endl;
+    return false;
+  }
+  set< vector<int> > contents;
+  for (size_t p = 0; p < nbPatterns; ++p) {
+    if (!contents.insert(patternSites->getSite(p).getContent()).second) {
+      cerr << "Pattern " << p << " is duplicated." << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  const DNA* alphabet = new DNA();
+
+  //Columns 'TD-' and 'YA-', as well as 'TDA' and 'YAA', have the same hash, and must be kept apart:
+  VectorSiteContainer sites1(alphabet);
+  sites1.addSequence(BasicSequence("s1", "TYTYTNNA-", alphabet));
+  sites1.addSequence(BasicSequence("s2", "DADANNN-A", alphabet));
+  sites1.addSequence(BasicSequence("s3", "--AA-NN--", alphabet));
+  if (!checkPatterns(sites1))
+    return 1;
+  SitePatterns patterns1(&sites1);
+  if (patterns1.getWeights().size() != 8 || patterns1.getIndices()[0] == patterns1.getIndices()[1]
+      || patterns1.getIndices()[2] == patterns1.getIndices()[3] || patterns1.getIndices()[5] != patterns1.getIndices()[6])
+    return 1;
+
+  //Random sites with gaps and unknown characters, and many repeated patterns:
+  string characters = "ACGT-NRY";
+  VectorSiteContainer sites2(alphabet);
+  for (size_t i = 0; i < 5; ++i) {
+    string sequence(2000, 'A');
+    for (size_t j = 0; j < sequence.size(); ++j)
+      sequence[j] = characters[RandomTools::giveIntRandomNumberBetweenZeroAndEntry<size_t>(i < 2 ? characters.size() : 2)];
+    sites2.addSequence(BasicSequence("s" + TextTools::toString(i), sequence, alphabet));
+  }
+  if (!checkPatterns(sites2))
+    return 1;
+
+  delete alphabet;
+  return 0;
+}
@@ -6,6 +6,10 @@
 #include <iostream>
 #include <fstream>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 // From bpp-core:
 #include <Bpp/Text/TextTools.h>
 #include <Bpp/App/ApplicationTools.h>
@@ -288,6 +292,65 @@ int main()
             checkIfMappingLegal(stocMapping, mappings[i], ttree, characterTreeLikelihood);
         }
 
+        // make sure the mappings sampled by uniformization are legal as well
+        stocMapping->setSamplingMethod(StochasticMapping::UNIFORMIZATION_SAMPLING);
+        vector<Tree*> uniformizationMappings;
+        stocMapping->generateStochasticMapping(uniformizationMappings);
+        for (size_t i=0; i<uniformizationMappings.size(); ++i)
+        {
+            checkIfMappingLegal(stocMapping, uniformizationMappings[i], ttree, characterTreeLikelihood);
+            delete uniformizationMappings[i];
+        }
+        stocMapping->setSamplingMethod(StochasticMapping::REJECTION_SAMPLING);
+
+        // make sure the mappings kept in a compact store give legal trees and expected history
+        StochasticMappingStore store;
+        stocMapping->generateStochasticMapping(store);
+        for (size_t i=0; i<store.getNumberOfMappings(); ++i)
+        {
+            Tree* mapping = stocMapping->getMappingTree(store, i);
+            checkIfMappingLegal(stocMapping, mapping, ttree, characterTreeLikelihood);
+            delete mapping;
+        }
+        Tree* storeExpectedHistory = stocMapping->generateExpectedMapping(store);
+        checkIfMappingLegal(stocMapping, storeExpectedHistory, ttree, characterTreeLikelihood);
+        delete storeExpectedHistory;
+
+        // make sure mappings generated in parallel only depend on the seed, and not on the number of threads
+        StochasticMappingStore seededStore1, seededStore2;
+#ifdef _OPENMP
+        int maxThreads = omp_get_max_threads();
+        omp_set_num_threads(1);
+#endif
+        stocMapping->generateStochasticMapping(seededStore1, 42);
+#ifdef _OPENMP
+        omp_set_num_threads(4);
+#endif
+        stocMapping->generateStochasticMapping(seededStore2, 42);
+#ifdef _OPENMP
+        omp_set_num_threads(maxThreads);
+#endif
+        bool sameMappings = seededStore1.getNumberOfMappings() == mappingsNum && seededStore1.getNumberOfEvents() == seededStore2.getNumberOfEvents();
+        for (size_t i=0; sameMappings && i<seededStore1.getNumberOfMappings(); ++i)
+        {
+            for (size_t n=0; sameMappings && n<seededStore1.getNumberOfNodes(); ++n)
+            {
+                sameMappings = seededStore1.getNodeState(i, n) == seededStore2.getNodeState(i, n) && seededStore1.getNumberOfEvents(i, n) == seededStore2.getNumberOfEvents(i, n);
+                for (size_t e=0; sameMappings && e<seededStore1.getNumberOfEvents(i, n); ++e)
+                {
+                    sameMappings = seededStore1.getEventTime(i, n, e) == seededStore2.getEventTime(i, n, e) && seededStore1.getEventState(i, n, e) == seededStore2.getEventState(i, n, e);
+                }
+            }
+        }
+        if (!sameMappings)
+        {
+            cerr << "Error! mappings generated with the same seed differ" << endl;
+            return 1;
+        }
+        Tree* seededMapping = stocMapping->getMappingTree(seededStore1, 0);
+        checkIfMappingLegal(stocMapping, seededMapping, ttree, characterTreeLikelihood);
+        delete seededMapping;
+
         // compute posterior probabilies
         VVDouble posteriorProbabilities;
         posteriorProbabilities.clear();
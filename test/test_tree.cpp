@@ -40,13 +40,44 @@ knowledge of the CeCILL license and that you accept its terms.
 #include <Bpp/Phyl/TreeTemplate.h>
 #include <Bpp/Phyl/TreeTemplateTools.h>
 #include <Bpp/Phyl/Io/Newick.h>
+#include <Bpp/Phyl/Io/NewickTreeStream.h>
+#include <Bpp/Phyl/Io/BinaryTreeFormat.h>
+#include <Bpp/Phyl/BipartitionList.h>
+#include <Bpp/Phyl/BipartitionTools.h>
 #include <string>
 #include <vector>
 #include <iostream>
+#include <memory>
+#include <sstream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace bpp;
 using namespace std;
 
+//Independent computation of the Robinson-Foulds distance, from the distinct non-trivial bipartitions of the trees:
+int countDifferentBipartitions(const Tree& tree1, const Tree& tree2, int& missing2, int& missing1) {
+  BipartitionList bipartitions1(tree1, true), bipartitions2(tree2, true);
+  bipartitions1.removeTrivialBipartitions();
+  bipartitions1.removeRedundantBipartitions();
+  bipartitions2.removeTrivialBipartitions();
+  bipartitions2.removeRedundantBipartitions();
+  int nbShared = 0;
+  for (size_t i = 0; i < bipartitions1.getNumberOfBipartitions(); ++i) {
+    for (size_t j = 0; j < bipartitions2.getNumberOfBipartitions(); ++j) {
+      if (BipartitionTools::areIdentical(bipartitions1, i, bipartitions2, j)) {
+        nbShared++;
+        break;
+      }
+    }
+  }
+  missing2 = static_cast<int>(bipartitions1.getNumberOfBipartitions()) - nbShared;
+  missing1 = static_cast<int>(bipartitions2.getNumberOfBipartitions()) - nbShared;
+  return missing1 + missing2;
+}
+
 int main() {
   //Get some leaf names:
   vector<string> leaves(100);
@@ -156,6 +187,301 @@ int main() {
   }
   cout << "Newick multiple I/O ok." << endl;
 
+  //Same with the fast parser:
+  Newick tFastReader;
+  tFastReader.enableFastParser();
+  vector<Tree *> trees3;
+  tFastReader.readTrees("tmp_trees.dnd", trees3);
+  if (trees3.size() != trees.size())
+    return 1;
+  for (unsigned int i = 0; i < 100; ++i) {
+    if (!TreeTools::haveSameTopology(*trees[i], *trees3[i]))
+    {
+      cerr << "Tree " << i << " failed to be read with the fast parser!" << endl;
+      return 1;
+    }
+    delete trees3[i];
+  }
+  istringstream iss11("((A:1,B:2)80:3,\n C:4)2:5;");
+  TreeTemplate<Node>* tree11 = tFastReader.readTree(iss11);
+  if (tree11->getNumberOfLeaves() != 3 || tree11->getRootNode()->getSon(0)->getBootstrapValue() != 80.
+      || tree11->getRootNode()->getSon(0)->getDistanceToFather() != 3.)
+    return 1;
+  delete tree11;
+  cout << "Newick fast parser ok." << endl;
+
+  //Streamed trees, read sequentially or parsed in parallel by small batches, come in the order of the file:
+  for (unsigned int k = 0; k < 2; ++k) {
+    NewickTreeStream stream("tmp_trees.dnd", Newick(), k == 1, 7);
+    for (unsigned int i = 0; i < 100; ++i) {
+      unique_ptr<Tree> streamTree(stream.nextTree());
+      if (!streamTree.get() || TreeTools::treeToParenthesis(*streamTree) != TreeTools::treeToParenthesis(*trees2[i]))
+      {
+        cerr << "Tree " << i << " failed to be streamed (parallel: " << k << ")!" << endl;
+        return 1;
+      }
+    }
+    if (stream.nextTree() || stream.getNumberOfTreesRead() != 100)
+      return 1;
+  }
+  //A bad tree is reported after all the trees before it:
+  string badTrees;
+  for (unsigned int i = 0; i < 20; ++i)
+    badTrees += (i == 10 ? "((A,B):x,C);" : TreeTools::treeToParenthesis(*trees2[i])) + "\n";
+  for (unsigned int k = 0; k < 2; ++k) {
+    istringstream badInput(badTrees);
+    NewickTreeStream stream(badInput, Newick(), k == 1, 7);
+    unsigned int nbRead = 0;
+    try {
+      while (Tree* streamTree = stream.nextTree()) {
+        bool same = TreeTools::treeToParenthesis(*streamTree) == TreeTools::treeToParenthesis(*trees2[nbRead]);
+        delete streamTree;
+        if (!same)
+          return 1;
+        nbRead++;
+      }
+      cerr << "Bad tree was not reported (parallel: " << k << ")!" << endl;
+      return 1;
+    } catch (IOException& e) {}
+    if (nbRead != 10)
+    {
+      cerr << "Bad tree was reported after " << nbRead << " trees instead of 10 (parallel: " << k << ")!" << endl;
+      return 1;
+    }
+  }
+  //Semi-colons within comments do not end trees:
+  istringstream commentInput("((A,B)[first;tree],C);\n(A,[second;tree](B,C));\n");
+  NewickTreeStream commentStream(commentInput, Newick(true));
+  unique_ptr< TreeTemplate<Node> > commentTree1(commentStream.nextTree());
+  unique_ptr< TreeTemplate<Node> > commentTree2(commentStream.nextTree());
+  if (!commentTree1.get() || !commentTree2.get() || commentStream.nextTree()
+      || commentTree1->getNumberOfLeaves() != 3 || commentTree2->getNumberOfLeaves() != 3
+      || commentTree1->getNode(commentTree1->getLeafId("A"))->getFather()->getNumberOfSons() != 2
+      || commentTree2->getNode(commentTree2->getLeafId("B"))->getFather()->getNumberOfSons() != 2)
+    return 1;
+  //Consensus trees and bootstrap values computed from a stream are the same as from a vector of trees:
+  for (unsigned int k = 0; k < 2; ++k) {
+    double threshold = k == 0 ? 0. : 0.5;
+    unique_ptr< TreeTemplate<Node> > consensus1(TreeTools::thresholdConsensus(trees2, threshold));
+    NewickTreeStream stream("tmp_trees.dnd", Newick(), true, 7);
+    unique_ptr< TreeTemplate<Node> > consensus2(TreeTools::thresholdConsensus(stream, threshold));
+    if (TreeTools::robinsonFouldsDistance(*consensus1, *consensus2) != 0
+        || consensus1->getNumberOfNodes() != consensus2->getNumberOfNodes())
+      return 1;
+  }
+  TreeTemplate<Node> bootstrapTree1(*dynamic_cast<TreeTemplate<Node>*>(trees2[0]));
+  TreeTemplate<Node> bootstrapTree2(bootstrapTree1);
+  TreeTools::computeBootstrapValues(bootstrapTree1, trees2, false);
+  NewickTreeStream bootstrapStream("tmp_trees.dnd", Newick(), true, 7);
+  TreeTools::computeBootstrapValues(bootstrapTree2, bootstrapStream, false);
+  vector<Node*> bootstrapNodes = bootstrapTree1.getInnerNodes();
+  for (size_t i = 0; i < bootstrapNodes.size(); ++i) {
+    if (!bootstrapNodes[i]->hasFather())
+      continue;
+    //The two sons of a root define the same bipartition, which is annotated once:
+    const Node* node2 = bootstrapTree2.getNode(bootstrapNodes[i]->getId());
+    if (node2->hasBootstrapValue() != bootstrapNodes[i]->hasBootstrapValue()
+        || (node2->hasBootstrapValue() && node2->getBootstrapValue() != bootstrapNodes[i]->getBootstrapValue()))
+      return 1;
+  }
+  cout << "Newick tree stream ok." << endl;
+
+  //Consensus trees and bootstrap values do not depend on the number of threads:
+  string consensusStrings[2], majorityStrings[2];
+  vector<double> bootstrapValues[2];
+#ifdef _OPENMP
+  int maxThreads = omp_get_max_threads();
+#endif
+  for (unsigned int k = 0; k < 2; ++k) {
+#ifdef _OPENMP
+    omp_set_num_threads(k == 0 ? 1 : 4);
+#endif
+    unique_ptr< TreeTemplate<Node> > consensus(TreeTools::thresholdConsensus(trees2, 0.));
+    consensusStrings[k] = TreeTools::treeToParenthesis(*consensus);
+    unique_ptr< TreeTemplate<Node> > majority(TreeTools::majorityConsensus(trees2));
+    majorityStrings[k] = TreeTools::treeToParenthesis(*majority);
+    TreeTemplate<Node> bootstrapTree(*dynamic_cast<TreeTemplate<Node>*>(trees2[1]));
+    TreeTools::computeBootstrapValues(bootstrapTree, trees2, false, 2);
+    vector<Node*> nodes = bootstrapTree.getInnerNodes();
+    for (size_t i = 0; i < nodes.size(); ++i)
+      bootstrapValues[k].push_back(nodes[i]->hasBootstrapValue() ? nodes[i]->getBootstrapValue() : -1.);
+  }
+#ifdef _OPENMP
+  omp_set_num_threads(maxThreads);
+#endif
+  if (consensusStrings[0] != consensusStrings[1] || majorityStrings[0] != majorityStrings[1] || bootstrapValues[0] != bootstrapValues[1])
+  {
+    cerr << "Consensus trees or bootstrap values depend on the number of threads!" << endl;
+    return 1;
+  }
+  //Known bipartition frequencies in 10 trees: AB 90%, CD 60%, CE 30%, AC and BD 10%.
+  //The rare bipartitions come last, and are incompatible with better supported ones:
+  vector<Tree *> sample;
+  for (unsigned int i = 0; i < 10; ++i)
+    sample.push_back(TreeTemplateTools::parenthesisToTree(i < 6 ? "((A,B),(C,D),E);" : (i < 9 ? "((A,B),(C,E),D);" : "((A,C),(B,D),E);")));
+  unique_ptr< TreeTemplate<Node> > resolvedTree(TreeTemplateTools::parenthesisToTree("((A,B),(C,D),E);"));
+  unique_ptr< TreeTemplate<Node> > partialTree(TreeTemplateTools::parenthesisToTree("((A,B),C,D,E);"));
+  unique_ptr< TreeTemplate<Node> > starTree(TreeTemplateTools::parenthesisToTree("(A,B,C,D,E);"));
+  unique_ptr< TreeTemplate<Node> > sampleConsensus(TreeTools::thresholdConsensus(sample, 0.));
+  unique_ptr< TreeTemplate<Node> > sampleMajority(TreeTools::majorityConsensus(sample));
+  unique_ptr< TreeTemplate<Node> > samplePartial(TreeTools::thresholdConsensus(sample, 0.7));
+  unique_ptr< TreeTemplate<Node> > sampleStrict(TreeTools::strictConsensus(sample));
+  if (TreeTools::robinsonFouldsDistance(*resolvedTree, *sampleConsensus) != 0
+      || TreeTools::robinsonFouldsDistance(*resolvedTree, *sampleMajority) != 0
+      || TreeTools::robinsonFouldsDistance(*partialTree, *samplePartial) != 0
+      || TreeTools::robinsonFouldsDistance(*starTree, *sampleStrict) != 0)
+  {
+    cerr << "Wrong consensus tree: " << TreeTools::treeToParenthesis(*sampleConsensus) << endl;
+    return 1;
+  }
+  unique_ptr< TreeTemplate<Node> > annotatedTree1(TreeTemplateTools::parenthesisToTree("((A,B),(C,E),D);"));
+  unique_ptr< TreeTemplate<Node> > annotatedTree2(TreeTemplateTools::parenthesisToTree("((A,C),(B,D),E);"));
+  TreeTools::computeBootstrapValues(*annotatedTree1, sample, false);
+  TreeTools::computeBootstrapValues(*annotatedTree2, sample, false);
+  if (annotatedTree1->getRootNode()->getSon(0)->getBootstrapValue() != 90.
+      || annotatedTree1->getRootNode()->getSon(1)->getBootstrapValue() != 30.
+      || annotatedTree2->getRootNode()->getSon(0)->getBootstrapValue() != 10.
+      || annotatedTree2->getRootNode()->getSon(1)->getBootstrapValue() != 10.)
+    return 1;
+  for (size_t i = 0; i < sample.size(); ++i)
+    delete sample[i];
+  cout << "Consensus trees ok." << endl;
+
+  //Binary round trip, with random access:
+  BinaryTreeFormat tBinary;
+  tBinary.writeTrees(trees, "tmp_trees.bin");
+  BinaryTreeFile binFile("tmp_trees.bin");
+  if (binFile.getNumberOfTrees() != trees.size())
+    return 1;
+  for (unsigned int i = 0; i < 100; ++i) {
+    TreeTemplate<Node>* binTree = binFile.getTree(i);
+    if (!TreeTools::haveSameTopology(*trees[i], *binTree))
+    {
+      cerr << "Tree " << i << " failed to be read from the binary file!" << endl;
+      return 1;
+    }
+    delete binTree;
+  }
+  try {
+    binFile.getTree(trees.size());
+    return 1;
+  } catch (IndexOutOfBoundsException& e) {}
+  //A corrupted record size must be reported, not allocated:
+  ostringstream binOutput;
+  tBinary.writeTree(*trees[0], binOutput);
+  string binRecord = binOutput.str();
+  uint64_t hugeSize = uint64_t(1) << 60;
+  binRecord.replace(BinaryTreeFormat::getHeaderSize(), sizeof(hugeSize), reinterpret_cast<const char*>(&hugeSize), sizeof(hugeSize));
+  istringstream binInput(binRecord);
+  try {
+    delete tBinary.readTree(binInput);
+    return 1;
+  } catch (IOException& e) {}
+  cout << "Binary tree format ok." << endl;
+
+  //Bipartitions, on more than 64 leaves:
+  for (unsigned int i = 0; i < 100; ++i) {
+    if (TreeTools::robinsonFouldsDistance(*trees[i], *trees2[i]) != 0)
+      return 1;
+  }
+  int missing2 = 0, missing1 = 0;
+  int rf = TreeTools::robinsonFouldsDistance(*trees[0], *trees[1], true, &missing2, &missing1);
+  if (rf == 0 || rf != missing1 + missing2 || missing1 != missing2)
+    return 1;
+  vector<Tree *> sameTrees(3, trees[0]);
+  TreeTemplate<Node>* consensus = TreeTools::strictConsensus(sameTrees);
+  if (!TreeTools::haveSameTopology(*trees[0], *consensus))
+    return 1;
+  delete consensus;
+  vector<Tree *> firstTrees(trees.begin(), trees.begin() + 10);
+  DistanceMatrix* rfMatrix = TreeTools::robinsonFouldsDistances(firstTrees);
+  for (unsigned int i = 0; i < 10; ++i) {
+    for (unsigned int j = 0; j < 10; ++j) {
+      if ((*rfMatrix)(i, j) != TreeTools::robinsonFouldsDistance(*trees[i], *trees[j]))
+        return 1;
+    }
+  }
+  delete rfMatrix;
+  //Same with multifurcations, unary nodes, and rooted and unrooted trees, on fewer leaves as the reference computation is slow:
+  vector<string> rfLeaves(leaves.begin(), leaves.begin() + 20);
+  vector<Tree *> rfTrees;
+  for (unsigned int i = 0; i < 10; ++i) {
+    TreeTemplate<Node>* rfTree = TreeTemplateTools::getRandomTree(rfLeaves, true);
+    vector<Node*> rfNodes = rfTree->getNodes();
+    for (size_t k = 0; k < rfNodes.size(); ++k) {
+      if (rfNodes[k]->hasFather())
+        rfNodes[k]->setDistanceToFather(RandomTools::giveRandomNumberBetweenZeroAndEntry(1.));
+      if (rfNodes[k]->hasFather() && !rfNodes[k]->isLeaf())
+        rfNodes[k]->setBranchProperty(TreeTools::BOOTSTRAP, Number<double>(RandomTools::giveRandomNumberBetweenZeroAndEntry(100.)));
+    }
+    TreeTemplateTools::unresolveUncertainNodes(*rfTree, 10. * i);
+    rfNodes = rfTree->getNodes();
+    for (size_t k = 0; k < rfNodes.size(); ++k) {
+      if (rfNodes[k]->hasFather() && RandomTools::giveRandomNumberBetweenZeroAndEntry(1.) < 0.1) {
+        Node* father = rfNodes[k]->getFather();
+        Node* unary = new Node();
+        father->setSon(father->getSonPosition(rfNodes[k]), unary);
+        unary->addSon(rfNodes[k]);
+      }
+    }
+    if (i % 2 == 1 && rfTree->isRooted())
+      rfTree->unroot();
+    rfTree->resetNodesId();
+    rfTrees.push_back(rfTree);
+  }
+  //The same tree, rooted and unrooted:
+  TreeTemplate<Node>* rootedTree = TreeTemplateTools::getRandomTree(rfLeaves, true);
+  rfTrees.push_back(rootedTree);
+  TreeTemplate<Node>* unrootedTree = new TreeTemplate<Node>(*rootedTree);
+  unrootedTree->unroot();
+  rfTrees.push_back(unrootedTree);
+  if (!rfTrees[10]->isRooted() || rfTrees[11]->isRooted() || TreeTools::robinsonFouldsDistance(*rfTrees[10], *rfTrees[11]) != 0)
+    return 1;
+  rfMatrix = TreeTools::robinsonFouldsDistances(rfTrees);
+  for (unsigned int i = 0; i < rfTrees.size(); ++i) {
+    for (unsigned int j = 0; j < rfTrees.size(); ++j) {
+      int expectedMissing2 = 0, expectedMissing1 = 0;
+      int expected = countDifferentBipartitions(*rfTrees[i], *rfTrees[j], expectedMissing2, expectedMissing1);
+      rf = TreeTools::robinsonFouldsDistance(*rfTrees[i], *rfTrees[j], true, &missing2, &missing1);
+      if (rf != expected || missing2 != expectedMissing2 || missing1 != expectedMissing1 || (*rfMatrix)(i, j) != expected)
+      {
+        cerr << "Wrong Robinson-Foulds distance between trees " << i << " and " << j << ": " << rf << " instead of " << expected << "." << endl;
+        return 1;
+      }
+    }
+  }
+  delete rfMatrix;
+  for (size_t i = 0; i < rfTrees.size(); ++i)
+    delete rfTrees[i];
+  cout << "Bipartitions ok." << endl;
+
+  //Constant time queries:
+  TreeTemplate<Node>* tree12 = TreeTemplateTools::parenthesisToTree("(((A:1,B:2):3,C:4):5,D:6);");
+  const TreeQueryIndex& queries = tree12->getQueryIndex();
+  int idA = tree12->getLeafId("A"), idB = tree12->getLeafId("B"), idC = tree12->getLeafId("C"), idD = tree12->getLeafId("D");
+  if (queries.getLastCommonAncestor(idA, idB) != tree12->getFatherId(idA)
+      || queries.getLastCommonAncestor(idA, idD) != tree12->getRootId()
+      || queries.getDistanceBetweenAnyTwoNodes(idA, idC) != 8.
+      || queries.getDistanceBetweenAnyTwoNodes(idB, idD) != 16.
+      || queries.getNumberOfBranchesBetween(idA, idD) != 4)
+    return 1;
+  //Failed lookups do not invalidate the index:
+  try {
+    tree12->getNode(1000);
+    return 1;
+  } catch (NodeNotFoundException& e) {}
+  if (&tree12->getQueryIndex() != &queries || queries.getNumberOfBranchesBetween(idA, idD) != 4)
+    return 1;
+  tree12->setDistanceToFather(idD, 1.);
+  if (tree12->getQueryIndex().getDistanceBetweenAnyTwoNodes(idB, idD) != 11.)
+    return 1;
+  DistanceMatrix* distances = TreeTools::getDistanceMatrix(*tree12);
+  if ((*distances)("A", "C") != 8. || (*distances)("C", "D") != 10.)
+    return 1;
+  delete distances;
+  delete tree12;
+  cout << "Tree queries ok." << endl;
+
   for (unsigned int i = 0; i < 100; ++i) {
     delete trees[i];
     delete trees2[i];
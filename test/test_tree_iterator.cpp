@@ -58,6 +58,32 @@ void giveNamesToInternalNodes(Tree* tree)
     }  
 }
 
+bool checkOrder(TreeIterator& treeIt, const vector<string>& expectedOrder, const string& orderName)
+{
+  size_t counter = 0;
+  for (Node* node = treeIt.begin(); node != treeIt.end(); node = treeIt.next()) {
+      if (counter >= expectedOrder.size() || node->getName() != expectedOrder[counter])
+      {
+        cerr << orderName << " traversion failed at step " << counter << ": returned " << node->getName() << endl;
+        return false;
+      }
+      counter += 1;
+  }
+  if (counter != expectedOrder.size())
+  {
+    cerr << orderName << " traversion stopped after " << counter << " nodes instead of " << expectedOrder.size() << endl;
+    return false;
+  }
+  return true;
+}
+
+Node* addNode(Node* father, const string& name)
+{
+  Node* node = new Node(name);
+  if (father) father->addSon(node);
+  return node;
+}
+
 int main() {
 
   // parse a string:
@@ -112,5 +138,42 @@ int main() {
   delete(treeIt3);
 
   delete(tree);
+
+  // Unary and multifurcating nodes.
+  // The expected orders are the ones of the iterators which tagged nodes with their visitation status:
+  Node* root = addNode(0, "R");
+  Node* multi = addNode(root, "M");
+  addNode(multi, "S1");
+  addNode(addNode(multi, "U1"), "S2");
+  addNode(multi, "S3");
+  addNode(multi, "S4");
+  addNode(addNode(addNode(root, "U3"), "U2"), "S5");
+  Node* bifurcation = addNode(root, "B");
+  addNode(bifurcation, "S6");
+  addNode(bifurcation, "S7");
+  TreeTemplate<Node> tree2(root);
+  tree2.resetNodesId();
+
+  PreOrderTreeIterator preIt(tree2);
+  if (!checkOrder(preIt, {"R", "M", "S1", "U1", "S2", "S3", "S4", "U3", "U2", "S5", "B", "S6", "S7"}, "Preorder"))
+    return 1;
+  PostOrderTreeIterator postIt(tree2);
+  if (!checkOrder(postIt, {"S1", "S2", "U1", "S3", "S4", "M", "S5", "U2", "U3", "S6", "S7", "B", "R"}, "Postorder"))
+    return 1;
+  InOrderTreeIterator inIt(tree2);
+  if (!checkOrder(inIt, {"S1", "U1", "S2", "M", "S3", "S4", "R", "U3", "U2", "S5", "S6", "B", "S7"}, "Inorder"))
+    return 1;
+
+  // A unary node on the leftmost path is visited before its son, like other unary nodes
+  // (the former in-order iterator started at the leftmost leaf, and visited it first):
+  Node* root3 = addNode(0, "R");
+  addNode(addNode(root3, "U"), "S1");
+  addNode(root3, "S2");
+  TreeTemplate<Node> tree3(root3);
+  tree3.resetNodesId();
+  InOrderTreeIterator inIt3(tree3);
+  if (!checkOrder(inIt3, {"U", "S1", "R", "S2"}, "Inorder"))
+    return 1;
+
   return 0;
 }
@@ -71,6 +71,51 @@ int main() {
       cerr << "Error, rerooting gave incorrect branch lengths :(: " << l << " vs. " << totalLen << endl;
       return 1;
     }
+    if (!tr->isNodeIndexValid()) {
+      cerr << "Error, node index is not up to date after rerooting." << endl;
+      return 1;
+    }
+  }
+
+  //Testing the node index when adding outgroups:
+  for (unsigned int i = 0; i < 100; ++i) {
+    size_t pos = RandomTools::giveIntRandomNumberBetweenZeroAndEntry<size_t>(100);
+    tr->newOutGroup(nodes[pos]);
+    if (!tr->isNodeIndexValid() || tr->getNode(nodes[pos]->getId()) != nodes[pos]) {
+      cerr << "Error, node index is not up to date after changing outgroup." << endl;
+      return 1;
+    }
+  }
+
+  //Testing the node index when nodes are deleted:
+  nodes = tr->getNodes();
+  vector<int> removedIds;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (nodes[i]->hasFather() && !nodes[i]->isLeaf()) {
+      double bootstrap = RandomTools::giveRandomNumberBetweenZeroAndEntry(100.);
+      nodes[i]->setBranchProperty(TreeTools::BOOTSTRAP, Number<double>(bootstrap));
+      if (bootstrap < 50.) removedIds.push_back(nodes[i]->getId());
+    }
+  }
+  TreeTemplateTools::unresolveUncertainNodes(*tr, 50.);
+  if (!tr->isNodeIndexValid()) {
+    cerr << "Error, node index is not up to date after unresolving nodes." << endl;
+    return 1;
+  }
+  for (size_t i = 0; i < removedIds.size(); ++i) {
+    if (tr->hasNode(removedIds[i])) {
+      cerr << "Error, node " << removedIds[i] << " was not removed from the index." << endl;
+      return 1;
+    }
+  }
+
+  //Lookups on a const tree find new nodes without modifying the index:
+  Node* newLeaf = new Node(TreeTools::getMPNUId(*tr, tr->getRootId()), "newLeaf");
+  tr->getRootNode()->addSon(newLeaf);
+  const TreeTemplate<Node>& ctr = *tr;
+  if (ctr.getNode(newLeaf->getId()) != newLeaf || ctr.getNode(newLeaf->getId(), true) != newLeaf || ctr.isNodeIndexValid()) {
+    cerr << "Error, const lookup of a new node failed or modified the index." << endl;
+    return 1;
   }
 
   return 0;